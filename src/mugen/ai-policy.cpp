@@ -0,0 +1,384 @@
+#include "ai-policy.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <r-tech1/file-system.h>
+#include <r-tech1/system.h>
+#include <r-tech1/debug.h>
+#include <r-tech1/funcs.h>
+#include "exception.h"
+
+using namespace std;
+
+namespace Mugen{
+
+static const int POLICY_VERSION = 1;
+static const char * AI_DIRECTORY = "mugen-ai";
+
+AIPolicy::Cell::Cell():
+attempts(0),
+hits(0){
+}
+
+AIPolicy::Command::Command():
+available(false){
+}
+
+AIPolicy::AIPolicy():
+learning(true){
+    for (int i = 0; i < Buckets; i++){
+        dirty[i] = true;
+    }
+}
+
+int AIPolicy::bucket(int distance){
+    if (distance < 0){
+        distance = -distance;
+    }
+    int out = distance / BucketWidth;
+    if (out >= Buckets){
+        return Buckets - 1;
+    }
+    return out;
+}
+
+int AIPolicy::find(const string & name) const {
+    map<string, int>::const_iterator found = ids.find(name);
+    if (found != ids.end()){
+        return found->second;
+    }
+    return -1;
+}
+
+int AIPolicy::add(const string & name){
+    int id = commands.size();
+    commands.push_back(Command());
+    commands.back().name = name;
+    ids[name] = id;
+    return id;
+}
+
+int AIPolicy::intern(const string & name){
+    int id = find(name);
+    if (id == -1){
+        id = add(name);
+    }
+
+    if (!commands[id].available){
+        commands[id].available = true;
+        available.push_back(id);
+        for (int i = 0; i < Buckets; i++){
+            dirty[i] = true;
+        }
+    }
+
+    return id;
+}
+
+const string & AIPolicy::getName(int command) const {
+    return commands[command].name;
+}
+
+void AIPolicy::setLearning(bool learning){
+    if (this->learning != learning){
+        this->learning = learning;
+        for (int i = 0; i < Buckets; i++){
+            dirty[i] = true;
+        }
+    }
+}
+
+void AIPolicy::attempted(int command, int bucket){
+    if (learning){
+        commands[command].cells[bucket].attempts += 1;
+        dirty[bucket] = true;
+    }
+}
+
+void AIPolicy::hit(int command, int bucket){
+    if (learning){
+        commands[command].cells[bucket].hits += 1;
+        dirty[bucket] = true;
+    }
+}
+
+unsigned int AIPolicy::getAttempts(int command, int bucket) const {
+    return commands[command].cells[bucket].attempts;
+}
+
+unsigned int AIPolicy::getHits(int command, int bucket) const {
+    return commands[command].cells[bucket].hits;
+}
+
+bool AIPolicy::isTrained() const {
+    for (vector<Command>::const_iterator it = commands.begin(); it != commands.end(); it++){
+        for (int bucket = 0; bucket < Buckets; bucket++){
+            if (it->cells[bucket].attempts > 0){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* How often the command hit. While learning a command that was never tried
+ * counts as hitting half the time so it gets tried. Otherwise guesses don't
+ * count, and a command that wasn't tried enough goes after the ones that
+ * were.
+ */
+static double score(unsigned int attempts, unsigned int hits, bool learning){
+    if (learning){
+        return (hits + 1.0) / (attempts + 2.0);
+    }
+
+    if (attempts < AIPolicy::MinimumAttempts){
+        return -1;
+    }
+    return (double) hits / attempts;
+}
+
+void AIPolicy::rank(int bucket){
+    vector<int> & best = ranked[bucket];
+    best.clear();
+    for (vector<int>::const_iterator it = available.begin(); it != available.end(); it++){
+        const Cell & cell = commands[*it].cells[bucket];
+        double points = score(cell.attempts, cell.hits, learning);
+        unsigned int where = 0;
+        while (where < best.size()){
+            const Cell & other = commands[best[where]].cells[bucket];
+            if (score(other.attempts, other.hits, learning) < points){
+                break;
+            }
+            where += 1;
+        }
+
+        if (where < Choices){
+            best.insert(best.begin() + where, *it);
+            if (best.size() > Choices){
+                best.pop_back();
+            }
+        }
+    }
+    dirty[bucket] = false;
+}
+
+int AIPolicy::choose(int bucket, unsigned int random){
+    if (dirty[bucket]){
+        rank(bucket);
+    }
+
+    const vector<int> & best = ranked[bucket];
+    if (best.empty()){
+        return -1;
+    }
+
+    /* the best one half the time, then less and less */
+    static const unsigned int weights[] = {0, 0, 0, 0, 1, 1, 2, 3};
+    unsigned int index = weights[random % (sizeof(weights) / sizeof(weights[0]))];
+    if (index >= best.size()){
+        index = best.size() - 1;
+    }
+    return best[index];
+}
+
+int AIPolicy::explore(unsigned int random) const {
+    if (available.empty()){
+        return -1;
+    }
+    return available[random % available.size()];
+}
+
+void AIPolicy::merge(const AIPolicy & him, const AIPolicy * base){
+    for (vector<Command>::const_iterator it = him.commands.begin(); it != him.commands.end(); it++){
+        const Command & command = *it;
+        int id = find(command.name);
+        if (id == -1){
+            id = add(command.name);
+        }
+
+        int old = base != NULL ? base->find(command.name) : -1;
+        for (int bucket = 0; bucket < Buckets; bucket++){
+            Cell & cell = commands[id].cells[bucket];
+            unsigned int attempts = command.cells[bucket].attempts;
+            unsigned int hits = command.cells[bucket].hits;
+            if (old != -1){
+                const Cell & before = base->commands[old].cells[bucket];
+                attempts -= PaintownUtil::min(attempts, before.attempts);
+                hits -= PaintownUtil::min(hits, before.hits);
+            }
+            cell.attempts += attempts;
+            cell.hits += hits;
+        }
+    }
+
+    for (int i = 0; i < Buckets; i++){
+        dirty[i] = true;
+    }
+}
+
+/* The file looks like
+ *
+ *   policy version buckets bucket-width
+ *   command name
+ *   bucket attempts hits
+ *   ...
+ *
+ * with only the buckets a command was tried in.
+ */
+void AIPolicy::write(ostream & out) const {
+    out << "# Learned AI policy, made by run-match --train" << endl;
+    out << "policy " << POLICY_VERSION << " " << Buckets << " " << BucketWidth << endl;
+    for (vector<Command>::const_iterator it = commands.begin(); it != commands.end(); it++){
+        const Command & command = *it;
+        bool header = false;
+        for (int bucket = 0; bucket < Buckets; bucket++){
+            const Cell & cell = command.cells[bucket];
+            if (cell.attempts == 0 && cell.hits == 0){
+                continue;
+            }
+            if (!header){
+                out << "command " << command.name << endl;
+                header = true;
+            }
+            out << bucket << " " << cell.attempts << " " << cell.hits << endl;
+        }
+    }
+}
+
+void AIPolicy::read(istream & input){
+    static const string commandPrefix = "command ";
+    bool header = false;
+    int current = -1;
+    string line;
+    while (getline(input, line)){
+        if (line.size() > 0 && line[line.size() - 1] == '\r'){
+            line.erase(line.size() - 1);
+        }
+
+        if (line.size() == 0 || line[0] == '#'){
+            continue;
+        }
+
+        if (!header){
+            istringstream in(line);
+            string word;
+            int version = 0;
+            int buckets = 0;
+            int width = 0;
+            in >> word >> version >> buckets >> width;
+            if (in.fail() || word != "policy" || version != POLICY_VERSION){
+                throw MugenException("Not an AI policy: " + line, __FILE__, __LINE__);
+            }
+            if (buckets != Buckets || width != BucketWidth){
+                throw MugenException("AI policy was made with different distance buckets", __FILE__, __LINE__);
+            }
+            header = true;
+            continue;
+        }
+
+        if (line.compare(0, commandPrefix.size(), commandPrefix) == 0){
+            string name = line.substr(commandPrefix.size());
+            current = find(name);
+            if (current == -1){
+                current = add(name);
+            }
+            continue;
+        }
+
+        istringstream in(line);
+        int bucket = -1;
+        unsigned int attempts = 0;
+        unsigned int hits = 0;
+        in >> bucket >> attempts >> hits;
+        if (in.fail() || current == -1 || bucket < 0 || bucket >= Buckets){
+            throw MugenException("Bad line in AI policy: " + line, __FILE__, __LINE__);
+        }
+        Cell & cell = commands[current].cells[bucket];
+        cell.attempts += attempts;
+        cell.hits += hits;
+    }
+
+    if (!header){
+        throw MugenException("Not an AI policy", __FILE__, __LINE__);
+    }
+
+    for (int i = 0; i < Buckets; i++){
+        dirty[i] = true;
+    }
+}
+
+void AIPolicy::save(const Filesystem::AbsolutePath & path) const {
+    Filesystem::AbsolutePath directory = path.getDirectory();
+    if (!System::isDirectory(directory.path())){
+        /* like mkdir -p */
+        System::makeAllDirectory(directory.path());
+    }
+
+    ofstream out(path.path().c_str());
+    if (!out){
+        throw MugenException("Could not write " + path.path(), __FILE__, __LINE__);
+    }
+    write(out);
+}
+
+void AIPolicy::load(const Filesystem::AbsolutePath & path){
+    ifstream in(path.path().c_str());
+    if (!in){
+        throw MugenException("Could not read " + path.path(), __FILE__, __LINE__);
+    }
+    read(in);
+}
+
+static int replaceSlash(int what){
+    if (what == '/' || what == '\\'){
+        return '-';
+    }
+    return what;
+}
+
+Filesystem::AbsolutePath AIPolicy::location(const Filesystem::AbsolutePath & character){
+    string converted = Storage::instance().cleanse(character).path();
+    std::transform(converted.begin(), converted.end(), converted.begin(), replaceSlash);
+    return Storage::instance().userDirectory().join(Filesystem::RelativePath(AI_DIRECTORY)).join(Filesystem::RelativePath(converted + ".policy"));
+}
+
+/* keyed by the file the policy is saved in */
+static map<string, PaintownUtil::ReferenceCount<AIPolicy> > policies;
+
+PaintownUtil::ReferenceCount<AIPolicy> AIPolicy::forCharacter(const Filesystem::AbsolutePath & character){
+    Filesystem::AbsolutePath path = location(character);
+    map<string, PaintownUtil::ReferenceCount<AIPolicy> >::iterator found = policies.find(path.path());
+    if (found != policies.end()){
+        return found->second;
+    }
+
+    PaintownUtil::ReferenceCount<AIPolicy> policy(new AIPolicy());
+    try{
+        policy->load(path);
+        Global::debug(1, "mugen-ai") << "Loaded AI policy " << path.path() << endl;
+    } catch (const MugenException & fail){
+        Global::debug(1, "mugen-ai") << "No AI policy for " << character.path() << ": " << fail.getReason() << endl;
+        policy = PaintownUtil::ReferenceCount<AIPolicy>(new AIPolicy());
+    }
+    policy->setLearning(!policy->isTrained());
+
+    policies[path.path()] = policy;
+    return policy;
+}
+
+void AIPolicy::saveAll(const string & suffix){
+    for (map<string, PaintownUtil::ReferenceCount<AIPolicy> >::iterator it = policies.begin(); it != policies.end(); it++){
+        Filesystem::AbsolutePath path(it->first + suffix);
+        try{
+            it->second->save(path);
+            Global::debug(1, "mugen-ai") << "Saved AI policy " << path.path() << endl;
+        } catch (const MugenException & fail){
+            Global::debug(0, "mugen-ai") << "Could not save AI policy: " << fail.getReason() << endl;
+        }
+    }
+}
+
+}
@@ -0,0 +1,146 @@
+#ifndef _paintown_mugen_ai_policy_h
+#define _paintown_mugen_ai_policy_h
+
+#include <string>
+#include <vector>
+#include <map>
+#include <istream>
+#include <ostream>
+#include <r-tech1/pointer.h>
+#include <r-tech1/file-system.h>
+
+namespace PaintownUtil = ::Util;
+
+namespace Mugen{
+
+/* What LearningAIBehavior knows about one character: how many times each of
+ * its commands was tried and how many times it hit, from each distance to
+ * the enemy.
+ *
+ * Commands are interned once so the rest of the time they are just an index,
+ * and the best few commands of every distance are kept in order so choosing
+ * one is a table read. The order is only worked out again while the policy
+ * is learning.
+ *
+ * Policies are trained by playing matches with run-match --train and saved
+ * in the user directory, one file per character.
+ */
+class AIPolicy{
+public:
+    /* distances are put in buckets this many pixels wide */
+    static const int BucketWidth = 20;
+    /* anything farther away than the last bucket goes in it */
+    static const int Buckets = 16;
+    /* how many of the best commands of a bucket are kept */
+    static const unsigned int Choices = 4;
+    /* when not learning, commands tried fewer times than this go last */
+    static const unsigned int MinimumAttempts = 3;
+
+    AIPolicy();
+
+    static int bucket(int distance);
+
+    /* The id of a command, the same for as long as the policy exists. Only
+     * commands interned here can be chosen, commands that were read from a
+     * file and never interned belong to some older version of the character.
+     */
+    int intern(const std::string & command);
+
+    const std::string & getName(int command) const;
+
+    inline unsigned int size() const {
+        return commands.size();
+    }
+
+    /* While learning, attempts and hits are counted and the best commands
+     * are sorted again when they change, with commands that were never tried
+     * counted as hitting half the time so they get tried. Otherwise the
+     * policy doesn't change and commands are ranked only by how often they
+     * were seen to hit.
+     */
+    void setLearning(bool learning);
+
+    inline bool isLearning() const {
+        return learning;
+    }
+
+    void attempted(int command, int bucket);
+    void hit(int command, int bucket);
+
+    unsigned int getAttempts(int command, int bucket) const;
+    unsigned int getHits(int command, int bucket) const;
+
+    /* true if anything was ever tried */
+    bool isTrained() const;
+
+    /* One of the best commands for the bucket, usually the best one. `random'
+     * is any random number. -1 if nothing was interned.
+     */
+    int choose(int bucket, unsigned int random);
+
+    /* any command that can be chosen, to try things that look bad so far */
+    int explore(unsigned int random) const;
+
+    /* Adds what `him' learned. If `base' is given, only what `him' learned
+     * after starting from `base' is added, so training from processes that
+     * all loaded the same file can be put together.
+     */
+    void merge(const AIPolicy & him, const AIPolicy * base = NULL);
+
+    void write(std::ostream & out) const;
+    /* throws MugenException if the data is not a policy */
+    void read(std::istream & in);
+
+    void save(const Filesystem::AbsolutePath & path) const;
+    void load(const Filesystem::AbsolutePath & path);
+
+    /* where the policy of a character is saved */
+    static Filesystem::AbsolutePath location(const Filesystem::AbsolutePath & character);
+
+    /* The saved policy of a character, or an empty one, loaded once and
+     * shared by every behavior in the process. A trained policy starts out
+     * not learning.
+     */
+    static PaintownUtil::ReferenceCount<AIPolicy> forCharacter(const Filesystem::AbsolutePath & character);
+
+    /* Saves every policy forCharacter gave out. `suffix' is added to the
+     * file names.
+     */
+    static void saveAll(const std::string & suffix = "");
+
+protected:
+    struct Cell{
+        Cell();
+
+        unsigned int attempts;
+        unsigned int hits;
+    };
+
+    struct Command{
+        Command();
+
+        std::string name;
+        /* interned, as opposed to only read from a file */
+        bool available;
+        Cell cells[Buckets];
+    };
+
+    int find(const std::string & name) const;
+    int add(const std::string & name);
+    /* works out the best commands of a bucket */
+    void rank(int bucket);
+
+    std::vector<Command> commands;
+    std::map<std::string, int> ids;
+    /* ids of the interned commands */
+    std::vector<int> available;
+
+    /* best first */
+    std::vector<int> ranked[Buckets];
+    bool dirty[Buckets];
+    bool learning;
+};
+
+}
+
+#endif
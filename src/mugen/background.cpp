@@ -5,6 +5,7 @@
 #include <cstring>
 #include <string>
 #include <list>
+#include <set>
 #include <algorithm>
 #include "globals.h"
 #include <r-tech1/debug.h>
@@ -289,6 +290,17 @@ void BackgroundElement::act(){
     y += getVelocityY();
 }
 
+bool BackgroundElement::canComposite() const {
+    return false;
+}
+
+void BackgroundElement::renderComposite(int cameraX, int cameraY, int originX, int originY, const Graphics::Bitmap & work){
+}
+
+int BackgroundElement::getCoveredArea() const {
+    return 0;
+}
+
 /* Copy the contents of this into element
  * If this element is linked then we will call it recursively until we've come to the end of the chain
  * and then copy the contents of the last link of the chain into our passed element
@@ -516,12 +528,70 @@ public:
     vector<Point>::iterator current_point;
 };
 
-void NormalElement::render(int cameraX, int cameraY, const Graphics::Bitmap &bmp, Graphics::Bitmap::Filter * filter){
+/* Not moving by itself and drawn as is, so where it ends up only depends on
+ * the camera. A window that covers the whole screen doesn't clip anything.
+ */
+bool NormalElement::canComposite() const {
+    return sprite != NULL &&
+           getTrans() == None &&
+           getVelocityX() == 0 && getVelocityY() == 0 &&
+           (getSinX().amp == 0 || getSinX().period == 0) &&
+           (getSinY().amp == 0 || getSinY().period == 0) &&
+           getWindowDeltaX() == 0 && getWindowDeltaY() == 0 &&
+           getWindow().x <= 0 && getWindow().y <= 0 &&
+           getWindow().getX2() >= DEFAULT_WINDOW_WIDTH - 1 &&
+           getWindow().getY2() >= DEFAULT_WINDOW_HEIGHT - 1;
+}
+
+void NormalElement::renderComposite(int cameraX, int cameraY, int originX, int originY, const Graphics::Bitmap & work){
     if (!getVisible()){
         return;
     }
+    const int currentX = (int)(originX + getCurrentX() - cameraX + cameraX * (1 - getDeltaX()));
+    const int currentY = (int)(originY + getCurrentY() - cameraY + cameraY * (1 - getDeltaY()));
+    draw(currentX, currentY, work, NULL);
+}
+
+/* Tiling forever covers the whole screen in that direction */
+int NormalElement::getCoveredArea() const {
+    if (sprite == NULL){
+        return 0;
+    }
+
+    int width = sprite->getWidth();
+    int height = sprite->getHeight();
+    if (getTile().x == 1){
+        width = DEFAULT_WINDOW_WIDTH;
+    } else if (getTile().x > 1){
+        width = (width + getTileSpacing().x) * getTile().x;
+    }
+    if (getTile().y == 1){
+        height = DEFAULT_WINDOW_HEIGHT;
+    } else if (getTile().y > 1){
+        height = (height + getTileSpacing().y) * getTile().y;
+    }
+
+    return std::min(width, DEFAULT_WINDOW_WIDTH) * std::min(height, DEFAULT_WINDOW_HEIGHT);
+}
+
+void NormalElement::draw(int currentX, int currentY, const Graphics::Bitmap & bmp, Graphics::Bitmap::Filter * filter){
     const int addw = sprite->getWidth() + getTileSpacing().x;
     const int addh = sprite->getHeight() + getTileSpacing().y;
+
+    Tiler tiler(getTile(), currentX, currentY, addw, addh, sprite->getX(), sprite->getY(), sprite->getWidth(), sprite->getHeight(), bmp.getWidth(), bmp.getHeight());
+
+    Effects effects = getEffects();
+    effects.filter = filter;
+    while (tiler.hasMore()){
+        Point where = tiler.nextPoint();
+        sprite->render(where.x, where.y, bmp, effects);
+    }
+}
+
+void NormalElement::render(int cameraX, int cameraY, const Graphics::Bitmap &bmp, Graphics::Bitmap::Filter * filter){
+    if (!getVisible()){
+        return;
+    }
     const int currentX = (int)(bmp.getWidth()/2 + getCurrentX() - cameraX + cameraX * (1 - getDeltaX()));
     const int currentY = (int)(getCurrentY() - cameraY + cameraY * (1 - getDeltaY()));
     const int windowAddX = (int) (getWindowDeltaX() * cameraX);
@@ -534,14 +604,7 @@ void NormalElement::render(int cameraX, int cameraY, const Graphics::Bitmap &bmp
     // Set the clipping window
     bmp.setClipRect( getWindow().x + windowAddX, getWindow().y + windowAddY, getWindow().getX2() + windowAddX, getWindow().getY2() + windowAddY );
 
-    Tiler tiler(getTile(), currentX, currentY, addw, addh, sprite->getX(), sprite->getY(), sprite->getWidth(), sprite->getHeight(), bmp.getWidth(), bmp.getHeight());
-
-    Effects effects = getEffects();
-    effects.filter = filter;
-    while (tiler.hasMore()){
-        Point where = tiler.nextPoint();
-        sprite->render(where.x, where.y, bmp, effects);
-    }
+    draw(currentX, currentY, bmp, filter);
 
 #if 0
     /* Render initial sprite */
@@ -1131,7 +1194,6 @@ name(name),
 timeStart(0),
 endTime(0),
 loopTime(-1),
-ticker(0),
 dontReset(false){
     class Walker: public Ast::Walker{
     public:
@@ -1159,7 +1221,8 @@ dontReset(false){
                     self.endTime = self.timeStart;
                 }
                 if (loop != -2){
-                    self.loopTime = loop;
+                    /* a looptime of 0 can't repeat anything */
+                    self.loopTime = loop > 0 ? loop : -1;
                     self.dontReset = true;
                 }
                 /*
@@ -1195,10 +1258,11 @@ dontReset(false){
 Controller::~Controller(){
 }
 
-void Controller::reset(){
-    if (!dontReset){
-        ticker = 0;
+int Controller::getLoopTime(int parentLoopTime) const {
+    if (dontReset){
+        return loopTime;
     }
+    return parentLoopTime;
 }
 
 /*! Null Controller doesn't do anything */
@@ -1209,7 +1273,7 @@ class NullController : public Controller{
 	}
         virtual ~NullController(){
 	}
-        virtual void act(){
+        virtual void apply(){
 	}
     private:
 };
@@ -1241,20 +1305,12 @@ class PosAddController : public Controller{
 	}
         virtual ~PosAddController(){
 	}
-        virtual void act(){
-	    if ( ticker >= timeStart && ticker <= endTime){
-		for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
-		    BackgroundElement *element = *i;
-		    element->setX(element->getX() + x);
-		    element->setY(element->getY() + y);
-		}
-	    }
-	    if (loopTime != -1){
-		if (ticker == loopTime){
-		    reset();
-		}
+        virtual void apply(){
+	    for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
+		BackgroundElement *element = *i;
+		element->setX(element->getX() + x);
+		element->setY(element->getY() + y);
 	    }
-	    ticker++;
 	}
     private:
         int x, y;
@@ -1289,20 +1345,12 @@ class PosSetController : public Controller{
         virtual ~PosSetController(){
 	}
 
-        virtual void act(){
-	    if ( ticker >= timeStart && ticker <= endTime){
-		for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
-		    BackgroundElement *element = *i;
-		    element->setX(x);
-		    element->setY(y);
-		}
-	    }
-	    if (loopTime != -1){
-		if (ticker == loopTime){
-		    reset();
-		}
+        virtual void apply(){
+	    for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
+		BackgroundElement *element = *i;
+		element->setX(x);
+		element->setY(y);
 	    }
-	    ticker++;
 	}
     private:
         int x, y;
@@ -1339,21 +1387,11 @@ public:
     virtual ~SinXController(){
     }
 
-    virtual void act(){
-        if (ticker >= timeStart && ticker <= endTime){
-            for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
-                BackgroundElement *element = *i;
-                element->setSinX(sin);
-            }
-        }
-
-        if (loopTime != -1){
-            if (ticker == loopTime){
-                reset();
-            }
+    virtual void apply(){
+        for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
+            BackgroundElement *element = *i;
+            element->setSinX(sin);
         }
-
-        ticker += 1;
     }
 
 private:
@@ -1386,19 +1424,11 @@ class SinYController : public Controller{
 	}
 	virtual ~SinYController(){
 	}
-	virtual void act(){
-	    if ( ticker >= timeStart && ticker <= endTime){
-		for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
-		    BackgroundElement *element = *i;
-		    element->setSinY(sin);
-		}
-	    }
-	    if (loopTime != -1){
-		if (ticker == loopTime){
-		    reset();
-		}
+	virtual void apply(){
+	    for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
+		BackgroundElement *element = *i;
+		element->setSinY(sin);
 	    }
-	    ticker++;
 	}
     private:
 	Sin sin;
@@ -1431,19 +1461,11 @@ class VelAddController : public Controller{
 	}
         virtual ~VelAddController(){
 	}
-        virtual void act(){
-	    if ( ticker >= timeStart && ticker <= endTime){
-		for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
-		    BackgroundElement *element = *i;
-		    element->setVelocity(element->getVelocityX() + x,element->getVelocityY() + y);
-		}
+        virtual void apply(){
+	    for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
+		BackgroundElement *element = *i;
+		element->setVelocity(element->getVelocityX() + x,element->getVelocityY() + y);
 	    }
-	    if (loopTime != -1){
-		if (ticker == loopTime){
-		    reset();
-		}
-	    }
-	    ticker++;
 	}
     private:
 	double x, y;
@@ -1476,19 +1498,11 @@ class VelSetController : public Controller{
 	}
         virtual ~VelSetController(){
 	}
-        virtual void act(){
-	    if ( ticker >= timeStart && ticker <= endTime){
-		for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
-		    BackgroundElement *element = *i;
-		    element->setVelocity(x, y);
-		}
-	    }
-	    if (loopTime != -1){
-		if (ticker == loopTime){
-		    reset();
-		}
+        virtual void apply(){
+	    for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
+		BackgroundElement *element = *i;
+		element->setVelocity(x, y);
 	    }
-	    ticker++;
 	}
     private:
 	double x, y;
@@ -1518,19 +1532,11 @@ class EnabledController : public Controller{
 	}
         virtual ~EnabledController(){
 	}
-        virtual void act(){
-	    if ( ticker >= timeStart && ticker <= endTime){
-		for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
-		    BackgroundElement *element = *i;
-		    element->setEnabled(enabled);
-		}
+        virtual void apply(){
+	    for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
+		BackgroundElement *element = *i;
+		element->setEnabled(enabled);
 	    }
-	    if (loopTime != -1){
-		if (ticker == loopTime){
-		    reset();
-		}
-	    }
-	    ticker++;
 	}
     private:
 	bool enabled;
@@ -1560,19 +1566,11 @@ class VisibleController : public Controller{
 	}
         virtual ~VisibleController(){
 	}
-        virtual void act(){
-	    if ( ticker >= timeStart && ticker <= endTime){
-		for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
-		    BackgroundElement *element = *i;
-		    element->setVisible(visible);
-		}
-	    }
-	    if (loopTime != -1){
-		if (ticker == loopTime){
-		    reset();
-		}
+        virtual void apply(){
+	    for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
+		BackgroundElement *element = *i;
+		element->setVisible(visible);
 	    }
-	    ticker++;
 	}
     private:
 	bool visible;
@@ -1615,22 +1613,14 @@ class AnimationController: public Controller {
         virtual ~AnimationController(){
 	}
 
-        virtual void act(){
-	    if ( ticker >= timeStart && ticker <= endTime){
-                if (animation != NULL){
-                    for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
-                        BackgroundElement *element = *i;
-                        /* FIXME: this cast looks dangerous. Explain it or remove it */
-                        ((AnimationElement *)element)->setAnimation(PaintownUtil::ReferenceCount<Animation>(new Animation(*animation)));
-                    }
-                }
-	    }
-	    if (loopTime != -1){
-		if (ticker == loopTime){
-		    reset();
+        virtual void apply(){
+	    if (animation != NULL){
+		for (std::vector< BackgroundElement *>::iterator i = elements.begin(); i != elements.end(); ++i){
+		    BackgroundElement *element = *i;
+		    /* FIXME: this cast looks dangerous. Explain it or remove it */
+		    ((AnimationElement *)element)->setAnimation(PaintownUtil::ReferenceCount<Animation>(new Animation(*animation)));
 		}
 	    }
-	    ticker++;
 	}
 
     private:
@@ -1642,7 +1632,7 @@ BackgroundController::BackgroundController(const std::string & name, Ast::Sectio
 name(name),
 ID(0),
 globalLooptime(-1),
-ticker(0){
+compiled(false){
     class Walker: public Ast::Walker{
     public:
         Walker(BackgroundController & self, Background & background, bool & hasID):
@@ -1700,28 +1690,138 @@ BackgroundController::~BackgroundController(){
     }
 }
 
+BackgroundController::Timeline::Timeline(int loopTime):
+loopTime(loopTime),
+ticker(0),
+lastTick(0),
+next(0){
+}
+
+BackgroundController::Timeline::Entry::Entry(unsigned int order, unsigned int timeline, Controller * controller):
+order(order),
+timeline(timeline),
+controller(controller){
+}
+
+static bool startsFirst(const BackgroundController::Timeline::Entry & a, const BackgroundController::Timeline::Entry & b){
+    if (a.controller->getStartTime() != b.controller->getStartTime()){
+        return a.controller->getStartTime() < b.controller->getStartTime();
+    }
+    return a.order < b.order;
+}
+
+/* Puts controllers that loop at the same time in a timeline, sorted by the
+ * time they start.
+ */
+void BackgroundController::compile(){
+    timelines.clear();
+    active.clear();
+    for (unsigned int order = 0; order < controllers.size(); order++){
+        Controller * controller = controllers[order];
+        if (controller == NULL){
+            continue;
+        }
+
+        int loop = controller->getLoopTime(globalLooptime);
+        unsigned int timeline = 0;
+        while (timeline < timelines.size() && timelines[timeline].loopTime != loop){
+            timeline += 1;
+        }
+
+        if (timeline == timelines.size()){
+            timelines.push_back(Timeline(loop));
+        }
+
+        timelines[timeline].controllers.push_back(Timeline::Entry(order, timeline, controller));
+        if (controller->getEndTime() > timelines[timeline].lastTick){
+            timelines[timeline].lastTick = controller->getEndTime();
+        }
+    }
+
+    for (vector<Timeline>::iterator it = timelines.begin(); it != timelines.end(); it++){
+        std::sort(it->controllers.begin(), it->controllers.end(), startsFirst);
+    }
+
+    compiled = true;
+}
+
+void BackgroundController::Timeline::start(vector<Entry> & active){
+    while (next < controllers.size() && controllers[next].controller->getStartTime() <= ticker){
+        const Entry & entry = controllers[next];
+        if (entry.controller->getEndTime() >= ticker){
+            vector<Entry>::iterator where = active.begin();
+            while (where != active.end() && where->order < entry.order){
+                where++;
+            }
+            active.insert(where, entry);
+        }
+        next += 1;
+    }
+}
+
+bool BackgroundController::Timeline::advance(){
+    /* done for good */
+    if (loopTime == -1 && next == controllers.size() && ticker > lastTick){
+        return false;
+    }
+
+    ticker += 1;
+    if (loopTime != -1 && ticker >= loopTime){
+        ticker = 0;
+        next = 0;
+        return true;
+    }
+    return false;
+}
+
+/* Only the controllers whose time has come are looked at. Ones that run
+ * together do so in the order they were defined in, even if they are in
+ * different timelines.
+ */
 void BackgroundController::act(){
-    for (std::vector< Controller *>::iterator i = controllers.begin(); i != controllers.end(); ++i){
-        Controller *controller = *i;
-        controller->act();
-    }
-    if (globalLooptime != -1){
-        if (ticker == globalLooptime){
-            ticker = 0;
-            for (std::vector< Controller *>::iterator i = controllers.begin(); i != controllers.end(); ++i){
-               Controller *controller = *i;
-               controller->reset();
+    if (!compiled){
+        compile();
+    }
+
+    for (vector<Timeline>::iterator it = timelines.begin(); it != timelines.end(); it++){
+        it->start(active);
+    }
+
+    unsigned int keep = 0;
+    for (unsigned int i = 0; i < active.size(); i++){
+        active[i].controller->apply();
+        if (active[i].controller->getEndTime() > timelines[active[i].timeline].ticker){
+            active[keep] = active[i];
+            keep += 1;
+        }
+    }
+    active.resize(keep, Timeline::Entry(0, 0, NULL));
+
+    for (unsigned int timeline = 0; timeline < timelines.size(); timeline++){
+        if (timelines[timeline].advance()){
+            /* everything in it starts over */
+            keep = 0;
+            for (unsigned int i = 0; i < active.size(); i++){
+                if (active[i].timeline != timeline){
+                    active[keep] = active[i];
+                    keep += 1;
+                }
             }
+            active.resize(keep, Timeline::Entry(0, 0, NULL));
         }
-        ticker++;
     }
 }
 
+int BackgroundController::getActiveControllers() const {
+    return active.size();
+}
+
 Background::Background(const Filesystem::AbsolutePath &file, const std::string &header):
 file(file),
 header(header),
 debug(false),
-clearColor(Graphics::MaskColor()){
+clearColor(Graphics::MaskColor()),
+madeLayers(false){
     TimeDifference diff;
     diff.startTime();
     AstRef parsed(Mugen::Util::parseDef(file));
@@ -1933,7 +2033,8 @@ clearColor(Graphics::MaskColor()){
 Background::Background(const AstRef & parsed, const string & header, const Mugen::SpriteMap & sprites):
 header(header),
 debug(false),
-clearColor(Graphics::MaskColor()){
+clearColor(Graphics::MaskColor()),
+madeLayers(false){
     // for linked position in backgrounds
     BackgroundElement * priorElement = NULL;
     /* use the sprites that are passed in unless the background has a def
@@ -2122,6 +2223,14 @@ Background::~Background(){
             delete controller;
         }
     }
+
+    for (vector<BackgroundLayer *>::iterator i = backgroundLayers.begin(); i != backgroundLayers.end(); ++i){
+        delete *i;
+    }
+
+    for (vector<BackgroundLayer *>::iterator i = foregroundLayers.begin(); i != foregroundLayers.end(); ++i){
+        delete *i;
+    }
 }
 void Background::act(){
     // Backgrounds
@@ -2142,6 +2251,172 @@ void Background::act(){
     }
 }
 
+/* How far past the screen a composited layer is drawn, as a fraction of the
+ * screen. The camera moves a lot more sideways than up and down.
+ */
+static const int COMPOSITE_MARGIN_X = 2;
+static const int COMPOSITE_MARGIN_Y = 4;
+/* A single element is only composited if it covers at least this fraction
+ * of the screen, otherwise drawing it is cheaper than moving the cache.
+ */
+static const int COMPOSITE_AREA = 2;
+
+BackgroundLayer::BackgroundLayer(BackgroundElement * first, bool composite):
+composite(composite),
+deltaX(first->getDeltaX()),
+deltaY(first->getDeltaY()),
+builtX(0),
+builtY(0){
+    elements.push_back(first);
+}
+
+BackgroundLayer::~BackgroundLayer(){
+}
+
+bool BackgroundLayer::accepts(BackgroundElement * element, bool composite) const {
+    if (!this->composite){
+        return !composite;
+    }
+
+    return composite && element->getDeltaX() == deltaX && element->getDeltaY() == deltaY;
+}
+
+void BackgroundLayer::add(BackgroundElement * element){
+    elements.push_back(element);
+}
+
+void BackgroundLayer::append(const BackgroundLayer & layer){
+    elements.insert(elements.end(), layer.elements.begin(), layer.elements.end());
+}
+
+bool BackgroundLayer::worthCompositing() const {
+    if (elements.size() > 1){
+        return true;
+    }
+
+    int area = 0;
+    for (vector<BackgroundElement *>::const_iterator it = elements.begin(); it != elements.end(); it++){
+        area += (*it)->getCoveredArea();
+    }
+    return area >= DEFAULT_WINDOW_WIDTH * DEFAULT_WINDOW_HEIGHT / COMPOSITE_AREA;
+}
+
+void BackgroundLayer::build(int cameraX, int cameraY, const Graphics::Bitmap & work){
+    const int marginX = work.getWidth() / COMPOSITE_MARGIN_X;
+    const int marginY = work.getHeight() / COMPOSITE_MARGIN_Y;
+    if (cache == NULL || cache->getWidth() != work.getWidth() + marginX * 2 || cache->getHeight() != work.getHeight() + marginY * 2){
+        cache = PaintownUtil::ReferenceCount<Graphics::Bitmap>(new Graphics::Bitmap(work.getWidth() + marginX * 2, work.getHeight() + marginY * 2));
+    }
+
+    cache->clearToMask();
+    for (vector<BackgroundElement *>::iterator it = elements.begin(); it != elements.end(); it++){
+        (*it)->renderComposite(cameraX, cameraY, cache->getWidth() / 2, marginY, *cache);
+    }
+
+    builtX = (int) (cameraX * deltaX);
+    builtY = (int) (cameraY * deltaY);
+}
+
+void BackgroundLayer::render(int cameraX, int cameraY, const Graphics::Bitmap & work, Graphics::Bitmap::Filter * filter){
+    /* palette effects change the colors every frame */
+    if (!composite || filter != NULL){
+        for (vector<BackgroundElement *>::iterator it = elements.begin(); it != elements.end(); it++){
+            (*it)->render(cameraX, cameraY, work, filter);
+        }
+        return;
+    }
+
+    const int marginX = work.getWidth() / COMPOSITE_MARGIN_X;
+    const int marginY = work.getHeight() / COMPOSITE_MARGIN_Y;
+
+    /* how far the elements moved since the cache was drawn */
+    int moveX = builtX - (int) (cameraX * deltaX);
+    int moveY = builtY - (int) (cameraY * deltaY);
+    if (cache == NULL ||
+        cache->getWidth() != work.getWidth() + marginX * 2 ||
+        cache->getHeight() != work.getHeight() + marginY * 2 ||
+        moveX < -marginX || moveX > marginX ||
+        moveY < -marginY || moveY > marginY){
+        build(cameraX, cameraY, work);
+        moveX = 0;
+        moveY = 0;
+    }
+
+    cache->draw(moveX - marginX, moveY - marginY, work);
+}
+
+int Background::getActiveControllers() const {
+    int total = 0;
+    for (vector<BackgroundController *>::const_iterator it = controllers.begin(); it != controllers.end(); it++){
+        total += (*it)->getActiveControllers();
+    }
+    return total;
+}
+
+int Background::getControllerCount() const {
+    int total = 0;
+    for (vector<BackgroundController *>::const_iterator it = controllers.begin(); it != controllers.end(); it++){
+        total += (*it)->getControllers().size();
+    }
+    return total;
+}
+
+void Background::makeLayers(const vector<BackgroundElement *> & elements, vector<BackgroundLayer *> & layers){
+    /* anything a controller can change is drawn by itself */
+    std::set<BackgroundElement *> controlled;
+    for (vector<BackgroundController *>::iterator it = controllers.begin(); it != controllers.end(); it++){
+        const vector<Controller *> & all = (*it)->getControllers();
+        for (vector<Controller *>::const_iterator controller = all.begin(); controller != all.end(); controller++){
+            if (*controller != NULL){
+                controlled.insert((*controller)->getElements().begin(), (*controller)->getElements().end());
+            }
+        }
+    }
+
+    vector<BackgroundLayer *> runs;
+    for (vector<BackgroundElement *>::const_iterator it = elements.begin(); it != elements.end(); it++){
+        BackgroundElement * element = *it;
+        bool composite = controlled.find(element) == controlled.end() && element->canComposite();
+        if (!runs.empty() && runs.back()->accepts(element, composite)){
+            runs.back()->add(element);
+        } else {
+            runs.push_back(new BackgroundLayer(element, composite));
+        }
+    }
+
+    /* runs that aren't worth a cache are drawn element by element along with
+     * their neighbours
+     */
+    for (vector<BackgroundLayer *>::iterator it = runs.begin(); it != runs.end(); it++){
+        BackgroundLayer * run = *it;
+        if (run->isComposite() && !run->worthCompositing()){
+            run->setComposite(false);
+        }
+
+        if (!run->isComposite() && !layers.empty() && !layers.back()->isComposite()){
+            layers.back()->append(*run);
+            delete run;
+        } else {
+            layers.push_back(run);
+        }
+    }
+}
+
+void Background::makeLayers(){
+    makeLayers(backgrounds, backgroundLayers);
+    makeLayers(foregrounds, foregroundLayers);
+    madeLayers = true;
+
+    int composited = 0;
+    for (vector<BackgroundLayer *>::iterator it = backgroundLayers.begin(); it != backgroundLayers.end(); it++){
+        composited += (*it)->isComposite() ? 1 : 0;
+    }
+    for (vector<BackgroundLayer *>::iterator it = foregroundLayers.begin(); it != foregroundLayers.end(); it++){
+        composited += (*it)->isComposite() ? 1 : 0;
+    }
+    Global::debug(1) << "Background has " << (backgrounds.size() + foregrounds.size()) << " elements in " << (backgroundLayers.size() + foregroundLayers.size()) << " layers, " << composited << " composited" << endl;
+}
+
 void Background::renderBackground(int x, int y, const Graphics::Bitmap &bmp, Graphics::Bitmap::Filter * filter){
     if (clearColor != Graphics::MaskColor()){
 	bmp.fill(clearColor);
@@ -2151,16 +2426,22 @@ void Background::renderBackground(int x, int y, const Graphics::Bitmap &bmp, Gra
 	bmp.fill(Graphics::MaskColor());
     }
 
-    for( vector< BackgroundElement *>::iterator i = backgrounds.begin(); i != backgrounds.end(); ++i ){
-	BackgroundElement *element = *i;
-	element->render(x, y, bmp, filter);
+    if (!madeLayers){
+        makeLayers();
+    }
+
+    for (vector<BackgroundLayer *>::iterator i = backgroundLayers.begin(); i != backgroundLayers.end(); ++i){
+	(*i)->render(x, y, bmp, filter);
     }
 }
 
 void Background::renderForeground(int x, int y, const Graphics::Bitmap &bmp, Graphics::Bitmap::Filter * filter){
-    for( vector< BackgroundElement *>::iterator i = foregrounds.begin(); i != foregrounds.end(); ++i ){
-	BackgroundElement *element = *i;
-	element->render(x, y, bmp, filter);
+    if (!madeLayers){
+        makeLayers();
+    }
+
+    for (vector<BackgroundLayer *>::iterator i = foregroundLayers.begin(); i != foregroundLayers.end(); ++i){
+	(*i)->render(x, y, bmp, filter);
     }
 }
 
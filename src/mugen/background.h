@@ -43,6 +43,22 @@ class BackgroundElement: public Element {
 	virtual void act();
 	virtual void render(int x, int y, const Graphics::Bitmap &, Graphics::Bitmap::Filter * filter = NULL) = 0;
 
+        /* True if the element only ever moves with the camera, so it can be
+         * drawn once into a bitmap shared with its neighbours. Elements a
+         * controller works on are never asked.
+         */
+        virtual bool canComposite() const;
+
+        /* Draw the element as if the center of the screen was at originX and
+         * the top at originY, without the window. Only called if canComposite()
+         */
+        virtual void renderComposite(int cameraX, int cameraY, int originX, int originY, const Graphics::Bitmap &);
+
+        /* About how many pixels the element draws on a screen of the default
+         * size. Only asked of elements that can be composited.
+         */
+        virtual int getCoveredArea() const;
+
         //! Set the passed element to this elements values, this is called when the next element is linked to this one
         virtual void setLink(BackgroundElement *element);
 
@@ -260,10 +276,15 @@ class NormalElement : public BackgroundElement {
 	virtual ~NormalElement();
 	virtual void act();
 	virtual void render(int x, int y, const Graphics::Bitmap &, Graphics::Bitmap::Filter * filter = NULL);
+        virtual bool canComposite() const;
+        virtual void renderComposite(int cameraX, int cameraY, int originX, int originY, const Graphics::Bitmap &);
+        virtual int getCoveredArea() const;
 	virtual inline void setSprite(PaintownUtil::ReferenceCount<Mugen::Sprite> sprite){
 	    this->sprite = sprite;
 	}
     private:
+        void draw(int currentX, int currentY, const Graphics::Bitmap &, Graphics::Bitmap::Filter * filter);
+
 	//! Sprite Based
 	PaintownUtil::ReferenceCount<Mugen::Sprite> sprite;
 };
@@ -346,14 +367,29 @@ class Controller {
         Controller(const std::string & name, Ast::Section * data, BackgroundController & control, Background & background);
         virtual ~Controller();
 
-        virtual void act()=0;
-        /*! Reset Counter */
-        virtual void reset();
+ 
+        /*! Do whatever the controller does to its elements, called every tick between its start and end time */
+        virtual void apply()=0;
+
+        virtual inline int getStartTime() const {
+            return timeStart;
+        }
+
+        virtual inline int getEndTime() const {
+            return endTime;
+        }
+
+        /*! Its own looptime if it has one, otherwise the one of its BackgroundController. -1 is no loop */
+        virtual int getLoopTime(int parentLoopTime) const;
         
         virtual inline void addElements(const std::vector<BackgroundElement *> & elements){
 	    this->elements.insert(this->elements.end(), elements.begin(), elements.end());
 	}
 
+        virtual inline const std::vector<BackgroundElement *> & getElements() const {
+            return this->elements;
+        }
+
     protected:
         /*! Name of controller */
         std::string name;
@@ -363,8 +399,6 @@ class Controller {
 	int endTime;
         /*! How many ticks before controller is reset (-1 means no reset) */
 	int loopTime;
-        /*! Tick handler */
-	int ticker;
         /*! Current Elements this controller has governance over */
         std::vector< BackgroundElement * > elements;
 
@@ -375,6 +409,39 @@ class Controller {
 /*! Background Controller */
 class BackgroundController{
     public:
+        /*! Controllers that restart at the same time, sorted by their start
+         * time so each tick only looks at the ones that are running.
+         */
+        struct Timeline{
+            Timeline(int loopTime);
+
+            struct Entry{
+                Entry(unsigned int order, unsigned int timeline, Controller * controller);
+
+                /*! position in the definition file */
+                unsigned int order;
+                /*! index of the timeline the controller is in */
+                unsigned int timeline;
+                Controller * controller;
+            };
+
+            /*! Adds the controllers that start now to `active', which is kept
+             * in definition order
+             */
+            void start(std::vector<Entry> & active);
+
+            /*! Moves to the next tick, true if the timeline started over */
+            bool advance();
+
+            int loopTime;
+            int ticker;
+            /*! the last tick any controller runs at, for timelines that don't loop */
+            int lastTick;
+            /*! next controller in `controllers' to start */
+            unsigned int next;
+            std::vector<Entry> controllers;
+        };
+
 	BackgroundController(const std::string & name, Ast::Section * data, Background & background);
 	virtual ~BackgroundController();
 	
@@ -394,6 +461,14 @@ class BackgroundController{
 
         virtual inline void addController(Controller * controller){
             this->controllers.push_back(controller);
+            compiled = false;
+        }
+
+        /*! Controllers running this tick */
+        virtual int getActiveControllers() const;
+
+        virtual inline const std::vector<Controller *> & getControllers() const {
+            return this->controllers;
         }
     private:
         /*! Name of controller */
@@ -402,12 +477,63 @@ class BackgroundController{
         int ID;
 	/*! Global Looptime if not given then it will be disabled. At looptime it will reset itself and all controllers. */
 	int globalLooptime;
-	/*! Ticker of Background Controller */ 
-	int ticker;
 	/*! BackgroundElement list */
 	std::vector < BackgroundElement *> elements;
 	/*! Controllers */
 	std::vector < Controller *> controllers;
+
+        void compile();
+        bool compiled;
+        std::vector<Timeline> timelines;
+        /*! Controllers of every timeline running now, in definition order, so
+         * ones that work on the same element run in the order they were
+         * defined in no matter how they loop.
+         */
+        std::vector<Timeline::Entry> active;
+};
+
+/*! A run of elements that are drawn one after the other. If they can all be
+ * composited and move the same amount with the camera they are drawn into a
+ * bitmap bigger than the screen, which is then just moved around until the
+ * camera gets past its edge.
+ */
+class BackgroundLayer{
+    public:
+        BackgroundLayer(BackgroundElement * first, bool composite);
+        virtual ~BackgroundLayer();
+
+        //! True if the element can be drawn as part of this layer
+        virtual bool accepts(BackgroundElement * element, bool composite) const;
+        virtual void add(BackgroundElement * element);
+        //! Takes the elements of a layer that comes right after this one
+        virtual void append(const BackgroundLayer & layer);
+
+        /*! A composited layer is drawn with one blit of the whole screen, which
+         * only pays off if it saves drawing a few elements or a lot of pixels.
+         */
+        virtual bool worthCompositing() const;
+
+        virtual void render(int cameraX, int cameraY, const Graphics::Bitmap &, Graphics::Bitmap::Filter * filter);
+
+        virtual inline bool isComposite() const {
+            return composite;
+        }
+
+        virtual inline void setComposite(bool composite){
+            this->composite = composite;
+        }
+
+    private:
+        void build(int cameraX, int cameraY, const Graphics::Bitmap & work);
+
+        std::vector<BackgroundElement *> elements;
+        bool composite;
+        double deltaX;
+        double deltaY;
+        PaintownUtil::ReferenceCount<Graphics::Bitmap> cache;
+        //! How far the elements had moved with the camera when the cache was drawn
+        int builtX;
+        int builtY;
 };
 
 /*! Our Background */
@@ -422,6 +548,10 @@ class Background{
 	virtual void act();
 	virtual void renderBackground(int cameraX, int cameraY, const Graphics::Bitmap &, Graphics::Bitmap::Filter * filter = NULL);
 	virtual void renderForeground(int cameraX, int cameraY, const Graphics::Bitmap &, Graphics::Bitmap::Filter * filter = NULL);
+
+        //! Background controllers running this tick, for debugging
+        virtual int getActiveControllers() const;
+        virtual int getControllerCount() const;
 	
         //! Returns a vector of Elements by given ID
         std::vector< BackgroundElement * > getIDList(int ID);
@@ -435,6 +565,8 @@ class Background{
         }
 
     private:
+        void makeLayers();
+        void makeLayers(const std::vector<BackgroundElement *> & elements, std::vector<BackgroundLayer *> & layers);
 	
 	//! File where background is in
         Filesystem::AbsolutePath file;
@@ -470,6 +602,11 @@ class Background{
 
         //! Controllers
         std::vector< BackgroundController *> controllers;
+
+        //! Backgrounds and foregrounds split into layers, made on the first render
+        bool madeLayers;
+        std::vector< BackgroundLayer *> backgroundLayers;
+        std::vector< BackgroundLayer *> foregroundLayers;
 };
     
 }
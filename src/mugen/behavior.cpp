@@ -8,7 +8,7 @@
 #include <r-tech1/funcs.h>
 // #include "command.h"
 #include "constraint.h"
-#include "random.h"
+#include "context.h"
 #include "character.h"
 #include "stage.h"
 
@@ -132,12 +132,9 @@ vector<string> HumanBehavior::currentCommands(const Mugen::Stage & stage, Charac
     // InputMap<Mugen::Keys>::Output output = InputManager::getMap(getInput(reversed));
     input = updateInput(getInput(reversed), input);
 
-    for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-        Command2 * command = *it;
-        if (command->handle(input, stage.getTicks())){
-            Global::debug(1) << "command: " << command->getName() << endl;
-            out.push_back(command->getName());
-        }
+    out = CommandSet::names(commands, matcher.handle(commands, input, stage.getTicks()));
+    for (vector<string>::const_iterator it = out.begin(); it != out.end(); it++){
+        Global::debug(1) << "command: " << *it << endl;
     }
 
     return out;
@@ -161,19 +158,19 @@ RandomAIBehavior::RandomAIBehavior(){
 void RandomAIBehavior::flip(){
 }
 
-static string randomCommand(const vector<Command2*> & commands){
+static string randomCommand(MatchContext & context, const vector<Command2*> & commands){
     if (commands.size() == 0){
         return "";
     }
 
-    int choice = Mugen::random(commands.size());
+    int choice = context.random(commands.size());
     return commands[choice]->getName();
 }
 
 vector<string> RandomAIBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, const vector<Command2*> & commands, bool reversed){
     vector<string> out;
-    if (Mugen::random(100) > 90){
-        out.push_back(randomCommand(commands));
+    if (stage.getContext().random(100) > 90){
+        out.push_back(randomCommand(stage.getContext(), commands));
     }
     return out;
 }
@@ -182,41 +179,34 @@ RandomAIBehavior::~RandomAIBehavior(){
 }
 
 LearningAIBehavior::LearningAIBehavior(int difficulty):
+boundOwner(NULL),
+boundGeneration(0),
+lastCommand(-1),
+lastBucket(0),
 direction(Forward),
 difficulty(difficulty),
 dontMove(0){
-    /* make walking more likely to begin with */
-    /*
-    moves["holdfwd"].points -= 10;
-    moves["holdfwd"].minimumDistance = 999999;
-    moves["holdfwd"].maximumDistance = 0;
-    moves["holdback"].points -= 10;
-    moves["holdback"].minimumDistance = 999999;
-    moves["holdback"].maximumDistance = 0;
-    */
-
-    /* this is just to give the AI a starting move that does nothing, this is
-     * basically a noop. eventualy the AI will learn other moves to do.
-     *
-     * the name is something that the user can't write for a command (hopefully) 
-     */
-    moves["not-possible+#$*(@#$"].points = 5;
-}
-
-/* the command with the most points will be chosen. points are tallied by
- * adding all the quantities associated with that move thus far. right now they are:
- *  - starting points is the number of times the move hit successfully
- *  - add points if the move is within range, where range is determined by the last
- *     successful hit for that command
- *  - add a random number of points to shake things up
- *  - subtract points if the move is out of range
- *  - subtract points based on the number of times the move has been tried
- *  - subtract points if the move has been done recently
- */
-string LearningAIBehavior::selectBestCommand(int distance, const vector<Command2*> & commands){
-    Move * currentMove = NULL;
-    string what = "";
-    double points = 0;
+}
+
+LearningAIBehavior::LearningAIBehavior(int difficulty, const PaintownUtil::ReferenceCount<AIPolicy> & policy):
+policy(policy),
+boundOwner(NULL),
+boundGeneration(0),
+lastCommand(-1),
+lastBucket(0),
+direction(Forward),
+difficulty(difficulty),
+dontMove(0){
+}
+
+void LearningAIBehavior::bind(Character * owner, const vector<Command2*> & commands){
+    if (policy == NULL){
+        policy = AIPolicy::forCharacter(owner->getLocation());
+    }
+
+    if (boundOwner == owner && boundGeneration == owner->getCommandsGeneration()){
+        return;
+    }
 
     for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
         string name = (*it)->getName();
@@ -229,48 +219,40 @@ string LearningAIBehavior::selectBestCommand(int distance, const vector<Command2
             continue;
         }
 
-        Move & move = moves[name];
-        double morePoints = move.points + Mugen::random(10);
-        if (move.minimumDistance != -1){
-            if (distance < move.maximumDistance + 10 && distance > move.minimumDistance - 10){
-                morePoints += 2;
-            } else if (distance > move.maximumDistance + 10){
-                morePoints -= 3;
-            }
-        }
+        policy->intern(name);
+    }
+    boundOwner = owner;
+    boundGeneration = owner->getCommandsGeneration();
+}
 
-        morePoints -= log((double) move.attempts * 3);
-        morePoints -= move.consecutive * 2;
-
-        if (currentMove == NULL){
-            currentMove = &move;
-            what = name;
-            points = morePoints;
-        } else if (morePoints > points){
-            currentMove = &move;
-            what = name;
-            points = morePoints;
-        }
+/* Usually one of the commands that hit most often from about this distance,
+ * and while learning sometimes any command at all so the ones that haven't
+ * worked so far still get tried.
+ */
+string LearningAIBehavior::selectBestCommand(MatchContext & context, int distance){
+    int bucket = AIPolicy::bucket(distance);
+    int command = -1;
+    if (policy->isLearning() && context.random(4) == 0){
+        command = policy->explore(context.random(0x10000));
+    } else {
+        command = policy->choose(bucket, context.random(8));
     }
 
-    for (map<string, Move>::iterator it = moves.begin(); it != moves.end(); it++){
-        Move & move = (*it).second;
-        if (currentMove != &move){
-            move.consecutive /= 2;
-        }
+    if (command == -1){
+        return "";
     }
-        
-    currentMove->attempts += 1;
-    currentMove->consecutive += 1;
 
-    return what;
+    policy->attempted(command, bucket);
+    lastCommand = command;
+    lastBucket = bucket;
+    return policy->getName(command);
 }
     
 void LearningAIBehavior::flip(){
 }
 
-static LearningAIBehavior::Direction randomDirection(){
-    int what = Mugen::random(100);
+static LearningAIBehavior::Direction randomDirection(MatchContext & context){
+    int what = context.random(100);
     if (what > 70){
         return LearningAIBehavior::Forward;
     } else if (what > 40){
@@ -285,15 +267,18 @@ static LearningAIBehavior::Direction randomDirection(){
 vector<string> LearningAIBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, const vector<Command2*> & commands, bool reversed){
 
     vector<string> out;
+    MatchContext & context = stage.getContext();
+
+    bind(owner, commands);
 
     /* maybe attack */
-    if ((int) Mugen::random(200) < difficulty * 2){
+    if ((int) context.random(200) < difficulty * 2){
         const Character * enemy = stage.getEnemy(owner);
         int xDistance = (int) fabs(owner->getX() - enemy->getX());
-        string command = selectBestCommand(xDistance, commands);
-        out.push_back(command);
-        lastCommand = command;
-        lastDistance = xDistance;
+        string command = selectBestCommand(context, xDistance);
+        if (command != ""){
+            out.push_back(command);
+        }
     } else {
         /* otherwise move around */
         dontMove += 1;
@@ -307,13 +292,13 @@ vector<string> LearningAIBehavior::currentCommands(const Mugen::Stage & stage, C
         }
             
         /* after keeping a direction for 40 ticks, maybe change directions */
-        if (dontMove > 40 && Mugen::random(10) > 8){
-            direction = randomDirection();
+        if (dontMove > 40 && context.random(10) > 8){
+            direction = randomDirection(context);
             dontMove = 0;
         }
 
         /* make the AI jump sometimes */
-        if (Mugen::random(100) == 0){
+        if (context.random(100) == 0){
             out.push_back("holdup");
         }
     }
@@ -321,20 +306,14 @@ vector<string> LearningAIBehavior::currentCommands(const Mugen::Stage & stage, C
     return out;
 }
 
-/* hit succeeded, reinforce learning behavior for that move */
+/* hit succeeded, reinforce learning behavior for that move. a move that hits
+ * more than once only counts once so the hits of a command are never more
+ * than its attempts.
+ */
 void LearningAIBehavior::hit(Object * enemy){
-    Move & move = moves[lastCommand];
-    move.points += 1;
-    if (move.points > 5){
-        move.points = 5;
-    }
-
-    if (move.maximumDistance == -1 || lastDistance > move.maximumDistance){
-        move.maximumDistance = lastDistance;
-    }
-
-    if (move.minimumDistance == -1 || lastDistance < move.minimumDistance){
-        move.minimumDistance = lastDistance;
+    if (policy != NULL && lastCommand != -1){
+        policy->hit(lastCommand, lastBucket);
+        lastCommand = -1;
     }
 }
 
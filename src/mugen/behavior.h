@@ -6,6 +6,8 @@
 #include "util.h"
 #include <r-tech1/input/input-map.h>
 #include "command.h"
+#include "constraint.h"
+#include "ai-policy.h"
 
 namespace Mugen{
 
@@ -13,6 +15,7 @@ class Object;
 class Character;
 class Command2;
 class Stage;
+class MatchContext;
 
 /* handles input and tells the character what commands to invoke */
 class Behavior{
@@ -54,6 +57,7 @@ protected:
     InputMap<Keys> right;
     InputMap<Keys> left;
     Mugen::Input input;
+    CommandSet matcher;
 };
 
 /* dummy does absolutely nothing */
@@ -103,12 +107,14 @@ protected:
 };
 
 /* This behavior will attempt to learn which moves do damage and how likely
- * they are to hit.
+ * they are to hit. What it learns goes in the AIPolicy of the character,
+ * which can be trained ahead of time (see run-match --train).
  */
 class LearningAIBehavior: public Behavior {
 public:
-    /* 1 is easy, 10 is hard */
+    /* 1 is easy, 10 is hard. uses the policy saved for the character */
     LearningAIBehavior(int difficult);
+    LearningAIBehavior(int difficult, const PaintownUtil::ReferenceCount<AIPolicy> & policy);
 
     virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed);
     virtual void flip();
@@ -117,43 +123,25 @@ public:
 
     virtual ~LearningAIBehavior();
 
-    /* stores information about the player when the move was executed */
-    struct Move{
-        Move():
-        points(0),
-        attempts(0),
-        consecutive(0),
-        minimumDistance(-1),
-        maximumDistance(-1){
-        }
-
-        /* times the move succeeded */
-        int points;
-
-        /* times the move was tried */
-        int attempts;
-
-        /* how many consecutive times this move was tried */
-        double consecutive;
-
-        /* minimum known distance the move succeeded */
-        int minimumDistance;
-
-        /* maximum known distance the move succeeded */
-        int maximumDistance;
-    };
-    
     enum Direction{
         Forward, Backward, Crouch, Stopped
     };
 
 protected:
-    std::string selectBestCommand(int distance, const std::vector<Command2*> & commands);
+    /* interns the commands of the character in the policy */
+    void bind(Character * owner, const std::vector<Command2*> & commands);
+    std::string selectBestCommand(MatchContext & context, int distance);
 
-    std::map<std::string, Move> moves;
+    PaintownUtil::ReferenceCount<AIPolicy> policy;
+    /* the character whose commands were interned last and the generation of
+     * its commands at the time, a new generation means it was reloaded
+     */
+    const Character * boundOwner;
+    unsigned int boundGeneration;
 
-    std::string lastCommand;
-    int lastDistance;
+    /* policy ids */
+    int lastCommand;
+    int lastBucket;
     Direction direction;
     int difficulty;
     int dontMove;
@@ -0,0 +1,159 @@
+#include "broad-phase.h"
+#include "animation.h"
+
+using std::vector;
+
+namespace Mugen{
+
+BroadPhase::BroadPhase():
+widest(0),
+visited(0){
+}
+
+BroadPhase::~BroadPhase(){
+}
+
+void BroadPhase::clear(){
+    entries.clear();
+    where.clear();
+    widest = 0;
+    visited = 0;
+}
+
+/* Moves the entry at `index' left or right until the entries are sorted again.
+ * Things don't move much between updates so this is usually one or two swaps.
+ */
+void BroadPhase::place(unsigned int index){
+    while (index > 0 && entries[index - 1].left > entries[index].left){
+        Entry temp = entries[index - 1];
+        entries[index - 1] = entries[index];
+        entries[index] = temp;
+        where[entries[index].id] = index;
+        index -= 1;
+    }
+
+    while (index + 1 < entries.size() && entries[index + 1].left < entries[index].left){
+        Entry temp = entries[index + 1];
+        entries[index + 1] = entries[index];
+        entries[index] = temp;
+        where[entries[index].id] = index;
+        index += 1;
+    }
+
+    where[entries[index].id] = index;
+}
+
+void BroadPhase::update(int id, int left, int right){
+    if (id < 0){
+        return;
+    }
+
+    if (id >= (int) where.size()){
+        where.resize(id + 1, -1);
+    }
+
+    if (right - left > widest){
+        widest = right - left;
+    }
+
+    if (where[id] == -1){
+        Entry entry;
+        entry.id = id;
+        entry.left = left;
+        entry.right = right;
+        entries.push_back(entry);
+        place(entries.size() - 1);
+    } else {
+        Entry & entry = entries[where[id]];
+        entry.left = left;
+        entry.right = right;
+        place(where[id]);
+    }
+}
+
+void BroadPhase::remove(int id){
+    if (id < 0 || id >= (int) where.size() || where[id] == -1){
+        return;
+    }
+
+    unsigned int index = where[id];
+    entries.erase(entries.begin() + index);
+    where[id] = -1;
+    for (unsigned int i = index; i < entries.size(); i++){
+        where[entries[i].id] = i;
+    }
+}
+
+void BroadPhase::query(int left, int right, vector<int> & out) const {
+    /* Nothing that starts before this can reach `left' */
+    const int start = left - widest;
+
+    unsigned int low = 0;
+    unsigned int high = entries.size();
+    while (low < high){
+        unsigned int middle = (low + high) / 2;
+        if (entries[middle].left < start){
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (unsigned int index = low; index < entries.size() && entries[index].left <= right; index++){
+        visited += 1;
+        if (entries[index].right >= left){
+            out.push_back(entries[index].id);
+        }
+    }
+}
+
+bool BroadPhase::find(int id, int & left, int & right) const {
+    if (id < 0 || id >= (int) where.size() || where[id] == -1){
+        return false;
+    }
+
+    left = entries[where[id]].left;
+    right = entries[where[id]].right;
+    return true;
+}
+
+/* Area::collision accepts boxes whose corners are in any order */
+bool BroadPhase::extent(const vector<Area> & boxes, int x, int & left, int & right){
+    bool any = false;
+    for (vector<Area>::const_iterator it = boxes.begin(); it != boxes.end(); it++){
+        const Area & area = *it;
+        int low = area.x1 < area.x2 ? area.x1 : area.x2;
+        int high = area.x1 < area.x2 ? area.x2 : area.x1;
+        if (!any || low + x < left){
+            left = low + x;
+        }
+        if (!any || high + x > right){
+            right = high + x;
+        }
+        any = true;
+    }
+
+    return any;
+}
+
+bool BroadPhase::extent(const vector<Area> & boxes1, const vector<Area> & boxes2, int x, int & left, int & right){
+    int left2 = 0;
+    int right2 = 0;
+    bool first = extent(boxes1, x, left, right);
+    bool second = extent(boxes2, x, left2, right2);
+    if (first && second){
+        if (left2 < left){
+            left = left2;
+        }
+        if (right2 > right){
+            right = right2;
+        }
+    } else if (second){
+        left = left2;
+        right = right2;
+    }
+
+    return first || second;
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef _paintown_mugen_broad_phase_h
+#define _paintown_mugen_broad_phase_h
+
+#include <vector>
+
+namespace Mugen{
+
+class Area;
+
+/* Sweep and prune along the x axis. Every entry is the horizontal extent of
+ * all the collision boxes of one thing on the stage, kept sorted by its left
+ * edge so that finding the things that could possibly touch some extent
+ * doesn't have to look at everything. Only pairs that overlap here need to
+ * have their boxes compared.
+ *
+ * Entries are identified by a small integer chosen by the caller.
+ */
+class BroadPhase{
+public:
+    BroadPhase();
+    virtual ~BroadPhase();
+
+    void clear();
+
+    /* Add `id' or move it to cover left to right, inclusive */
+    void update(int id, int left, int right);
+    void remove(int id);
+
+    /* Appends the ids of all entries that overlap left to right. The order
+     * of the ids is not defined.
+     */
+    void query(int left, int right, std::vector<int> & out) const;
+
+    /* Where `id' is right now. Returns false if it isn't there. */
+    bool find(int id, int & left, int & right) const;
+
+    /* Extent of `boxes' at position x. Returns false if there are no boxes. */
+    static bool extent(const std::vector<Area> & boxes, int x, int & left, int & right);
+    static bool extent(const std::vector<Area> & boxes1, const std::vector<Area> & boxes2, int x, int & left, int & right);
+
+    /* Number of entries that were looked at by query() since the last clear() */
+    inline unsigned int getVisited() const {
+        return visited;
+    }
+
+protected:
+    struct Entry{
+        int left;
+        int right;
+        int id;
+    };
+
+    void place(unsigned int index);
+
+    std::vector<Entry> entries;
+    /* index into `entries' for each id, -1 if the id isn't there */
+    std::vector<int> where;
+    /* widest entry seen since the last clear() */
+    int widest;
+    mutable unsigned int visited;
+};
+
+}
+
+#endif
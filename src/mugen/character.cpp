@@ -22,6 +22,7 @@
 #include <r-tech1/timedifference.h>
 #include <r-tech1/debug.h>
 #include <r-tech1/message-queue.h>
+#include <r-tech1/thread.h>
 #include "factory/font_render.h"
 
 #include "animation.h"
@@ -483,18 +484,32 @@ void Character::setZ(double what){
 }
     
 void Character::setX(double what){
-    getStateData().virtualx = what;
+    if (hotState != NULL){
+        hotState->x[hotSlot] = what;
+    } else {
+        getStateData().virtualx = what;
+    }
 }
 
 void Character::setY(double what){
-    getStateData().virtualy = what;
+    if (hotState != NULL){
+        hotState->y[hotSlot] = what;
+    } else {
+        getStateData().virtualy = what;
+    }
 }
 
 double Character::getY() const {
+    if (hotState != NULL){
+        return hotState->y[hotSlot];
+    }
     return getStateData().virtualy;
 }
 
 double Character::getX() const {
+    if (hotState != NULL){
+        return hotState->x[hotSlot];
+    }
     return getStateData().virtualx;
 }
 
@@ -573,11 +588,14 @@ Object(alliance){
 Character::Character(const Character & copy):
 Object(copy),
 stateControllerId(copy.stateControllerId),
+hotState(NULL),
+hotSlot(-1),
 localData(copy.localData),
-stateData(copy.stateData){
+stateData(copy.snapshotStateData()){
 }
 
 Character::~Character(){
+    unbindHotState();
     stopRecording();
     for (vector<Command2*>::iterator it = getLocalData().commands.begin(); it != getLocalData().commands.end(); it++){
         delete (*it);
@@ -586,12 +604,14 @@ Character::~Character(){
 
 void Character::initialize(){
     stateControllerId = 0;
+    hotState = NULL;
+    hotSlot = -1;
 
     getLocalData().max_health = 0;
     getStateData().health = 0;
     getLocalData().maxChangeStates = 0;
     getStateData().currentState = Standing;
-    getStateData().currentPhysics = Physics::Stand;
+    setCurrentPhysics(Physics::Stand);
     setMoveType(Move::Idle);
     getStateData().wasHitCounter = 0;
     getStateData().frozen = false;
@@ -642,8 +662,8 @@ void Character::initialize(){
     getLocalData().runforwardy = 0;
     getStateData().power = 0;
 
-    getStateData().velocity_x = 0;
-    getStateData().velocity_y = 0;
+    setXVelocity(0);
+    setYVelocity(0);
 
     getLocalData().gravity = 0.1;
     getLocalData().standFriction = 0.85;
@@ -714,6 +734,7 @@ static void mergeStates(map<int, PaintownUtil::ReferenceCount<State> > & mergeIn
 
 void Character::loadCmdFile(const Filesystem::RelativePath & path){
     Filesystem::AbsolutePath full = Storage::instance().lookupInsensitive(getLocalData().baseDir, path);
+    watchFile(full);
     map<int, PaintownUtil::ReferenceCount<State> > out;
     try{
         int defaultTime = 15;
@@ -1108,8 +1129,13 @@ void Character::changeOwnState(Mugen::Stage & stage, int state, const std::vecto
     changeState(stage, state);
 }
 
+Filesystem::AbsolutePath Character::findCnsFile(const Filesystem::RelativePath & path) const {
+    return Storage::instance().findInsensitive(Storage::instance().cleanse(getLocalData().baseDir).join(path));
+}
+
 void Character::loadCnsFile(const Filesystem::RelativePath & path){
-    Filesystem::AbsolutePath full = Storage::instance().findInsensitive(Storage::instance().cleanse(getLocalData().baseDir).join(path));
+    Filesystem::AbsolutePath full = findCnsFile(path);
+    watchFile(full);
     try{
         /* cns can use the Cmd parser */
         AstRef parsed(Util::parseCmd(full));
@@ -1561,6 +1587,8 @@ PaintownUtil::ReferenceCount<State> Character::parseStateDefinition(Ast::Section
         
 static map<string, StateController::Type> types;
 static bool typesSetup = false;
+/* characters can be loaded by more than one thread at a time */
+static PaintownUtil::Thread::LockObject typesLock;
 
 StateController * Character::parseState(Ast::Section * section){
     std::string head = section->getName();
@@ -1573,8 +1601,8 @@ StateController * Character::parseState(Ast::Section * section){
     public:
         StateControllerWalker():
         type(StateController::Unknown){
+            PaintownUtil::Thread::ScopedLock locked(typesLock);
             if (!typesSetup){
-                typesSetup = true;
                 types["afterimage"] = StateController::AfterImage;
                 types["afterimagetime"] = StateController::AfterImageTime;
                 types["allpalfx"] = StateController::AllPalFX;
@@ -1664,6 +1692,7 @@ StateController * Character::parseState(Ast::Section * section){
                 types["width"] = StateController::Width;
                 types["zoom"] = StateController::Zoom;
                 types["debug"] = StateController::Debug;
+                typesSetup = true;
             }
         }
 
@@ -1728,6 +1757,7 @@ static Filesystem::AbsolutePath findStateFile(const Filesystem::AbsolutePath & b
         
 void Character::loadStateFile(const Filesystem::AbsolutePath & base, const string & path){
     Filesystem::AbsolutePath full = findStateFile(base, path);
+    watchFile(full);
     MessageQueue::info("Reading " + Storage::instance().cleanse(full).path());
     PaintownUtil::Parameter<Filesystem::RelativePath> currentFile(stateFileParameter, Storage::instance().cleanse(full));
     // string full = Filesystem::find(base + "/" + PaintownUtil::trim(path));
@@ -1939,6 +1969,7 @@ void Character::load(int useAct){
                                 string file;
                                 simple.view() >> file;
                                 /* just loads the constants */
+                                self.getLocalData().constantsFile = file;
                                 self.loadCnsFile(Filesystem::RelativePath(file));
                             } else if (PaintownUtil::matchRegex(PaintownUtil::lowerCaseAll(simple.idString()), PaintownUtil::Regex("st[0-9]+"))){
                                 int num = atoi(PaintownUtil::captureRegex(PaintownUtil::lowerCaseAll(simple.idString()), PaintownUtil::Regex("st([0-9]+)"), 0).c_str());
@@ -1994,6 +2025,7 @@ void Character::load(int useAct){
                  */
                 for (vector<Location>::iterator it = walker.stateFiles.begin(); it != walker.stateFiles.end(); it++){
                     Location & where = *it;
+                    getLocalData().stateFiles.push_back(make_pair(where.base, where.file));
                     try{
                         /* load definitions first */
                         loadStateFile(where.base, where.file);
@@ -2190,7 +2222,134 @@ void Character::loadGraphics(int palette){
     Util::readSprites(Storage::instance().lookupInsensitive(getLocalData().baseDir, Filesystem::RelativePath(getLocalData().sffFile)), finalPalette, getLocalData().sprites, true);
 
     Global::debug(2) << "Reading Air (animation) Data..." << endl;
-    getLocalData().animations = Util::loadAnimations(Storage::instance().lookupInsensitive(getLocalData().baseDir, Filesystem::RelativePath(getLocalData().airFile)), getLocalData().sprites, true);
+    Filesystem::AbsolutePath air = Storage::instance().lookupInsensitive(getLocalData().baseDir, Filesystem::RelativePath(getLocalData().airFile));
+    watchFile(air);
+    getLocalData().animations = Util::loadAnimations(air, getLocalData().sprites, true);
+}
+
+void Character::watchFile(const Filesystem::AbsolutePath & path){
+    getLocalData().sourceFiles[path] = ParseCache::modificationTime(path);
+}
+
+void Character::watchFiles(const vector<Filesystem::AbsolutePath> & paths){
+    for (vector<Filesystem::AbsolutePath>::const_iterator it = paths.begin(); it != paths.end(); it++){
+        watchFile(*it);
+    }
+}
+
+/* Loads all the state files and the cmd file again, and the constants if
+ * they changed. Files that didn't change come out of the parse cache so only
+ * the changed ones are parsed. If anything goes wrong the character is left
+ * the way it was.
+ */
+void Character::reloadStates(bool constants){
+    LocalData old = getLocalData();
+    vector<Command2*> oldCommands = getLocalData().commands;
+    getLocalData().states.clear();
+    getLocalData().commands.clear();
+
+    try{
+        if (constants){
+            loadCnsFile(Filesystem::RelativePath(getLocalData().constantsFile));
+        }
+
+        for (vector<pair<Filesystem::AbsolutePath, string> >::iterator it = getLocalData().stateFiles.begin(); it != getLocalData().stateFiles.end(); it++){
+            try{
+                loadStateFile(it->first, it->second);
+            } catch (const Mugen::Cmd::ParseException & e){
+                ostringstream out;
+                out << "Problem loading state file " << it->second << ": " << e.getReason();
+                throw MugenException(out.str(), __FILE__, __LINE__);
+            }
+        }
+
+        loadCmdFile(getLocalData().cmdFile);
+    } catch (...){
+        /* keep playing with what we had */
+        for (vector<Command2*>::iterator it = getLocalData().commands.begin(); it != getLocalData().commands.end(); it++){
+            delete *it;
+        }
+        getLocalData() = old;
+        updateHotConstants();
+        throw;
+    }
+
+    for (vector<Command2*>::iterator it = oldCommands.begin(); it != oldCommands.end(); it++){
+        delete *it;
+    }
+    getLocalData().commandsGeneration += 1;
+
+    checkStateControllers();
+}
+
+void Character::reloadAnimations(){
+    Filesystem::AbsolutePath air = Storage::instance().lookupInsensitive(getLocalData().baseDir, Filesystem::RelativePath(getLocalData().airFile));
+    std::map<int, PaintownUtil::ReferenceCount<Animation> > animations = Util::loadAnimations(air, getLocalData().sprites, true);
+
+    /* carry on from the same spot in the current animation if it still has that many frames */
+    AnimationState state = getCurrentAnimationState();
+    getLocalData().animations = animations;
+    PaintownUtil::ReferenceCount<Animation> current = getCurrentAnimation();
+    if (current != NULL && state.position < current->getFrames().size()){
+        current->setState(state);
+    }
+}
+
+vector<Filesystem::AbsolutePath> Character::reloadChangedFiles(){
+    vector<Filesystem::AbsolutePath> changed;
+    for (map<Filesystem::AbsolutePath, int>::iterator it = getLocalData().sourceFiles.begin(); it != getLocalData().sourceFiles.end(); it++){
+        if (ParseCache::modificationTime(it->first) != it->second){
+            changed.push_back(it->first);
+        }
+    }
+
+    if (changed.size() == 0){
+        return changed;
+    }
+
+    Filesystem::AbsolutePath air = Storage::instance().lookupInsensitive(getLocalData().baseDir, Filesystem::RelativePath(getLocalData().airFile));
+    vector<Filesystem::AbsolutePath> states;
+    vector<Filesystem::AbsolutePath> animations;
+    bool constants = false;
+    for (vector<Filesystem::AbsolutePath>::iterator it = changed.begin(); it != changed.end(); it++){
+        ParseCache::forget(*it);
+        if (it->path() == air.path()){
+            animations.push_back(*it);
+        } else {
+            states.push_back(*it);
+            /* the cns file usually has states too */
+            if (getLocalData().constantsFile != "" && it->path() == findCnsFile(Filesystem::RelativePath(getLocalData().constantsFile)).path()){
+                constants = true;
+            }
+        }
+    }
+
+    /* The new modification times are kept even if a reload fails so a broken
+     * file is reported once and not every time the files are checked, saving
+     * it again tries again. If the states fail the animations aren't tried
+     * and stay changed until the next check.
+     */
+    if (states.size() > 0){
+        try{
+            reloadStates(constants);
+        } catch (...){
+            watchFiles(states);
+            throw;
+        }
+        watchFiles(states);
+    }
+
+    if (animations.size() > 0){
+        try{
+            reloadAnimations();
+        } catch (...){
+            watchFiles(animations);
+            throw;
+        }
+        watchFiles(animations);
+    }
+
+    return changed;
 }
 
 bool Character::isBound() const {
@@ -2564,6 +2723,10 @@ void Character::renderSprite(const int x, const int y, const unsigned int group,
 const std::vector<Command2 *> & Character::getCommands() const {
     return getLocalData().commands;
 }
+
+unsigned int Character::getCommandsGeneration() const {
+    return getLocalData().commandsGeneration;
+}
         
 bool Character::canRecover() const {
     /* TODO */
@@ -2839,6 +3002,11 @@ void Character::setInputs(uint32_t tick, const std::vector<std::string> & inputs
 
 /* Inherited members */
 void Character::act(Stage * stage){
+    Profiler & profiler = stage->getContext().getProfiler();
+    /* helpers share their parent's name so traces tell them apart by id */
+    const char * label = profiler.isTracing() ? getLocalData().displayName.c_str() : NULL;
+    int id = getId().intValue();
+    Profiler::Scope profile(profiler, Profiler::Act, label, id);
 
     getLocalData().maxChangeStates = 0;
 
@@ -2889,6 +3057,7 @@ void Character::act(Stage * stage){
      */
     if (! stage->replayEnabled()){
         // stage->getTicks() - 1 >= getLocalData().inputHistory.size()){
+        Profiler::Scope profile(profiler, Profiler::Input);
         /* active is the current set of commands */
         getStateData().active = doInput(*stage);
         getLocalData().inputHistory.push_back(getStateData().active);
@@ -2987,12 +3156,15 @@ void Character::act(Stage * stage){
     /* always run through the negative states unless we are borrowing another
      * players states
      */
-    if (!getStateData().characterData.enabled){
-        doStates(*stage, getStateData().active, -3);
-        doStates(*stage, getStateData().active, -2);
-        doStates(*stage, getStateData().active, -1);
+    {
+        Profiler::Scope profile(profiler, Profiler::States, label, id);
+        if (!getStateData().characterData.enabled){
+            doStates(*stage, getStateData().active, -3);
+            doStates(*stage, getStateData().active, -2);
+            doStates(*stage, getStateData().active, -1);
+        }
+        doStates(*stage, getStateData().active, getCurrentState());
     }
-    doStates(*stage, getStateData().active, getCurrentState());
 
     /*! do regeneration if set, but only for main players */
     if (getLocalData().regenerateHealth && !isHelper()){
@@ -3403,10 +3575,16 @@ bool Character::doStates(Mugen::Stage & stage, const vector<string> & active, in
         // Global::debug(0) << getDisplayName() << " evaluating state " << stateNumber << " states " << state->getControllers().size() << std::endl;
         const vector<StateController*> & controllers = state->getControllers();
         FullEnvironment environment(stage, *this, active);
+        Profiler & profiler = stage.getContext().getProfiler();
         for (vector<StateController*>::const_iterator it = controllers.begin(); it != controllers.end(); it++){
             StateController * controller = *it;
             Global::debug(2 * !controller->getDebug()) << "State " << stateNumber << " check state controller " << controller->getName() << endl;
 
+            Profiler::ControllerCount * count = NULL;
+            if (profiler.isCountingControllers()){
+                count = &profiler.getControllerCount(getId().intValue(), getLocalData().displayName, stateNumber, *controller);
+            }
+
 #if 0
             /* more debugging */
             bool hasFF = false;
@@ -3427,14 +3605,26 @@ bool Character::doStates(Mugen::Stage & stage, const vector<string> & active, in
 #endif
 
             try{
-                if (controller->canTrigger(environment)){
+                uint64_t start = count != NULL ? Profiler::now() : 0;
+                bool triggered = controller->canTrigger(environment);
+                if (count != NULL){
+                    count->evaluations += 1;
+                    count->triggerTime += Profiler::now() - start;
+                }
+
+                if (triggered){
                     /* check if the controller's persistent values allow it
                      * to be activated.
                      */
                     if (controller->persistentOk()){
                         Global::debug(2, getDisplayName()) << "Activate controller " << controller->getName() << std::endl;
+                        uint64_t start = count != NULL ? Profiler::now() : 0;
                         /* activate may modify the current state */
                         controller->activate(stage, *this, active);
+                        if (count != NULL){
+                            count->activations += 1;
+                            count->activateTime += Profiler::now() - start;
+                        }
 
                         /* 8/27/2012 - the mugen docs say this about negative states:
                          *   For each tick of game-time, MUGEN makes a single pass through each of the special states, from top to bottom, in order of increasing state number (-3, -2, then -1). For each state controller encountered, its condition-type triggers are evaluated and, if they are satisfied, the controller is executed. Then processing proceeds to the next state controller in the state. A state transition (ChangeState) in any of the special states will update the player's current state number, but will not abort processing of the special states. After all the state controllers in the special states have been checked, the player's current state is processed, again from top to bottom. If a state transition is made out of the current state, the rest of the state controllers (if any) in the current state are skipped, and processing continues from the beginning of the new state. When the end of the current state is reached and no state transition is made, processing halts for this tick.
@@ -3468,10 +3658,19 @@ bool Character::doStates(Mugen::Stage & stage, const vector<string> & active, in
                     }
                 }
             } catch (const MugenNormalRuntimeException & me){
+                if (count != NULL){
+                    count->errors += 1;
+                }
                 Global::debug(1, getName()) << "Error while processing state " << stateNumber << ", " << controller->getName() << ". Error with trigger: " << me.getReason() << endl;
             } catch (const MugenFatalRuntimeException & me){
+                if (count != NULL){
+                    count->errors += 1;
+                }
                 Global::debug(0, getName()) << "Fatal error while processing state " << stateNumber << ", " << controller->getName() << ". Error with trigger: " << me.getReason() << endl;
             } catch (const MugenException & me){
+                if (count != NULL){
+                    count->errors += 1;
+                }
                 Global::debug(0, getName()) << "Abnormal error while processing state " << stateNumber << ", " << controller->getName() << ". Error with trigger: " << me.getReason() << endl;
             }
         }
@@ -4272,16 +4471,16 @@ void Character::doFreeze(){
 void Character::moveX(double x, bool force){
     if (force || !getStateData().frozen){
 	if (getFacing() == FacingLeft){
-            getStateData().virtualx -= x;
+            setX(getX() - x);
 	} else {
-            getStateData().virtualx += x;
+            setX(getX() + x);
 	}
     }
 }
 
 void Character::moveY(double y, bool force){
     if (force || !getStateData().frozen){
-        getStateData().virtualy += y;
+        setY(getY() + y);
     }
 }
         
@@ -4656,6 +4855,14 @@ int Character::getAirFront() const {
 
 void Character::setStateData(const StateData & data){
     this->stateData = data;
+    if (hotState != NULL){
+        hotState->x[hotSlot] = data.virtualx;
+        hotState->y[hotSlot] = data.virtualy;
+        hotState->velocityX[hotSlot] = data.velocity_x;
+        hotState->velocityY[hotSlot] = data.velocity_y;
+        hotState->physics[hotSlot] = data.currentPhysics;
+        hotState->beingHit[hotSlot] = data.moveType == Move::Hit;
+    }
     const std::map<std::string, std::string > & serializedCommands = data.commandState;;
 
     std::map<std::string, Command2*> commandMap;
@@ -4677,6 +4884,55 @@ void Character::setStateData(const StateData & data){
     }
 }
 
+StateData Character::snapshotStateData() const {
+    StateData data = getStateData();
+    if (hotState != NULL){
+        data.virtualx = hotState->x[hotSlot];
+        data.virtualy = hotState->y[hotSlot];
+        data.velocity_x = hotState->velocityX[hotSlot];
+        data.velocity_y = hotState->velocityY[hotSlot];
+        data.currentPhysics = hotState->physics[hotSlot];
+    }
+    return data;
+}
+
+void Character::bindHotState(HotState * state){
+    if (hotState == state){
+        return;
+    }
+
+    unbindHotState();
+    if (state != NULL){
+        hotSlot = state->add(this, getStateData().virtualx, getStateData().virtualy,
+                             getStateData().velocity_x, getStateData().velocity_y,
+                             getStateData().currentPhysics);
+        hotState = state;
+        updateHotConstants();
+    }
+}
+
+void Character::updateHotConstants(){
+    if (hotState != NULL){
+        hotState->beingHit[hotSlot] = getMoveType() == Move::Hit;
+        hotState->standFriction[hotSlot] = getStandingFriction();
+        hotState->crouchFriction[hotSlot] = getCrouchingFriction();
+        hotState->gravity[hotSlot] = getGravity();
+    }
+}
+
+void Character::unbindHotState(){
+    if (hotState != NULL){
+        getStateData().virtualx = hotState->x[hotSlot];
+        getStateData().virtualy = hotState->y[hotSlot];
+        getStateData().velocity_x = hotState->velocityX[hotSlot];
+        getStateData().velocity_y = hotState->velocityY[hotSlot];
+        getStateData().currentPhysics = hotState->physics[hotSlot];
+        hotState->remove(hotSlot);
+        hotState = NULL;
+        hotSlot = -1;
+    }
+}
+
 Character::LocalData::LocalData(){
 #define Z(x) x = 0
     /* TODO: add all the variables here */
@@ -4695,6 +4951,7 @@ Character::LocalData::LocalData(){
     Z(velocity_air_gethit_recover_forward);
     Z(velocity_air_gethit_recover_back);
     Z(air_gethit_recover_yaccel);
+    Z(commandsGeneration);
 #undef Z
 }
 
@@ -4707,6 +4964,8 @@ Character::LocalData::LocalData(const Character::LocalData & copy){
     // frozen = false;
     // pushPlayer = 0;
     maxChangeStates = 0;
+    /* the commands aren't copied */
+    commandsGeneration = 0;
     C(xscale);
     C(yscale);
     // C(currentState);
@@ -19,6 +19,7 @@
 #include "common.h"
 #include "sprite.h"
 #include "character-state.h"
+#include "hot-state.h"
 
 namespace Ast{
     class KeyList;
@@ -347,6 +348,13 @@ public:
 
         /* Reloads all the sprites and animations. Must call this after load() */
         virtual void loadGraphics(int palette);
+
+        /* Parses the state, command and animation files that changed on disk
+         * since they were loaded and replaces the states or animations with
+         * the new ones. The state data is not touched so this can be done in
+         * the middle of a match, between ticks. Returns the files that changed.
+         */
+        virtual std::vector<Filesystem::AbsolutePath> reloadChangedFiles();
 	
 	virtual inline const std::string getName() const {
             return getLocalData().name;
@@ -488,18 +496,32 @@ public:
         }
 
         virtual inline void setXVelocity(double x){
-            getStateData().velocity_x = x;
+            if (hotState != NULL){
+                hotState->velocityX[hotSlot] = x;
+            } else {
+                getStateData().velocity_x = x;
+            }
         }
 
         virtual inline double getXVelocity() const {
+            if (hotState != NULL){
+                return hotState->velocityX[hotSlot];
+            }
             return getStateData().velocity_x;
         }
         
         virtual inline void setYVelocity(double y){
-            getStateData().velocity_y = y;
+            if (hotState != NULL){
+                hotState->velocityY[hotSlot] = y;
+            } else {
+                getStateData().velocity_y = y;
+            }
         }
         
         virtual inline double getYVelocity() const {
+            if (hotState != NULL){
+                return hotState->velocityY[hotSlot];
+            }
             return getStateData().velocity_y;
         }
 
@@ -690,6 +712,9 @@ public:
 
         virtual inline void setMoveType(const std::string & str){
             getStateData().moveType = str;
+            if (hotState != NULL){
+                hotState->beingHit[hotSlot] = str == Move::Hit;
+            }
         }
 
         virtual void destroyed(Stage & stage);
@@ -707,15 +732,25 @@ public:
         virtual RuntimeValue getSystemVariable(int index) const;
 
         virtual inline Physics::Type getCurrentPhysics() const {
+            if (hotState != NULL){
+                return hotState->physics[hotSlot];
+            }
             return getStateData().currentPhysics;
         }
 
         virtual void setCurrentPhysics(Physics::Type p){
-            getStateData().currentPhysics = p;
+            if (hotState != NULL){
+                hotState->physics[hotSlot] = p;
+            } else {
+                getStateData().currentPhysics = p;
+            }
         }
 
         virtual void setGravity(double n){
             getLocalData().gravity = n;
+            if (hotState != NULL){
+                hotState->gravity[hotSlot] = n;
+            }
         }
 
         virtual double getGravity() const {
@@ -756,6 +791,9 @@ public:
 
         virtual void setCrouchingFriction(double n){
             getLocalData().crouchFriction = n;
+            if (hotState != NULL){
+                hotState->crouchFriction[hotSlot] = n;
+            }
         }
 
         virtual double getCrouchingFrictionThreshold() const {
@@ -784,6 +822,9 @@ public:
 
         virtual void setStandingFriction(double n){
             getLocalData().standFriction = n;
+            if (hotState != NULL){
+                hotState->standFriction[hotSlot] = n;
+            }
         }
 
         virtual double getStandingFriction() const {
@@ -1164,6 +1205,8 @@ public:
         void setId(const CharacterId & id);
 
         virtual const std::vector<Command2 *> & getCommands() const;
+        /* goes up every time the commands are loaded again */
+        virtual unsigned int getCommandsGeneration() const;
 
 protected:
     void initialize();
@@ -1180,6 +1223,13 @@ protected:
     virtual void loadCnsFile(const Filesystem::RelativePath & path);
     virtual void loadStateFile(const Filesystem::AbsolutePath & base, const std::string & path);
 
+    /* remember the modification time of a file so reloadChangedFiles() can find it */
+    void watchFile(const Filesystem::AbsolutePath & path);
+    void watchFiles(const std::vector<Filesystem::AbsolutePath> & paths);
+    void reloadStates(bool constants);
+    Filesystem::AbsolutePath findCnsFile(const Filesystem::RelativePath & path) const;
+    void reloadAnimations();
+
     virtual void addCommand(Command2 * command);
 
     virtual void setConstant(std::string name, const std::vector<double> & values);
@@ -1228,6 +1278,12 @@ protected:
     unsigned int stateControllerId;
     unsigned int nextStateControllerId();
 
+    /* Position, velocity and physics live in the stage's table while the
+     * character is on a stage.
+     */
+    HotState * hotState;
+    int hotSlot;
+
     /* Data that doesn't have to be sent to remote instances */
     struct LocalData{
         LocalData();
@@ -1288,6 +1344,11 @@ protected:
         // Palettes max 12
         std::map<int, std::string> palFile;
 
+        /* state files in the order they were loaded as base directory and file */
+        std::vector<std::pair<Filesystem::AbsolutePath, std::string> > stateFiles;
+        /* modification times of the files states, commands and animations came from */
+        std::map<Filesystem::AbsolutePath, int> sourceFiles;
+
         // Arcade mode ( I don't think we will be using this anytime soon )
         std::string introFile;
         std::string endingFile;
@@ -1429,6 +1490,7 @@ protected:
         std::map<std::string, Constant> constants;
 
         std::vector<Command2 *> commands;
+        unsigned int commandsGeneration;
 
         // Debug state
         bool debug;
@@ -1525,6 +1587,24 @@ public:
     }
 
     void setStateData(const StateData & data);
+
+    /* The state data including the values that are kept in the hot state table */
+    StateData snapshotStateData() const;
+
+    /* Move position, velocity and physics into `state' */
+    void bindHotState(HotState * state);
+
+    /* Copy the values back into the state data and leave the table */
+    void unbindHotState();
+
+    /* Write friction, gravity and move type into the table after they
+     * changed behind the setters' back
+     */
+    void updateHotConstants();
+
+    inline int getHotSlot() const {
+        return hotSlot;
+    }
 };
 
 }
@@ -181,14 +181,13 @@ Win
 #include "characterhud.h"
 #include "character.h"
 #include "helper.h"
-#include "random.h"
+#include "context.h"
 #include "stage.h"
 #include <r-tech1/funcs.h>
 #include <r-tech1/regex.h>
 #include <math.h>
 #include <sstream>
 #include <string>
-#include "config.h"
 #include "projectile.h"
 
 namespace PaintownUtil = ::Util;
@@ -490,6 +489,10 @@ bool RuntimeValue::operator>=(const RuntimeValue & value2) const {
     return compareRuntimeValues(*this, value2, greaterThanEqualsDouble);
 }
 
+MatchContext & Environment::getContext() const {
+    return getStage().getContext();
+}
+
 const Character & EmptyEnvironment::getCharacter() const {
     throw MugenException("Cannot get a character from an empty environment", __FILE__, __LINE__);
 }
@@ -1285,7 +1288,7 @@ public:
             public:
                 RuntimeValue evaluate(const Environment & environment) const {
                     /* Returns a random number between 0 and 999, inclusive. */
-                    return RuntimeValue((int) Mugen::random(1000));
+                    return RuntimeValue((int) environment.getContext().random(1000));
                 }
 
                 Value * copy() const {
@@ -2053,7 +2056,18 @@ public:
         }
         
         if (identifier == "tickspersecond"){
-            return compile(Mugen::Data::getInstance().getGameSpeed());
+            class TicksPerSecond: public Value {
+            public:
+                RuntimeValue evaluate(const Environment & environment) const {
+                    return RuntimeValue(environment.getContext().getGameSpeed());
+                }
+
+                Value * copy() const {
+                    return new TicksPerSecond();
+                }
+            };
+
+            return new TicksPerSecond();
         }
 
         std::ostringstream out;
@@ -17,6 +17,7 @@ namespace Compiler{
 
 class Character;
 class Stage;
+class MatchContext;
 
 struct Range{
     Range():
@@ -216,6 +217,9 @@ public:
 
     virtual RuntimeValue getArg1() const = 0;
 
+    /* the match being played, which by default belongs to the stage */
+    virtual MatchContext & getContext() const;
+
     virtual ~Environment(){
     }
 };
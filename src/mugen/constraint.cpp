@@ -7,6 +7,8 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <map>
+#include <algorithm>
 #include <sstream>
 #include <exception>
 
@@ -69,6 +71,10 @@ public:
         return satisfied;
     }
 
+    virtual bool isIdle() const {
+        return !satisfied && held == 0;
+    }
+
     virtual string toString() const {
         std::ostringstream out;
 
@@ -131,7 +137,7 @@ public:
 
     virtual Token * serialize() const {
         Token * token = new Token();
-        *token << "z" << key1->serialize() << key2->serialize();
+        *token << "z" << satisfied << satisfiedTick << key1->serialize() << key2->serialize();
         return token;
     }
 
@@ -139,7 +145,9 @@ public:
     virtual void deserialize(const Token * token){
         const Token * token1 = NULL;
         const Token * token2 = NULL;
-        token->view() >> token1 >> token2;
+        TokenView view = token->view();
+        Constraint::deserialize(view);
+        view >> token1 >> token2;
         key1->deserialize(token1);
         key2->deserialize(token2);
     }
@@ -790,6 +798,10 @@ std::string Constraint::toString() const {
 }
 
 bool Constraint::doSatisfy(const Mugen::Input & input, int tick){
+    return test(type, input);
+}
+
+bool Constraint::test(Type type, const Mugen::Input & input){
     switch (type){
         case PressA: return input.pressed.a; break;
         case ReleaseA: return input.released.a; break;
@@ -846,6 +858,20 @@ bool Constraint::doSatisfy(const Mugen::Input & input, int tick){
     return false;
 }
 
+uint32_t Constraint::keyState(const Mugen::Input & input){
+    uint32_t out = 0;
+    for (int type = PressA; type < Combine; type++){
+        if (test((Type) type, input)){
+            out |= 1 << type;
+        }
+    }
+    return out;
+}
+
+bool Constraint::isIdle() const {
+    return !satisfied;
+}
+
 bool Constraint::satisfy(const Mugen::Input & input, int tick){
     if (!satisfied){
         /*
@@ -898,7 +924,34 @@ name(name),
 maxTime(maxTime),
 bufferTime(bufferTime),
 useBufferTime(0),
-emitted(false){
+emitted(false),
+triggers(0),
+waiting(true){
+    std::map<uint32_t, unsigned int> positions;
+    for (unsigned int i = 0; i < constraints.size(); i++){
+        positions[constraints[i]->getId()] = i;
+    }
+
+    for (unsigned int i = 0; i < constraints.size(); i++){
+        ConstraintRef & constraint = constraints[i];
+        const std::set<ConstraintCompare> & needs = constraint->getDepends();
+        vector<unsigned int> where;
+        for (std::set<ConstraintCompare>::const_iterator it = needs.begin(); it != needs.end(); it++){
+            where.push_back(positions[it->constraint->getId()]);
+        }
+        depends.push_back(where);
+
+        /* Only the constraints that depend on nothing can be satisfied first */
+        if (needs.size() == 0){
+            if (constraint->getType() == Constraint::Combine){
+                triggers = 0xffffffff;
+            } else {
+                triggers |= 1 << constraint->getType();
+            }
+        }
+    }
+
+    satisfied.resize(constraints.size());
 }
     
 const std::string & Command2::getName() const {
@@ -914,6 +967,29 @@ void Command2::resetConstraints(){
     emitted = false;
 }
 
+void Command2::updateWaiting(){
+    /* Constraints that depend on something are never looked at until what they
+     * depend on is satisfied, so only their own satisfied flag matters.
+     */
+    waiting = useBufferTime == 0 && !emitted;
+    for (unsigned int i = 0; waiting && i < constraints.size(); i++){
+        const ConstraintRef & constraint = constraints[i];
+        if (depends[i].size() == 0){
+            waiting = constraint->isIdle();
+        } else {
+            waiting = !constraint->isSatisfied();
+        }
+    }
+}
+
+bool Command2::isWaiting() const {
+    return waiting;
+}
+
+uint32_t Command2::getTriggers() const {
+    return triggers;
+}
+
 int Command2::activeTicks(int ticks){
     if (constraints.size() > 0){
         ConstraintRef ref = constraints[0];
@@ -963,14 +1039,14 @@ bool Command2::handle(const Mugen::Input & input, int ticks){
     }
 
     bool emit = false;
-    std::set<ConstraintRef> satisfied;
-    for (vector<ConstraintRef>::iterator it = constraints.begin(); it != constraints.end(); it++){
+    unsigned int satisfiedCount = 0;
+    std::fill(satisfied.begin(), satisfied.end(), 0);
+    for (unsigned int i = 0; i < constraints.size(); i++){
         bool all = true;
-        ConstraintRef constraint = *it;
-        const std::set<ConstraintCompare> & depends = constraint->getDepends();
-        for (std::set<ConstraintCompare>::const_iterator it2 = depends.begin(); it2 != depends.end(); it2++){
-            /* If its not in the satisified set then not all dependencies can be satisifed */
-            if (satisfied.find(it2->constraint) == satisfied.end()){
+        const vector<unsigned int> & needs = depends[i];
+        for (vector<unsigned int>::const_iterator it = needs.begin(); it != needs.end(); it++){
+            /* If it wasn't satisfied this tick then not all dependencies can be satisifed */
+            if (!satisfied[*it]){
                 all = false;
                 break;
             }
@@ -978,8 +1054,10 @@ bool Command2::handle(const Mugen::Input & input, int ticks){
 
         /* If `all' is still true then all dependencies have been satisfied and we can continue */
         if (all){
+            ConstraintRef & constraint = constraints[i];
             if (constraint->satisfy(input, ticks)){
-                satisfied.insert(constraint);
+                satisfied[i] = 1;
+                satisfiedCount += 1;
                 if (constraint->isEmit()){
                     emit = true;
                 }
@@ -998,16 +1076,18 @@ bool Command2::handle(const Mugen::Input & input, int ticks){
     }
 
     /* Reset the constraints if they were all satisfied. */
-    if (satisfied.size() == constraints.size()){
+    if (satisfiedCount == constraints.size()){
         resetConstraints();
     }
 
+    updateWaiting();
+
     /* Uncomment to debug the commands */
     /*
     Global::debug(0) << "Tick: " << ticks << " Input " << debugInput(input) << std::endl;
     for (vector<ConstraintRef>::iterator it = constraints.begin(); it != constraints.end(); it++){
         ConstraintRef constraint = *it;
-        Global::debug(0) << " Constraint " << constraint->getTime() << " " << constraint->toString() << " satisfied " << (satisfied.find(constraint) != satisfied.end()) << std::endl;
+        Global::debug(0) << " Constraint " << constraint->getTime() << " " << constraint->toString() << " satisfied " << (int) satisfied[it - constraints.begin()] << std::endl;
     }
     Global::debug(0) << std::endl;
     */
@@ -1036,6 +1116,48 @@ void Command2::deserialize(const Token * token){
         view >> next;
         ref->deserialize(next);
     }
+
+    updateWaiting();
+}
+
+CommandSet::CommandSet():
+handled(0),
+skipped(0){
+}
+
+const vector<bool> & CommandSet::handle(const vector<Command2*> & commands, const Mugen::Input & input, int ticks){
+    fired.assign(commands.size(), false);
+    uint32_t keys = Constraint::keyState(input);
+    for (unsigned int i = 0; i < commands.size(); i++){
+        Command2 * command = commands[i];
+        if (command->isWaiting() && (command->getTriggers() & keys) == 0){
+            skipped += 1;
+            continue;
+        }
+
+        handled += 1;
+        fired[i] = command->handle(input, ticks);
+    }
+
+    return fired;
+}
+
+vector<string> CommandSet::names(const vector<Command2*> & commands, const vector<bool> & fired){
+    vector<string> out;
+    for (unsigned int i = 0; i < commands.size() && i < fired.size(); i++){
+        if (fired[i]){
+            out.push_back(commands[i]->getName());
+        }
+    }
+    return out;
+}
+
+uint64_t CommandSet::getHandled() const {
+    return handled;
+}
+
+uint64_t CommandSet::getSkipped() const {
+    return skipped;
 }
 
 }
@@ -4,6 +4,7 @@
 #include <set>
 #include <vector>
 #include <string>
+#include <stdint.h>
 #include "command.h"
 #include <r-tech1/token.h>
 #include <r-tech1/pointer.h>
@@ -83,6 +84,18 @@ public:
 
     virtual bool doSatisfy(const Mugen::Input & input, int tick);
 
+    /* true if `input' presses or releases the key for `type'. Combine is never true */
+    static bool test(Type type, const Mugen::Input & input);
+
+    /* bit N is set if test() is true for type N */
+    static uint32_t keyState(const Mugen::Input & input);
+
+    /* true if handling an input that doesn't press or release this
+     * constraint's key would leave it exactly as it is, assuming nothing it
+     * depends on is satisfied
+     */
+    virtual bool isIdle() const;
+
     virtual bool satisfy(const Mugen::Input & input, int tick);
 
     int getSatisfiedTick() const;
@@ -102,11 +115,9 @@ public:
     virtual void deserialize(TokenView & view);
     virtual void deserialize(const Token * token);
     
-    /*
     virtual bool isSatisfied() const {
         return satisfied;
     }
-    */
     
     const std::set<ConstraintCompare> & getDepends();
 
@@ -134,16 +145,58 @@ public:
     Token * serialize() const;
     void deserialize(const Token * token);
 
+    /* true if nothing has been matched yet. handle() can only change a
+     * waiting command if one of the keys in getTriggers() is in the input.
+     */
+    bool isWaiting() const;
+
+    /* Constraint::keyState bits of the keys that can start the command */
+    uint32_t getTriggers() const;
+
 protected:
     void resetConstraints();
     int activeTicks(int ticks);
+    void updateWaiting();
 
     std::vector<PaintownUtil::ReferenceCount<Constraint> > constraints;
+    /* positions in `constraints' that each constraint depends on */
+    std::vector<std::vector<unsigned int> > depends;
+    /* which constraints were satisfied during the current handle() */
+    std::vector<char> satisfied;
     std::string name;
     int maxTime;
     int bufferTime;
     int useBufferTime;
     bool emitted;
+    uint32_t triggers;
+    bool waiting;
+};
+
+/* Runs all of a character's commands against one tick of input. The input
+ * is reduced to a word of Constraint::keyState bits once and shared by all
+ * the commands, and a command that is still waiting is only handled when
+ * that word has one of its triggers, which on most ticks is true for very
+ * few of them. The commands keep all of the matching state, so they are
+ * serialized and deserialized the same as when they are handled one by one.
+ */
+class CommandSet{
+public:
+    CommandSet();
+
+    /* element i is true if commands[i] fired this tick */
+    const std::vector<bool> & handle(const std::vector<Command2*> & commands, const Mugen::Input & input, int ticks);
+
+    /* names of the commands that fired */
+    static std::vector<std::string> names(const std::vector<Command2*> & commands, const std::vector<bool> & fired);
+
+    /* totals of the commands that were handled and skipped */
+    uint64_t getHandled() const;
+    uint64_t getSkipped() const;
+
+protected:
+    std::vector<bool> fired;
+    uint64_t handled;
+    uint64_t skipped;
 };
 
 }
@@ -0,0 +1,57 @@
+#include "context.h"
+#include "config.h"
+
+namespace Mugen{
+
+MatchContext::MatchContext(){
+    loadSettings();
+}
+
+MatchContext::MatchContext(uint32_t seed):
+randomState(seed){
+    loadSettings();
+}
+
+MatchContext::~MatchContext(){
+}
+
+/* Data is only read here, while the match is being set up */
+void MatchContext::loadSettings(){
+    gameSpeed = Data::getInstance().getGameSpeed();
+    attackLifeToPower = Data::getInstance().getDefaultAttackLifeToPowerMultiplier();
+    getHitLifeToPower = Data::getInstance().getDefaultGetHitLifeToPowerMultiplier();
+}
+
+Random & MatchContext::getRandom(){
+    return randomState;
+}
+
+const Random & MatchContext::getRandom() const {
+    return randomState;
+}
+
+void MatchContext::setRandom(const Random & random){
+    randomState = random;
+}
+
+uint32_t MatchContext::random(int high){
+    return randomState.next(high);
+}
+
+uint32_t MatchContext::random(int low, int high){
+    return randomState.next(low, high);
+}
+
+double MatchContext::getGameSpeed() const {
+    return gameSpeed;
+}
+
+double MatchContext::getAttackLifeToPowerMultiplier() const {
+    return attackLifeToPower;
+}
+
+double MatchContext::getGetHitLifeToPowerMultiplier() const {
+    return getHitLifeToPower;
+}
+
+}
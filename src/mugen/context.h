@@ -0,0 +1,58 @@
+#ifndef _paintown_mugen_context_h
+#define _paintown_mugen_context_h
+
+#include <stdint.h>
+#include "random.h"
+#include "profile.h"
+
+namespace Mugen{
+
+/* The state of one match that used to be global. Every Stage owns one and
+ * hands it to whatever needs it while the match runs, through the stage or a
+ * compiler Environment, so several stages can run at the same time in
+ * different threads.
+ *
+ * Parsed files, sprites and compiled states never change once they are loaded
+ * so they stay shared between matches and are not in here.
+ */
+class MatchContext{
+public:
+    /* random numbers are seeded from rand() and the settings come from Data */
+    MatchContext();
+    /* matches with the same seed and the same input play out the same way */
+    MatchContext(uint32_t seed);
+
+    virtual ~MatchContext();
+
+    Random & getRandom();
+    const Random & getRandom() const;
+    void setRandom(const Random & random);
+
+    /* 0 to high - 1 */
+    uint32_t random(int high);
+    /* low to high - 1 */
+    uint32_t random(int low, int high);
+
+    /* ticks per second */
+    double getGameSpeed() const;
+    double getAttackLifeToPowerMultiplier() const;
+    double getGetHitLifeToPowerMultiplier() const;
+
+    /* off unless something asks for it */
+    inline Profiler & getProfiler(){
+        return profiler;
+    }
+
+protected:
+    void loadSettings();
+
+    Random randomState;
+    double gameSpeed;
+    double attackLifeToPower;
+    double getHitLifeToPower;
+    Profiler profiler;
+};
+
+}
+
+#endif
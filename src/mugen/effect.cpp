@@ -53,6 +53,20 @@ Effect(NULL, animation, -1, x, y, 1, 1, spritePriority){
 Spark::~Spark(){
 }
 
+static MemoryPool sparkPool(sizeof(Spark), 64);
+
+void * Spark::operator new(std::size_t size){
+    return sparkPool.allocate(size);
+}
+
+void Spark::operator delete(void * memory, std::size_t size){
+    sparkPool.release(memory, size);
+}
+
+const MemoryPool & Spark::getPool(){
+    return sparkPool;
+}
+
 /* FIXME: this came from state-controller.cpp. maybe it can be shared */
 static void computePosition(double posX, double posY, const Character * owner, const Stage & stage, PositionType positionType, bool horizontalFlip, double & x, double & y){
     posX *= horizontalFlip ? -1 : 1;
@@ -129,6 +143,21 @@ hitCount(owner->getWasHitCount()),
 shouldRemove(false){
 }
 
+/* MUGEN allows at most 512 explods */
+static MemoryPool explodPool(sizeof(ExplodeEffect), 512);
+
+void * ExplodeEffect::operator new(std::size_t size){
+    return explodPool.allocate(size);
+}
+
+void ExplodeEffect::operator delete(void * memory, std::size_t size){
+    explodPool.release(memory, size);
+}
+
+const MemoryPool & ExplodeEffect::getPool(){
+    return explodPool;
+}
+
 
 
 void ExplodeEffect::logic(){
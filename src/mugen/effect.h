@@ -3,6 +3,7 @@
 
 #include <r-tech1/pointer.h>
 #include "common.h"
+#include "pool.h"
 
 namespace Graphics{
     class Bitmap;
@@ -65,6 +66,10 @@ class Spark: public Effect {
 public:
     Spark(int x, int y, int spritePriority, ::Util::ReferenceCount<Animation> animation);
     virtual ~Spark();
+
+    static void * operator new(std::size_t size);
+    static void operator delete(void * memory, std::size_t size);
+    static const MemoryPool & getPool();
 };
 
 class ExplodeEffect: public Effect {
@@ -121,6 +126,11 @@ class ExplodeEffect: public Effect {
         virtual void draw(const Graphics::Bitmap & work, int cameraX, int cameraY);
         virtual bool isDead();
 
+        /* Some characters make dozens of explods a second so their memory is recycled */
+        static void * operator new(std::size_t size);
+        static void operator delete(void * memory, std::size_t size);
+        static const MemoryPool & getPool();
+
         const Mugen::Stage & stage;
         double velocityX;
         double velocityY;
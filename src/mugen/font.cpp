@@ -111,6 +111,9 @@ Font::Font( const Font &copy ){
     this->offsety = copy.offsety;
     this->pcx = copy.pcx;
     this->banks = copy.banks;
+    for (int i = 0; i < 256; i++){
+        this->glyphs[i] = copy.glyphs[i];
+    }
 }
 
 Font::~Font(){
@@ -129,6 +132,10 @@ Font & Font::operator=( const Font &copy ){
     this->offsetx = copy.offsetx;
     this->offsety = copy.offsety;
     this->banks = copy.banks;
+    for (int i = 0; i < 256; i++){
+        this->glyphs[i] = copy.glyphs[i];
+    }
+    this->runs.clear();
     
     return *this;
 }
@@ -148,12 +155,11 @@ int Font::getSizeY() const{
 }
 
 int Font::textLength( const char * text ) const{
-    std::string str(text);
     int size =0;
-    for (unsigned int i = 0; i < str.size(); ++i){
-        std::map<char, FontLocation>::const_iterator loc = positions.find(str[i]);
-        if (loc != positions.end()){
-            size += loc->second.width + spacingx;
+    for (const char * i = text; *i != '\0'; ++i){
+        const FontLocation & loc = glyphs[(unsigned char) *i];
+        if (loc.exists){
+            size += loc.width + spacingx;
         } else {
             // Couldn't find a position for this character assume regular width and skip to the next character
             size += width + spacingx;
@@ -186,50 +192,117 @@ void Font::printf(int x, int y, int bank, const Graphics::Bitmap & work, const s
     vsnprintf(buf, sizeof(buf), str.c_str(), ap);
     va_end(ap);
 
-    const std::string newstr(buf);
+    formatted.assign(buf);
 
-    const PaintownUtil::ReferenceCount<Graphics::Bitmap> & font = changeBank(bank);
-    if (font == NULL){
-        return;
-    }
-
-    int workoffsetx = 0;
-    for (unsigned int i = 0; i < newstr.size(); ++i){
-        std::map<char, FontLocation>::const_iterator loc = positions.find(newstr[i]);
-        if (loc != positions.end()){
-            /*
-            Bitmap character = Bitmap::temporaryBitmap(loc->second.width + spacingx, height + spacingy);
-            character.clearToMask();
-            bmp->Blit(loc->second.startx, 0, loc->second.width + spacingx, height + spacingy,0,0, character);
-            */
-
-            Graphics::Bitmap character = font->subBitmap(loc->second.startx, 0, loc->second.width, height);
-            character.draw(x + workoffsetx + offsetx, y + offsety, work);
-            workoffsetx += loc->second.width + spacingx;
-        } else{
-            // Couldn't find a position for this character draw nothing, assume width, and skip to the next character
-            workoffsetx += width + spacingx;
-        }
+    const TextRun * run = getTextRun(bank, formatted);
+    if (run != NULL){
+        drawTextRun(*run, x, y, work);
     }
 }
 
+/* The text is drawn as is, it isn't a printf format. */
 void Font::render(int x, int y, int position, int bank, const Graphics::Bitmap & work, const string & str){
+    const TextRun * run = getTextRun(bank, str);
+    if (run == NULL){
+        return;
+    }
+
     const int height = getHeight();
-    const int length = textLength(str.c_str());
+    const int length = run->length;
     switch (position){
 	case -1:
-	    printf(x - length, y - height, bank, work, str, 0);
+	    drawTextRun(*run, x - length, y - height, work);
 	    break;
 	case 1:
-	    printf(x, y - height, bank, work, str, 0);
+	    drawTextRun(*run, x, y - height, work);
 	    break;
 	case 0:
 	default:
-	    printf(x - (length/2), y - height, bank, work, str, 0);
+	    drawTextRun(*run, x - (length/2), y - height, work);
 	    break;
     }
 }
 
+Font::TextRun::TextRun():
+length(0){
+}
+
+/* Gives up on the cache when it gets big, something like a timer in
+ * milliseconds would otherwise fill it forever.
+ */
+static const unsigned int MaxTextRuns = 128;
+
+const Font::TextRun * Font::getTextRun(int bank, const string & text){
+    const PaintownUtil::ReferenceCount<Graphics::Bitmap> & font = changeBank(bank);
+    if (font == NULL){
+        return NULL;
+    }
+
+    if (runs.size() < (unsigned int) colors){
+        runs.resize(colors);
+    }
+
+    std::map<string, TextRun> & cache = runs[bank];
+    std::map<string, TextRun>::iterator found = cache.find(text);
+    if (found != cache.end()){
+        return &found->second;
+    }
+
+    if (cache.size() >= MaxTextRuns){
+        cache.clear();
+    }
+
+    TextRun & run = cache[text];
+    run = makeTextRun(*font, text);
+    return &run;
+}
+
+Font::TextRun Font::makeTextRun(const Graphics::Bitmap & font, const string & text) const {
+    TextRun run;
+    run.length = textLength(text.c_str());
+
+    /* spacing can be negative so find how far the glyphs really go */
+    int right = 0;
+    int workoffsetx = 0;
+    for (unsigned int i = 0; i < text.size(); ++i){
+        const FontLocation & loc = glyphs[(unsigned char) text[i]];
+        if (loc.exists){
+            right = PaintownUtil::max(right, workoffsetx + loc.width);
+            workoffsetx += loc.width + spacingx;
+        } else {
+            workoffsetx += width + spacingx;
+        }
+    }
+
+    if (right <= 0 || height <= 0){
+        return run;
+    }
+
+    run.bitmap = PaintownUtil::ReferenceCount<Graphics::Bitmap>(new Graphics::Bitmap(right, height));
+    run.bitmap->clearToMask();
+
+    workoffsetx = 0;
+    for (unsigned int i = 0; i < text.size(); ++i){
+        const FontLocation & loc = glyphs[(unsigned char) text[i]];
+        if (loc.exists){
+            Graphics::Bitmap character = font.subBitmap(loc.startx, 0, loc.width, height);
+            character.draw(workoffsetx, 0, *run.bitmap);
+            workoffsetx += loc.width + spacingx;
+        } else{
+            // Couldn't find a position for this character draw nothing, assume width, and skip to the next character
+            workoffsetx += width + spacingx;
+        }
+    }
+
+    return run;
+}
+
+void Font::drawTextRun(const TextRun & run, int x, int y, const Graphics::Bitmap & work) const {
+    if (run.bitmap != NULL){
+        run.bitmap->draw(x + offsetx, y + offsety, work);
+    }
+}
+
 /* get a pointer to a specific bank. bank numbers start from 0 */
 unsigned char * Font::findBankPalette(int bank) const {
     return pcx + pcxsize - ((bank+1) * colors * 3);
@@ -421,9 +494,10 @@ void Font::load(const Filesystem::AbsolutePath & path){
                     FontLocation loc;
                     loc.startx = startx;
                     loc.width = chrwidth;
+                    loc.exists = true;
                     char code = character[0];
                     Global::debug(3) << "Storing Character: " << code << " | startx: " << loc.startx << " | width: " << loc.width << endl;
-                    positions[code] = loc;
+                    glyphs[(unsigned char) code] = loc;
                 }
                 delete opt;
                 ++locationx;
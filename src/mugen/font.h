@@ -4,6 +4,7 @@
 #include <fstream>
 #include <string>
 #include <map>
+#include <vector>
 #include <stdint.h>
 
 // Extend the font interface already made for paintown
@@ -25,8 +26,16 @@ enum FontType{
 };
 
 struct FontLocation{
+    FontLocation():
+    startx(0),
+    width(0),
+    exists(false){
+    }
+
     int startx;
     int width;
+    /* false if the font has no glyph for this character */
+    bool exists;
 };
 
 class Font{
@@ -60,8 +69,23 @@ public:
     inline int getTotalBanks() { return colors; };
 
 protected:
+    /* A string already drawn in one bank, so text that doesn't change from
+     * one frame to the next (the hud) is a single blit.
+     */
+    struct TextRun{
+        TextRun();
+
+        PaintownUtil::ReferenceCount<Graphics::Bitmap> bitmap;
+        /* same as textLength() */
+        int length;
+    };
+
     unsigned char * findBankPalette(int bank) const;
     Graphics::Bitmap * makeBank(int bank) const;
+
+    const TextRun * getTextRun(int bank, const std::string & text);
+    TextRun makeTextRun(const Graphics::Bitmap & font, const std::string & text) const;
+    void drawTextRun(const TextRun & run, int x, int y, const Graphics::Bitmap & work) const;
     
 protected:
     // File
@@ -81,8 +105,13 @@ protected:
     unsigned char *pcx;
     unsigned char palette[768];
     uint32_t pcxsize;
-    // mapping positions of font in bitmap
-    std::map< char, FontLocation> positions;
+    // mapping positions of font in bitmap, indexed by unsigned char
+    FontLocation glyphs[256];
+
+    /* drawn text for each bank */
+    std::vector<std::map<std::string, TextRun> > runs;
+    /* printf formats into this so it doesn't allocate once it is big enough */
+    std::string formatted;
     
     // int currentBank;
     
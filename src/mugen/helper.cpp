@@ -22,6 +22,36 @@ name(owner->getName() + " " + name + " (helper)"){
 
 Helper::~Helper(){
 }
+
+/* MUGEN allows at most 56 helpers */
+static MemoryPool helperPool(sizeof(Helper), 56);
+
+void * Helper::operator new(std::size_t size){
+    return helperPool.allocate(size);
+}
+
+void Helper::operator delete(void * memory, std::size_t size){
+    helperPool.release(memory, size);
+}
+
+const MemoryPool & Helper::getPool(){
+    return helperPool;
+}
+
+void Helper::takeResources(HelperResources & resources){
+    proxyAnimations.swap(resources.animations);
+    proxyStates.swap(resources.states);
+
+    /* The animations still remember which frame the old helper was on */
+    for (map<int, PaintownUtil::ReferenceCount<Animation> >::iterator it = proxyAnimations.begin(); it != proxyAnimations.end(); it++){
+        it->second->reset();
+    }
+}
+
+void Helper::giveResources(HelperResources & resources){
+    proxyAnimations.swap(resources.animations);
+    proxyStates.swap(resources.states);
+}
     
 void Helper::destroyed(Stage & stage){
     Character::destroyed(stage);
@@ -1,11 +1,22 @@
 #include "stage.h"
 #include "character.h"
 #include "behavior.h"
+#include "pool.h"
 
 namespace Mugen{
 
 class Sound;
 
+/* The expensive parts of a helper, its private copies of the parent's states
+ * and animations. When a helper dies the stage keeps these around and gives
+ * them to the next helper spawned by the same root character so they don't
+ * have to be copied all over again.
+ */
+struct HelperResources{
+    std::map< int, PaintownUtil::ReferenceCount<Animation> > animations;
+    std::map< int, PaintownUtil::ReferenceCount<State> > states;
+};
+
 /* copy all data from the parent somehow, maybe lazily. to speed things up */
 class Helper: public Character {
 public:
@@ -42,6 +53,16 @@ public:
         return root;
     }
 
+    /* Swap in states and animations left behind by a dead helper */
+    virtual void takeResources(HelperResources & resources);
+    /* Hand this helper's states and animations to the stage to reuse */
+    virtual void giveResources(HelperResources & resources);
+
+    /* Helpers come and go all the time so their memory is recycled */
+    static void * operator new(std::size_t size);
+    static void operator delete(void * memory, std::size_t size);
+    static const MemoryPool & getPool();
+
 protected:
     /* the character that spawned this helper */
     CharacterId owner;
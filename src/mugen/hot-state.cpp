@@ -0,0 +1,57 @@
+#include "hot-state.h"
+
+namespace Mugen{
+
+HotState::HotState(){
+}
+
+HotState::~HotState(){
+}
+
+int HotState::add(Character * who, double x, double y, double velocityX, double velocityY, Physics::Type physics){
+    int slot = 0;
+    if (freeSlots.size() > 0){
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = owner.size();
+        owner.push_back(NULL);
+        this->x.push_back(0);
+        this->y.push_back(0);
+        this->velocityX.push_back(0);
+        this->velocityY.push_back(0);
+        this->physics.push_back(Physics::None);
+        beingHit.push_back(false);
+        standFriction.push_back(0);
+        crouchFriction.push_back(0);
+        gravity.push_back(0);
+    }
+
+    owner[slot] = who;
+    this->x[slot] = x;
+    this->y[slot] = y;
+    this->velocityX[slot] = velocityX;
+    this->velocityY[slot] = velocityY;
+    this->physics[slot] = physics;
+    beingHit[slot] = false;
+    standFriction[slot] = 0;
+    crouchFriction[slot] = 0;
+    gravity[slot] = 0;
+
+    return slot;
+}
+
+void HotState::remove(int slot){
+    if (slot < 0 || slot >= (int) owner.size() || owner[slot] == NULL){
+        return;
+    }
+
+    owner[slot] = NULL;
+    freeSlots.push_back(slot);
+}
+
+int HotState::getLive() const {
+    return owner.size() - freeSlots.size();
+}
+
+}
@@ -0,0 +1,60 @@
+#ifndef _paintown_mugen_hot_state_h
+#define _paintown_mugen_hot_state_h
+
+#include <vector>
+#include "common.h"
+
+namespace Mugen{
+
+class Character;
+
+/* The handful of values that every character on the stage reads and writes
+ * every tick: position, velocity and physics type. They are stored as
+ * parallel arrays indexed by a slot so the stage can run movement, friction
+ * and gravity without going through the virtual getters of each Character.
+ *
+ * A character that is bound to a slot forwards its accessors here, otherwise
+ * it uses its own StateData. Unbinding copies the values back into the
+ * StateData so serialization always sees the current values.
+ *
+ * Friction, gravity and whether the character is being hit rarely change,
+ * the character writes them here when they do.
+ */
+class HotState{
+public:
+    HotState();
+    virtual ~HotState();
+
+    /* Returns the slot assigned to `who' */
+    int add(Character * who, double x, double y, double velocityX, double velocityY, Physics::Type physics);
+    void remove(int slot);
+
+    /* Number of slots, some of which might be unused. Check owner[slot]. */
+    inline unsigned int size() const {
+        return owner.size();
+    }
+
+    /* Number of slots that are in use */
+    int getLive() const;
+
+    std::vector<Character*> owner;
+
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> velocityX;
+    std::vector<double> velocityY;
+    std::vector<Physics::Type> physics;
+
+    /* Written by the character when they change */
+    std::vector<char> beingHit;
+    std::vector<double> standFriction;
+    std::vector<double> crouchFriction;
+    std::vector<double> gravity;
+
+protected:
+    std::vector<int> freeSlots;
+};
+
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include "thread.h"
 #include "token.h"
 #include "lz4/lz4.h"
+#include "system/queue.h"
 
 #include <string>
 #include <vector>
@@ -438,6 +439,7 @@ public:
     uint32_t lastTick;
     Input lastInput;
     std::map<uint32_t, Input> history;
+    CommandSet matcher;
 
     virtual void setInput(uint32_t tick, const Input & input){
         if (tick > lastTick){
@@ -475,12 +477,9 @@ public:
 
         Input input = getInput(stage);
 
-        for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-            Command2 * command = *it;
-            if (command->handle(input, stage.getTicks())){
-                Global::debug(1) << "command: " << command->getName() << std::endl;
-                out.push_back(command->getName());
-            }
+        out = CommandSet::names(commands, matcher.handle(commands, input, stage.getTicks()));
+        for (vector<string>::const_iterator it = out.begin(); it != out.end(); it++){
+            Global::debug(1) << "command: " << *it << std::endl;
         }
 
         return out;
@@ -525,12 +524,9 @@ public:
         Input use = getInput(stage, reversed);
         history[stage.getTicks()] = use;
 
-        for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-            Command2 * command = *it;
-            if (command->handle(use, stage.getTicks())){
-                Global::debug(1) << "command: " << command->getName() << std::endl;
-                out.push_back(command->getName());
-            }
+        out = CommandSet::names(commands, matcher.handle(commands, use, stage.getTicks()));
+        for (vector<string>::const_iterator it = out.begin(); it != out.end(); it++){
+            Global::debug(1) << "command: " << *it << std::endl;
         }
 
         return out;
@@ -567,18 +563,23 @@ public:
     PacketHandler(const Network::Socket & socket, HostHandler & host):
     socket(socket),
     host(host),
+    outBox(256),
     sendThread(this, send),
     receiveThread(this, receive),
     alive_(true){
     }
 
+    ~PacketHandler(){
+        outBox.getStatistics().report(Global::debug(1), "Packet send queue");
+    }
+
     Network::Socket socket;
     HostHandler & host;
     
     PaintownUtil::Thread::LockObject lock;
     
-    vector<PaintownUtil::ReferenceCount<Packet> > outBox;
-    vector<PaintownUtil::ReferenceCount<Packet> > inBox;
+    /* filled by the game and the receive thread, emptied by the send thread */
+    System::ManyQueue<PaintownUtil::ReferenceCount<Packet> > outBox;
 
     PaintownUtil::Thread::ThreadObject sendThread;
     PaintownUtil::Thread::ThreadObject receiveThread;
@@ -596,21 +597,18 @@ public:
     }
 
     void sendPacket(const PaintownUtil::ReferenceCount<Packet> & packet){
-        PaintownUtil::Thread::ScopedLock scoped(lock);
-        outBox.push_back(packet);
+        /* the queue is only full if the send thread is stuck, so wait for it */
+        while (!outBox.push(packet)){
+            if (!alive()){
+                return;
+            }
+            PaintownUtil::rest(1);
+        }
     }
 
     PaintownUtil::ReferenceCount<Packet> getSendPacket(){
         PaintownUtil::ReferenceCount<Packet> out;
-
-        {
-            PaintownUtil::Thread::ScopedLock scoped(lock);
-            if (outBox.size() > 0){
-                out = outBox.front();
-                outBox.erase(outBox.begin());
-            }
-        }
-
+        outBox.pop(out);
         return out;
     }
 
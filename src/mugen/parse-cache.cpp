@@ -1,8 +1,10 @@
 #include <list>
+#include <vector>
 #include <string>
 #include <exception>
 #include "parse-cache.h"
 #include "parser/all.h"
+#include "parser/reentrant.h"
 #include "ast/all.h"
 #include "ast/extra.h"
 #include "globals.h"
@@ -105,7 +107,13 @@ Util::ReferenceCount<Ast::AstParse> Parser::loadFile(const Filesystem::AbsoluteP
     return out;
 }
 
+void Parser::forget(const Filesystem::AbsolutePath & path){
+    PaintownUtil::Thread::ScopedLock scoped(lock);
+    cache.erase(path);
+}
+
 void Parser::destroy(){
+    PaintownUtil::Thread::ScopedLock scoped(lock);
     cache.clear();
 }
 
@@ -159,7 +167,220 @@ DefCache::DefCache(){
 DefCache::~DefCache(){
 }
 
-static list<Ast::Section*> * reallyParseX(const Filesystem::AbsolutePath & path, const void * (*parse)(const char * data, int length, bool stats)){
+/* A run of complete sections inside a file. `line' is the line number of the
+ * first byte so that the AST and any parse errors refer to the original file.
+ */
+struct SectionChunk{
+    SectionChunk(int start, int length, int line):
+        start(start),
+        length(length),
+        line(line){
+        }
+
+    int start;
+    int length;
+    int line;
+};
+
+/* Files smaller than this are parsed in one go, starting threads would cost
+ * more than it saves.
+ */
+static const int MINIMUM_CHUNK_SIZE = 32 * 1024;
+static const int MAXIMUM_CHUNKS = 8;
+
+/* true if the line starting at `position' is a section header, [...].
+ * Comments can't start a section because the ';' comes first.
+ */
+static bool isSectionHeader(const char * data, int length, int position){
+    while (position < length && (data[position] == ' ' || data[position] == '\t')){
+        position += 1;
+    }
+    if (position >= length || data[position] != '['){
+        return false;
+    }
+    /* the title has to be closed on the same line, otherwise the parser would
+     * keep reading the title onto the next line and the split would be wrong.
+     */
+    for (position += 1; position < length; position++){
+        char c = data[position];
+        if (c == ']'){
+            return true;
+        }
+        if (c == '\n' || c == '\r' || c == ';'){
+            return false;
+        }
+    }
+    return false;
+}
+
+/* Every mugen file is a flat list of sections that don't depend on each other,
+ * so the buffer can be cut up right before any section header and each piece
+ * parsed by itself. Lines that end with a \ continue onto the next line so
+ * the next line is never a split point. Only '\n' counts as the end of a line
+ * because that is what the parser uses to count lines.
+ */
+static vector<SectionChunk> splitSections(const char * data, int length, int pieces){
+    vector<SectionChunk> chunks;
+    int target = length / pieces;
+    int chunkStart = 0;
+    int chunkLine = 1;
+    int line = 1;
+    for (int position = 0; position < length; position++){
+        if (data[position] != '\n'){
+            continue;
+        }
+
+        /* look back past a \r for a continuation character */
+        int last = position - 1;
+        if (last >= 0 && data[last] == '\r'){
+            last -= 1;
+        }
+        bool continues = last >= 0 && data[last] == '\\';
+
+        line += 1;
+        int next = position + 1;
+        if (!continues &&
+            next - chunkStart >= target &&
+            (int) chunks.size() < pieces - 1 &&
+            isSectionHeader(data, length, next)){
+            chunks.push_back(SectionChunk(chunkStart, next - chunkStart, chunkLine));
+            chunkStart = next;
+            chunkLine = line;
+        }
+    }
+
+    chunks.push_back(SectionChunk(chunkStart, length - chunkStart, chunkLine));
+    return chunks;
+}
+
+typedef const void * (*ParseFunction)(const char * data, int length, int line, bool stats);
+
+/* Parses one chunk on its own thread. Parse errors are not passed back,
+ * instead the chunk is parsed again on the calling thread so that the
+ * original exception type propagates to the caller.
+ */
+class ChunkParser{
+public:
+    ChunkParser(ParseFunction parse, const char * data, const SectionChunk & chunk):
+        parse(parse),
+        data(data),
+        chunk(chunk),
+        result(NULL),
+        failed(false),
+        thread(PaintownUtil::Thread::uninitializedValue){
+        }
+
+    void start(){
+        if (!PaintownUtil::Thread::createThread(&thread, NULL, (PaintownUtil::Thread::ThreadFunction) run, this)){
+            /* no thread, so just do it here */
+            thread = PaintownUtil::Thread::uninitializedValue;
+            run(this);
+        }
+    }
+
+    void wait(){
+        if (thread != PaintownUtil::Thread::uninitializedValue){
+            PaintownUtil::Thread::joinThread(thread);
+            thread = PaintownUtil::Thread::uninitializedValue;
+        }
+    }
+
+    static void * run(void * self){
+        ChunkParser * parser = (ChunkParser*) self;
+        parser->compute();
+        return NULL;
+    }
+
+    void compute(){
+        try{
+            result = (list<Ast::Section*>*) parse(data + chunk.start, chunk.length, chunk.line, false);
+        } catch (...){
+            failed = true;
+        }
+    }
+
+    /* throws the same exception the parser threw on the worker thread */
+    void reparse(){
+        list<Ast::Section*> * out = (list<Ast::Section*>*) parse(data + chunk.start, chunk.length, chunk.line, false);
+        /* shouldn't get here */
+        destroySections(out);
+        throw MugenException("Parse failed", __FILE__, __LINE__);
+    }
+
+    static void destroySections(list<Ast::Section*> * sections){
+        if (sections != NULL){
+            for (list<Ast::Section*>::iterator it = sections->begin(); it != sections->end(); it++){
+                delete *it;
+            }
+        }
+        delete sections;
+    }
+
+    ParseFunction parse;
+    const char * data;
+    SectionChunk chunk;
+    list<Ast::Section*> * result;
+    volatile bool failed;
+    PaintownUtil::Thread::Id thread;
+};
+
+/* Parse the chunks concurrently and splice the section lists together in
+ * file order.
+ */
+static list<Ast::Section*> * parseChunks(ParseFunction parse, const char * data, const vector<SectionChunk> & chunks){
+    vector<ChunkParser*> parsers;
+    for (vector<SectionChunk>::const_iterator it = chunks.begin(); it != chunks.end(); it++){
+        parsers.push_back(new ChunkParser(parse, data, *it));
+    }
+
+    /* the first chunk is parsed by this thread */
+    for (unsigned int i = 1; i < parsers.size(); i++){
+        parsers[i]->start();
+    }
+    parsers[0]->compute();
+
+    for (unsigned int i = 1; i < parsers.size(); i++){
+        parsers[i]->wait();
+    }
+
+    ChunkParser * failed = NULL;
+    for (vector<ChunkParser*>::iterator it = parsers.begin(); it != parsers.end(); it++){
+        if ((*it)->failed){
+            failed = *it;
+            break;
+        }
+    }
+
+    if (failed != NULL){
+        for (vector<ChunkParser*>::iterator it = parsers.begin(); it != parsers.end(); it++){
+            ChunkParser::destroySections((*it)->result);
+            (*it)->result = NULL;
+        }
+
+        try{
+            failed->reparse();
+        } catch (...){
+            for (vector<ChunkParser*>::iterator it = parsers.begin(); it != parsers.end(); it++){
+                delete *it;
+            }
+            throw;
+        }
+    }
+
+    list<Ast::Section*> * out = parsers[0]->result;
+    for (unsigned int i = 1; i < parsers.size(); i++){
+        out->splice(out->end(), *parsers[i]->result);
+        delete parsers[i]->result;
+    }
+
+    for (vector<ChunkParser*>::iterator it = parsers.begin(); it != parsers.end(); it++){
+        delete *it;
+    }
+
+    return out;
+}
+
+static list<Ast::Section*> * reallyParseX(const Filesystem::AbsolutePath & path, ParseFunction parse){
     if (!Storage::instance().exists(path)){
         throw MugenException(path.path() + " does not exist", __FILE__, __LINE__);
     }
@@ -172,11 +393,26 @@ static list<Ast::Section*> * reallyParseX(const Filesystem::AbsolutePath & path,
      * memory and pass it along to the parser. The PEG will actually do this operation
      * internally anyway given a filename so its not like this is has any overhead.
      */
-    char * data = new char[file->getSize()];
-    file->readLine(data, file->getSize());
+    int size = file->getSize();
+    char * data = new char[size];
+    file->readLine(data, size);
     list<Ast::Section*> * out = NULL;
     try{
-        out = (list<Ast::Section*>*) parse(data, file->getSize(), false);
+#ifdef PARSER_THREAD_LOCAL
+        int pieces = size / MINIMUM_CHUNK_SIZE;
+        if (pieces > MAXIMUM_CHUNKS){
+            pieces = MAXIMUM_CHUNKS;
+        }
+        if (pieces > 1){
+            vector<SectionChunk> chunks = splitSections(data, size, pieces);
+            Global::debug(1, "mugen-parse-cache") << "Parsing " << path.path() << " in " << chunks.size() << " pieces" << endl;
+            out = parseChunks(parse, data, chunks);
+        } else {
+            out = (list<Ast::Section*>*) parse(data, size, 1, false);
+        }
+#else
+        out = (list<Ast::Section*>*) parse(data, size, 1, false);
+#endif
     } catch (...){
         delete[] data;
         throw;
@@ -238,6 +474,17 @@ void ParseCache::destroy(){
     }
 }
 
+void ParseCache::forget(const Filesystem::AbsolutePath & path){
+    if (cache){
+        cache->forgetFile(path);
+    }
+}
+
+int ParseCache::modificationTime(const Filesystem::AbsolutePath & path){
+    PaintownUtil::ReferenceCount<Storage::File> file = Storage::instance().open(path);
+    return file != NULL ? file->getModificationTime() : 0;
+}
+
 ParseCache::ParseCache(){
     /* If there is already an existing cache then this object will not be the target of
      * static calls. If there is not an existing cache then this becomes the 'global' one.
@@ -255,6 +502,15 @@ void ParseCache::destroyCache(){
     defCache.destroy();
 }
 
+/* The file on disk is newer than the saved parse in the cache directory so
+ * only the in-memory copy has to go.
+ */
+void ParseCache::forgetFile(const Filesystem::AbsolutePath & path){
+    cmdCache.forget(path);
+    airCache.forget(path);
+    defCache.forget(path);
+}
+
 ParseCache::~ParseCache(){
     if (cache == this){
         cache = NULL;
@@ -24,6 +24,9 @@ public:
 
     PaintownUtil::ReferenceCount<Ast::AstParse> parse(const Filesystem::AbsolutePath & path);
 
+    /* drop the in-memory copy so the next parse() reads the file again */
+    void forget(const Filesystem::AbsolutePath & path);
+
     void destroy();
 
 protected:
@@ -69,6 +72,14 @@ public:
     static PaintownUtil::ReferenceCount<Ast::AstParse> parseAir(const Filesystem::AbsolutePath & path);
     static PaintownUtil::ReferenceCount<Ast::AstParse> parseDef(const Filesystem::AbsolutePath & path);
 
+    /* Forget the parse of a file that was changed on disk. The next parse
+     * of it will read the file again instead of using the cached copy.
+     */
+    static void forget(const Filesystem::AbsolutePath & path);
+
+    /* Modification time of a file, 0 if it can't be opened */
+    static int modificationTime(const Filesystem::AbsolutePath & path);
+
     /* clear the cache */
     static void destroy();
 protected:
@@ -77,6 +88,7 @@ protected:
     PaintownUtil::ReferenceCount<Ast::AstParse> doParseAir(const Filesystem::AbsolutePath & path);
     PaintownUtil::ReferenceCount<Ast::AstParse> doParseDef(const Filesystem::AbsolutePath & path);
     void destroyCache();
+    void forgetFile(const Filesystem::AbsolutePath & path);
 
     static ParseCache * cache;
 
@@ -356,6 +356,19 @@ public:
         setup();
     }
 
+    /* user-defined length where the first character of the input is on
+     * some line other than 1, such as a chunk cut out of a larger file.
+     */
+    Stream(const char * in, int length, int line):
+    temp(0),
+    buffer(in),
+    farthest(0),
+    last_line_info(-1){
+        max = length;
+        line_info[-1] = LineInfo(line, 1);
+        setup();
+    }
+
     void setup(){
         
         createMemo();
@@ -476,7 +489,7 @@ public:
     /* throws a ParseException */
     void reportError(const std::string & parsingContext){
         std::ostringstream out;
-        int line = 1;
+        int line = line_info[-1].line;
         int column = 1;
         for (int i = 0; i < farthest; i++){
             if (buffer[i] == '\n'){
@@ -7311,8 +7324,10 @@ Result rule_value(Stream & stream, const int position){
 }
         
 
+/* errorResult is never modified after it is constructed so that more than
+ * one thread can be inside the parser at the same time.
+ */
 static const void * doParse(Stream & stream, bool stats, const std::string & context){
-    errorResult.setError();
     Result done = rule_start(stream, 0);
     if (done.error()){
         stream.reportError(context);
@@ -7338,6 +7353,11 @@ const void * parse(const char * in, int length, bool stats = false){
     return doParse(stream, stats, "memory");
 }
 
+const void * parse(const char * in, int length, int line, bool stats){
+    Stream stream(in, length, line);
+    return doParse(stream, stats, "memory");
+}
+
 
 
     
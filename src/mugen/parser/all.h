@@ -9,6 +9,8 @@ namespace Mugen{
     namespace Def{
         extern const void * parse(const std::string & filename, bool stats = false);
         extern const void * parse(const char * in, int length, bool stats = false);
+        /* `line' is the line number of the first character in `in' */
+        extern const void * parse(const char * in, int length, int line, bool stats);
 
         class ParseException: public std::exception {
         public:
@@ -22,6 +24,8 @@ namespace Mugen{
     namespace Air{
         extern const void * parse(const std::string & filename, bool stats = false);
         extern const void * parse(const char * in, int length, bool stats = false);
+        /* `line' is the line number of the first character in `in' */
+        extern const void * parse(const char * in, int length, int line, bool stats);
 
         class ParseException: public std::exception {
         public:
@@ -36,6 +40,8 @@ namespace Mugen{
         extern const void * parse(const std::string & filename, bool stats = false);
         extern const void * parse(const char * data, bool stats = false);
         extern const void * parse(const char * in, int length, bool stats = false);
+        /* `line' is the line number of the first character in `in' */
+        extern const void * parse(const char * in, int length, int line, bool stats);
 
         class ParseException: public std::exception {
         public:
@@ -3,6 +3,7 @@
 
 #include <list>
 #include "mugen/ast/all.h"
+#include "reentrant.h"
 #include <exception>
 
 namespace GC{
@@ -16,16 +17,46 @@ namespace GC{
  * a new class, Collectable, with constructors and fields for every class
  * that is allocated. Collectable will call the appropriate destructor.
  */
+#ifdef PARSER_THREAD_LOCAL
+/* each thread gets its own list so that separate threads can parse
+ * different files (or different pieces of the same file) at the same time.
+ * only a pointer can be thread local so the list is created on demand
+ * and destroyed by cleanup().
+ */
+static PARSER_THREAD_LOCAL std::list<Ast::Collectable> * saved_pointers_local = 0;
+
+static std::list<Ast::Collectable> & savedPointers(){
+    if (saved_pointers_local == 0){
+        saved_pointers_local = new std::list<Ast::Collectable>();
+    }
+    return *saved_pointers_local;
+}
+
+static void releasePointers(){
+    delete saved_pointers_local;
+    saved_pointers_local = 0;
+}
+#else
 static std::list<Ast::Collectable> saved_pointers;
+
+static std::list<Ast::Collectable> & savedPointers(){
+    return saved_pointers;
+}
+
+static void releasePointers(){
+    saved_pointers.clear();
+}
+#endif
+
 typedef std::list<Ast::Section*> SectionList;
 
 template<class X>
 static void save(const X x){
-    saved_pointers.push_back(Ast::Collectable(x));
+    savedPointers().push_back(Ast::Collectable(x));
 }
 
 static void check(){
-    if (!(saved_pointers.size() == 0)){
+    if (!(savedPointers().size() == 0)){
         throw std::exception();
     }
 }
@@ -67,6 +98,7 @@ static void cleanup(SectionList * list){
      * but B to be dead.
      */
     std::map<const void *, int> memory;
+    std::list<Ast::Collectable> & saved_pointers = savedPointers();
 
     /* all unmarked pointers should be deleted but since the destructors
      * of AST nodes will delete child objects we only need to delete
@@ -165,7 +197,7 @@ static void cleanup(SectionList * list){
         }
     }
     // std::cout << "Destroying everything" << std::endl;
-    saved_pointers.clear();
+    releasePointers();
 }
 
 } /* GC */
@@ -0,0 +1,16 @@
+#ifndef _paintown_parser_reentrant_h
+#define _paintown_parser_reentrant_h
+
+/* The generated parsers have no global state of their own except for the
+ * list of allocated AST nodes kept by gc.h. If the compiler can put that list
+ * in thread local storage then any number of threads can be parsing at the
+ * same time, otherwise only one parse of a given kind (cmd, air, def) may be
+ * running at once.
+ */
+#if defined(__GNUC__)
+#define PARSER_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define PARSER_THREAD_LOCAL __declspec(thread)
+#endif
+
+#endif
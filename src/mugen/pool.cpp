@@ -0,0 +1,73 @@
+#include "pool.h"
+#include <new>
+
+namespace Mugen{
+
+MemoryPool::MemoryPool(std::size_t size, unsigned int maximumFree):
+size(size),
+maximumFree(maximumFree),
+live(0),
+highWater(0){
+}
+
+MemoryPool::~MemoryPool(){
+    for (std::vector<void*>::iterator it = freeBlocks.begin(); it != freeBlocks.end(); it++){
+        ::operator delete(*it);
+    }
+}
+
+void * MemoryPool::allocate(std::size_t size){
+    if (size != this->size){
+        return ::operator new(size);
+    }
+
+    PaintownUtil::Thread::ScopedLock scoped(lock);
+    live += 1;
+    if (live > highWater){
+        highWater = live;
+    }
+
+    if (freeBlocks.size() > 0){
+        void * memory = freeBlocks.back();
+        freeBlocks.pop_back();
+        return memory;
+    }
+
+    return ::operator new(size);
+}
+
+void MemoryPool::release(void * memory, std::size_t size){
+    if (memory == NULL){
+        return;
+    }
+
+    if (size != this->size){
+        ::operator delete(memory);
+        return;
+    }
+
+    PaintownUtil::Thread::ScopedLock scoped(lock);
+    live -= 1;
+    if (freeBlocks.size() < maximumFree){
+        freeBlocks.push_back(memory);
+    } else {
+        ::operator delete(memory);
+    }
+}
+
+int MemoryPool::getLive() const {
+    PaintownUtil::Thread::ScopedLock scoped(lock);
+    return live;
+}
+
+int MemoryPool::getHighWater() const {
+    PaintownUtil::Thread::ScopedLock scoped(lock);
+    return highWater;
+}
+
+int MemoryPool::getFree() const {
+    PaintownUtil::Thread::ScopedLock scoped(lock);
+    return freeBlocks.size();
+}
+
+}
@@ -0,0 +1,72 @@
+#ifndef _paintown_mugen_pool_h
+#define _paintown_mugen_pool_h
+
+#include <vector>
+#include <cstddef>
+#include <r-tech1/thread.h>
+
+namespace PaintownUtil = ::Util;
+
+namespace Mugen{
+
+/* Keeps the memory of destroyed objects around so that objects which are
+ * created and destroyed many times a second, like explods, helpers and
+ * projectiles, don't keep going back to the system allocator. Classes use
+ * it from their own operator new/delete.
+ *
+ * Only blocks of exactly `size' bytes are recycled, anything else (like a
+ * subclass) is passed on to the normal allocator.
+ */
+class MemoryPool{
+public:
+    /* at most `maximumFree' unused blocks are kept around */
+    MemoryPool(std::size_t size, unsigned int maximumFree);
+    virtual ~MemoryPool();
+
+    void * allocate(std::size_t size);
+    void release(void * memory, std::size_t size);
+
+    /* number of blocks currently handed out */
+    int getLive() const;
+
+    /* most blocks that were ever handed out at the same time */
+    int getHighWater() const;
+
+    /* number of blocks waiting to be reused */
+    int getFree() const;
+
+protected:
+    const std::size_t size;
+    const unsigned int maximumFree;
+    std::vector<void*> freeBlocks;
+    int live;
+    int highWater;
+    mutable PaintownUtil::Thread::LockObject lock;
+};
+
+/* Number of objects of one kind that are alive on a stage and the most that
+ * were ever alive at once. `limit' is the maximum allowed, same as the
+ * HelperMax/ExplodMax/PlayerProjectileMax options in mugen.cfg.
+ */
+struct EntityCount{
+    EntityCount(int limit):
+        live(0),
+        highWater(0),
+        limit(limit){
+        }
+
+    void update(int now){
+        live = now;
+        if (live > highWater){
+            highWater = live;
+        }
+    }
+
+    int live;
+    int highWater;
+    int limit;
+};
+
+}
+
+#endif
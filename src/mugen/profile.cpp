@@ -0,0 +1,307 @@
+#include "profile.h"
+#include "state-controller.h"
+#include <fstream>
+#include <algorithm>
+#include <iomanip>
+#include <r-tech1/debug.h>
+
+#ifdef WINDOWS
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+using std::string;
+using std::vector;
+using std::ostream;
+using std::endl;
+
+namespace Mugen{
+
+/* a trace of a minute of 60 frames already has well under this many events */
+static const unsigned int MaxTraceEvents = 1000000;
+
+Profiler::Frame::Frame(){
+    for (int i = 0; i < PhaseCount; i++){
+        times[i] = 0;
+    }
+}
+
+Profiler::ControllerCount::ControllerCount():
+characterId(-1),
+state(0),
+evaluations(0),
+activations(0),
+errors(0),
+triggerTime(0),
+activateTime(0){
+}
+
+Profiler::ControllerKey::ControllerKey(int characterId, const string & character, int state, unsigned int id):
+characterId(characterId),
+character(character),
+state(state),
+id(id){
+}
+
+bool Profiler::ControllerKey::operator<(const ControllerKey & him) const {
+    if (id != him.id){
+        return id < him.id;
+    }
+    if (state != him.state){
+        return state < him.state;
+    }
+    if (characterId != him.characterId){
+        return characterId < him.characterId;
+    }
+    return character < him.character;
+}
+
+Profiler::Profiler():
+enabled(false),
+tracing(false),
+active(false),
+traceFrames(0),
+countControllers(false){
+    reset();
+}
+
+const char * Profiler::phaseName(Phase phase){
+    switch (phase){
+        case Logic: return "logic";
+        case Act: return "act";
+        case Input: return "input";
+        case States: return "states";
+        case Physics: return "physics";
+        case Effects: return "effects";
+        case Background: return "background";
+        case Hud: return "hud";
+        case Render: return "render";
+        case RenderBackground: return "render-background";
+        case RenderCharacters: return "render-characters";
+        case RenderEffects: return "render-effects";
+        case RenderHud: return "render-hud";
+        case RenderFilters: return "render-filters";
+        case PhaseCount: break;
+    }
+    return "unknown";
+}
+
+bool Profiler::isRenderPhase(Phase phase){
+    return phase >= Render && phase < PhaseCount;
+}
+
+/* never returns 0 so a Scope can use 0 to mean it isn't timing anything */
+uint64_t Profiler::now(){
+#ifdef WINDOWS
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t) (counter.QuadPart * (1000000000.0 / frequency.QuadPart)) | 1;
+#elif defined(__APPLE__)
+    struct timeval time;
+    gettimeofday(&time, NULL);
+    return ((uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_usec * 1000) | 1;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return ((uint64_t) time.tv_sec * 1000000000 + time.tv_nsec) | 1;
+#endif
+}
+
+void Profiler::update(){
+    active = enabled || tracing;
+}
+
+void Profiler::setEnabled(bool enabled){
+    this->enabled = enabled;
+    update();
+}
+
+void Profiler::reset(){
+    for (int i = 0; i < PhaseCount; i++){
+        times[i] = 0;
+        counts[i] = 0;
+    }
+    current = Frame();
+    history.clear();
+}
+
+void Profiler::add(Phase phase, uint64_t start, uint64_t end, const char * label, int id){
+    add(phase, end - start);
+    if (events.size() < MaxTraceEvents){
+        Event event;
+        event.phase = phase;
+        event.start = start;
+        event.end = end;
+        if (label != NULL){
+            event.label = label;
+        }
+        event.id = id;
+        events.push_back(event);
+    }
+}
+
+void Profiler::endFrame(){
+    history.push_back(current);
+    while (history.size() > HistorySize){
+        history.pop_front();
+    }
+    current = Frame();
+
+    if (tracing){
+        if (traceFrames > 0){
+            traceFrames -= 1;
+        }
+        if (traceFrames == 0){
+            finishTrace();
+        }
+    }
+}
+
+void Profiler::startTrace(const string & path, unsigned int frames){
+    events.clear();
+    tracePath = path;
+    traceFrames = frames > 0 ? frames : 1;
+    tracing = true;
+    update();
+}
+
+void Profiler::finishTrace(){
+    tracing = false;
+    update();
+
+    std::ofstream out(tracePath.c_str());
+    if (!out){
+        Global::debug(0, "profile") << "Could not write trace to " << tracePath << endl;
+    } else {
+        writeTrace(out);
+        Global::debug(0, "profile") << "Wrote " << events.size() << " events to " << tracePath << endl;
+    }
+
+    events.clear();
+    /* let go of the memory, a trace can be big */
+    vector<Event>().swap(events);
+}
+
+static string jsonString(const string & what){
+    string out = "\"";
+    for (unsigned int i = 0; i < what.size(); i++){
+        char c = what[i];
+        switch (c){
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            default: {
+                if ((unsigned char) c < 0x20){
+                    out += ' ';
+                } else {
+                    out += c;
+                }
+            }
+        }
+    }
+    return out + "\"";
+}
+
+/* Chrome's trace format: complete ("X") events with times in microseconds.
+ * Everything runs on one thread so nesting comes from the times alone.
+ */
+void Profiler::writeTrace(ostream & out) const {
+    uint64_t first = events.empty() ? 0 : events[0].start;
+    for (vector<Event>::const_iterator it = events.begin(); it != events.end(); it++){
+        if (it->start < first){
+            first = it->start;
+        }
+    }
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+    for (vector<Event>::const_iterator it = events.begin(); it != events.end(); it++){
+        const Event & event = *it;
+        out << "{\"name\": " << jsonString(phaseName(event.phase))
+            << ", \"cat\": \"" << (isRenderPhase(event.phase) ? "render" : "logic") << "\""
+            << ", \"ph\": \"X\""
+            << ", \"ts\": " << (event.start - first) / 1000.0
+            << ", \"dur\": " << (event.end - event.start) / 1000.0
+            << ", \"pid\": 1, \"tid\": 1";
+        if (event.label != ""){
+            out << ", \"args\": {\"name\": " << jsonString(event.label);
+            if (event.id != -1){
+                out << ", \"id\": " << event.id;
+            }
+            out << "}";
+        }
+        out << "}" << (it + 1 != events.end() ? "," : "") << endl;
+    }
+    out << "]}" << endl;
+}
+
+void Profiler::setCountControllers(bool count){
+    countControllers = count;
+}
+
+Profiler::ControllerCount & Profiler::getControllerCount(int characterId, const string & character, int state, const StateController & controller){
+    ControllerKey key(characterId, character, state, controller.getId());
+    std::map<ControllerKey, ControllerCount>::iterator found = controllers.find(key);
+    if (found != controllers.end()){
+        return found->second;
+    }
+
+    ControllerCount & count = controllers[key];
+    count.characterId = characterId;
+    count.character = character;
+    count.state = state;
+    count.name = controller.getName();
+    count.type = StateController::typeName(controller.getType());
+    return count;
+}
+
+void Profiler::resetControllerCounts(){
+    controllers.clear();
+}
+
+static bool slowerController(const Profiler::ControllerCount & a, const Profiler::ControllerCount & b){
+    return a.triggerTime + a.activateTime > b.triggerTime + b.activateTime;
+}
+
+vector<Profiler::ControllerCount> Profiler::hottestControllers(unsigned int limit) const {
+    vector<ControllerCount> out;
+    for (std::map<ControllerKey, ControllerCount>::const_iterator it = controllers.begin(); it != controllers.end(); it++){
+        out.push_back(it->second);
+    }
+    std::sort(out.begin(), out.end(), slowerController);
+    if (out.size() > limit){
+        out.resize(limit);
+    }
+    return out;
+}
+
+void Profiler::writeControllerReport(ostream & out, unsigned int limit) const {
+    vector<ControllerCount> hottest = hottestControllers(limit);
+    if (hottest.empty()){
+        out << "No state controllers counted" << endl;
+        return;
+    }
+
+    /* times are in microseconds */
+    out << "total_us trigger_us activate_us evaluations activations errors id character state controller type" << endl;
+    for (vector<ControllerCount>::const_iterator it = hottest.begin(); it != hottest.end(); it++){
+        const ControllerCount & count = *it;
+        out << std::fixed << std::setprecision(1)
+            << (count.triggerTime + count.activateTime) / 1000.0 << " "
+            << count.triggerTime / 1000.0 << " "
+            << count.activateTime / 1000.0 << " "
+            << count.evaluations << " "
+            << count.activations << " "
+            << count.errors << " "
+            << count.characterId << " "
+            << "\"" << count.character << "\" "
+            << count.state << " "
+            << "\"" << count.name << "\" "
+            << count.type << endl;
+    }
+}
+
+}
@@ -0,0 +1,240 @@
+#ifndef _paintown_mugen_profile_h
+#define _paintown_mugen_profile_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <ostream>
+
+namespace Mugen{
+
+class StateController;
+
+/* Adds up how long each part of the stage logic and drawing takes. Every
+ * MatchContext has one and it is off until something turns it on, then a
+ * Scope costs a test of a bool.
+ *
+ * Phases nest, Act includes the Input and States time of the same
+ * character, so the times are not meant to add up to Logic.
+ *
+ * While a trace is being recorded every Scope is also kept as an event and
+ * written out in the Chrome trace format (chrome://tracing) at the end.
+ *
+ * Counting state controllers is separate from the rest because it needs a
+ * lookup for every controller that is checked.
+ */
+class Profiler{
+public:
+    enum Phase{
+        /* all of Stage::logic */
+        Logic,
+        /* Character::act, once per character */
+        Act,
+        /* reading commands in Character::act */
+        Input,
+        /* running state controllers */
+        States,
+        /* Stage::physics, collisions and pushing characters apart */
+        Physics,
+        /* sparks and projectiles */
+        Effects,
+        Background,
+        Hud,
+        /* all of Stage::render */
+        Render,
+        RenderBackground,
+        RenderCharacters,
+        RenderEffects,
+        RenderHud,
+        /* scaling the stage to the screen, done after Stage::render */
+        RenderFilters,
+        PhaseCount
+    };
+
+    /* how long each phase took in one frame */
+    struct Frame{
+        Frame();
+
+        uint64_t times[PhaseCount];
+    };
+
+    /* what happened to one state controller of one character. characters
+     * are told apart by id since helpers and both sides of a mirror match
+     * have the same name.
+     */
+    struct ControllerCount{
+        ControllerCount();
+
+        int characterId;
+        std::string character;
+        int state;
+        std::string name;
+        std::string type;
+
+        /* times the triggers were checked */
+        uint64_t evaluations;
+        /* times the controller ran */
+        uint64_t activations;
+        /* triggers or the controller threw */
+        uint64_t errors;
+        /* nanoseconds */
+        uint64_t triggerTime;
+        uint64_t activateTime;
+    };
+
+    /* frames kept for the overlay */
+    static const unsigned int HistorySize = 120;
+
+    Profiler();
+
+    static const char * phaseName(Phase phase);
+    static bool isRenderPhase(Phase phase);
+
+    /* nanoseconds from some fixed point */
+    static uint64_t now();
+
+    void setEnabled(bool enabled);
+
+    inline bool isEnabled() const {
+        return active;
+    }
+
+    void reset();
+
+    inline void add(Phase phase, uint64_t time){
+        times[phase] += time;
+        counts[phase] += 1;
+        current.times[phase] += time;
+    }
+
+    /* `id' is written with the label if it isn't -1 */
+    void add(Phase phase, uint64_t start, uint64_t end, const char * label, int id);
+
+    /* total nanoseconds spent in a phase since the last reset */
+    inline uint64_t getTime(Phase phase) const {
+        return times[phase];
+    }
+
+    /* number of times the phase was entered */
+    inline uint64_t getCount(Phase phase) const {
+        return counts[phase];
+    }
+
+    /* Called once everything for a frame has been drawn. Moves the times of
+     * the frame into the history and writes the trace once it has all the
+     * frames it wanted.
+     */
+    void endFrame();
+
+    /* oldest frame first */
+    inline const std::deque<Frame> & getHistory() const {
+        return history;
+    }
+
+    /* records the next `frames' frames and writes them to `path' */
+    void startTrace(const std::string & path, unsigned int frames);
+
+    inline bool isTracing() const {
+        return tracing;
+    }
+
+    void writeTrace(std::ostream & out) const;
+
+    void setCountControllers(bool count);
+
+    inline bool isCountingControllers() const {
+        return countControllers;
+    }
+
+    /* the counts for a controller of some state, made the first time */
+    ControllerCount & getControllerCount(int characterId, const std::string & character, int state, const StateController & controller);
+
+    void resetControllerCounts();
+
+    /* the `limit' controllers that took the longest, slowest first */
+    std::vector<ControllerCount> hottestControllers(unsigned int limit) const;
+
+    void writeControllerReport(std::ostream & out, unsigned int limit) const;
+
+    /* Times the rest of the block it is declared in. `label' and `id' show
+     * up in traces, the label has to stay around until the scope ends.
+     */
+    class Scope{
+    public:
+        Scope(Profiler & profiler, Phase phase, const char * label = NULL, int id = -1):
+        profiler(profiler),
+        phase(phase),
+        label(label),
+        id(id),
+        start(profiler.isEnabled() ? now() : 0){
+        }
+
+        ~Scope(){
+            if (start != 0){
+                if (profiler.isTracing()){
+                    profiler.add(phase, start, now(), label, id);
+                } else {
+                    profiler.add(phase, now() - start);
+                }
+            }
+        }
+
+    protected:
+        Profiler & profiler;
+        const Phase phase;
+        const char * label;
+        const int id;
+        const uint64_t start;
+
+    private:
+        Scope(const Scope &);
+        Scope & operator=(const Scope &);
+    };
+
+protected:
+    struct Event{
+        Phase phase;
+        uint64_t start;
+        uint64_t end;
+        std::string label;
+        int id;
+    };
+
+    void update();
+    void finishTrace();
+
+    bool enabled;
+    bool tracing;
+    /* enabled or tracing */
+    bool active;
+    uint64_t times[PhaseCount];
+    uint64_t counts[PhaseCount];
+
+    Frame current;
+    std::deque<Frame> history;
+
+    std::string tracePath;
+    unsigned int traceFrames;
+    std::vector<Event> events;
+
+    /* character id and name, state and controller id */
+    struct ControllerKey{
+        ControllerKey(int characterId, const std::string & character, int state, unsigned int id);
+
+        bool operator<(const ControllerKey & him) const;
+
+        int characterId;
+        std::string character;
+        int state;
+        unsigned int id;
+    };
+
+    bool countControllers;
+    std::map<ControllerKey, ControllerCount> controllers;
+};
+
+}
+
+#endif
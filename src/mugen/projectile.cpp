@@ -56,6 +56,20 @@ lastCanceled(0){
 Projectile::~Projectile(){
 }
 
+static MemoryPool projectilePool(sizeof(Projectile), 256);
+
+void * Projectile::operator new(std::size_t size){
+    return projectilePool.allocate(size);
+}
+
+void Projectile::operator delete(void * memory, std::size_t size){
+    projectilePool.release(memory, size);
+}
+
+const MemoryPool & Projectile::getPool(){
+    return projectilePool;
+}
+
 const CharacterId & Projectile::getOwner() const {
     return owner;
 }
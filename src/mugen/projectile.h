@@ -5,6 +5,7 @@
 #include "object.h"
 #include "animation.h"
 #include "common.h"
+#include "pool.h"
 #include <vector>
 
 namespace Graphics{
@@ -75,6 +76,11 @@ public:
         return hit;
     }
 
+    /* Projectiles are created and destroyed constantly so their memory is recycled */
+    static void * operator new(std::size_t size);
+    static void operator delete(void * memory, std::size_t size);
+    static const MemoryPool & getPool();
+
 protected:
     CharacterId owner;
     int spritePriority;
@@ -10,6 +10,19 @@ Random::Random(){
     init();
 }
 
+Random::Random(uint32_t seed){
+    /* splitmix64 spreads the seed over the whole state */
+    uint64_t mix = seed;
+    index = 0;
+    for (int i = 0; i < 16; i++){
+        mix += 0x9E3779B97F4A7C15ULL;
+        uint64_t value = mix;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        state[i] = value ^ (value >> 31);
+    }
+}
+
 Random::Random(const Random & copy){
     memcpy(state, copy.state, sizeof(state));
     index = copy.index;
@@ -75,36 +88,15 @@ Random Random::deserialize(const Token * token){
     return out;
 }
 
-PaintownUtil::ReferenceCount<Random> Random::current;
-PaintownUtil::ReferenceCount<Random> Random::getState(){
-    if (current == NULL){
-        current = PaintownUtil::ReferenceCount<Random>(new Random());
-    }
-
-    return current;
-}
-    
-void Random::setState(const Random & what){
-    current = PaintownUtil::ReferenceCount<Random>(new Random(what));
-}
-
-uint32_t Random::random(){
-    return Random::getState()->next();
-}
-
-uint32_t random(){
-    return Random::random();
-}
-
-uint32_t random(int q){
-    if (q <= 0){
+uint32_t Random::next(int high){
+    if (high <= 0){
         return 0;
     }
-    return Mugen::random() % q;
+    return ((uint32_t) next()) % high;
 }
 
-uint32_t random(int low, int high){
-    return Mugen::random(high - low) + low;
+uint32_t Random::next(int low, int high){
+    return next(high - low) + low;
 }
 
 }
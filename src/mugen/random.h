@@ -11,21 +11,25 @@ namespace Mugen{
 
 /* Uses the WELL 512 random algorithm.
  * http://www.iro.umontreal.ca/~panneton/WELLRNG.html
+ *
+ * There is no global generator, each match has its own in its MatchContext.
  */
 class Random{
 public:
-    /* Uses time() for default initialization */
+    /* Uses rand() for default initialization */
     Random();
+    /* Always starts the same way for the same seed */
+    explicit Random(uint32_t seed);
     Random(const Random & copy);
 
     Random & operator=(const Random &);
 
     uint64_t next();
 
-    static uint32_t random();
-
-    static PaintownUtil::ReferenceCount<Random> getState();
-    static void setState(const Random & what);
+    /* 0 to high - 1, or 0 if high is not positive */
+    uint32_t next(int high);
+    /* low to high - 1 */
+    uint32_t next(int low, int high);
 
     Token * serialize() const;
     static Random deserialize(const Token * token);
@@ -35,14 +39,8 @@ protected:
 
     uint64_t state[16];
     uint32_t index;
-
-    static PaintownUtil::ReferenceCount<Random> current;
 };
 
-uint32_t random();
-uint32_t random(int high);
-uint32_t random(int low, int high);
-
 }
 
 #endif
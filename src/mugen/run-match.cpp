@@ -9,6 +9,8 @@
 #include <r-tech1/message-queue.h>
 // #include <r-tech1/lz4/lz4.h>
 #include <r-tech1/init.h>
+#include <r-tech1/file-system.h>
+#include <r-tech1/timedifference.h>
 #include "game.h"
 #include "stage.h"
 #include "factory/font_render.h"
@@ -18,6 +20,7 @@
 #include "config.h"
 #include "character.h"
 #include "world.h"
+#include "profile.h"
 
 using std::string;
 using std::ostringstream;
@@ -46,6 +49,7 @@ enum MugenInput{
     QuitGame,
     SetHealth,
     ShowFps,
+    ShowProfile,
     ToggleConsole,
 };
 
@@ -328,13 +332,44 @@ static Token * filterTokens(Token * start){
     return out;
 }
 
+/* Reload the state, command and animation files of the players that were
+ * changed since the match started. Returns a line for each reloaded file or error.
+ */
+static vector<string> reloadCharacters(Mugen::Stage * stage){
+    vector<string> lines;
+    vector<Character*> players = stage->getPlayers();
+    for (vector<Character*>::iterator it = players.begin(); it != players.end(); it++){
+        Character * player = *it;
+        try{
+            TimeDifference time;
+            time.startTime();
+            vector<Filesystem::AbsolutePath> changed = player->reloadChangedFiles();
+            time.endTime();
+            for (vector<Filesystem::AbsolutePath>::iterator file = changed.begin(); file != changed.end(); file++){
+                lines.push_back("Reloaded " + Storage::instance().cleanse(*file).path());
+            }
+            if (changed.size() > 0){
+                stage->forgetHelperResources(player);
+                lines.push_back(time.printTime(player->getDisplayName()));
+            }
+        } catch (const MugenException & fail){
+            lines.push_back("Could not reload " + player->getDisplayName() + ": " + fail.getFullReason());
+        } catch (const Exception::Base & fail){
+            lines.push_back("Could not reload " + player->getDisplayName() + ": " + fail.getTrace());
+        }
+    }
+    return lines;
+}
+
 class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
     public:
-        LogicDraw(Mugen::Stage * stage, bool & show_fps, Console::Console & console, RunMatchOptions & options):
+        LogicDraw(Mugen::Stage * stage, bool & show_fps, bool & show_profile, bool & watchFiles, Console::Console & console, RunMatchOptions & options):
         endMatch(false),
         gameSpeed(Data::getInstance().getGameSpeed()),
         stage(stage),
         show_fps(show_fps),
+        show_profile(show_profile),
+        watchFiles(watchFiles),
         console(console),
         gameTicks(0),
         totalTicks(0),
@@ -353,6 +388,7 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
             gameInput.set(Joystick::Quit, QuitGame);
             gameInput.set(Keyboard::Key_F5, SetHealth);
             gameInput.set(Keyboard::Key_F9, ShowFps);
+            gameInput.set(Keyboard::Key_F10, ShowProfile);
             gameInput.set(Keyboard::Key_TILDE, ToggleConsole);
             gameInput.set(Keyboard::Key_LEFT, ReplayRewindLarge);
             gameInput.set(Keyboard::Key_RIGHT, ReplayForwardLarge);
@@ -387,6 +423,10 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
         double gameSpeed;
         Mugen::Stage * stage;
         bool & show_fps;
+        /* draw the profiler graph over the stage */
+        bool & show_profile;
+        /* check for changed character files once a second */
+        bool & watchFiles;
         Console::Console & console;
         /* global info messages will appear in the console */
         MessageQueue messages;
@@ -553,6 +593,11 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
                                 logic.show_fps = ! logic.show_fps;
                                 break;
                             }
+                            case ShowProfile: {
+                                logic.show_profile = ! logic.show_profile;
+                                logic.stage->getContext().getProfiler().setEnabled(logic.show_profile);
+                                break;
+                            }
                             case ToggleConsole: {
                                 logic.console.toggle();
                                 break;
@@ -613,6 +658,13 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
                 if (totalTicks % secondsInTicks(3) == 0){
                     snapshots[totalTicks] = stage->snapshotState();
                 }
+
+                if (watchFiles && totalTicks % secondsInTicks(1) == 0){
+                    vector<string> lines = reloadCharacters(stage);
+                    for (vector<string>::iterator it = lines.begin(); it != lines.end(); it++){
+                        console.addLine(*it);
+                    }
+                }
             }
 
             while (messages.hasAny()){
@@ -652,6 +704,86 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
             font.printf(x, y, color, screen, message, 0);
         }
 
+        /* A bar per frame, newest on the right, split into the parts of the
+         * logic and drawing that took the time. Phases that contain others
+         * are left out so nothing is counted twice, whatever they did
+         * themselves goes into 'other'.
+         */
+        void drawProfile(const Profiler & profiler, const Graphics::Bitmap & screen){
+            struct Part{
+                Profiler::Phase phase;
+                int red, green, blue;
+            };
+
+            static const Part parts[] = {
+                {Profiler::Input, 255, 255, 64},
+                {Profiler::States, 255, 128, 0},
+                {Profiler::Physics, 255, 32, 32},
+                {Profiler::Effects, 255, 64, 255},
+                {Profiler::Background, 128, 64, 32},
+                {Profiler::Hud, 160, 160, 160},
+                {Profiler::RenderBackground, 32, 128, 255},
+                {Profiler::RenderCharacters, 32, 255, 64},
+                {Profiler::RenderEffects, 128, 255, 255},
+                {Profiler::RenderHud, 96, 96, 255},
+                {Profiler::RenderFilters, 0, 160, 128},
+            };
+            const int partCount = sizeof(parts) / sizeof(Part);
+
+            const std::deque<Profiler::Frame> & history = profiler.getHistory();
+
+            const int barWidth = 2;
+            const int height = 100;
+            /* nanoseconds for the full height of the graph, two frames at 60hz */
+            const double full = 2 * 1000000000.0 / 60;
+            const int x1 = 5;
+            const int y2 = screen.getHeight() - 5;
+            const int x2 = x1 + Profiler::HistorySize * barWidth;
+            const int y1 = y2 - height;
+
+            Graphics::Bitmap::transBlender(0, 0, 0, 160);
+            screen.translucent().rectangleFill(x1, y1, x2, y2, Graphics::makeColor(0, 0, 0));
+
+            uint64_t totals[Profiler::PhaseCount + 1] = {0};
+            int x = x2 - (int) history.size() * barWidth;
+            for (std::deque<Profiler::Frame>::const_iterator it = history.begin(); it != history.end(); it++, x += barWidth){
+                const Profiler::Frame & frame = *it;
+                uint64_t total = frame.times[Profiler::Logic] + frame.times[Profiler::Render] + frame.times[Profiler::RenderFilters];
+                uint64_t sum = 0;
+                int y = y2;
+                for (int i = 0; i < partCount; i++){
+                    uint64_t time = frame.times[parts[i].phase];
+                    totals[parts[i].phase] += time;
+                    sum += time;
+                    int size = (int) (time * height / full);
+                    if (size > 0 && y > y1){
+                        screen.rectangleFill(x, PaintownUtil::max(y - size, y1), x + barWidth - 1, y - 1, Graphics::makeColor(parts[i].red, parts[i].green, parts[i].blue));
+                        y -= size;
+                    }
+                }
+
+                uint64_t other = total > sum ? total - sum : 0;
+                totals[Profiler::PhaseCount] += other;
+                int size = (int) (other * height / full);
+                if (size > 0 && y > y1){
+                    screen.rectangleFill(x, PaintownUtil::max(y - size, y1), x + barWidth - 1, y - 1, Graphics::makeColor(255, 255, 255));
+                }
+            }
+
+            /* one frame at 60hz */
+            screen.hLine(x1, y2 - height / 2, x2, Graphics::makeColor(255, 0, 0));
+
+            /* average time per frame of each part */
+            const ::Font & font = ::Font::getDefaultFont(10, 10);
+            int frames = PaintownUtil::max((int) history.size(), 1);
+            int y = y1 - font.getHeight() * (partCount + 1) - 2;
+            for (int i = 0; i < partCount; i++){
+                font.printf(x1, y, Graphics::makeColor(parts[i].red, parts[i].green, parts[i].blue), screen, "%s %.2fms", 0, Profiler::phaseName(parts[i].phase), totals[parts[i].phase] / 1000000.0 / frames);
+                y += font.getHeight();
+            }
+            font.printf(x1, y, Graphics::makeColor(255, 255, 255), screen, "other %.2fms", 0, totals[Profiler::PhaseCount] / 1000000.0 / frames);
+        }
+
         virtual void draw(const Graphics::Bitmap & screen){
             if (show_fps){
                 if (Global::second_counter % 2 == 0){
@@ -664,19 +796,30 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
                 }
             }
 
+            Profiler & profiler = stage->getContext().getProfiler();
             if (stage->isZoomed()){
                 Graphics::Bitmap work(DEFAULT_WIDTH, DEFAULT_HEIGHT);
                 stage->render(&work);
                 // Global::debug(0) << "X1 " << stage->zoomX1() << " Y1 " << stage->zoomY1() << " X2 " << stage->zoomX2() << " Y2 " << stage->zoomY2() << std::endl;
+                Profiler::Scope profile(profiler, Profiler::RenderFilters);
                 work.Stretch(screen, stage->zoomX1(), stage->zoomY1(), stage->zoomX2() - stage->zoomX1(), stage->zoomY2() - stage->zoomY1(), 0, 0, screen.getWidth(), screen.getHeight());
             } else {
                 Graphics::StretchedBitmap work(DEFAULT_WIDTH, DEFAULT_HEIGHT, screen, Graphics::StretchedBitmap::NoClear, Graphics::qualityFilterName(::Configuration::getQualityFilter()));
                 work.start();
                 stage->render(&work);
                 options.draw(work);
+                Profiler::Scope profile(profiler, Profiler::RenderFilters);
                 work.finish();
             }
 
+            if (profiler.isEnabled()){
+                profiler.endFrame();
+            }
+
+            if (show_profile){
+                drawProfile(profiler, screen);
+            }
+
             FontRender * render = FontRender::getInstance();
             render->render(&screen);
             console.draw(screen);
@@ -728,6 +871,8 @@ void Game::runMatch(Mugen::Stage * stage, const std::string & musicOverride, Run
     Music::play();
     */
 
+    bool watchFiles = false;
+    bool show_profile = false;
     Console::Console console(150);
     {
         class CommandQuit: public Console::Command {
@@ -897,6 +1042,116 @@ void Game::runMatch(Mugen::Stage * stage, const std::string & musicOverride, Run
             }
         };
 
+        class CommandProfile: public Console::Command {
+        public:
+            CommandProfile(Mugen::Stage * stage, bool & showProfile):
+            stage(stage),
+            showProfile(showProfile){
+            }
+
+            Mugen::Stage * stage;
+            bool & showProfile;
+
+            string getDescription() const {
+                return "profile [trace file [frames]] - Show where each frame goes. 'trace' writes the next frames (default 300) to a chrome://tracing file";
+            }
+
+            string act(const string & line){
+                std::istringstream input(line);
+                string command;
+                string argument;
+                string file;
+                unsigned int frames = 300;
+                input >> command >> argument >> file >> frames;
+                Profiler & profiler = stage->getContext().getProfiler();
+                if (argument == "trace"){
+                    if (file == ""){
+                        file = "mugen-trace.json";
+                    }
+                    profiler.startTrace(file, frames);
+                    ostringstream out;
+                    out << "Tracing " << frames << " frames to " << file;
+                    return out.str();
+                }
+
+                showProfile = !showProfile;
+                profiler.setEnabled(showProfile);
+                return showProfile ? "Profiling" : "Stopped profiling";
+            }
+        };
+
+        class CommandControllers: public Console::Command {
+        public:
+            CommandControllers(Mugen::Stage * stage):
+            stage(stage){
+            }
+
+            Mugen::Stage * stage;
+
+            string getDescription() const {
+                return "controllers [report [#]|reset] - Count how often each state controller is checked and run and how long it takes. 'report' lists the # slowest";
+            }
+
+            string act(const string & line){
+                std::istringstream input(line);
+                string command;
+                string argument;
+                unsigned int limit = 15;
+                input >> command >> argument >> limit;
+                Profiler & profiler = stage->getContext().getProfiler();
+                if (argument == "report"){
+                    ostringstream out;
+                    profiler.writeControllerReport(out, limit);
+                    return out.str();
+                }
+
+                if (argument == "reset"){
+                    profiler.resetControllerCounts();
+                    return "Cleared state controller counts";
+                }
+
+                profiler.setCountControllers(!profiler.isCountingControllers());
+                return profiler.isCountingControllers() ? "Counting state controllers" : "Stopped counting state controllers";
+            }
+        };
+
+        class CommandReload: public Console::Command {
+        public:
+            CommandReload(Mugen::Stage * stage, bool & watchFiles):
+            stage(stage),
+            watchFiles(watchFiles){
+            }
+
+            Mugen::Stage * stage;
+            bool & watchFiles;
+
+            string getDescription() const {
+                return "reload [watch] - Reload changed state, command and animation files of the players. 'watch' toggles checking every second";
+            }
+
+            string act(const string & line){
+                std::istringstream input(line);
+                string command;
+                string argument;
+                input >> command >> argument;
+                if (argument == "watch"){
+                    watchFiles = !watchFiles;
+                    return watchFiles ? "Watching character files" : "Stopped watching character files";
+                }
+
+                vector<string> lines = reloadCharacters(stage);
+                if (lines.size() == 0){
+                    return "Nothing changed";
+                }
+
+                ostringstream out;
+                for (vector<string>::iterator it = lines.begin(); it != lines.end(); it++){
+                    out << *it << "\n";
+                }
+                return out.str();
+            }
+        };
+
         console.addCommand("quit", PaintownUtil::ReferenceCount<Console::Command>(new CommandQuit()));
         console.addAlias("exit", "quit");
         console.addCommand("help", PaintownUtil::ReferenceCount<Console::Command>(new CommandHelp(console)));
@@ -905,13 +1160,23 @@ void Game::runMatch(Mugen::Stage * stage, const std::string & musicOverride, Run
         console.addCommand("record", PaintownUtil::ReferenceCount<Console::Command>(new CommandRecord(stage)));
         console.addCommand("debug", PaintownUtil::ReferenceCount<Console::Command>(new CommandDebug(stage)));
         console.addCommand("change-state", PaintownUtil::ReferenceCount<Console::Command>(new CommandChangeState(stage)));
+        console.addCommand("reload", PaintownUtil::ReferenceCount<Console::Command>(new CommandReload(stage, watchFiles)));
+        console.addCommand("profile", PaintownUtil::ReferenceCount<Console::Command>(new CommandProfile(stage, show_profile)));
+        console.addCommand("controllers", PaintownUtil::ReferenceCount<Console::Command>(new CommandControllers(stage)));
     }
 
     bool show_fps = false;
 
-    LogicDraw all(stage, show_fps, console, options);
+    LogicDraw all(stage, show_fps, show_profile, watchFiles, console, options);
 
     PaintownUtil::standardLoop(all, all);
+
+    Profiler & profiler = stage->getContext().getProfiler();
+    if (profiler.isCountingControllers()){
+        ostringstream report;
+        profiler.writeControllerReport(report, 30);
+        Global::debug(0, "profile") << "Slowest state controllers this match" << std::endl << report.str();
+    }
 }
 
 }
@@ -21,6 +21,7 @@
 #include <r-tech1/funcs.h>
 #include <r-tech1/file-system.h>
 #include <r-tech1/graphics/bitmap.h>
+#include <r-tech1/font.h>
 // #include "util/console.h"
 /*
 #include "object/animation.h"
@@ -171,9 +172,15 @@ p2points(0),
 // console(new Console::Console(CONSOLE_SIZE)),
 debugMode(false),
 loaded(false),
+/* Same as the defaults for HelperMax, ExplodMax and PlayerProjectileMax in mugen 1.0 */
+helperCount(56),
+effectCount(512),
+projectileCount(256),
+projectilesChecked(false),
 gameHUD(NULL),
 gameOver(false),
 objectId(0),
+context(new MatchContext()),
 replay(false){
     getStateData().gameRate = 1;
 }
@@ -851,6 +858,143 @@ void Mugen::Stage::doProjectileToProjectileCollision(Projectile * mine, Projecti
     }
 }
 
+void Mugen::Stage::indexCharacter(Character * who){
+    int left = 0;
+    int right = 0;
+    if (BroadPhase::extent(who->getAttackBoxes(), who->getDefenseBoxes(), (int) who->getX(), left, right)){
+        characterPhase.update(who->getHotSlot(), left, right);
+    } else {
+        characterPhase.remove(who->getHotSlot());
+    }
+}
+
+void Mugen::Stage::indexProjectile(unsigned int index){
+    Projectile * projectile = projectiles[index];
+    int left = 0;
+    int right = 0;
+    if (BroadPhase::extent(projectile->getAttackBoxes(), projectile->getDefenseBoxes(), (int) projectile->getX(), left, right)){
+        projectilePhase.update(index, left, right);
+    } else {
+        projectilePhase.remove(index);
+    }
+}
+
+/* Called before the physics of any character is done in a tick */
+void Mugen::Stage::beginCollisions(){
+    characterPhase.clear();
+    projectilePhase.clear();
+    projectilesChecked = false;
+
+    objectOrder.clear();
+    for (unsigned int index = 0; index < objects.size(); index++){
+        Character * who = objects[index];
+        who->bindHotState(&hotState);
+        if ((int) objectOrder.size() <= who->getHotSlot()){
+            objectOrder.resize(who->getHotSlot() + 1, 0);
+        }
+        objectOrder[who->getHotSlot()] = index;
+        indexCharacter(who);
+    }
+
+    for (unsigned int index = 0; index < projectiles.size(); index++){
+        indexProjectile(index);
+    }
+}
+
+/* Characters whose boxes could touch the boxes of `who', in the same order
+ * as they are in `objects' so that hits happen in the same order as they
+ * did when every character was checked.
+ */
+void Mugen::Stage::nearbyCharacters(Character * who, vector<Character*> & out){
+    int left = 0;
+    int right = 0;
+    if (!characterPhase.find(who->getHotSlot(), left, right)){
+        return;
+    }
+
+    vector<int> slots;
+    characterPhase.query(left, right, slots);
+
+    vector<pair<int, Character*> > sorted;
+    for (vector<int>::iterator it = slots.begin(); it != slots.end(); it++){
+        int slot = *it;
+        if (slot != who->getHotSlot() && hotState.owner[slot] != NULL){
+            sorted.push_back(pair<int, Character*>(objectOrder[slot], hotState.owner[slot]));
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    for (vector<pair<int, Character*> >::iterator it = sorted.begin(); it != sorted.end(); it++){
+        out.push_back(it->second);
+    }
+}
+
+/* Index into `projectiles' of the projectiles that could touch `who', in order */
+void Mugen::Stage::nearbyProjectiles(Character * who, vector<int> & out){
+    int left = 0;
+    int right = 0;
+    if (!characterPhase.find(who->getHotSlot(), left, right)){
+        return;
+    }
+
+    projectilePhase.query(left, right, out);
+    std::sort(out.begin(), out.end());
+}
+
+/* Projectiles only move in runCycle so this has to be done once per tick */
+void Mugen::Stage::doProjectileToProjectileCollisions(){
+    for (unsigned int index = 0; index < projectiles.size(); index++){
+        Projectile * projectile = projectiles[index];
+        int left = 0;
+        int right = 0;
+        if (!projectilePhase.find(index, left, right)){
+            continue;
+        }
+
+        vector<int> nearby;
+        projectilePhase.query(left, right, nearby);
+        std::sort(nearby.begin(), nearby.end());
+        for (vector<int>::iterator it = nearby.begin(); it != nearby.end(); it++){
+            Projectile * other = projectiles[*it];
+            /* I'm assuming that projectiles fired from the same character cant cancel each other */
+            /* FIXME: should we test to see if both projectiles can collide or will they
+             * cancel each other even if one has its miss time active?
+             */
+            if (other != projectile && other->getOwner() != projectile->getOwner()){
+                doProjectileToProjectileCollision(projectile, other);
+                /* canceled projectiles switch animations */
+                indexProjectile(index);
+                indexProjectile(*it);
+            }
+        }
+    }
+}
+
+void Mugen::Stage::applyForces(Character * mugen){
+    const int slot = mugen->getHotSlot();
+    const Physics::Type physics = hotState.physics[slot];
+    if (physics == Mugen::Physics::Stand || physics == Mugen::Physics::Crouch){
+        /* friction */
+        if (hotState.y[slot] == 0){
+            if (physics == Mugen::Physics::Crouch){
+                hotState.velocityX[slot] *= hotState.crouchFriction[slot];
+            } else {
+                hotState.velocityX[slot] *= hotState.standFriction[slot];
+            }
+            if (hotState.beingHit[slot] &&
+                hotState.velocityX[slot] < 0 &&
+                getTicks() % 5 == 0){
+                createDust((int) hotState.x[slot], (int) mugen->getRY());
+            }
+        }
+    } else if (physics == Mugen::Physics::Air){
+        /* gravity */
+        if (hotState.y[slot] < 0){
+            hotState.velocityY[slot] += hotState.gravity[slot];
+        }
+    }
+}
+
 /* for helpers and players */
 void Mugen::Stage::physics(Character * mugen){
     // Z/Y offset
@@ -873,28 +1017,21 @@ void Mugen::Stage::physics(Character * mugen){
 
     mugen->doMovement(*this);
 
-    if (mugen->getCurrentPhysics() == Mugen::Physics::Stand ||
-        mugen->getCurrentPhysics() == Mugen::Physics::Crouch){
-        // mugen->setY(0);
-        /* friction */
-        if (mugen->getY() == 0){
-            mugen->setXVelocity(mugen->getXVelocity() * mugen->getGroundFriction());
-            if (mugen->getMoveType() == Mugen::Move::Hit && 
-                mugen->getXVelocity() < 0 &&
-                getTicks() % 5 == 0){
-                createDust((int) mugen->getX(), (int) mugen->getRY());
-            }
-        }
-    } else if (mugen->getCurrentPhysics() == Mugen::Physics::Air){
-        /* gravity */
-        if (mugen->getY() < 0){
-            mugen->setYVelocity(mugen->getYVelocity() + mugen->getGravity());
-        }
+    mugen->bindHotState(&hotState);
+    applyForces(mugen);
+    indexCharacter(mugen);
+
+    if (!projectilesChecked){
+        projectilesChecked = true;
+        doProjectileToProjectileCollisions();
     }
 
     if (mugen->isAttacking() && mugen->getHit().alive){
 
-        for (vector<Mugen::Character*>::iterator enem = objects.begin(); enem != objects.end(); ++enem){
+        /* only the things whose boxes are close enough to touch */
+        vector<Mugen::Character*> nearby;
+        nearbyCharacters(mugen, nearby);
+        for (vector<Mugen::Character*>::iterator enem = nearby.begin(); enem != nearby.end(); ++enem){
             Mugen::Character * enemy = *enem;
             if (enemy->getAlliance() != mugen->getAlliance() && enemy->canBeHit((Character*) mugen)){
 		// Check attack distance to make sure we begin block at the correct distance
@@ -932,6 +1069,10 @@ void Mugen::Stage::physics(Character * mugen){
 
                     enemy->didReverse(*this, mugen, enemy->getReversal());
                     mugen->wasReversed(*this, enemy, enemy->getReversal());
+
+                    /* a reversal changes the state and so the boxes */
+                    indexCharacter(enemy);
+                    indexCharacter(mugen);
                 } else if ((collision || blockingCollision) &&
                            enemy->isBlocking(mugen->getHit()) &&
                            enemy->compatibleHitFlag(mugen->getHit().guardFlag)){
@@ -950,6 +1091,12 @@ void Mugen::Stage::physics(Character * mugen){
                     }
                     mugen->didHitGuarded(enemy, *this);
                     enemy->guarded(*this, mugen, mugen->getHit());
+
+                    /* guarding changes the state and pushes back, characters
+                     * later in this tick have to see where enemy is now
+                     */
+                    indexCharacter(enemy);
+                    indexCharacter(mugen);
                 } else if (collision && enemy->compatibleHitFlag(mugen->getHit().hitFlag)){
                     addSpark((int)(mugen->getHit().sparkPosition.x + enemy->getX()),
                              (int)(mugen->getHit().sparkPosition.y + enemy->getRY()),
@@ -963,33 +1110,31 @@ void Mugen::Stage::physics(Character * mugen){
                      */
                     mugen->didHit(enemy, *this);
                     enemy->wasHit(*this, mugen, mugen->getHit());
+
+                    indexCharacter(enemy);
+                    indexCharacter(mugen);
                 }
             }
         }
     }
 
-    for (vector<Projectile*>::iterator it = projectiles.begin(); it != projectiles.end(); it++){
-        Projectile * projectile = *it;
+    vector<int> nearby;
+    nearbyProjectiles(mugen, nearby);
+    for (vector<int>::iterator it = nearby.begin(); it != nearby.end(); it++){
+        Projectile * projectile = projectiles[*it];
         if (projectile->getOwner() != mugen->getId() && projectile->canCollide()){
             doProjectileCollision(projectile, mugen);
-        }
-
-        for (vector<Projectile*>::iterator it2 = projectiles.begin(); it2 != projectiles.end(); it2++){
-            Projectile * other = *it2;
-            /* I'm assuming that projectiles fired from the same character cant cancel each other */
-            /* FIXME: should we test to see if both projectiles can collide or will they
-             * cancel each other even if one has its miss time active?
+            /* the projectile might have switched to its hit animation and
+             * mugen might have been hit
              */
-            if (other != projectile && other->getOwner() != projectile->getOwner()){
-                doProjectileToProjectileCollision(projectile, other);
-            }
+            indexProjectile(*it);
+            indexCharacter(mugen);
         }
     }
 
-    /* TODO: projectile collisions with other projectiles */
-
     // Check collisions
-    for (vector<Mugen::Character*>::iterator enem = objects.begin(); enem != objects.end(); ++enem){
+    /* players are in the same order in `players' as in `objects' */
+    for (vector<Mugen::Character*>::iterator enem = players.begin(); enem != players.end(); ++enem){
         Mugen::Character *enemy = *enem;
         if (mugen->getAlliance() != enemy->getAlliance()){
             // Do stuff for players
@@ -1055,6 +1200,9 @@ void Mugen::Stage::physics(Character * mugen){
                             }
                         }
                     }
+
+                    indexCharacter(enemy);
+                    indexCharacter(mugen);
                 }
                 // autoturn need to do turning actions
                 if (autoturn){
@@ -1194,29 +1342,32 @@ void Mugen::Stage::runCycle(){
         getStateData().quake_time--;
     }
 
-    for (vector<Mugen::Effect*>::iterator it = showSparks.begin(); it != showSparks.end(); /**/){ 
-        Mugen::Effect * spark = *it;
-        spark->logic();
+    {
+        Profiler::Scope profile(getContext().getProfiler(), Profiler::Effects);
+        for (vector<Mugen::Effect*>::iterator it = showSparks.begin(); it != showSparks.end(); /**/){ 
+            Mugen::Effect * spark = *it;
+            spark->logic();
 
-        /* if the spark looped then kill it */
-        if (spark->isDead()){
-            delete spark;
-            it = showSparks.erase(it);
-        } else {
-            it++;
+            /* if the spark looped then kill it */
+            if (spark->isDead()){
+                delete spark;
+                it = showSparks.erase(it);
+            } else {
+                it++;
+            }
         }
-    }
 
-    /* FIXME: Projectiles should not act during a pause or superpause */
-    for (vector<Projectile*>::iterator it = projectiles.begin(); it != projectiles.end(); /**/){
-        Projectile * projectile = *it;
-        projectile->logic(*this);
+        /* FIXME: Projectiles should not act during a pause or superpause */
+        for (vector<Projectile*>::iterator it = projectiles.begin(); it != projectiles.end(); /**/){
+            Projectile * projectile = *it;
+            projectile->logic(*this);
 
-        if (projectile->isDead()){
-            delete projectile;
-            it = projectiles.erase(it);
-        } else {
-            it++;
+            if (projectile->isDead()){
+                delete projectile;
+                it = projectiles.erase(it);
+            } else {
+                it++;
+            }
         }
     }
 
@@ -1254,6 +1405,7 @@ void Mugen::Stage::runCycle(){
         }
 
         if (getStateData().pause.time <= 0 || (getStateData().pause.time > 0 && !getStateData().pause.pauseBackground)){
+            Profiler::Scope profile(getContext().getProfiler(), Profiler::Background);
             background->act();
         }
        
@@ -1272,7 +1424,11 @@ void Mugen::Stage::runCycle(){
             }
         }
 
-        /* Then do physics/collision detection */
+        /* Then do physics/collision detection. This is timed to the end of
+         * the block, adding the new objects after it hardly takes any time.
+         */
+        Profiler::Scope physicsProfile(getContext().getProfiler(), Profiler::Physics);
+        beginCollisions();
         for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); /**/ ){
             bool next = true;
             Mugen::Character * player = *it;
@@ -1293,6 +1449,10 @@ void Mugen::Stage::runCycle(){
             } else if (!isaPlayer(player) && player->getHealth() <= 0){
                 player->destroyed(*this);
                 // unbind(player);
+                characterPhase.remove(player->getHotSlot());
+                if (player->isHelper()){
+                    recycleHelper((Mugen::Helper*) player);
+                }
                 delete player;
                 it = objects.erase(it);
                 next = false;
@@ -1303,6 +1463,10 @@ void Mugen::Stage::runCycle(){
             }
         }
 
+        for (vector<Mugen::Character*>::iterator it = addedObjects.begin(); it != addedObjects.end(); it++){
+            (*it)->bindHotState(&hotState);
+        }
+
         /* Have to insert objects at the front of the vector because new helpers should
          * have their states executed before players. At least this is the only way
          * I can get MVC2_IronMan's intro to work properly.
@@ -1311,9 +1475,12 @@ void Mugen::Stage::runCycle(){
         objects.insert(objects.begin(), addedObjects.begin(), addedObjects.end());
         addedObjects.clear();
     }
+
+    updateEntityCounts();
 }
 
 void Mugen::Stage::logic(){
+    Profiler::Scope profile(getContext().getProfiler(), Profiler::Logic);
 
     /* This must be the first thing done in this function! */
     /*
@@ -1338,7 +1505,10 @@ void Mugen::Stage::logic(){
     }
     
     // Player HUD Need to make this more elegant than casting and passing from array
-    gameHUD->act(*this, *((Mugen::Character *)players[0]),*((Mugen::Character *)players[1]));
+    {
+        Profiler::Scope profile(getContext().getProfiler(), Profiler::Hud);
+        gameHUD->act(*this, *((Mugen::Character *)players[0]),*((Mugen::Character *)players[1]));
+    }
 
     /* This must be the last thing done in this function! */
     /*
@@ -1552,7 +1722,7 @@ PaintownUtil::ReferenceCount<Mugen::World> Mugen::Stage::snapshotState(){
     }
 
     world->setStageData(getStateData());
-    world->setRandom(*Random::getState());
+    world->setRandom(getContext().getRandom());
     world->setGameInfo(gameHUD->serialize());
 
     return world;
@@ -1560,7 +1730,7 @@ PaintownUtil::ReferenceCount<Mugen::World> Mugen::Stage::snapshotState(){
     
 void Mugen::Stage::updateState(const Mugen::World & world){
     setStateData(world.getStageData());
-    Random::setState(world.getRandom());
+    getContext().setRandom(world.getRandom());
     gameHUD->deserialize(world.getGameInfo());
 
     const map<CharacterId, AllCharacterData> & data = world.getCharacterData();
@@ -1635,8 +1805,11 @@ int Mugen::Stage::findMaximumSpritePriority(){
 }
 
 void Mugen::Stage::render(Graphics::Bitmap *work){
+    Profiler & profiler = getContext().getProfiler();
+    Profiler::Scope profile(profiler, Profiler::Render);
 
     if (getStateData().environmentColor.time == 0){
+        Profiler::Scope profile(profiler, Profiler::RenderBackground);
         if (paletteEffects.time > 0){
             drawBackgroundWithEffects((int) getStateData().camerax, (int) getStateData().cameray, *work);
         } else {
@@ -1657,7 +1830,10 @@ void Mugen::Stage::render(Graphics::Bitmap *work){
     }
 
     //! Render layer 0 HUD
-    gameHUD->render(Mugen::Element::Background, *work);
+    {
+        Profiler::Scope profile(profiler, Profiler::RenderHud);
+        gameHUD->render(Mugen::Element::Background, *work);
+    }
 
     /* FIXME: this is a hack to deal with sprite priorities. Really we should get all
      * the drawable objects and sort them.
@@ -1670,24 +1846,28 @@ void Mugen::Stage::render(Graphics::Bitmap *work){
     vector<int> priorities = allSpritePriorities();
     for (vector<int>::iterator spritePriority = priorities.begin(); spritePriority != priorities.end(); spritePriority++){
         // Players go in here
-        for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); it++){
-            Mugen::Character *obj = *it;
-
-            if (obj->getSpritePriority() == *spritePriority){
-                /* Reflection */
-                /* FIXME: reflection and shade need camerax/y */
-                if (reflectionIntensity > 0){
-                    obj->drawReflection(work, (int)(getStateData().camerax - DEFAULT_WIDTH / 2), (int) getStateData().cameray, reflectionIntensity);
-                }
+        {
+            Profiler::Scope profile(profiler, Profiler::RenderCharacters);
+            for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); it++){
+                Mugen::Character *obj = *it;
+
+                if (obj->getSpritePriority() == *spritePriority){
+                    /* Reflection */
+                    /* FIXME: reflection and shade need camerax/y */
+                    if (reflectionIntensity > 0){
+                        obj->drawReflection(work, (int)(getStateData().camerax - DEFAULT_WIDTH / 2), (int) getStateData().cameray, reflectionIntensity);
+                    }
 
-                /* Shadow */
-                obj->drawMugenShade(work, (int)(getStateData().camerax - DEFAULT_WIDTH / 2), shadowIntensity, shadowColor, shadowYscale, shadowFadeRangeMid, shadowFadeRangeHigh);
+                    /* Shadow */
+                    obj->drawMugenShade(work, (int)(getStateData().camerax - DEFAULT_WIDTH / 2), shadowIntensity, shadowColor, shadowYscale, shadowFadeRangeMid, shadowFadeRangeHigh);
 
-                /* draw the player */
-                obj->draw(work, (int)(getStateData().camerax - DEFAULT_WIDTH / 2), (int) getStateData().cameray);
+                    /* draw the player */
+                    obj->draw(work, (int)(getStateData().camerax - DEFAULT_WIDTH / 2), (int) getStateData().cameray);
+                }
             }
         }
 
+        Profiler::Scope profile(profiler, Profiler::RenderEffects);
         for (vector<Mugen::Effect*>::iterator it = showSparks.begin(); it != showSparks.end(); it++){
             Mugen::Effect * spark = *it;
             if (spark->getSpritePriority() == *spritePriority){
@@ -1709,9 +1889,13 @@ void Mugen::Stage::render(Graphics::Bitmap *work){
     }
 
     //! Render layer 1 HUD
-    gameHUD->render(Mugen::Element::Foreground, *work);
+    {
+        Profiler::Scope profile(profiler, Profiler::RenderHud);
+        gameHUD->render(Mugen::Element::Foreground, *work);
+    }
 
     if (getStateData().environmentColor.time == 0){
+        Profiler::Scope profile(profiler, Profiler::RenderBackground);
         if (paletteEffects.time > 0){
             drawForegroundWithEffects((int) getStateData().camerax, (int) getStateData().cameray, *work);
         } else {
@@ -1720,7 +1904,10 @@ void Mugen::Stage::render(Graphics::Bitmap *work){
     }
     
     //! Render layer 2 HUD
-    gameHUD->render(Mugen::Element::Top, *work);
+    {
+        Profiler::Scope profile(profiler, Profiler::RenderHud);
+        gameHUD->render(Mugen::Element::Top, *work);
+    }
 
     // Player debug
     for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); it++){
@@ -1750,6 +1937,12 @@ void Mugen::Stage::render(Graphics::Bitmap *work){
 	work->vLine( 0, tension, 240, Graphics::makeColor( 0,255,0 ));
 	work->vLine( 0, 320 - tension, 240, Graphics::makeColor( 0,255,0 ));
     }
+
+    if (debugMode && background != NULL){
+        const ::Font & font = ::Font::getDefaultFont(16, 16);
+        int y = 480 - font.getHeight() - 1;
+        FontRender::getInstance()->addMessage(font, 1, y, Graphics::makeColor(255, 255, 255), Graphics::MaskColor(), "Background controllers %d / %d", background->getActiveControllers(), background->getControllerCount());
+    }
     
     /*
     // Life bars, will eventually be changed out with mugens interface
@@ -1873,6 +2066,7 @@ void Mugen::Stage::addPlayer1(Mugen::Character * o){
     o->setZ(currentZOffset());
     o->setFacing(FacingRight);
     o->setId(nextId());
+    o->bindHotState(&hotState);
     objects.push_back(o);
     players.push_back(o);
 
@@ -1895,6 +2089,7 @@ void Mugen::Stage::addPlayer2(Mugen::Character * o){
     o->setZ(currentZOffset());
     o->setFacing(FacingLeft);
     o->setId(nextId());
+    o->bindHotState(&hotState);
     objects.push_back(o);
     players.push_back(o);
     
@@ -2012,7 +2207,15 @@ const std::string Mugen::Stage::getStageName(const std::string &filename){
 }
 
 void Mugen::Stage::cleanup(){
+    /* players outlive the stage so give them their position back */
+    for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); it++){
+        (*it)->unbindHotState();
+    }
+
     if (loaded){
+        Global::debug(1) << "Most helpers " << helperCount.highWater << " explods " << effectCount.highWater << " projectiles " << projectileCount.highWater << endl;
+        Global::debug(1) << "Pooled helpers " << Helper::getPool().getHighWater() << " explods " << ExplodeEffect::getPool().getHighWater() << " sparks " << Spark::getPool().getHighWater() << " projectiles " << Projectile::getPool().getHighWater() << endl;
+
 	if (background){
 	    delete background;
 	    background = 0;
@@ -2062,6 +2265,8 @@ void Mugen::Stage::cleanup(){
         }
         projectiles.clear();
 
+        spareHelperResources.clear();
+
         for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); /**/){
             Mugen::Character * object = *it;
 
@@ -2537,6 +2742,92 @@ void Mugen::Stage::addEffect(Mugen::Effect * effect){
     showSparks.push_back(effect);
 }
 
+Mugen::Helper * Mugen::Stage::createHelper(Mugen::Character * owner, const Mugen::Character * root, int id, const std::string & name){
+    if (countHelpers() >= helperCount.limit){
+        Global::debug(1) << "Not creating helper " << name << ", there are already " << helperCount.limit << " helpers" << endl;
+        return NULL;
+    }
+
+    Mugen::Helper * helper = new Mugen::Helper(owner, root, id, name);
+
+    map<CharacterId, vector<PaintownUtil::ReferenceCount<HelperResources> > >::iterator spare = spareHelperResources.find(root->getId());
+    if (spare != spareHelperResources.end() && spare->second.size() > 0){
+        helper->takeResources(*spare->second.back());
+        spare->second.pop_back();
+    }
+
+    return helper;
+}
+
+void Mugen::Stage::forgetHelperResources(const Mugen::Character * root){
+    spareHelperResources.erase(root->getId());
+}
+
+void Mugen::Stage::recycleHelper(Mugen::Helper * helper){
+    vector<PaintownUtil::ReferenceCount<HelperResources> > & spare = spareHelperResources[helper->getRoot()];
+    /* there can't be more than the limit alive at once so there is no
+     * point keeping more than that many around
+     */
+    if ((int) spare.size() < helperCount.limit){
+        PaintownUtil::ReferenceCount<HelperResources> resources(new HelperResources());
+        helper->giveResources(*resources);
+        spare.push_back(resources);
+    }
+}
+
+bool Mugen::Stage::canAddEffect() const {
+    return (int) showSparks.size() < effectCount.limit;
+}
+
+bool Mugen::Stage::canAddProjectile(const Mugen::Character * owner) const {
+    int count = 0;
+    for (vector<Projectile*>::const_iterator it = projectiles.begin(); it != projectiles.end(); it++){
+        if ((*it)->getOwner() == owner->getRoot()){
+            count += 1;
+        }
+    }
+    return count < projectileCount.limit;
+}
+
+void Mugen::Stage::setEntityLimits(int helpers, int explods, int projectiles){
+    helperCount.limit = helpers;
+    effectCount.limit = explods;
+    projectileCount.limit = projectiles;
+}
+
+const Mugen::EntityCount & Mugen::Stage::getHelperCount() const {
+    return helperCount;
+}
+
+const Mugen::EntityCount & Mugen::Stage::getEffectCount() const {
+    return effectCount;
+}
+
+const Mugen::EntityCount & Mugen::Stage::getProjectileCount() const {
+    return projectileCount;
+}
+
+int Mugen::Stage::countHelpers() const {
+    int count = 0;
+    for (vector<Mugen::Character*>::const_iterator it = objects.begin(); it != objects.end(); it++){
+        if ((*it)->isHelper()){
+            count += 1;
+        }
+    }
+    for (vector<Mugen::Character*>::const_iterator it = addedObjects.begin(); it != addedObjects.end(); it++){
+        if ((*it)->isHelper()){
+            count += 1;
+        }
+    }
+    return count;
+}
+
+void Mugen::Stage::updateEntityCounts(){
+    helperCount.update(countHelpers());
+    effectCount.update(showSparks.size());
+    projectileCount.update(projectiles.size());
+}
+
 int Mugen::Stage::countMyHelpers(const Mugen::Character * owner) const {
     int count = 0;
     for (vector<Mugen::Character*>::const_iterator it = objects.begin(); it != objects.end(); it++){
@@ -11,6 +11,10 @@
 #include <r-tech1/graphics/bitmap.h>
 #include "common.h"
 #include "stage-state.h"
+#include "pool.h"
+#include "hot-state.h"
+#include "broad-phase.h"
+#include "context.h"
 
 namespace Graphics{
 class Bitmap;
@@ -31,6 +35,7 @@ namespace Mugen{
     class Effect;
     class GameInfo;
     class World;
+    struct HelperResources;
 }
 
 namespace Ast{
@@ -106,6 +111,11 @@ public:
 
     inline unsigned long int getTicks() const { return getStateData().ticker; }
 
+    /* random numbers and settings of this match. const stages hand it out too
+     * because evaluating expressions draws random numbers.
+     */
+    inline MatchContext & getContext() const { return *context; }
+
     void setCamera( const double x, const double y );
     void moveCamera( const double x, const double y );
 
@@ -230,6 +240,29 @@ public:
     virtual void addEffect(Effect * effect);
     virtual void removeEffects(const Character * owner, int id);
 
+    /* Creates a helper, or returns NULL if there are already as many helpers
+     * as the stage allows. The caller should add the helper with addObject().
+     */
+    virtual Helper * createHelper(Character * owner, const Character * root, int id, const std::string & name);
+
+    /* Drops the states kept from dead helpers of `root', after its files
+     * were reloaded so new helpers get the new states.
+     */
+    virtual void forgetHelperResources(const Character * root);
+
+    /* false if there are already as many explods as the stage allows */
+    virtual bool canAddEffect() const;
+
+    /* false if the root of `owner' already has as many projectiles as allowed */
+    virtual bool canAddProjectile(const Character * owner) const;
+
+    /* maximum helpers in total, explods in total, and projectiles per player */
+    virtual void setEntityLimits(int helpers, int explods, int projectiles);
+
+    virtual const EntityCount & getHelperCount() const;
+    virtual const EntityCount & getEffectCount() const;
+    virtual const EntityCount & getProjectileCount() const;
+
     virtual int countMyHelpers(const Character * owner) const;
     virtual std::vector<Projectile*> findProjectile(int id, const Character * owner) const;
     virtual std::vector<Effect*> findExplode(int id, const Character * owner) const;
@@ -348,6 +381,15 @@ protected:
 
     void updatePlayer(Character *o);
     void physics(Character * o);
+    /* friction and gravity, right after the character moved */
+    void applyForces(Character * mugen);
+
+    void beginCollisions();
+    void indexCharacter(Character * who);
+    void indexProjectile(unsigned int index);
+    void nearbyCharacters(Character * who, std::vector<Character*> & out);
+    void nearbyProjectiles(Character * who, std::vector<int> & out);
+    void doProjectileToProjectileCollisions();
     bool doBlockingDetection(Character * obj1, Character * obj2);
     bool doCollisionDetection(Character * obj1, Character * obj2);
     bool doReversalDetection(Character * obj1, Character * obj2);
@@ -359,6 +401,11 @@ protected:
     bool exists(Character * who);
     bool exists(CharacterId id);
 
+    /* keep the states and animations of a dead helper for the next one */
+    void recycleHelper(Helper * helper);
+    int countHelpers() const;
+    void updateEntityCounts();
+
     /* Current level of zoom scaling */
     double zoomScale() const;
     void updateZoom();
@@ -651,6 +698,25 @@ private:
     std::map<int, PaintownUtil::ReferenceCount<Animation> > sparks;
     std::vector<Effect*> showSparks;
 
+    EntityCount helperCount;
+    EntityCount effectCount;
+    EntityCount projectileCount;
+
+    /* position, velocity and physics of everything in `objects' */
+    HotState hotState;
+
+    /* horizontal extent of the boxes of characters, by hot state slot, and of
+     * projectiles, by their index in `projectiles'. Rebuilt every tick.
+     */
+    BroadPhase characterPhase;
+    BroadPhase projectilePhase;
+    /* position in `objects' by hot state slot */
+    std::vector<int> objectOrder;
+    bool projectilesChecked;
+
+    /* states and animations from dead helpers, by the id of their root character */
+    std::map<CharacterId, std::vector<PaintownUtil::ReferenceCount<HelperResources> > > spareHelperResources;
+
     // Character huds
     GameInfo *gameHUD;
 
@@ -658,6 +724,8 @@ private:
 
     int objectId;
 
+    PaintownUtil::ReferenceCount<MatchContext> context;
+
     StageStateData stateData;
     StageStateData & getStateData();
     const StageStateData & getStateData() const;
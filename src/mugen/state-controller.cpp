@@ -4,11 +4,10 @@
 #include <r-tech1/debug.h>
 #include "ast/all.h"
 #include "state-controller.h"
-#include "random.h"
+#include "context.h"
 #include "effect.h"
 #include "character.h"
 #include "helper.h"
-#include "config.h"
 #include "stage.h"
 #include "projectile.h"
 #include "common.h"
@@ -1148,7 +1147,7 @@ public:
                     vector<CharacterId> & objects = it->second;
                     if (objects.size() > 0){
                         /* Save a random object */
-                        CharacterId save = objects[Mugen::random(objects.size())];
+                        CharacterId save = objects[stage.getContext().random(objects.size())];
                         objects.clear();
                         objects.push_back(save);
                     }
@@ -2966,10 +2965,10 @@ static void evaluateHitDefinition(const HitDefinitionData & hit, HitDefinition &
     his.player1SpritePriority = evaluateNumberLocal(hit.player1SpritePriority, 1);
     his.player2SpritePriority = evaluateNumberLocal(hit.player2SpritePriority, 0);
 
-    his.getPower.hit = evaluateNumberLocal(hit.getPower.hit, his.damage.damage * Data::getInstance().getDefaultAttackLifeToPowerMultiplier());
+    his.getPower.hit = evaluateNumberLocal(hit.getPower.hit, his.damage.damage * env.getContext().getAttackLifeToPowerMultiplier());
     his.getPower.guarded = evaluateNumberLocal(hit.getPower.guarded, his.getPower.hit / 2);
     
-    his.givePower.hit = evaluateNumberLocal(hit.givePower.hit, his.damage.damage * Data::getInstance().getDefaultGetHitLifeToPowerMultiplier());
+    his.givePower.hit = evaluateNumberLocal(hit.givePower.hit, his.damage.damage * env.getContext().getGetHitLifeToPowerMultiplier());
     his.givePower.guarded = evaluateNumberLocal(hit.getPower.guarded, his.getPower.hit / 2);
 
 #undef evaluateNumber
@@ -4558,6 +4557,11 @@ private:
     }
 
     virtual void activate(Mugen::Stage & stage, Character & guy, const vector<string> & commands) const {
+        if (!stage.canAddEffect()){
+            /* too many explods already */
+            return;
+        }
+
         int facingLeft = guy.getFacing() == FacingLeft ? -1 : 1;
         FullEnvironment env(stage, guy);
 
@@ -4567,8 +4571,8 @@ private:
 #define evaluateNumber(value, default_) (value != NULL ? value->evaluate(env).toNumber() : default_)
         int animation_value = (int) evaluateNumber(this->animation, -1);
         int id_value = (int) evaluateNumber(id, -1);
-        double posX_value = evaluateNumber(posX, 0) + Mugen::random(randomX) - randomX / 2;
-        double posY_value = evaluateNumber(posY, 0) + Mugen::random(randomY) - randomY / 2;
+        double posX_value = evaluateNumber(posX, 0) + stage.getContext().random(randomX) - randomX / 2;
+        double posY_value = evaluateNumber(posY, 0) + stage.getContext().random(randomY) - randomY / 2;
         double velocityX_value = evaluateNumber(velocityX, 0);
         double velocityY_value = evaluateNumber(velocityY, 0);
         double accelerationX_value = evaluateNumber(accelerationX, 0);
@@ -4689,8 +4693,8 @@ public:
         int y = (int)(evaluateNumber(posY, environment, 0) + guy.getRY());
 
         int random = evaluateNumber(this->random, environment, 0);
-        x += Mugen::random(random) - random / 2;
-        y += Mugen::random(random) - random / 2;
+        x += stage.getContext().random(random) - random / 2;
+        y += stage.getContext().random(random) - random / 2;
 
         PaintownUtil::ReferenceCount<Animation> animation;
         animation = stage.getFightAnimation(animation_value);
@@ -5234,7 +5238,7 @@ public:
         int index = (int) evaluateNumber(this->index, environment, 0);
         int minimum = (int) evaluateNumber(this->minimum, environment, 0);
         int maximum = (int) evaluateNumber(this->maximum, environment, 0);
-        guy.setVariable(index, RuntimeValue((int) Mugen::random(minimum, maximum)));
+        guy.setVariable(index, RuntimeValue((int) stage.getContext().random(minimum, maximum)));
     }
 
     StateController * deepCopy() const {
@@ -6470,7 +6474,11 @@ public:
     virtual void activate(Mugen::Stage & stage, Character & guy, const vector<string> & commands) const {
         FullEnvironment environment(stage, guy, commands);
         /* FIXME */
-        Mugen::Helper * helper = new Mugen::Helper(&guy, environment.getStage().getCharacter(guy.getRoot()), (int) evaluateNumber(id, environment, 0), name);
+        Mugen::Helper * helper = stage.createHelper(&guy, environment.getStage().getCharacter(guy.getRoot()), (int) evaluateNumber(id, environment, 0), name);
+        if (helper == NULL){
+            /* too many helpers already */
+            return;
+        }
 
         helper->setOwnPalette(evaluateBool(ownPalette, environment, false));
 
@@ -7514,6 +7522,11 @@ public:
     }
 
     virtual void activate(Stage & stage, Character & guy, const vector<string> & commands) const {
+        if (!stage.canAddProjectile(&guy)){
+            /* too many projectiles already */
+            return;
+        }
+
         FullEnvironment environment(stage, guy, commands);
         int id = (int) evaluateNumber(this->id, environment, 0);
         int animation = (int) evaluateNumber(this->animation, environment, 0);
@@ -8084,6 +8097,10 @@ static string toString(StateController::Type type){
     return "???";
 }
 
+string StateController::typeName(Type type){
+    return toString(type);
+}
+
 StateController * StateController::compile(Ast::Section * section, const string & name, int state, unsigned int id, StateController::Type type){
     switch (type){
         case StateController::ChangeAnim : return new ControllerChangeAnim(section, name, state, id);
@@ -138,6 +138,9 @@ public:
     
     static StateController * compile(Ast::Section * section, const std::string & name, int state, unsigned int id,Type type);
 
+    /* the name used for the type in cns files, like ChangeState */
+    static std::string typeName(Type type);
+
     virtual bool canTrigger(const Environment & environment) const;
 
     virtual void activate(Mugen::Stage & stage, Character & who, const std::vector<std::string> & commands) const = 0;
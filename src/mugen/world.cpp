@@ -41,7 +41,7 @@ AllCharacterData::AllCharacterData(){
 }
 
 void World::addCharacter(const Character & who){
-    characterData[who.getId()] = AllCharacterData(who.getStateData(), who.getCurrentAnimationState(), who.getStatePersistent());
+    characterData[who.getId()] = AllCharacterData(who.snapshotStateData(), who.getCurrentAnimationState(), who.getStatePersistent());
     AllCharacterData & data = characterData[who.getId()];
     const std::vector<Command2 *> & commands = who.getCommands();
     std::map<std::string, std::string > & commandState = data.character.commandState;
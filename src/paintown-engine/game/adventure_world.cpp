@@ -25,6 +25,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <math.h>
 
 using namespace std;
 
@@ -73,7 +74,8 @@ descriptionTime(0),
 descriptionGradient(0),
 gameTicks(0),
 replayEnabled(false),
-camera(0, 0){
+camera(0, 0),
+grid(64, 16){
 	scene = NULL;
 	bang = NULL;
 }
@@ -92,7 +94,8 @@ descriptionTime(DESCRIPTION_TIME),
 descriptionGradient(new Effects::Gradient(100, Graphics::makeColor(255, 255, 255), Graphics::makeColor(128, 128, 128))),
 gameTicks(0),
 replayEnabled(false),
-camera(_screen_size / 2, 0){
+camera(_screen_size / 2, 0),
+grid(64, 16){
 	scene = NULL;
 	bang = NULL;
 	screen_size = _screen_size;
@@ -432,8 +435,38 @@ void AdventureWorld::dyingObject(const Paintown::Player & obj){
     // enterSlowMotion(60);
 }
 
+/* Objects that are moved by someone else during the tick, like grabbed
+ * characters, are only put in the right cell the next time the grid is
+ * rebuilt so look a little further than necessary.
+ */
+static const int gridSlack = 32;
+
+void AdventureWorld::findNearby(double x, double z, double xRadius, double zRadius, vector<Paintown::Object*> & out){
+    if (!grid.isReady()){
+        World::findNearby(x, z, xRadius, zRadius, out);
+        return;
+    }
+
+    vector<unsigned int> candidates;
+    grid.query(x, z, xRadius + gridSlack, zRadius + gridSlack, candidates);
+    for (vector<unsigned int>::iterator it = candidates.begin(); it != candidates.end(); it++){
+        if (*it < objects.size()){
+            Paintown::Object * object = objects[*it];
+            if (fabs(object->getX() - x) <= xRadius && fabs(object->getZ() - z) <= zRadius){
+                out.push_back(object);
+            }
+        }
+    }
+}
+
 void AdventureWorld::handleCollisions(Paintown::ObjectAttack * o_good, vector<Paintown::Object*> & added_effects){
-    for (vector<Paintown::Object*>::iterator fight = objects.begin(); fight != objects.end(); fight++){
+    /* Nothing can be hit by o_good unless their collision masks overlap, and
+     * no mask reaches further from an object than SpatialGrid::reach.
+     */
+    vector<Paintown::Object*> nearby;
+    findNearby(o_good->getX(), o_good->getZ(), SpatialGrid::reach(o_good) + grid.getWidest(), o_good->minZDistance(), nearby);
+
+    for (vector<Paintown::Object*>::iterator fight = nearby.begin(); fight != nearby.end(); fight++){
         if (*fight != o_good && (*fight)->isCollidable(o_good) && o_good->isCollidable(*fight)){
             // cout << "Zdistance: " << good->ZDistance( *fight ) << " = " << (good->ZDistance( *fight ) < o_good->minZDistance()) << endl;
             // cout << "Collision: " << (*fight)->collision( o_good ) << endl;
@@ -507,10 +540,14 @@ void AdventureWorld::doLogic(){
     gameTicks += 1;
 
     vector<Paintown::Object *> added_effects;
+    grid.rebuild(objects);
     for (vector<Paintown::Object *>::iterator it = objects.begin(); it != objects.end(); it++){
         Paintown::Object * good = *it;
         updateObject(good, added_effects);
+        grid.update(it - objects.begin());
     }
+    /* objects are about to be erased so the indexes in the grid are no good */
+    grid.clear();
 
     eraseDeadObjects(added_effects);
     getItems();
@@ -686,15 +723,11 @@ void AdventureWorld::addObject( Paintown::Object * o ){
     objects.push_back(o);
 }
 
-void AdventureWorld::drawWorld(const PlayerTracker & tracker, Graphics::Bitmap * where, const map< int, vector< Paintown::Object * > > & object_z, double cameraX){
+void AdventureWorld::drawWorld(const PlayerTracker & tracker, Graphics::Bitmap * where, const vector< Paintown::Object * > & ordered, double cameraX){
     scene->drawBack((int) cameraX, where);
 
-    for (map<int, vector<Paintown::Object *> >::const_iterator it = object_z.begin(); it != object_z.end(); it++ ){
-        const vector<Paintown::Object *> & xx = (*it).second;
-        for ( vector<Paintown::Object *>::const_iterator mm = xx.begin(); mm != xx.end(); mm++ ){
-
-            (*mm)->draw(where, (int) cameraX, 0);
-        }
+    for (vector<Paintown::Object *>::const_iterator it = ordered.begin(); it != ordered.end(); it++){
+        (*it)->draw(where, (int) cameraX, 0);
     }
 
     scene->drawFront((int) cameraX, where);
@@ -703,11 +736,8 @@ void AdventureWorld::drawWorld(const PlayerTracker & tracker, Graphics::Bitmap *
      * this is things like icon/name/health, not objects that are part of
      * the scene, and therefore the atmosphere doesn't apply to them.
      */
-    for (map<int,vector<Paintown::Object *> >::const_iterator it = object_z.begin(); it != object_z.end(); it++){
-        const vector<Paintown::Object *> & xx = (*it).second;
-        for ( vector<Paintown::Object *>::const_iterator mm = xx.begin(); mm != xx.end(); mm++ ){
-            (*mm)->drawFront(where, cameraX);
-        }
+    for (vector<Paintown::Object *>::const_iterator it = ordered.begin(); it != ordered.end(); it++){
+        (*it)->drawFront(where, cameraX);
     }
 }
 
@@ -755,7 +785,7 @@ void AdventureWorld::doTakeScreenshot(Graphics::Bitmap * work){
     */
 }
 
-void AdventureWorld::drawMiniMap(Graphics::Bitmap * work, const PlayerTracker & player, const map<int, vector<Paintown::Object*> > & object_z, int x, int y, int width, int height){
+void AdventureWorld::drawMiniMap(Graphics::Bitmap * work, const PlayerTracker & player, const vector<Paintown::Object*> & ordered, int x, int y, int width, int height){
     if (mini_map == NULL){
         /* 1.3333 is the aspect ratio of screen_width/screen_height when the res is any standard of
          * 640,480 800,600, 1024,768
@@ -765,7 +795,7 @@ void AdventureWorld::drawMiniMap(Graphics::Bitmap * work, const PlayerTracker &
 	mini_map = new Graphics::Bitmap(screen_size, (int)((double) screen_size / 1.3333));
     }
 
-    drawWorld(player, mini_map.raw(), object_z, player.min_x);
+    drawWorld(player, mini_map.raw(), ordered, player.min_x);
     Graphics::Bitmap mini(width, height);
     mini_map->Stretch(mini);
     Graphics::Bitmap::transBlender(0, 0, 0, 160);
@@ -785,12 +815,8 @@ void AdventureWorld::showDescription(Graphics::Bitmap * work, int time, const st
 }
 
 void AdventureWorld::draw(Graphics::Bitmap * work){
-    map<int, vector<Paintown::Object*> > object_z;
-
-    for (vector< Paintown::Object * >::iterator it = objects.begin(); it != objects.end(); it++){
-        Paintown::Object * n = *it;
-        object_z[n->getRZ()].push_back(n);
-    }
+    drawList.update(objects);
+    const vector<Paintown::Object*> & ordered = drawList.getObjects();
 
     if (descriptionTime > 0 && scene->getDescription() != ""){
         showDescription(work, descriptionTime, scene->getDescription());
@@ -814,7 +840,7 @@ void AdventureWorld::draw(Graphics::Bitmap * work){
          * to draw a minimap.
          */
         if (it == players.begin()){
-            drawWorld(*it, work, object_z, camera.getX());
+            drawWorld(*it, work, ordered, camera.getX());
             /* Don't need a minimap for the main player */
             continue;
         } else if (!shouldDrawMiniMaps()){
@@ -824,7 +850,7 @@ void AdventureWorld::draw(Graphics::Bitmap * work){
         }
 
         /* draw the minimaps where the camera is always centered on the guy */
-        drawMiniMap(work, *it, object_z, mini_position_x, mini_position_y, mini_width, mini_height);
+        drawMiniMap(work, *it, ordered, mini_position_x, mini_position_y, mini_width, mini_height);
 
         mini_position_x -= mini_width - 2;
         if (mini_position_x <= 0){
@@ -24,6 +24,8 @@ class Gradient;
 #include <r-tech1/file-system.h>
 #include <r-tech1/network/network.h>
 #include "world.h"
+#include "spatial_grid.h"
+#include "draw_list.h"
 #include "../level/cacher.h"
 #include "../level/block.h"
 
@@ -68,7 +70,7 @@ protected:
 class AdventureWorld: public World {
 public:
 	AdventureWorld();
-	AdventureWorld(const std::vector< Paintown::Object * > & players, const Filesystem::AbsolutePath & path, Level::Cacher * cacher = new Level::DefaultCacher(), int screen_size = 320);
+	AdventureWorld(const std::vector< Paintown::Object * > & players, const Filesystem::AbsolutePath & path, Level::Cacher * cacher = new Level::ThreadedCacher(), int screen_size = 320);
 
 	virtual ~AdventureWorld();
 
@@ -114,6 +116,7 @@ public:
 	virtual void doScene( int min_x, int max_x );
 
         virtual Paintown::Object * findObject(int id);
+        virtual void findNearby(double x, double z, double xRadius, double zRadius, std::vector<Paintown::Object*> & out);
 
 	virtual int getMaximumZ();
 	virtual int getMinimumZ();
@@ -150,8 +153,8 @@ protected:
 	void loadLevel( const Filesystem::AbsolutePath & path );
 	void threadedLoadLevel( const Filesystem::AbsolutePath & path );
 
-	virtual void drawWorld( const PlayerTracker & tracker, Graphics::Bitmap * where, const std::map< int, std::vector< Paintown::Object * > > & object_z, double cameraX);
-        virtual void drawMiniMap(Graphics::Bitmap * work, const PlayerTracker & player, const std::map<int, std::vector<Paintown::Object*> > & objects, int x, int y, int width, int height);
+	virtual void drawWorld( const PlayerTracker & tracker, Graphics::Bitmap * where, const std::vector< Paintown::Object * > & ordered, double cameraX);
+        virtual void drawMiniMap(Graphics::Bitmap * work, const PlayerTracker & player, const std::vector<Paintown::Object*> & ordered, int x, int y, int width, int height);
         virtual void showDescription(Graphics::Bitmap * work, int time, const std::string & description);
 
 	virtual void deleteObjects( std::vector< Paintown::Object * > * objects );
@@ -231,6 +234,12 @@ protected:
     bool replayEnabled;
 
     Camera camera;
+
+    /* where everything is during doLogic() */
+    SpatialGrid grid;
+
+    /* used by draw() for the main view and the minimaps */
+    DrawList drawList;
 };
 
 #endif
@@ -0,0 +1,71 @@
+#include "draw_list.h"
+#include "../object/object.h"
+
+#include <algorithm>
+
+using namespace std;
+
+DrawList::DrawList(){
+}
+
+DrawList::~DrawList(){
+}
+
+bool DrawList::before(const Entry & a, const Entry & b){
+    if (a.z != b.z){
+        return a.z < b.z;
+    }
+    return a.order < b.order;
+}
+
+void DrawList::update(const vector<Paintown::Object*> & objects){
+    lookup.clear();
+    for (unsigned int index = 0; index < objects.size(); index++){
+        lookup.push_back(make_pair(objects[index], index));
+    }
+    sort(lookup.begin(), lookup.end());
+    seen.assign(objects.size(), 0);
+
+    /* keep the objects that are still around in the order they were in */
+    unsigned int kept = 0;
+    for (unsigned int index = 0; index < entries.size(); index++){
+        Entry & entry = entries[index];
+        vector<pair<Paintown::Object*, unsigned int> >::iterator found = lower_bound(lookup.begin(), lookup.end(), make_pair(entry.object, 0u));
+        if (found != lookup.end() && found->first == entry.object && !seen[found->second]){
+            seen[found->second] = 1;
+            entry.z = entry.object->getRZ();
+            entry.order = found->second;
+            entries[kept] = entry;
+            kept += 1;
+        }
+    }
+    entries.resize(kept);
+
+    for (unsigned int index = 0; index < objects.size(); index++){
+        if (!seen[index]){
+            Entry entry;
+            entry.object = objects[index];
+            entry.z = entry.object->getRZ();
+            entry.order = index;
+            entries.push_back(entry);
+        }
+    }
+
+    /* insertion sort */
+    for (unsigned int index = 1; index < entries.size(); index++){
+        if (before(entries[index], entries[index - 1])){
+            Entry entry = entries[index];
+            unsigned int where = index;
+            while (where > 0 && before(entry, entries[where - 1])){
+                entries[where] = entries[where - 1];
+                where -= 1;
+            }
+            entries[where] = entry;
+        }
+    }
+
+    ordered.clear();
+    for (vector<Entry>::iterator it = entries.begin(); it != entries.end(); it++){
+        ordered.push_back(it->object);
+    }
+}
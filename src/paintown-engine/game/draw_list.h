@@ -0,0 +1,47 @@
+#ifndef _paintown_draw_list_h
+#define _paintown_draw_list_h
+
+#include <vector>
+#include <utility>
+
+namespace Paintown{
+class Object;
+}
+
+/* The objects of a world in the order they should be drawn, back to front by
+ * their z position and then by their position in the world's object list.
+ * The list is kept between frames and sorted with an insertion sort because
+ * objects barely move from one frame to the next, so usually there is nothing
+ * to do.
+ */
+class DrawList{
+public:
+    DrawList();
+    virtual ~DrawList();
+
+    /* Add new objects, drop the ones that are gone and sort again */
+    void update(const std::vector<Paintown::Object*> & objects);
+
+    inline const std::vector<Paintown::Object*> & getObjects() const {
+        return ordered;
+    }
+
+protected:
+    struct Entry{
+        Paintown::Object * object;
+        int z;
+        /* position in the world's object list */
+        unsigned int order;
+    };
+
+    static bool before(const Entry & a, const Entry & b);
+
+    std::vector<Entry> entries;
+    std::vector<Paintown::Object*> ordered;
+
+    /* reused every update so they don't have to be allocated again */
+    std::vector<std::pair<Paintown::Object*, unsigned int> > lookup;
+    std::vector<char> seen;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include <r-tech1/ebox.h>
+#include "spatial_grid.h"
+#include "../object/object.h"
+
+#include <algorithm>
+
+using namespace std;
+
+SpatialGrid::SpatialGrid(int cellWidth, int cellDepth):
+cellWidth(cellWidth),
+cellDepth(cellDepth),
+minimumX(0),
+minimumZ(0),
+columns(0),
+rows(0),
+objects(NULL),
+widest(0),
+ready(false){
+}
+
+SpatialGrid::~SpatialGrid(){
+}
+
+int SpatialGrid::reach(const Paintown::Object * object){
+    int most = object->getWidth();
+    vector<ECollide*> collides = object->getCollide();
+    for (vector<ECollide*>::iterator it = collides.begin(); it != collides.end(); it++){
+        if (*it != NULL && (*it)->getWidth() > most){
+            most = (*it)->getWidth();
+        }
+    }
+    return most;
+}
+
+void SpatialGrid::clear(){
+    for (vector<vector<unsigned int> >::iterator it = cells.begin(); it != cells.end(); it++){
+        it->clear();
+    }
+    where.clear();
+    objects = NULL;
+    widest = 0;
+    ready = false;
+}
+
+void SpatialGrid::rebuild(const vector<Paintown::Object*> & objects){
+    clear();
+    this->objects = &objects;
+
+    if (objects.empty()){
+        columns = 0;
+        rows = 0;
+        ready = true;
+        return;
+    }
+
+    double lowX = objects[0]->getX();
+    double highX = lowX;
+    double lowZ = objects[0]->getZ();
+    double highZ = lowZ;
+    for (vector<Paintown::Object*>::const_iterator it = objects.begin(); it != objects.end(); it++){
+        const Paintown::Object * object = *it;
+        lowX = min(lowX, object->getX());
+        highX = max(highX, object->getX());
+        lowZ = min(lowZ, object->getZ());
+        highZ = max(highZ, object->getZ());
+    }
+
+    minimumX = (int) lowX;
+    minimumZ = (int) lowZ;
+    columns = ((int) highX - minimumX) / cellWidth + 1;
+    rows = ((int) highZ - minimumZ) / cellDepth + 1;
+
+    /* keeps the lists that were allocated last time around */
+    if ((int) cells.size() < columns * rows){
+        cells.resize(columns * rows);
+    }
+
+    where.resize(objects.size());
+    for (unsigned int index = 0; index < objects.size(); index++){
+        const Paintown::Object * object = objects[index];
+        int cell = row(object->getZ()) * columns + column(object->getX());
+        cells[cell].push_back(index);
+        where[index] = cell;
+        widest = max(widest, reach(object));
+    }
+
+    ready = true;
+}
+
+int SpatialGrid::column(double x) const {
+    int out = ((int) x - minimumX) / cellWidth;
+    if (x < minimumX || out < 0){
+        return 0;
+    }
+    if (out >= columns){
+        return columns - 1;
+    }
+    return out;
+}
+
+int SpatialGrid::row(double z) const {
+    int out = ((int) z - minimumZ) / cellDepth;
+    if (z < minimumZ || out < 0){
+        return 0;
+    }
+    if (out >= rows){
+        return rows - 1;
+    }
+    return out;
+}
+
+void SpatialGrid::update(unsigned int index){
+    if (!ready || index >= where.size()){
+        return;
+    }
+
+    const Paintown::Object * object = (*objects)[index];
+    int cell = row(object->getZ()) * columns + column(object->getX());
+    widest = max(widest, reach(object));
+    if (cell == where[index]){
+        return;
+    }
+
+    vector<unsigned int> & old = cells[where[index]];
+    old.erase(find(old.begin(), old.end(), index));
+    cells[cell].push_back(index);
+    where[index] = cell;
+}
+
+void SpatialGrid::query(double x, double z, double xRadius, double zRadius, vector<unsigned int> & out) const {
+    if (!ready || columns == 0){
+        return;
+    }
+
+    unsigned int start = out.size();
+    int left = column(x - xRadius);
+    int right = column(x + xRadius);
+    int top = row(z - zRadius);
+    int bottom = row(z + zRadius);
+    for (int down = top; down <= bottom; down++){
+        for (int across = left; across <= right; across++){
+            const vector<unsigned int> & cell = cells[down * columns + across];
+            out.insert(out.end(), cell.begin(), cell.end());
+        }
+    }
+
+    sort(out.begin() + start, out.end());
+}
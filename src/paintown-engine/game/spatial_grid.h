@@ -0,0 +1,73 @@
+#ifndef _paintown_spatial_grid_h
+#define _paintown_spatial_grid_h
+
+#include <vector>
+
+namespace Paintown{
+class Object;
+}
+
+/* Buckets the objects of a world into cells over (x, z) so that finding the
+ * objects near some point doesn't have to look at all of them. Objects are
+ * identified by their index in the vector that was given to rebuild().
+ *
+ * Objects that move outside of the area that was covered when the grid was
+ * rebuilt are put in the cells along the edge, so queries are always correct
+ * as long as update() is called after an object moves.
+ */
+class SpatialGrid{
+public:
+    SpatialGrid(int cellWidth, int cellDepth);
+    virtual ~SpatialGrid();
+
+    void rebuild(const std::vector<Paintown::Object*> & objects);
+    void clear();
+
+    /* Move the object at `index' to the cell for its current position */
+    void update(unsigned int index);
+
+    /* Appends the indexes of the objects in the cells that touch the area
+     * x - xRadius to x + xRadius and z - zRadius to z + zRadius. The indexes
+     * are in increasing order. Some of the objects might be outside of the
+     * area, the caller should check the exact distance.
+     */
+    void query(double x, double z, double xRadius, double zRadius, std::vector<unsigned int> & out) const;
+
+    /* True after rebuild() until clear() */
+    inline bool isReady() const {
+        return ready;
+    }
+
+    /* Largest horizontal reach of any object seen since the last rebuild() */
+    inline int getWidest() const {
+        return widest;
+    }
+
+    /* How far from its x position an object can touch something, looks at its
+     * width and all of its collision masks.
+     */
+    static int reach(const Paintown::Object * object);
+
+protected:
+    int column(double x) const;
+    int row(double z) const;
+
+    const int cellWidth;
+    const int cellDepth;
+
+    int minimumX;
+    int minimumZ;
+    int columns;
+    int rows;
+
+    /* columns * rows cells, each one is a list of indexes */
+    std::vector<std::vector<unsigned int> > cells;
+    /* which cell each index is in */
+    std::vector<int> where;
+
+    const std::vector<Paintown::Object*> * objects;
+    int widest;
+    bool ready;
+};
+
+#endif
@@ -129,19 +129,10 @@ bool VersusWorld::finished() const {
 
 void VersusWorld::draw( Graphics::Bitmap * work ){
 
-	map< int, vector<Paintown::Object*> > object_z;
-
-	for ( vector< Paintown::Object * >::iterator it = objects.begin(); it != objects.end(); it++ ){
-            Paintown::Object * n = *it;
-		object_z[ n->getRZ() ].push_back( n );
-	}
-
-	for ( map<int,vector<Paintown::Object *> >::iterator it = object_z.begin(); it != object_z.end(); it++ ){
-		vector<Paintown::Object *> & xx = (*it).second;
-		for ( vector<Paintown::Object *>::iterator mm = xx.begin(); mm != xx.end(); mm++ ){
-
-			(*mm)->draw( work, 0, 0 );
-		}
+	drawList.update(objects);
+	const vector<Paintown::Object*> & ordered = drawList.getObjects();
+	for ( vector<Paintown::Object *>::const_iterator it = ordered.begin(); it != ordered.end(); it++ ){
+		(*it)->draw( work, 0, 0 );
 	}
 }
 
@@ -1,4 +1,6 @@
 #include "world.h"
+#include "../object/object.h"
+#include <math.h>
 
 using namespace std;
 
@@ -22,3 +24,12 @@ void World::dyingObject(const Paintown::Object & obj){
 
 void World::dyingObject(const Paintown::Player & obj){
 }
+
+void World::findNearby(double x, double z, double xRadius, double zRadius, vector<Paintown::Object*> & out){
+    for (vector<Paintown::Object*>::const_iterator it = getObjects().begin(); it != getObjects().end(); it++){
+        Paintown::Object * object = *it;
+        if (fabs(object->getX() - x) <= xRadius && fabs(object->getZ() - z) <= zRadius){
+            out.push_back(object);
+        }
+    }
+}
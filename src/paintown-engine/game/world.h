@@ -94,6 +94,11 @@ public:
 
     virtual Paintown::Object * findObject(int id) = 0;
 
+    /* Appends the objects that are no further than xRadius from x and zRadius
+     * from z, in the same order as getObjects().
+     */
+    virtual void findNearby(double x, double z, double xRadius, double zRadius, std::vector<Paintown::Object*> & out);
+
 	virtual int getMaximumZ() = 0;
 	virtual int getMinimumZ() = 0;
 
@@ -1,12 +1,25 @@
 #include "cacher.h"
 #include "blockobject.h"
 #include "../factory/object_factory.h"
+#include "../object/object.h"
+#include "../object/definition-cache.h"
+#include <r-tech1/debug.h>
+
+using std::vector;
+using std::endl;
 
 namespace Level{
 
 Cacher::Cacher(){
 }
 
+void Cacher::prepare(const vector<Util::ReferenceCount<BlockObject> > & objects){
+}
+
+Paintown::Object * Cacher::create(const Util::ReferenceCount<BlockObject> & block){
+    return ObjectFactory::createObject(block);
+}
+
 Cacher::~Cacher(){
 }
 
@@ -21,4 +34,76 @@ Paintown::Object * DefaultCacher::cache(const Util::ReferenceCount<BlockObject>
 DefaultCacher::~DefaultCacher(){
 }
 
+ThreadedCacher::ThreadedCacher():
+DefaultCacher(),
+thread(Util::Thread::uninitializedValue),
+reading(false),
+quit(false){
+}
+
+void ThreadedCacher::prepare(const vector<Util::ReferenceCount<BlockObject> > & objects){
+    Util::Thread::ScopedLock locked(lock);
+    for (vector<Util::ReferenceCount<BlockObject> >::const_iterator it = objects.begin(); it != objects.end(); it++){
+        const Filesystem::AbsolutePath & path = (*it)->getPath();
+        if (requested.insert(path.path()).second){
+            waiting.push_back(path);
+        }
+    }
+
+    /* the thread quits when it runs out of work so start a new one */
+    if (!reading && !waiting.empty()){
+        if (thread != Util::Thread::uninitializedValue){
+            Util::Thread::joinThread(thread);
+            thread = Util::Thread::uninitializedValue;
+        }
+        reading = true;
+        if (!Util::Thread::createThread(&thread, NULL, (Util::Thread::ThreadFunction) runReader, this)){
+            Global::debug(0) << "Could not create object cacher thread" << endl;
+            thread = Util::Thread::uninitializedValue;
+            reading = false;
+        }
+    }
+}
+
+void * ThreadedCacher::runReader(void * self){
+    ((ThreadedCacher*) self)->read();
+    return NULL;
+}
+
+void ThreadedCacher::read(){
+    while (true){
+        Filesystem::AbsolutePath path;
+        {
+            Util::Thread::ScopedLock locked(lock);
+            if (quit || waiting.empty()){
+                reading = false;
+                return;
+            }
+            path = waiting.front();
+            waiting.pop_front();
+        }
+
+        Paintown::DefinitionCache::prepare(path);
+    }
+}
+
+void ThreadedCacher::stop(){
+    {
+        Util::Thread::ScopedLock locked(lock);
+        quit = true;
+    }
+
+    if (thread != Util::Thread::uninitializedValue){
+        Util::Thread::joinThread(thread);
+        thread = Util::Thread::uninitializedValue;
+    }
+}
+
+ThreadedCacher::~ThreadedCacher(){
+    stop();
+
+    /* definitions of objects that were never made */
+    Paintown::DefinitionCache::clear();
+}
+
 }
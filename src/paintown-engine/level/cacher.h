@@ -1,7 +1,14 @@
 #ifndef _paintown_cacher_h
 #define _paintown_cacher_h
 
+#include <vector>
+#include <map>
+#include <deque>
+#include <set>
+#include <string>
 #include <r-tech1/pointer.h>
+#include <r-tech1/file-system.h>
+#include <r-tech1/thread.h>
 
 class BlockObject;
 
@@ -17,6 +24,12 @@ public:
 
     virtual Paintown::Object * cache(const Util::ReferenceCount<BlockObject> & block) const = 0;
 
+    /* The objects will be needed soon, a cacher can start making them now */
+    virtual void prepare(const std::vector<Util::ReferenceCount<BlockObject> > & objects);
+
+    /* Make a new object to put in the world */
+    virtual Paintown::Object * create(const Util::ReferenceCount<BlockObject> & block);
+
     virtual ~Cacher();
 };
 
@@ -29,6 +42,38 @@ public:
     virtual ~DefaultCacher();
 };
 
+/* Reads the definitions of the objects passed to prepare() on a separate
+ * thread so that parsing them doesn't stall the game when the player walks
+ * into a new block. The objects themselves are still made on the main thread
+ * by create(): their bitmaps belong to the display and their animations
+ * share data with the objects the game is using. They just find their
+ * definition already parsed in Paintown::DefinitionCache.
+ */
+class ThreadedCacher: public DefaultCacher {
+public:
+    ThreadedCacher();
+
+    virtual void prepare(const std::vector<Util::ReferenceCount<BlockObject> > & objects);
+
+    virtual ~ThreadedCacher();
+
+protected:
+    static void * runReader(void * self);
+    void read();
+    void stop();
+
+    Util::Thread::Id thread;
+    Util::Thread::LockObject lock;
+    /* true while the thread is running */
+    bool reading;
+    bool quit;
+
+    /* files the thread hasn't gotten to yet */
+    std::deque<Filesystem::AbsolutePath> waiting;
+    /* every file that was asked for, only used by the main thread */
+    std::set<std::string> requested;
+};
+
 }
 
 #endif
@@ -5,7 +5,7 @@
 
 using namespace std;
     
-RandomScene::RandomScene(const Filesystem::AbsolutePath & filename, const Level::Cacher & cacher):
+RandomScene::RandomScene(const Filesystem::AbsolutePath & filename, Level::Cacher & cacher):
 Scene(filename, cacher){
     objects = collectObjects();
 }
@@ -29,6 +29,9 @@ static Block * createRandomBlock(int minZ, int maxZ, const vector<Util::Referenc
     return block;
 }
 
+void RandomScene::prepareBlocks(){
+}
+
 /* I don't think I really care about `blocks' here */
 void RandomScene::advanceBlocks(int blocks){
     current_block = createRandomBlock(getMinimumZ(), getMaximumZ(), objects);
@@ -8,13 +8,16 @@ class BlockObject;
 
 class RandomScene: public Scene {
 public:
-    RandomScene(const Filesystem::AbsolutePath & filename, const Level::Cacher & cacher);
+    RandomScene(const Filesystem::AbsolutePath & filename, Level::Cacher & cacher);
 	
     virtual void advanceBlocks( int n );
 
     virtual ~RandomScene();
 
 protected:
+    /* the blocks are made up on the spot so there is nothing to prepare */
+    virtual void prepareBlocks();
+
     std::vector<Util::ReferenceCount<BlockObject> > collectObjects();
 
     std::vector<Util::ReferenceCount<BlockObject> > objects;
@@ -36,7 +36,7 @@ Panel::~Panel(){
     if (pic) delete pic;
 }
 
-Scene::Scene(const Filesystem::AbsolutePath & filename, const Level::Cacher & cacher):
+Scene::Scene(const Filesystem::AbsolutePath & filename, Level::Cacher & cacher):
 background(NULL),
 enemyCount(0),
 block_length(0),
@@ -48,7 +48,9 @@ backgroundParallax(5),
 foregroundParallax(1.2),
 frontBuffer(NULL),
 hasMusic(false),
-newBlock(true){
+newBlock(true),
+cacher(cacher),
+preparedBlock(0){
 
     TokenReader tr;
 
@@ -336,7 +338,7 @@ void Scene::doTriggers(){
 }
 
 void Scene::createObject(const Util::ReferenceCount<BlockObject> & object){
-    Paintown::Object * newobj = ObjectFactory::createObject(object);
+    Paintown::Object * newobj = cacher.create(object);
     if (newobj == NULL){
         return;
     }
@@ -362,12 +364,24 @@ void Scene::createObjects(const vector<Util::ReferenceCount<BlockObject> > & blo
     }
 }
 
+void Scene::prepareBlocks(){
+    const unsigned int lookAhead = 2;
+    for (unsigned int block = 0; block < lookAhead && block < level_blocks.size(); block++){
+        cacher.prepare(level_blocks[block]->getObjects());
+    }
+}
+
 void Scene::act(int min_x, int max_x, vector<Paintown::Object *> * objects){
     if (canContinue(min_x)){
         advanceBlocks(blockNumber + 1);
         Global::debug(3) << "[Scene] Current block is " << blockNumber << ". Length is " << current_block->getLength() << " Minimum x is " << min_x << endl;	
     }
 
+    if (preparedBlock != blockNumber){
+        preparedBlock = blockNumber;
+        prepareBlocks();
+    }
+
     doTriggers();
 
     if (newBlock && objects != NULL){
@@ -34,7 +34,7 @@ struct Panel{
 
 class Scene{
 public:
-    Scene(const Filesystem::AbsolutePath & filename, const Level::Cacher & cacher);
+    Scene(const Filesystem::AbsolutePath & filename, Level::Cacher & cacher);
 
     // void Draw( int x, Bitmap * work );
     void drawFront( int x, Graphics::Bitmap * work );
@@ -98,6 +98,9 @@ protected:
     /* true if the position x is passed the boundary of the current block */
     bool passedBoundary(int x);
 
+    /* let the cacher start making the objects of the next few blocks */
+    virtual void prepareBlocks();
+
     inline double getBackgroundParallax() const {
         return backgroundParallax;
     }
@@ -177,6 +180,10 @@ protected:
     Filesystem::RelativePath intro;
     Filesystem::RelativePath ending;
     bool newBlock;
+
+    Level::Cacher & cacher;
+    /* the block number that prepareBlocks() was last called for */
+    int preparedBlock;
 };
 
 #endif
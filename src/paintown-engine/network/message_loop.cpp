@@ -0,0 +1,306 @@
+#ifdef HAVE_NETWORKING
+
+#include "message_loop.h"
+#include <r-tech1/debug.h>
+#include <r-tech1/funcs.h>
+#include <r-tech1/system.h>
+
+using std::vector;
+using std::string;
+using std::endl;
+
+namespace Network{
+
+static std::ostream & debug(int level){
+    return Global::debug(level, "message-loop");
+}
+
+/* most messages are a few bytes so one read usually gets all of them */
+static const unsigned int ReadSize = 4096;
+/* how long a thread waits on its sockets before it looks for new ones */
+static const int PollTime = 50;
+
+MessageLoop::Connection::Connection(Socket socket, unsigned int thread):
+socket(socket),
+thread(thread),
+done(false),
+missing(0){
+}
+
+bool MessageLoop::Connection::partial() const {
+    return !done && !buffer.empty();
+}
+
+struct Worker{
+    MessageLoop * loop;
+    unsigned int thread;
+};
+
+static void * runWorker(void * arg){
+    Worker * worker = (Worker *) arg;
+    worker->loop->run(worker->thread);
+    delete worker;
+    return NULL;
+}
+
+MessageLoop::MessageLoop(int threads):
+threadCount(threads > 0 ? threads : 1),
+nextThread(0),
+incoming(1024),
+running(false),
+started(false),
+generation(0),
+deadline(0){
+}
+
+MessageLoop::~MessageLoop(){
+    stop();
+    wait();
+    for (vector<Connection*>::iterator it = connections.begin(); it != connections.end(); it++){
+        delete *it;
+    }
+}
+
+void MessageLoop::add(Socket socket){
+    Util::Thread::ScopedLock locked(lock);
+    connections.push_back(new Connection(socket, nextThread % threadCount));
+    nextThread += 1;
+    generation += 1;
+    if (started && !Network::blocking(socket, false)){
+        debug(0) << "Could not make socket " << socket << " non-blocking" << endl;
+    }
+}
+
+/* The connection is only marked as done here because a thread might be in the
+ * middle of reading it. It gets deleted once the threads are gone.
+ */
+void MessageLoop::remove(Socket socket){
+    Util::Thread::ScopedLock locked(lock);
+    for (vector<Connection*>::iterator it = connections.begin(); it != connections.end(); it++){
+        Connection * connection = *it;
+        if (connection->socket == socket){
+            connection->done = true;
+        }
+    }
+    generation += 1;
+}
+
+void MessageLoop::start(){
+    Util::Thread::ScopedLock locked(lock);
+    if (started){
+        return;
+    }
+
+    for (vector<Connection*>::iterator it = connections.begin(); it != connections.end(); it++){
+        Connection * connection = *it;
+        if (!Network::blocking(connection->socket, false)){
+            debug(0) << "Could not make socket " << connection->socket << " non-blocking" << endl;
+        }
+    }
+
+    running = true;
+    started = true;
+    deadline = 0;
+    for (unsigned int thread = 0; thread < threadCount; thread++){
+        Worker * worker = new Worker;
+        worker->loop = this;
+        worker->thread = thread;
+        Util::Thread::Id id;
+        if (Util::Thread::createThread(&id, NULL, (Util::Thread::ThreadFunction) runWorker, worker)){
+            threads.push_back(id);
+        } else {
+            debug(0) << "Could not create message loop thread " << thread << endl;
+            delete worker;
+        }
+    }
+}
+
+void MessageLoop::stop(){
+    Util::Thread::ScopedLock locked(lock);
+    running = false;
+}
+
+void MessageLoop::wait(unsigned int timeout){
+    {
+        Util::Thread::ScopedLock locked(lock);
+        deadline = System::currentMilliseconds() + timeout;
+    }
+
+    for (vector<Util::Thread::Id>::iterator it = threads.begin(); it != threads.end(); it++){
+        Util::Thread::joinThread(*it);
+    }
+    threads.clear();
+
+    Util::Thread::ScopedLock locked(lock);
+    if (started){
+        for (vector<Connection*>::iterator it = connections.begin(); it != connections.end(); it++){
+            Connection * connection = *it;
+            if (!connection->done && !Network::blocking(connection->socket, true)){
+                debug(0) << "Could not make socket " << connection->socket << " blocking" << endl;
+            }
+        }
+        started = false;
+    }
+}
+
+bool MessageLoop::isRunning(){
+    Util::Thread::ScopedLock locked(lock);
+    return running;
+}
+
+bool MessageLoop::getMessage(Message & out){
+    return incoming.pop(out);
+}
+
+/* Every thread has a HawkNL group of its sockets and sleeps in
+ * nlPollGroup until one of them can be read. The group is built again when
+ * connections come and go.
+ */
+void MessageLoop::run(unsigned int thread){
+    NLint group = NL_INVALID;
+    vector<Connection*> mine;
+    vector<NLsocket> ready;
+    unsigned int built = 0;
+    while (true){
+        bool stopping = false;
+        bool late = false;
+        {
+            Util::Thread::ScopedLock locked(lock);
+            stopping = !running;
+            late = deadline != 0 && System::currentMilliseconds() > deadline;
+            if (group == NL_INVALID || built != generation){
+                mine.clear();
+                if (group != NL_INVALID){
+                    nlGroupDestroy(group);
+                }
+                group = nlGroupCreate();
+                for (vector<Connection*>::iterator it = connections.begin(); it != connections.end(); it++){
+                    Connection * connection = *it;
+                    if (connection->thread == thread && !connection->done){
+                        mine.push_back(connection);
+                        nlGroupAddSocket(group, connection->socket);
+                    }
+                }
+                built = generation;
+            }
+        }
+
+        bool partial = false;
+        for (vector<Connection*>::iterator it = mine.begin(); it != mine.end(); it++){
+            Connection & connection = **it;
+            if (connection.partial()){
+                partial = true;
+                if (stopping && late){
+                    debug(0) << "Gave up on the rest of a message from socket " << connection.socket << endl;
+                    finish(connection);
+                }
+            }
+        }
+
+        /* leave the sockets at a message boundary */
+        if (stopping && (!partial || late)){
+            break;
+        }
+
+        if (mine.empty()){
+            /* nothing to wait on until a socket is added */
+            Util::rest(PollTime);
+            continue;
+        }
+
+        ready.resize(mine.size());
+        NLint count = nlPollGroup(group, NL_READ_STATUS, &ready[0], ready.size(), PollTime);
+        if (count == NL_INVALID){
+            debug(0) << "Could not poll the sockets of message loop thread " << thread << ": " << nlGetSystemErrorStr(nlGetSystemError()) << endl;
+            Util::rest(PollTime);
+            continue;
+        }
+
+        for (NLint index = 0; index < count; index++){
+            for (vector<Connection*>::iterator it = mine.begin(); it != mine.end(); it++){
+                Connection & connection = **it;
+                if (connection.socket == ready[index] && !connection.done){
+                    service(connection, stopping);
+                }
+            }
+        }
+    }
+
+    if (group != NL_INVALID){
+        nlGroupDestroy(group);
+    }
+    debug(1) << "Message loop thread " << thread << " is done" << endl;
+}
+
+void MessageLoop::queue(Message & message){
+    message.timestamp = System::currentMilliseconds();
+    message.reset();
+
+    /* if the queue is full then stop reading until the game catches up */
+    while (!incoming.push(message)){
+        if (!isRunning()){
+            debug(1) << "Dropping a message from socket " << message.readFrom << " while stopping" << endl;
+            break;
+        }
+        Util::rest(1);
+    }
+}
+
+/* Queues every whole message at the start of the buffer and keeps the rest */
+void MessageLoop::decode(Connection & connection){
+    unsigned int start = 0;
+    connection.missing = 0;
+    while (start < connection.buffer.size()){
+        Message message;
+        unsigned int used = Message::parse(&connection.buffer[start], connection.buffer.size() - start, message, connection.missing);
+        if (used == 0){
+            break;
+        }
+        message.readFrom = connection.socket;
+        queue(message);
+        start += used;
+    }
+    connection.buffer.erase(connection.buffer.begin(), connection.buffer.begin() + start);
+}
+
+void MessageLoop::finish(Connection & connection){
+    Util::Thread::ScopedLock locked(lock);
+    connection.done = true;
+    connection.buffer.clear();
+    generation += 1;
+}
+
+/* While the loop runs a read takes whatever the socket has. Once it is
+ * stopping no new message is started and a message that was started only
+ * gets the bytes it still needs.
+ */
+void MessageLoop::service(Connection & connection, bool stopping){
+    unsigned int wanted = ReadSize;
+    if (stopping){
+        if (connection.buffer.empty()){
+            return;
+        }
+        wanted = connection.missing;
+    }
+
+    try{
+        unsigned int have = connection.buffer.size();
+        connection.buffer.resize(have + wanted);
+        int got = readUptoBytes(connection.socket, &connection.buffer[have], wanted);
+        connection.buffer.resize(have + (got > 0 ? got : 0));
+        if (got > 0){
+            decode(connection);
+        }
+        return;
+    } catch (const MessageEnd & end){
+        debug(1) << "Closed connection with socket " << connection.socket << endl;
+    } catch (const NetworkException & e){
+        debug(0) << "Network exception on socket " << connection.socket << ": " << e.getMessage() << endl;
+    }
+
+    finish(connection);
+}
+
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef _paintown_engine_message_loop_h
+#define _paintown_engine_message_loop_h
+
+#include <r-tech1/network/network.h>
+#include <r-tech1/thread.h>
+#include "network.h"
+#include "system/queue.h"
+#include <vector>
+#include <string>
+
+namespace Network{
+
+/* Reads messages from a group of sockets with a small number of threads
+ * instead of one blocking thread per socket. The sockets are put into
+ * non-blocking mode and each thread waits on a HawkNL group of its sockets
+ * until one of them has something to read. Whatever a socket has is read in
+ * one go into the buffer of its connection and decoded from there.
+ *
+ * Once the loop is stopped only the bytes that the message being decoded
+ * still needs are read, so every socket is left at a message boundary and
+ * can be read with blocking Message(socket) again.
+ */
+class MessageLoop{
+public:
+    /* `threads' is the number of threads that read sockets. Each socket is
+     * read by just one of them.
+     */
+    MessageLoop(int threads = 1);
+    virtual ~MessageLoop();
+
+    void add(Socket socket);
+    /* stop reading from `socket'. its safe to call this from any thread */
+    void remove(Socket socket);
+
+    void start();
+    /* tells the threads to stop once they finish the messages they are in
+     * the middle of. no new messages will be started after this.
+     */
+    void stop();
+    /* waits for the threads and puts the sockets back into blocking mode.
+     * a thread in the middle of a message gives up on it if the rest doesn't
+     * show up within `timeout' milliseconds, that socket is left alone.
+     */
+    void wait(unsigned int timeout = 1000);
+
+    /* the next message that was read, returns false if there isn't one.
+     * only one thread should call this.
+     */
+    bool getMessage(Message & out);
+
+    inline const System::QueueStatistics & getStatistics() const {
+        return incoming.getStatistics();
+    }
+
+    /* the body of one reading thread */
+    void run(unsigned int thread);
+
+protected:
+    struct Connection{
+        Connection(Socket socket, unsigned int thread);
+
+        Socket socket;
+        unsigned int thread;
+        bool done;
+
+        /* bytes read from the socket that aren't a whole message yet */
+        std::vector<uint8_t> buffer;
+        /* how many more bytes the message in the buffer needs at least */
+        unsigned int missing;
+
+        /* true if some of a message has been read */
+        bool partial() const;
+    };
+
+    bool isRunning();
+
+    /* reads once from the connection and queues the messages that are whole */
+    void service(Connection & connection, bool stopping);
+    void decode(Connection & connection);
+    void queue(Message & message);
+    void finish(Connection & connection);
+
+    unsigned int threadCount;
+    unsigned int nextThread;
+    std::vector<Util::Thread::Id> threads;
+    std::vector<Connection*> connections;
+    System::ManyQueue<Message> incoming;
+    Util::Thread::LockObject lock;
+    bool running;
+    bool started;
+    /* changes whenever a connection is added or finished so the threads
+     * know to build their socket groups again
+     */
+    unsigned int generation;
+    /* when threads stop waiting for the rest of a message, 0 until wait() */
+    uint64_t deadline;
+};
+
+}
+
+#endif
@@ -33,78 +33,157 @@ using std::vector;
 
 namespace Network{
 
-/* just some random number I picked out of thin air */
-const unsigned int MagicId = 0x0dff2110;
+/* just some random number I picked out of thin air. change it whenever the
+ * format of messages changes so old clients are turned away.
+ */
+const unsigned int MagicId = 0x0dff2111;
+
+static const Message & deref(const Message & message){
+    return message;
+}
+
+static const Message & deref(Message* const & message){
+    return *message;
+}
+
+template <class M>
+static void doSendAllMessages(const vector<M> & messages, Socket socket, vector<uint8_t> & buffer, Traffic * traffic){
+#ifdef HAVE_NETWORKING
+    buffer.clear();
+    for (typename vector<M>::const_iterator it = messages.begin(); it != messages.end(); it++){
+        const Message & message = deref(*it);
+        unsigned int before = buffer.size();
+        message.dump(buffer);
+        if (traffic != NULL){
+            traffic->count(message, buffer.size() - before);
+        }
+    }
 
-static int messageSize(Message const & message){
-    return message.size();
+    // Compress::testCompression((unsigned char *) data, length);
+    if (buffer.size() > 0){
+        sendBytes(socket, &buffer[0], buffer.size());
+    }
+#endif
 }
 
-static int messageSize(Message* const & message){
-    return message->size();
+void sendAllMessages(const vector<Message> & messages, Socket socket){
+    vector<uint8_t> buffer;
+    doSendAllMessages<Message>(messages, socket, buffer, NULL);
 }
 
-static uint8_t * messageDump(const Message & message, uint8_t * buffer){
-    return message.dump(buffer);
+void sendAllMessages(const vector<Message*> & messages, Socket socket){
+    vector<uint8_t> buffer;
+    doSendAllMessages<Message*>(messages, socket, buffer, NULL);
 }
 
-static uint8_t * messageDump(Message* const & message, uint8_t * buffer){
-    return message->dump(buffer);
+void sendAllMessages(const vector<Message> & messages, Socket socket, vector<uint8_t> & buffer, Traffic * traffic){
+    doSendAllMessages<Message>(messages, socket, buffer, traffic);
 }
 
-template <typename M>
-static int totalSize(const vector<M> & messages){
-    int size = 0;
-    for (typename vector<M>::const_iterator it = messages.begin(); it != messages.end(); it++){
-        // size += messageSize<M>(*it);
-        size += messageSize(*it);
+void sendAllMessages(const vector<Message*> & messages, Socket socket, vector<uint8_t> & buffer, Traffic * traffic){
+    doSendAllMessages<Message*>(messages, socket, buffer, traffic);
+}
+
+Traffic::Counter::Counter():
+packets(0),
+bytes(0){
+}
+
+void Traffic::count(const Message & message, int bytes){
+    Counter & counter = message.id == 0 ? world[message.type()] : object[message.type()];
+    counter.packets += 1;
+    counter.bytes += bytes;
+    total.packets += 1;
+    total.bytes += bytes;
+}
+
+static void reportCounters(std::ostream & out, const char * kind, const std::map<int, Traffic::Counter> & counters){
+    for (std::map<int, Traffic::Counter>::const_iterator it = counters.begin(); it != counters.end(); it++){
+        out << "  " << kind << " message " << it->first << ": " << it->second.packets << " packets " << it->second.bytes << " bytes" << std::endl;
     }
-    return size;
 }
 
-template <class M>
-static void dump(const std::vector<M> & messages, uint8_t * buffer ){
-    for (typename vector<M>::const_iterator it = messages.begin(); it != messages.end(); it++ ){
-        buffer = messageDump(*it, buffer);
+void Traffic::report(std::ostream & out) const {
+    out << "Sent " << total.packets << " packets " << total.bytes << " bytes" << std::endl;
+    reportCounters(out, "world", world);
+    reportCounters(out, "object", object);
+}
+
+/* Messages used to go out with all DATA_SIZE bytes of data no matter how
+ * much of it was used, which is mostly zeros. Now numbers that are usually
+ * small (the id and the lengths) are written seven bits per byte with the
+ * high bit set on all bytes but the last, and only the data up to the last
+ * non-zero byte is sent. A message is
+ *
+ *   id : number
+ *   data length : number
+ *   data : data length bytes
+ *   path length : number, 0 if there is no path
+ *   path : path length bytes
+ */
+static int numberSize(uint32_t value){
+    int size = 1;
+    while (value >= 0x80){
+        value >>= 7;
+        size += 1;
     }
+    return size;
 }
 
-template <class M>
-static void doSendAllMessages(const vector<M> & messages, Socket socket){
-#ifdef HAVE_NETWORKING
-    int length = totalSize<M>(messages);
-    uint8_t * data = new uint8_t[length];
-    dump<M>(messages, data);
-    // Compress::testCompression((unsigned char *) data, length);
-    sendBytes(socket, data, length);
-    delete[] data;
-#endif
+static uint8_t * writeNumber(uint8_t * buffer, uint32_t value){
+    while (value >= 0x80){
+        *buffer = (value & 0x7f) | 0x80;
+        buffer += 1;
+        value >>= 7;
+    }
+    *buffer = value;
+    return buffer + 1;
 }
 
-void sendAllMessages(const vector<Message> & messages, Socket socket){
-    doSendAllMessages<Message>(messages, socket);
+/* reads the number at `position' and moves past it, returns false if the
+ * buffer ends before the number does
+ */
+static bool readNumber(const uint8_t * buffer, unsigned int length, unsigned int & position, uint32_t & out){
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7){
+        if (position >= length){
+            return false;
+        }
+        uint8_t byte = buffer[position];
+        position += 1;
+        value |= (uint32_t) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0){
+            out = value;
+            return true;
+        }
+    }
+    throw NetworkException("Malformed number in message");
 }
 
-void sendAllMessages(const vector<Message*> & messages, Socket socket){
-    doSendAllMessages<Message*>(messages, socket);
+/* readers of the data get zeros past the end of what was sent, which is what
+ * the unsent bytes were anyway
+ */
+static int usedData(const uint8_t * data){
+    int used = DATA_SIZE;
+    while (used > 0 && data[used - 1] == 0){
+        used -= 1;
+    }
+    return used;
 }
 
 void Message::send(Socket socket) const {
-	/*
-	send16( socket, id );
-	sendBytes( socket, data, DATA_SIZE );
-	if ( path != "" ){
-		send16( socket, path.length() + 1 );
-		sendStr( socket, path );
-	} else {
-		send16( socket, -1 );
-	}
-	*/
 #ifdef HAVE_NETWORKING
-    uint8_t * buffer = new uint8_t[size()];
-    dump(buffer);
-    sendBytes(socket, buffer, size());
-    delete[] buffer;
+    /* most messages are small enough to not need the heap */
+    uint8_t small[256];
+    int length = size();
+    if (length <= (int) sizeof(small)){
+        dump(small);
+        sendBytes(socket, small, length);
+    } else {
+        vector<uint8_t> buffer;
+        dump(buffer);
+        sendBytes(socket, &buffer[0], buffer.size());
+    }
 #endif
 }
 
@@ -137,26 +216,70 @@ Message & Message::operator=( const Message & m ){
     return *this;
 }
 
+/* Only as many bytes as the message still needs are read so the socket is
+ * left at the start of the next message.
+ */
 Message::Message(Socket socket){
 #ifdef HAVE_NETWORKING
-    position = data;
-    id = read32(socket);
-    readBytes(socket, data, DATA_SIZE);
-    int str = read16(socket);
-    if (str != -1){
-        /* cap strings at 1024 bytes */
-        char buf[1024];
-        str = (signed)(sizeof(buf) - 1) < str ? (signed)(sizeof(buf) - 1) : str;
-        readBytes(socket, (uint8_t *) buf, str);
-        buf[str] = 0;
-        /* this is a string copy, not an assignment to a temporary pointer */
-        this->path = buf;
+    vector<uint8_t> buffer;
+    unsigned int missing = 0;
+    while (parse(buffer.empty() ? NULL : &buffer[0], buffer.size(), *this, missing) == 0){
+        unsigned int start = buffer.size();
+        buffer.resize(start + missing);
+        readBytes(socket, &buffer[start], missing);
     }
     timestamp = System::currentMilliseconds();
     readFrom = socket;
 #endif
 }
 
+unsigned int Message::parse(const uint8_t * buffer, unsigned int length, Message & out, unsigned int & missing){
+    unsigned int position = 0;
+    uint32_t id = 0;
+    uint32_t used = 0;
+    /* the next byte has to be part of the number */
+    missing = 1;
+    if (!readNumber(buffer, length, position, id) ||
+        !readNumber(buffer, length, position, used)){
+        return 0;
+    }
+
+    if (used > (uint32_t) DATA_SIZE){
+        throw NetworkException("Message has too much data");
+    }
+
+    /* the data and at least one byte of the path length */
+    if (length - position < used + 1){
+        missing = used + 1 - (length - position);
+        return 0;
+    }
+    unsigned int data = position;
+    position += used;
+
+    uint32_t pathLength = 0;
+    if (!readNumber(buffer, length, position, pathLength)){
+        return 0;
+    }
+
+    /* cap strings at 64k */
+    if (pathLength > 65536){
+        throw NetworkException("Message path is too long");
+    }
+
+    if (length - position < pathLength){
+        missing = pathLength - (length - position);
+        return 0;
+    }
+
+    out.id = id;
+    memset(out.data, 0, sizeof(out.data));
+    memcpy(out.data, buffer + data, used);
+    out.position = out.data;
+    out.path = string((const char *) buffer + position, pathLength);
+    missing = 0;
+    return position + pathLength;
+}
+
 /* copies data into buffer and increments buffer by the number of bits
  * in Size
  */
@@ -166,25 +289,28 @@ template<class Size> static void mcopy(uint8_t *& buffer, Size data){
 }
 
 uint8_t * Message::dump(uint8_t * buffer) const {
-    mcopy<uint32_t>(buffer, htonl(id));
-    // *(uint32_t *) buffer = htonl(id);
-    // Global::debug(1, "network") << "Dumped id " << id << " as " << htonl(id) << std::endl;
-    // buffer += sizeof(id);
-    memcpy(buffer, data, DATA_SIZE);
-    buffer += DATA_SIZE;
-    if (path != ""){
-        // *(uint16_t *) buffer = htons(path.length() + 1);
-        // buffer += sizeof(uint16_t);
-        mcopy<uint16_t>(buffer, htons(path.length() + 1));
-        memcpy(buffer, path.c_str(), path.length() + 1);
-        buffer += path.length() + 1;
-    } else {
-        // *(uint16_t *) buffer = htons((uint16_t) -1);
-        // buffer += sizeof(uint16_t);
-        mcopy<uint16_t>(buffer, htons((uint16_t) -1));
-    }
+    int used = usedData(data);
+    buffer = writeNumber(buffer, id);
+    buffer = writeNumber(buffer, used);
+    memcpy(buffer, data, used);
+    buffer += used;
+    buffer = writeNumber(buffer, path.length());
+    memcpy(buffer, path.data(), path.length());
+    buffer += path.length();
     return buffer;
 }
+
+void Message::dump(vector<uint8_t> & buffer) const {
+    unsigned int start = buffer.size();
+    buffer.resize(start + size());
+    dump(&buffer[start]);
+}
+
+int Message::type() const {
+    int16_t out;
+    memcpy(&out, data, sizeof(out));
+    return (int16_t) ntohs(out);
+}
 	
 void Message::reset(){
     position = data;
@@ -261,8 +387,9 @@ Message & Message::operator<<(string p){
 }
 	
 int Message::size() const {
-    return sizeof(id) + DATA_SIZE + 
-           (path != "" ? sizeof(uint16_t) + path.length() + 1 : sizeof(uint16_t));
+    int used = usedData(data);
+    return numberSize(id) + numberSize(used) + used +
+           numberSize(path.length()) + path.length();
 }
 
 }
@@ -2,6 +2,9 @@
 #define _paintown_engine_network_h
 
 #include <r-tech1/network/network.h>
+#include <vector>
+#include <map>
+#include <ostream>
 
 namespace Network{
 
@@ -24,12 +27,28 @@ struct Message{
     Message & operator>>( unsigned int & x );
     Message & operator>>(std::string & out);
 
+    /* number of bytes this message takes on the wire */
     int size() const;
     uint8_t * dump( uint8_t * buffer ) const;
+    /* appends the message to the end of `buffer' */
+    void dump(std::vector<uint8_t> & buffer) const;
+
+    /* the first field of the data, which is the kind of message */
+    int type() const;
 
     void send( Socket socket ) const;
     void reset();
 
+    /* Decodes a message written by dump() from the first `length' bytes of
+     * `buffer' into `out'. Returns the number of bytes the message took, or
+     * 0 if the buffer ends before the message does. Then `missing' is how
+     * many more bytes the message needs at least, reading just that many
+     * never goes past the end of the message. Only the id, data and path of
+     * `out' are set.
+     * Throws NetworkException if the message is malformed.
+     */
+    static unsigned int parse(const uint8_t * buffer, unsigned int length, Message & out, unsigned int & missing);
+
     std::string path;
 
     /* time in microseconds
@@ -43,8 +62,32 @@ struct Message{
     Socket readFrom;
 };
 
+/* Number of packets and bytes sent, split up by the type of the message.
+ * World messages (id 0) and object messages are kept apart because their
+ * types come from different enums.
+ */
+struct Traffic{
+    struct Counter{
+        Counter();
+
+        unsigned int packets;
+        uint64_t bytes;
+    };
+
+    void count(const Message & message, int bytes);
+    void report(std::ostream & out) const;
+
+    std::map<int, Counter> world;
+    std::map<int, Counter> object;
+    Counter total;
+};
+
+/* All the messages are written into one buffer and sent with one write */
 void sendAllMessages(const std::vector<Message> & messages, Socket socket);
 void sendAllMessages(const std::vector<Message*> & messages, Socket socket);
+/* Same, but reuses `buffer' and counts what was sent in `traffic' if its not null */
+void sendAllMessages(const std::vector<Message> & messages, Socket socket, std::vector<uint8_t> & buffer, Traffic * traffic);
+void sendAllMessages(const std::vector<Message*> & messages, Socket socket, std::vector<uint8_t> & buffer, Traffic * traffic);
 
 }
 
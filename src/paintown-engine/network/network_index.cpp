@@ -0,0 +1,94 @@
+#include "network_index.h"
+
+using std::vector;
+
+/* objects that aren't known by the network have this id */
+static const Paintown::Object::networkid_t noId = (Paintown::Object::networkid_t) -1;
+
+NetworkIndex::NetworkIndex():
+buckets(16),
+count(0){
+}
+
+/* The buckets are cleared instead of thrown away so their memory is reused
+ * from one frame to the next.
+ */
+void NetworkIndex::resize(unsigned int size){
+    unsigned int wanted = buckets.size();
+    while (wanted < size){
+        wanted *= 2;
+    }
+
+    if (wanted != buckets.size()){
+        vector<Entry> all;
+        for (unsigned int i = 0; i < buckets.size(); i++){
+            all.insert(all.end(), buckets[i].begin(), buckets[i].end());
+        }
+        buckets.resize(wanted);
+        for (unsigned int i = 0; i < buckets.size(); i++){
+            buckets[i].clear();
+        }
+        for (vector<Entry>::iterator it = all.begin(); it != all.end(); it++){
+            buckets[bucket(it->id)].push_back(*it);
+        }
+    }
+}
+
+void NetworkIndex::rebuild(const vector<Paintown::Object*> & objects){
+    for (unsigned int i = 0; i < buckets.size(); i++){
+        buckets[i].clear();
+    }
+    count = 0;
+    resize(objects.size() * 2);
+
+    for (vector<Paintown::Object*>::const_iterator it = objects.begin(); it != objects.end(); it++){
+        add(*it);
+    }
+}
+
+void NetworkIndex::add(Paintown::Object * object){
+    Paintown::Object::networkid_t id = object->getId();
+    if (id == noId || find(id) != NULL){
+        return;
+    }
+
+    if (count * 2 >= buckets.size()){
+        resize(buckets.size() * 2);
+    }
+
+    Entry entry;
+    entry.id = id;
+    entry.object = object;
+    buckets[bucket(id)].push_back(entry);
+    count += 1;
+}
+
+void NetworkIndex::remove(Paintown::Object * object, const vector<Paintown::Object*> & objects){
+    Paintown::Object::networkid_t id = object->getId();
+    vector<Entry> & entries = buckets[bucket(id)];
+    for (vector<Entry>::iterator it = entries.begin(); it != entries.end(); it++){
+        if (it->object == object){
+            entries.erase(it);
+            count -= 1;
+
+            /* another object could have the same id */
+            for (vector<Paintown::Object*>::const_iterator other = objects.begin(); other != objects.end(); other++){
+                if (*other != object && (*other)->getId() == id){
+                    add(*other);
+                    break;
+                }
+            }
+            return;
+        }
+    }
+}
+
+Paintown::Object * NetworkIndex::find(Paintown::Object::networkid_t id) const {
+    const vector<Entry> & entries = buckets[bucket(id)];
+    for (vector<Entry>::const_iterator it = entries.begin(); it != entries.end(); it++){
+        if (it->id == id){
+            return it->object;
+        }
+    }
+    return NULL;
+}
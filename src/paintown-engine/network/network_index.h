@@ -0,0 +1,44 @@
+#ifndef _paintown_network_index_h
+#define _paintown_network_index_h
+
+#include <vector>
+#include "../object/object.h"
+
+/* Finds objects by their network id without looking at every object in the
+ * world. The network worlds rebuild it once a frame before they handle the
+ * messages that arrived, and keep it up to date as those messages add and
+ * remove objects.
+ *
+ * Network ids are handed out one after another so the low bits of the id
+ * make a good hash. Like a search of the objects, if two objects share an id
+ * the one that comes first is found.
+ */
+class NetworkIndex{
+public:
+    NetworkIndex();
+
+    void rebuild(const std::vector<Paintown::Object*> & objects);
+    void add(Paintown::Object * object);
+    /* `objects' is searched for another object with the same id */
+    void remove(Paintown::Object * object, const std::vector<Paintown::Object*> & objects);
+
+    Paintown::Object * find(Paintown::Object::networkid_t id) const;
+
+protected:
+    struct Entry{
+        Paintown::Object::networkid_t id;
+        Paintown::Object * object;
+    };
+
+    void resize(unsigned int size);
+
+    inline unsigned int bucket(Paintown::Object::networkid_t id) const {
+        return id & (buckets.size() - 1);
+    }
+
+    /* always a power of two */
+    std::vector<std::vector<Entry> > buckets;
+    unsigned int count;
+};
+
+#endif
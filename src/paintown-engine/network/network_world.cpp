@@ -22,46 +22,16 @@ using namespace std;
 
 typedef AdventureWorld super;
 
-struct Stuff{
-    Network::Socket socket;
-    NetworkWorld * world;
-};
-
 static std::ostream & debug( int level ){
     return Global::debug(level, "network-world");
 }
 
-static void * handleMessages( void * arg ){
-    Stuff * s = (Stuff *) arg;
-    Network::Socket socket = s->socket;
-    NetworkWorld * world = s->world;
-
-    unsigned int id = 1;
-    try{
-        while (world->isRunning()){
-            Network::Message m(socket);
-            ostringstream context;
-            context << __FILE__ << " " << System::currentMilliseconds();
-            Global::debug(2, context.str()) << "Received message " << id << " with path '" << m.path << "'" << endl;
-            id += 1;
-            world->addIncomingMessage(m, socket);
-            // debug(2, __FILE__) << "Received path '" << m.path << "'" << endl;
-        }
-    } catch (const Network::MessageEnd & end){
-        debug(1) << "Closed connection with socket " << socket << endl;
-    } catch ( const Network::NetworkException & ne ){
-        debug(0) << "Network exception: " << ne.getMessage() << endl;
-    }
-
-    delete s;
-
-    return NULL;
-}
-
 NetworkWorld::NetworkWorld(vector< Network::Socket > & sockets, const vector< Paintown::Object * > & players, const map<Paintown::Object*, Network::Socket> & characterToClient, const Filesystem::AbsolutePath & path, const map<Paintown::Object::networkid_t, string> & clientNames, int screen_size ):
-AdventureWorld( players, path, new Level::DefaultCacher(), screen_size ),
+AdventureWorld( players, path, new Level::ThreadedCacher(), screen_size ),
 ChatWidget(*this, 0),
 sockets(sockets),
+outgoing(4096),
+overflowing(false),
 clientNames(clientNames),
 characterToClient(characterToClient),
 sent_messages( 0 ),
@@ -81,26 +51,24 @@ running(true){
     this->id = max_id + 1;
 }
 
+/* all the clients are read by the message loop */
 void NetworkWorld::startMessageHandlers(){
     for ( vector<Network::Socket>::const_iterator it = sockets.begin(); it != sockets.end(); it++ ){
-        Stuff * s = new Stuff;
-        s->socket = *it;
-        s->world = this;
-        Util::Thread::Id thread;
-        Util::Thread::createThread( &thread, NULL, (Util::Thread::ThreadFunction) handleMessages, s );
-        threads.push_back( thread );
+        reader.add(*it);
     }
+    reader.start();
 }
 
 void NetworkWorld::waitForHandlers(){
-    for (vector<Util::Thread::Id>::iterator it = threads.begin(); it != threads.end(); it++){
-        Util::Thread::Id & thread = *it;
-        Util::Thread::joinThread(thread);
-    }
+    reader.wait();
 }
 
 NetworkWorld::~NetworkWorld(){
     stopRunning();
+    reader.wait();
+    traffic.report(debug(1));
+    outgoing.getStatistics().report(debug(1), "Outgoing queue");
+    reader.getStatistics().report(debug(1), "Incoming queue");
 }
 	
 void NetworkWorld::addObject( Paintown::Object * o ){
@@ -114,6 +82,7 @@ void NetworkWorld::addObject( Paintown::Object * o ){
     }
 
     AdventureWorld::addObject( o );
+    index.add(o);
 }
 	
 void NetworkWorld::addMessage( Network::Message m, Network::Socket from, Network::Socket to){
@@ -125,31 +94,30 @@ void NetworkWorld::addMessage( Network::Message m, Network::Socket from, Network
         }
         throw Network::NetworkException(out.str());
     }
-    Util::Thread::acquireLock( &message_mutex );
     /* if the server generates a message `from' will probably be 0.
      * if the message should go to a specific client `to' will be non-zero.
      */
     Packet p(m, from, to);
-    outgoing.push_back( p );
-    Util::Thread::releaseLock( &message_mutex );
-}
-
-void NetworkWorld::addIncomingMessage( const Network::Message & message, Network::Socket from ){
-    Util::Thread::acquireLock( &message_mutex );
-    incoming.push_back(message);
-    Util::Thread::releaseLock( &message_mutex );
-
-    /* by default all messages get relayed to all clients, but a client
-     * shouldn't send its own message back to itself so it populates the
-     * `from' field.
+    /* the queue only fills up if nothing is flushed for a long time. once
+     * a message goes into the overflow the rest follow it until the next
+     * flush so they stay in order.
      */
-    addMessage( message, from );
+    if (overflowing || !outgoing.push(p)){
+        Util::Thread::acquireLock( &message_mutex );
+        overflowing = true;
+        overflow.push_back(p);
+        Util::Thread::releaseLock( &message_mutex );
+    }
 }
 	
 void NetworkWorld::stopRunning(){
     Util::Thread::acquireLock( &running_mutex );
     running = false;
     Util::Thread::releaseLock( &running_mutex );
+    /* stop reading now so messages sent after the game, like FINISH, stay
+     * in the sockets for whoever reads them next
+     */
+    reader.stop();
 }
 
 bool NetworkWorld::isRunning(){
@@ -225,13 +193,7 @@ void NetworkWorld::doScene( int min_x, int max_x ){
 }
 
 Paintown::Object * NetworkWorld::findNetworkObject( Paintown::Object::networkid_t id ){
-    for ( vector< Paintown::Object * >::iterator it = objects.begin(); it != objects.end(); it++ ){
-        Paintown::Object * o = *it;
-        if ( o->getId() == id ){
-            return o;
-        }
-    }
-    return NULL;
+    return index.find(id);
 }
 
 void NetworkWorld::handlePing(Network::Message & message){
@@ -265,6 +227,7 @@ void NetworkWorld::removePlayer(Paintown::Object * player){
     for ( vector< Paintown::Object * >::iterator it = objects.begin(); it != objects.end(); ){
         Paintown::Object * o = *it;
         if (o->getId() == player->getId()){
+            index.remove(o, objects);
             it = objects.erase(it);
         } else {
             it++;
@@ -280,6 +243,8 @@ void NetworkWorld::removeSocket(Network::Socket socket){
             it++;
         }
     }
+    sendBuffers.erase(socket);
+    reader.remove(socket);
 }
 
 Paintown::Object * NetworkWorld::findPlayerFromSocket(Network::Socket socket){
@@ -341,15 +306,14 @@ void NetworkWorld::handleMessage( Network::Message & message ){
             case QUIT : {
                 /* when a client quits we have to
                  * 1. delete that player from existence, send DELETE_OBJ
-                 * 2. stop the socket input threads 
+                 * 2. stop reading from the socket
                  * 3. remove the socket from our list of clients
-                 * The thread will die on its own so we don't need to kill it.
                  */
                 Paintown::Object * player = findPlayerFromSocket(message.readFrom);
                 addMessage(deleteMessage(player->getId()));
                 removePlayer(player);
-                Network::close(message.readFrom);
                 removeSocket(message.readFrom);
+                Network::close(message.readFrom);
 
                 /* TODO: add a warning message to the user
                  * that a client just quit.
@@ -395,25 +359,37 @@ void NetworkWorld::handleMessage( Network::Message & message ){
     }
 }
 
-vector< Network::Message > NetworkWorld::getIncomingMessages(){
-    vector< Network::Message > m;
-    Util::Thread::acquireLock(&message_mutex);
-    m = incoming;
-    incoming.clear();
-    Util::Thread::releaseLock(&message_mutex);
-    return m;
+bool NetworkWorld::nextIncomingMessage(Network::Message & message){
+    if (!reader.getMessage(message)){
+        return false;
+    }
+
+    /* by default all messages get relayed to all clients, but a client
+     * shouldn't get its own message back so the sender goes in `from'.
+     */
+    addMessage(message, message.readFrom);
+    return true;
 }
 
 void NetworkWorld::flushOutgoing(){
-    vector< Packet > packets;
-    Util::Thread::acquireLock(&message_mutex);
-    packets = outgoing;
-    outgoing.clear();
-    Util::Thread::releaseLock(&message_mutex);
+    sending.clear();
+    Packet packet;
+    while (outgoing.pop(packet)){
+        sending.push_back(packet);
+    }
 
+    if (overflowing){
+        Util::Thread::acquireLock(&message_mutex);
+        sending.insert(sending.end(), overflow.begin(), overflow.end());
+        overflow.clear();
+        overflowing = false;
+        Util::Thread::releaseLock(&message_mutex);
+    }
+
+    vector<Network::Message*> messages;
     for (vector<Network::Socket>::iterator socket = sockets.begin(); socket != sockets.end(); socket++){
-        vector<Network::Message*> messages;
-        for ( vector< Packet >::iterator it = packets.begin(); it != packets.end(); it++ ){
+        messages.clear();
+        for ( vector< Packet >::iterator it = sending.begin(); it != sending.end(); it++ ){
             Network::Message & message = (*it).message;
             Network::Socket from = (*it).socket;
             Network::Socket to = (*it).to;
@@ -428,7 +404,8 @@ void NetworkWorld::flushOutgoing(){
             }
         }
 
-        Network::sendAllMessages(messages, *socket);
+        /* everything for this socket goes out in one write */
+        Network::sendAllMessages(messages, *socket, sendBuffers[*socket], &traffic);
     }
 }
 	
@@ -441,9 +418,12 @@ void NetworkWorld::act(){
     AdventureWorld::act();
     ChatWidget::act();
 
-    vector<Network::Message> messages = getIncomingMessages();
-    for (vector< Network::Message >::iterator it = messages.begin(); it != messages.end(); it++){
-        handleMessage(*it);
+    /* objects came and went during the logic */
+    index.rebuild(objects);
+
+    Network::Message message;
+    while (nextIncomingMessage(message)){
+        handleMessage(message);
     }
 
     flushOutgoing();
@@ -8,6 +8,9 @@
 #include "../object/object.h"
 #include "../game/adventure_world.h"
 #include "chat-widget.h"
+#include "message_loop.h"
+#include "network_index.h"
+#include "system/queue.h"
 #include <vector>
 #include <string>
 #include <deque>
@@ -15,6 +18,10 @@
 #include <map>
 
 struct Packet{
+        Packet():
+            socket(0),
+            to(0){}
+
 	Packet(const Network::Message & m, Network::Socket s, Network::Socket to = 0):
             message(m),
             socket(s),
@@ -36,12 +43,10 @@ public:
 	virtual void doScene( int min_x, int max_x );
         
         virtual void changePause();
-	
-	void addIncomingMessage( const Network::Message & message, Network::Socket from );
 
 	Network::Message finishMessage();
 
-        /* starts the threads for each client */
+        /* starts reading messages from the clients */
         void startMessageHandlers();
         void waitForHandlers();
 
@@ -58,7 +63,8 @@ public:
 protected:
         Paintown::Object * findNetworkObject( Paintown::Object::networkid_t id );
 	void sendMessage( const Network::Message & message, Network::Socket socket );
-        std::vector< Network::Message > getIncomingMessages();
+        /* the next message from a client, returns false if there are none */
+        bool nextIncomingMessage(Network::Message & message);
 	void handleMessage( Network::Message & message );
         void handlePing(Network::Message & message);
 
@@ -76,9 +82,19 @@ protected:
 
 private:
 	std::vector<Network::Socket> & sockets;
-	std::vector<Packet> outgoing;
-	std::vector<Network::Message> incoming;
-	std::vector<Util::Thread::Id> threads;
+	System::ManyQueue<Packet> outgoing;
+        /* where messages go when `outgoing' is full, guarded by message_mutex */
+	std::vector<Packet> overflow;
+        volatile bool overflowing;
+        /* the packets being sent by flushOutgoing */
+	std::vector<Packet> sending;
+        /* reused every frame so sending doesn't allocate */
+        std::map<Network::Socket, std::vector<uint8_t> > sendBuffers;
+        Network::Traffic traffic;
+        /* reads the messages from all the clients */
+        Network::MessageLoop reader;
+        /* only valid while messages are being handled */
+        NetworkIndex index;
         std::map<Paintown::Object::networkid_t, std::string> clientNames;
 	std::map<Paintown::Object*, Network::Socket> characterToClient;
         Paintown::Object::networkid_t id;
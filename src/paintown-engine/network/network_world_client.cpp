@@ -24,10 +24,12 @@
 #include "cacher.h"
 #include "input/input-manager.h"
 #include <sstream>
+#include <algorithm>
 
 #include "../object/character.h"
 #include "../object/cat.h"
 #include "../object/item.h"
+#include "../object/object_messages.h"
 
 using namespace std;
 
@@ -97,6 +99,7 @@ void NetworkWorldClient::startMessageHandler(){
 	
 NetworkWorldClient::~NetworkWorldClient(){
     debug(1) << "Destroy client world" << endl;
+    traffic.report(debug(1));
 }
 	
 bool NetworkWorldClient::isRunning(){
@@ -155,13 +158,12 @@ void NetworkWorldClient::changePause(){
 }
 
 bool NetworkWorldClient::uniqueObject( Paintown::Object::networkid_t id ){
-    for ( vector< Paintown::Object * >::iterator it = objects.begin(); it != objects.end(); it++ ){
-        Paintown::Object * o = *it;
-        if ( o->getId() == id ){
-            return false;
-        }
-    }
-    return true;
+    return index.find(id) == NULL;
+}
+
+void NetworkWorldClient::addObject(Paintown::Object * o){
+    super::addObject(o);
+    index.add(o);
 }
 
 void NetworkWorldClient::handleCreateCharacter( Network::Message & message ){
@@ -244,16 +246,12 @@ bool NetworkWorldClient::finished() const {
 }
 
 Paintown::Object * NetworkWorldClient::removeObject( Paintown::Object::networkid_t id ){
-    for (vector<Paintown::Object *>::iterator it = objects.begin(); it != objects.end(); ){
-        Paintown::Object * o = *it;
-        if (o->getId() == id){
-            it = objects.erase(it);
-            return o;
-        } else {
-            it++;
-        }
+    Paintown::Object * o = index.find(id);
+    if (o != NULL){
+        index.remove(o, objects);
+        objects.erase(std::find(objects.begin(), objects.end(), o));
     }
-    return NULL;
+    return o;
 }
 
 void NetworkWorldClient::handleCreateItem( Network::Message & message ){
@@ -299,13 +297,7 @@ bool NetworkWorldClient::respawnPlayers(const std::vector<Paintown::Object*> & p
 }
 
 Paintown::Object * NetworkWorldClient::findNetworkObject( Paintown::Object::networkid_t id ){
-    for (vector< Paintown::Object * >::iterator it = objects.begin(); it != objects.end(); it++ ){
-        Paintown::Object * o = *it;
-        if (o->getId() == id){
-            return o;
-        }
-    }
-    return NULL;
+    return index.find(id);
 }
 
 /* TODO: this code is duplicated in game/adventure_world.cpp and network_world.cpp.
@@ -348,6 +340,7 @@ void NetworkWorldClient::handlePing(Network::Message & message){
          * is the same, which is probably a reasonable assumption.
          */
         currentPing = alpha * drift / 2 + (1.0 - alpha) * currentPing;
+        prediction.setLatency(currentPing);
 
         Global::debug(1) << "Ping " << id << ": " << drift << " average ping: " << currentPing << endl;
 
@@ -461,11 +454,14 @@ void NetworkWorldClient::handleMessage( Network::Message & message ){
             }
         }
     } else {
-        for ( vector< Paintown::Object * >::iterator it = objects.begin(); it != objects.end(); it++ ){
-            Paintown::Object * o = *it;
-            /* message.id is a uint16_t and getId() is an unsigned long */
-            if ( o->getId() == message.id ){
-                o->interpretMessage(this, message );
+        Paintown::Object * o = findNetworkObject(message.id);
+        if (o != NULL){
+            double x = o->getX();
+            double y = o->getY();
+            double z = o->getZ();
+            o->interpretMessage(this, message);
+            if (message.type() == ObjectMessages::Moved){
+                prediction.moved(o, o->getId() == id, x, y, z, message.timestamp);
             }
         }
     }
@@ -521,7 +517,7 @@ void NetworkWorldClient::sendMessage( const Network::Message & message, Network:
 }
 
 void NetworkWorldClient::sendMessages(const vector<Network::Message> & messages, Network::Socket socket){
-    Network::sendAllMessages(messages, socket);
+    Network::sendAllMessages(messages, socket, sendBuffer, &traffic);
     /*
     int length = Network::totalSize(messages);
     uint8_t * data = new uint8_t[length];
@@ -628,6 +624,9 @@ void NetworkWorldClient::act(){
 #endif
     AdventureWorld::act();
 
+    /* objects came and went during the logic */
+    index.rebuild(objects);
+
     vector<Network::Message> messages;
     getIncomingMessages(messages);
     // vector< Network::Message > messages = getIncomingMessages();
@@ -635,6 +634,8 @@ void NetworkWorldClient::act(){
         handleMessage(*it);
     }
 
+    prediction.act(index, id);
+
 #if 0
     for (vector< Paintown::Object * >::iterator it = objects.begin(); it != objects.end();){
         if ( (*it)->getHealth() <= 0 ){
@@ -10,6 +10,8 @@
 #include "input/input-map.h"
 #include "input/text-input.h"
 #include "chat-widget.h"
+#include "network_index.h"
+#include "prediction.h"
 #include "thread.h"
 #include <vector>
 
@@ -52,6 +54,7 @@ public:
         }
 	
 	virtual void doScene( int min_x, int max_x );
+        virtual void addObject(Paintown::Object * o);
 	virtual void addMessage( Network::Message m, Network::Socket from = 0, Network::Socket to = 0);
         virtual bool respawnPlayers(const std::vector<Paintown::Object*> & players);
 
@@ -89,9 +92,15 @@ private:
 	NLsocket server;
 	std::vector< Network::Message > incoming;
 	std::vector< Network::Message > outgoing;
+        /* reused every frame so sending doesn't allocate */
+        std::vector<uint8_t> sendBuffer;
+        Network::Traffic traffic;
         Util::Thread::LockObject messageLock;
         Util::Thread::LockObject runningLock;
         Util::Thread::Id message_thread;
+        /* only valid while messages are being handled */
+        NetworkIndex index;
+        Prediction prediction;
 
 	bool world_finished;
         unsigned int secondCounter;
@@ -0,0 +1,230 @@
+#include "prediction.h"
+#include "network_index.h"
+#include <r-tech1/system.h>
+#include <math.h>
+
+using std::map;
+using std::deque;
+
+/* further than this and the object snaps to the server position */
+static const double SnapDistance = 80;
+/* the local player is considered to be in the right place if its this close */
+static const double LocalTolerance = 3;
+/* ticks to correct the local player over */
+static const int LocalCorrection = 4;
+/* never spread a correction over more ticks than this */
+static const double LongestInterval = 30;
+/* ticks of local predictions to keep, more than any round trip should take */
+static const unsigned int LongestHistory = 120;
+
+Prediction::Track::Track():
+errorX(0),
+errorY(0),
+errorZ(0),
+ticks(0),
+lastUpdate(0),
+interval(1){
+}
+
+Prediction::Prediction():
+ticks(0),
+lastTick(0),
+tickLength(0),
+latency(0){
+}
+
+void Prediction::moved(Paintown::Object * object, bool local, double x, double y, double z, uint64_t timestamp){
+    Track & track = tracks[object->getId()];
+
+    if (track.lastUpdate != 0 && tickLength > 0 && timestamp > track.lastUpdate){
+        double ticks = (timestamp - track.lastUpdate) / tickLength;
+        if (ticks < 1){
+            ticks = 1;
+        }
+        if (ticks > LongestInterval){
+            ticks = LongestInterval;
+        }
+        track.interval = track.interval * 0.75 + ticks * 0.25;
+    }
+    track.lastUpdate = timestamp;
+
+    if (local){
+        movedLocal(object, track, x, y, z, timestamp);
+        return;
+    }
+
+    double errorX = object->getX() - x;
+    double errorY = object->getY() - y;
+    double errorZ = object->getZ() - z;
+    double distance = sqrt(errorX * errorX + errorY * errorY + errorZ * errorZ);
+
+    track.errorX = 0;
+    track.errorY = 0;
+    track.errorZ = 0;
+    track.ticks = 0;
+
+    if (distance > SnapDistance){
+        return;
+    }
+
+    /* go back to where it was and get to the server position over time */
+    object->setX(x);
+    object->setY(y);
+    object->setZ(z);
+
+    track.errorX = errorX;
+    track.errorY = errorY;
+    track.errorZ = errorZ;
+    track.ticks = (int) (track.interval + 0.5);
+    if (track.ticks < 1){
+        track.ticks = 1;
+    }
+}
+
+uint64_t Prediction::answeredTick(uint64_t timestamp) const {
+    if (ticks == 0){
+        return 0;
+    }
+
+    /* the last tick that was remembered */
+    uint64_t last = ticks - 1;
+    if (tickLength <= 0){
+        return last;
+    }
+
+    /* the server applied our input about one latency after we sent it and
+     * the answer took about as long to come back
+     */
+    double since = (double) timestamp - (double) lastTick;
+    double back = (2 * latency - since) / tickLength;
+    if (back <= 0){
+        return last;
+    }
+
+    uint64_t ago = (uint64_t) (back + 0.5);
+    if (ago > last){
+        return 0;
+    }
+    return last - ago;
+}
+
+void Prediction::movedLocal(Paintown::Object * object, Track & track, double x, double y, double z, uint64_t timestamp){
+    double serverX = object->getX();
+    double serverY = object->getY();
+    double serverZ = object->getZ();
+
+    /* keep predicting, the server's position is only used to check it */
+    object->setX(x);
+    object->setY(y);
+    object->setZ(z);
+
+    uint64_t tick = answeredTick(timestamp);
+
+    /* the server won't answer anything older than this again */
+    while (history.size() > 1 && history[1].tick <= tick){
+        history.pop_front();
+    }
+
+    /* what was predicted for that tick, or for now if nothing was kept */
+    double thenX = x + track.errorX;
+    double thenY = y + track.errorY;
+    double thenZ = z + track.errorZ;
+    if (!history.empty()){
+        thenX = history.front().x;
+        thenY = history.front().y;
+        thenZ = history.front().z;
+    }
+
+    double errorX = serverX - thenX;
+    double errorY = serverY - thenY;
+    double errorZ = serverZ - thenZ;
+    double distance = sqrt(errorX * errorX + errorY * errorY + errorZ * errorZ);
+
+    if (distance > SnapDistance){
+        object->setX(serverX);
+        object->setY(serverY);
+        object->setZ(serverZ);
+        track.errorX = 0;
+        track.errorY = 0;
+        track.errorZ = 0;
+        track.ticks = 0;
+        history.clear();
+        return;
+    }
+
+    if (distance < LocalTolerance){
+        return;
+    }
+
+    /* Replay what the player did since that tick on top of the server's
+     * position. The moves themselves don't change so that is the same as
+     * moving every prediction from then on by the error.
+     */
+    for (deque<Predicted>::iterator it = history.begin(); it != history.end(); it++){
+        it->x += errorX;
+        it->y += errorY;
+        it->z += errorZ;
+    }
+
+    track.errorX += errorX;
+    track.errorY += errorY;
+    track.errorZ += errorZ;
+    track.ticks = LocalCorrection;
+}
+
+void Prediction::act(const NetworkIndex & index, Paintown::Object::networkid_t local){
+    uint64_t now = System::currentMilliseconds();
+    if (lastTick != 0 && now > lastTick){
+        if (tickLength == 0){
+            tickLength = now - lastTick;
+        } else {
+            tickLength = tickLength * 0.9 + (now - lastTick) * 0.1;
+        }
+    }
+    lastTick = now;
+
+    for (map<Paintown::Object::networkid_t, Track>::iterator it = tracks.begin(); it != tracks.end(); ){
+        Paintown::Object * object = index.find(it->first);
+        if (object == NULL){
+            tracks.erase(it++);
+            continue;
+        }
+
+        Track & track = it->second;
+        if (track.ticks > 0){
+            double moveX = track.errorX / track.ticks;
+            double moveY = track.errorY / track.ticks;
+            double moveZ = track.errorZ / track.ticks;
+            object->setX(object->getX() + moveX);
+            object->setY(object->getY() + moveY);
+            object->setZ(object->getZ() + moveZ);
+            track.errorX -= moveX;
+            track.errorY -= moveY;
+            track.errorZ -= moveZ;
+            track.ticks -= 1;
+        }
+
+        it++;
+    }
+
+    Paintown::Object * player = index.find(local);
+    if (player != NULL){
+        /* where the player will be once any correction is done */
+        Predicted now;
+        now.tick = ticks;
+        now.x = player->getX();
+        now.y = player->getY();
+        now.z = player->getZ();
+        map<Paintown::Object::networkid_t, Track>::const_iterator track = tracks.find(local);
+        if (track != tracks.end()){
+            now.x += track->second.errorX;
+            now.y += track->second.errorY;
+            now.z += track->second.errorZ;
+        }
+        history.push_back(now);
+        while (history.size() > LongestHistory){
+            history.pop_front();
+        }
+    }
+    ticks += 1;
+}
@@ -0,0 +1,89 @@
+#ifndef _paintown_network_prediction_h
+#define _paintown_network_prediction_h
+
+#include <map>
+#include <deque>
+#include <stdint.h>
+#include "../object/object.h"
+
+class NetworkIndex;
+
+/* Smooths out the positions the server sends to a client.
+ *
+ * Remote objects used to jump to the position in each moved message. Now the
+ * position from the server is taken as where the object should be by the
+ * time the next update arrives, and the object is moved there a bit at a time
+ * over that many ticks. The time between updates is measured from the
+ * timestamps of the messages so the server can send moved messages less often.
+ *
+ * The local player already moves as soon as a key is pressed, so that is the
+ * prediction. Where the player was predicted to be is kept for a short while
+ * with the tick it was at. A moved message for the local player answers input
+ * that left about a round trip earlier, so it is compared with the prediction
+ * from that tick and not with where the player is now. When they differ the
+ * local moves made since then are replayed on top of the server's position,
+ * which is the same as shifting the player and the rest of the history by
+ * the difference. Small differences are ignored and bigger ones are
+ * corrected over a few ticks.
+ *
+ * Anything that is far off, like a respawn, snaps right to the server's
+ * position.
+ */
+class Prediction{
+public:
+    Prediction();
+
+    /* call after `object' applied a moved message. x, y and z are where the
+     * object was before the message.
+     */
+    void moved(Paintown::Object * object, bool local, double x, double y, double z, uint64_t timestamp);
+
+    /* the average time a message takes to get to the server */
+    inline void setLatency(double latency){
+        this->latency = latency;
+    }
+
+    /* moves the objects a step toward where the server put them and
+     * remembers where the local player is, once a tick
+     */
+    void act(const NetworkIndex & index, Paintown::Object::networkid_t local);
+
+protected:
+    struct Track{
+        Track();
+
+        /* what is left to move */
+        double errorX;
+        double errorY;
+        double errorZ;
+        int ticks;
+
+        uint64_t lastUpdate;
+        /* average number of ticks between updates */
+        double interval;
+    };
+
+    /* where the local player was predicted to be at some tick */
+    struct Predicted{
+        uint64_t tick;
+        double x;
+        double y;
+        double z;
+    };
+
+    void movedLocal(Paintown::Object * object, Track & track, double x, double y, double z, uint64_t timestamp);
+    /* the tick a moved message for the local player answers */
+    uint64_t answeredTick(uint64_t timestamp) const;
+
+    std::map<Paintown::Object::networkid_t, Track> tracks;
+    /* oldest first */
+    std::deque<Predicted> history;
+    /* ticks since the prediction started */
+    uint64_t ticks;
+    uint64_t lastTick;
+    /* average length of a tick in the units of the message timestamps */
+    double tickLength;
+    double latency;
+};
+
+#endif
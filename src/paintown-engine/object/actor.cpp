@@ -5,6 +5,7 @@
 #include <r-tech1/tokenreader.h>
 #include <r-tech1/token.h>
 #include "actor.h"
+#include "definition-cache.h"
 
 using namespace std;
 
@@ -17,9 +18,13 @@ ObjectNonAttack( 0, 0 ){
 	setHealth( 1 );
 	
 	TokenReader tr;
+	/* owns the tokens if the file was read ahead of time */
+	Util::ReferenceCount<TokenReader> prepared;
 	try{
-		Token * head;
-		head = tr.readTokenFromFile(filename.path());
+		Token * head = DefinitionCache::take(filename, prepared);
+		if (head == NULL){
+			head = tr.readTokenFromFile(filename.path());
+		}
 		if ( *head != "actor" ){
 			throw LoadException(__FILE__, __LINE__, "File does not begin with 'actor'" );
 		}
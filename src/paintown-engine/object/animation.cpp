@@ -12,6 +12,7 @@
 #include <r-tech1/timedifference.h>
 #include <r-tech1/token.h>
 #include <r-tech1/token_exception.h>
+#include <r-tech1/thread.h>
 
 #include "animation.h"
 #include "animation_event.h"
@@ -47,6 +48,83 @@ Frame::~Frame(){
     }
 }
 
+/* Frames are shared by every animation that loads the same picture at the
+ * same scale, so characters that use the same sprites only have one copy of
+ * them. Palette swaps are done by a Remap while drawing so they don't need
+ * their own frames, and the collision masks only depend on the shape of the
+ * picture.
+ */
+struct SharedFrame{
+    Frame * frame;
+    int uses;
+};
+
+static map<string, SharedFrame> sharedFrames;
+static map<const Frame*, string> sharedFrameKeys;
+/* Animations can be loaded by Level::ThreadedCacher */
+static Util::Thread::LockObject sharedFramesLock;
+
+static string frameKey(const Filesystem::RelativePath & path, double scale){
+    ostringstream out;
+    out << path.path() << "@" << scale;
+    return out.str();
+}
+
+static Frame * acquireFrame(const Filesystem::RelativePath & path, double scale){
+    const string key = frameKey(path, scale);
+    {
+        Util::Thread::ScopedLock locked(sharedFramesLock);
+        map<string, SharedFrame>::iterator found = sharedFrames.find(key);
+        if (found != sharedFrames.end()){
+            found->second.uses += 1;
+            return found->second.frame;
+        }
+    }
+
+    Graphics::Bitmap * pic = Paintown::Mod::getCurrentMod()->createBitmap(path);
+    if (pic->getError()){
+        delete pic;
+        throw LoadException(__FILE__, __LINE__, "Could not load picture");
+    }
+
+    if (scale != 1){
+        *pic = pic->scaleBy(scale, scale);
+    }
+
+    Frame * frame = new Frame(pic, new ECollide(pic));
+
+    Util::Thread::ScopedLock locked(sharedFramesLock);
+    /* someone else might have loaded it in the meantime */
+    map<string, SharedFrame>::iterator found = sharedFrames.find(key);
+    if (found != sharedFrames.end()){
+        delete frame;
+        found->second.uses += 1;
+        return found->second.frame;
+    }
+
+    SharedFrame & shared = sharedFrames[key];
+    shared.frame = frame;
+    shared.uses = 1;
+    sharedFrameKeys[frame] = key;
+    return frame;
+}
+
+static void releaseFrame(Frame * frame){
+    Util::Thread::ScopedLock locked(sharedFramesLock);
+    map<const Frame*, string>::iterator key = sharedFrameKeys.find(frame);
+    if (key == sharedFrameKeys.end()){
+        return;
+    }
+
+    SharedFrame & shared = sharedFrames[key->second];
+    shared.uses -= 1;
+    if (shared.uses == 0){
+        sharedFrames.erase(key->second);
+        sharedFrameKeys.erase(key);
+        delete frame;
+    }
+}
+
 static const char * key_names[] = {
     /* key_idle isn't a real key anymore */
     // "key_idle",
@@ -428,18 +506,8 @@ changedAttacks(false){
                 Filesystem::RelativePath full = Filesystem::RelativePath(basedir).join(Filesystem::RelativePath(path));
                 // Filesystem::AbsolutePath full = Filesystem::find(Filesystem::RelativePath(basedir + path));
                 if (frames.find(full.path()) == frames.end()){
-                    Graphics::Bitmap * pic = Paintown::Mod::getCurrentMod()->createBitmap(full);
-                    if (owner != NULL && owner->getSpriteScale() != 1){
-                        *pic = pic->scaleBy(owner->getSpriteScale(), owner->getSpriteScale());
-                    }
-
-                    ECollide * collide = new ECollide(pic);
-                    Frame * f = new Frame(pic, collide);
-                    frames[full.path()] = f;
-                    if (pic->getError()){
-                        // Global::debug( 0 ) <<"Pic error"<<endl;
-                        throw LoadException(__FILE__, __LINE__, "Could not load picture");
-                    }
+                    double scale = owner != NULL ? owner->getSpriteScale() : 1;
+                    frames[full.path()] = acquireFrame(full, scale);
                 }
                 AnimationEvent * ani = new AnimationEventFrame(full.path());
                 events.push_back(ani);
@@ -710,69 +778,6 @@ void Animation::setFacing(const int direction){
     }
 }
 	
-void Animation::reMap(map<Graphics::Color, Graphics::Color> & colors ){
-    /* if they arent are own bitmaps, make them so */
-    if ( !own_bitmaps ){
-        for ( map<string,Frame*>::iterator it = frames.begin(); it != frames.end(); it++ ){
-            Frame* & xframe = (*it).second;
-
-            Graphics::Bitmap * xpic = new Graphics::Bitmap( *(xframe->pic), true );
-            ECollide * xcollide = new ECollide( xframe->collide );
-
-            /* oh evil! I am altering a map while iterating over it.
-             * It should be ok, though, since Im altering an element
-             * that already exists.
-             */
-            frames[ (*it).first ] = new Frame( xpic, xcollide );
-        }
-    }
-
-    for ( map<string,Frame*>::iterator it = frames.begin(); it != frames.end(); it++ ){
-        Frame * xframe = (*it).second;
-
-        Graphics::Bitmap * use = xframe->pic;
-        reMap(use, colors);
-    }
-
-    own_bitmaps = true;
-}
-
-void Animation::reMap( Graphics::Bitmap * work, map<Graphics::Color, Graphics::Color> & colors ){
-    const map<Graphics::Color, Graphics::Color>::iterator it_end = colors.end();
-
-    /* maybe this is a little faster than just reading every pixel
-     * and writing it back. i dunno
-     */
-    for ( int y1 = 0; y1< work->getHeight(); y1++ ){
-        vector<Graphics::Color> xcols;
-        work->readLine(xcols, y1);
-        for ( unsigned int x1 = 0; x1 < xcols.size(); x1++ ){
-            Graphics::Color pixel = xcols[x1];
-
-            map<Graphics::Color, Graphics::Color>::iterator find_it = colors.find(pixel);
-            if (find_it != it_end){
-                work->putPixel(x1, y1, (*find_it).second);
-            }
-            /*
-               if ( colors.find( pixel ) != it_end ){
-               work->putPixel( x1, y1, colors[ pixel ] );
-               }
-               */
-        }
-    }
-
-    /*
-       for ( int x1 = 0; x1 < work->getWidth(); x1++ ){
-       for ( int y1 = 0; y1 < work->getHeight(); y1++ ){
-       int pixel = work->getPixel( x1, y1 );
-       if ( colors.find( pixel ) != it_end ){
-       work->putPixel( x1, y1, colors[ pixel ] );
-       }
-       }
-       }
-       */
-}
-	
 void Animation::getAttackCoords1(int & x, int & y){
     /*
     // x = (attack_x1+attack_x2)/2;
@@ -1169,9 +1174,7 @@ Animation::~Animation(){
     if ( own_bitmaps ){
         // Global::debug( 1 ) << "Destroy animation bitmaps" << endl;
         for ( map< string, Frame * >::iterator it = frames.begin(); it != frames.end(); it++ ){
-            Frame * x = (*it).second;
-            // cout<<"Deleting frame "<<x<<" path = "<<x->pic->getPath()<<endl;
-            delete x;
+            releaseFrame((*it).second);
         }
     }
 
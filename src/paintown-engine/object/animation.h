@@ -100,12 +100,6 @@ public:
 	/* this animation touched something */
 	void contacted();
 
-	/* change the colors via the color mapping 
-	 * This method makes this animations bitmaps original, if they 
-	 * were copied
-	 */
-	void reMap(std::map<Graphics::Color, Graphics::Color> & colors );
-
 	/* returns true if a previous sequence is seq */
 	bool hasSequence( const std::string & seq );
 
@@ -291,8 +285,6 @@ public:
 
 protected:
 
-	void reMap(Graphics::Bitmap * work, std::map<Graphics::Color, Graphics::Color> & colors );
-
 	// int convertKeyPress( const string & key_name ) throw( LoadException );
     Input::PaintownInput convertKeyPress( const std::string & key_name );
 
@@ -116,18 +116,18 @@ void BuddyPlayer::act( vector< Object * > * others, World * world, vector< Objec
         return;
     }
 
-    filterEnemies(enemies, others);
+    filterNearbyEnemies(enemies, others, world);
 
     if (animation_current->Act()){
         animation_current->reset();
         // nextTicket();
         // animation_current = movements[ "idle" ];
-        animation_current = getMovement("idle");
+        animation_current = getMovement(Movement_Idle);
         animation_current->reset();
     }
 
-    if (animation_current == getMovement("idle") ||
-        animation_current == getMovement("walk") ){
+    if (animation_current == getMovement(Movement_Idle) ||
+        animation_current == getMovement(Movement_Walk) ){
         if (enemies.empty() && want_x == -1 && want_z == -1 && Util::rnd(15) == 0){
             // want_x = Util::rnd( 100 ) - 50 + furthestFriend( others, getAlliance(), this );
             want_x = Util::rnd(100) - 50 + (int) leader->getX();
@@ -206,14 +206,14 @@ void BuddyPlayer::act( vector< Object * > * others, World * world, vector< Objec
             }
 
             if (walk){
-                animation_current = getMovement("walk");
+                animation_current = getMovement(Movement_Walk);
             }
 
             if (fabs(getX() - want_x) <= 2 &&
                 fabs(getZ() - want_z) <= 2){
                 want_x = -1;
                 want_z = -1;
-                animation_current = getMovement("idle");
+                animation_current = getMovement(Movement_Idle);
             }
         }
     }
@@ -238,7 +238,7 @@ void BuddyPlayer::deathReset(){
     setStatus(Status_Falling);
     setHealth(getMaxHealth());
     setDeath(0);
-    animation_current = getMovement("idle");
+    animation_current = getMovement(Movement_Idle);
 }
 	
 /*
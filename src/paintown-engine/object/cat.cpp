@@ -10,6 +10,7 @@
 #include <r-tech1/file-system.h>
 #include <math.h>
 #include "cat.h"
+#include "definition-cache.h"
 
 using namespace std;
 
@@ -25,9 +26,13 @@ state( IDLE1 ){
 	setHealth( 1 );
 	
 	TokenReader tr;
+	/* owns the tokens if the file was read ahead of time */
+	Util::ReferenceCount<TokenReader> prepared;
 	try{
-		Token * head;
-		head = tr.readTokenFromFile(path.path());
+		Token * head = DefinitionCache::take(path, prepared);
+		if (head == NULL){
+			head = tr.readTokenFromFile(path.path());
+		}
 		if ( *head != "cat" ){
 			throw LoadException(__FILE__, __LINE__, "File does not begin with 'Cat'" );
 		}
@@ -10,6 +10,7 @@
 #include <r-tech1/token_exception.h>
 #include <r-tech1/file-system.h>
 #include <r-tech1/tokenreader.h>
+#include <r-tech1/thread.h>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -28,6 +29,7 @@
 #include "object_attack.h"
 #include "stimulation.h"
 #include "draw-effect.h"
+#include "definition-cache.h"
 #include "gib.h"
 
 #include "../factory/shadow.h"
@@ -39,16 +41,43 @@ using namespace std;
 
 namespace Paintown{
     
+Remap::Lookup::Lookup(const map<Graphics::Color, Graphics::Color> & colors):
+start(4096 + 1, 0){
+    /* count the colors in each bucket, then turn the counts into offsets */
+    for (map<Graphics::Color, Graphics::Color>::const_iterator it = colors.begin(); it != colors.end(); it++){
+        start[bucket(it->first) + 1] += 1;
+    }
+
+    for (unsigned int index = 1; index < start.size(); index++){
+        start[index] += start[index - 1];
+    }
+
+    entries.resize(colors.size());
+    vector<unsigned int> next(start.begin(), start.end() - 1);
+    for (map<Graphics::Color, Graphics::Color>::const_iterator it = colors.begin(); it != colors.end(); it++){
+        entries[next[bucket(it->first)]] = *it;
+        next[bucket(it->first)] += 1;
+    }
+}
+
+int Remap::Lookup::bucket(const Graphics::Color & color){
+    return ((Graphics::getRed(color) >> 4) << 8) |
+           ((Graphics::getGreen(color) >> 4) << 4) |
+           (Graphics::getBlue(color) >> 4);
+}
+
 Remap::Remap(const Filesystem::RelativePath & from, const Filesystem::RelativePath & to):
 remapFrom(from),
 remapTo(to){
     colors = computeRemapColors(from, to);
+    lookup = Util::ReferenceCount<Lookup>(new Lookup(colors));
 }
 
 Remap::Remap(const Remap & copy):
 remapFrom(copy.remapFrom),
 remapTo(copy.remapTo),
-colors(copy.colors){
+colors(copy.colors),
+lookup(copy.lookup){
 }
 
 Remap::~Remap(){
@@ -127,9 +156,11 @@ Util::ReferenceCount<Graphics::Shader> Remap::getShader(){
 }
     
 Graphics::Color Remap::filter(Graphics::Color pixel) const {
-    map<Graphics::Color, Graphics::Color>::const_iterator replace = colors.find(pixel);
-    if (replace != colors.end()){
-        return replace->second;
+    const int bucket = Lookup::bucket(pixel);
+    for (unsigned int index = lookup->start[bucket]; index < lookup->start[bucket + 1]; index++){
+        if (lookup->entries[index].first == pixel){
+            return lookup->entries[index].second;
+        }
     }
     return pixel;
 }
@@ -371,7 +402,7 @@ spriteScale(chr.spriteScale){
         */
     }
 
-    animation_current = getMovement("idle");
+    animation_current = getMovement(Movement_Idle);
 
     setMap(chr.getCurrentMap());
 
@@ -402,10 +433,15 @@ void Character::loadSelf(const Filesystem::AbsolutePath & filename ){
 
     // setInvincibility( 1000 );
     TokenReader tr;
+    /* owns the tokens if the file was read ahead of time */
+    Util::ReferenceCount<TokenReader> prepared;
 
     Token * head = NULL;
     try{
-        head = tr.readTokenFromFile(*Storage::instance().open(filename));
+        head = DefinitionCache::take(filename, prepared);
+        if (head == NULL){
+            head = tr.readTokenFromFile(*Storage::instance().open(filename));
+        }
     } catch (const TokenException & fail){
         throw LoadException(__FILE__, __LINE__, fail, string("Could not open character file: ") + filename.path());
     } catch (const Filesystem::NotFound & fail){
@@ -509,15 +545,15 @@ void Character::loadSelf(const Filesystem::AbsolutePath & filename ){
 
         squish_sound = new Sound(*Storage::instance().open(Storage::instance().find(Filesystem::RelativePath("sounds/squish.wav"))));
 
-        if ( getMovement( "idle" ) == NULL ){
+        if ( getMovement(Movement_Idle) == NULL ){
             throw LoadException(__FILE__, __LINE__, "No 'idle' movement");
         }
 
-        if ( getMovement( "pain" ) == NULL ){
+        if ( getMovement(Movement_Pain) == NULL ){
             throw LoadException(__FILE__, __LINE__, "No 'pain' movement");
         }
 
-        if ( getMovement( "rise" ) == NULL ){
+        if ( getMovement(Movement_Rise) == NULL ){
             throw LoadException(__FILE__, __LINE__, "No 'rise' movement");
         }
         /*
@@ -526,7 +562,7 @@ void Character::loadSelf(const Filesystem::AbsolutePath & filename ){
            }
            */
 
-        if ( getMovement( "fall" ) == NULL ){
+        if ( getMovement(Movement_Fall) == NULL ){
             throw LoadException(__FILE__, __LINE__, "No 'fall' movement");
         }
 
@@ -560,16 +596,16 @@ void Character::loadSelf(const Filesystem::AbsolutePath & filename ){
     }
     */
 
-    if (getMovement("walk") != NULL){
-        if (getMovement("walk")->getKeys().size() > 0){
+    if (getMovement(Movement_Walk) != NULL){
+        if (getMovement(Movement_Walk)->getKeys().size() > 0){
             Global::debug(0) << "Warning: " << getName() << " should not contain any keys for the 'walk' movement" << endl;
         }
     }
 
     // animation_current = movements[ "idle" ];
-    animation_current = getMovement("idle");
+    animation_current = getMovement(Movement_Idle);
 
-    body_parts = getBodyParts(getMovement("idle"));
+    body_parts = getBodyParts(getMovement(Movement_Idle));
     own_stuff = true;
 
     addEffect(new DrawNormalEffect(this));
@@ -794,6 +830,46 @@ Util::ReferenceCount<Animation> Character::getCurrentMovement() const {
 	
 void Character::setMovement(Animation * animation, const string & name){
     movements[name] = animation;
+
+    unsigned int handle = movementHandle(name);
+    if (handle >= movementsByHandle.size()){
+        movementsByHandle.resize(handle + 1);
+    }
+    movementsByHandle[handle] = movements[name];
+}
+
+/* characters can be loaded by Level::ThreadedCacher */
+static Util::Thread::LockObject movementHandlesLock;
+static map<string, int> movementHandles;
+static const Util::ReferenceCount<Animation> noMovement(NULL);
+
+int Character::movementHandle(const string & name){
+    map<string, int> & handles = movementHandles;
+
+    Util::Thread::ScopedLock locked(movementHandlesLock);
+    if (handles.empty()){
+        /* in the same order as the Movement_ constants */
+        const char * wellKnown[] = {"idle", "walk", "jump", "grab", "pain", "throw", "rise", "fall", "get"};
+        for (unsigned int index = 0; index < sizeof(wellKnown) / sizeof(wellKnown[0]); index++){
+            handles[wellKnown[index]] = index;
+        }
+    }
+
+    map<string, int>::iterator found = handles.find(name);
+    if (found != handles.end()){
+        return found->second;
+    }
+
+    int handle = handles.size();
+    handles[name] = handle;
+    return handle;
+}
+
+const Util::ReferenceCount<Animation> & Character::getMovement(const int handle){
+    if (handle >= 0 && handle < (int) movementsByHandle.size()){
+        return movementsByHandle[handle];
+    }
+    return noMovement;
 }
 
 Util::ReferenceCount<Animation> Character::getMovement(const string & name){
@@ -851,7 +927,7 @@ void Character::testReset(){
 void Character::testAnimation(string name){
     animation_current = getMovement(name);
     if (animation_current == NULL){
-        animation_current = getMovement("idle");
+        animation_current = getMovement(Movement_Idle);
     }
     animation_current->reset();
 }
@@ -960,7 +1036,7 @@ const string Character::getName() const{
 }
 
 void Character::fall( double x_vel, double y_vel ){
-	animation_current = getMovement( "fall" );
+	animation_current = getMovement(Movement_Fall);
 	// animation_current = movements[ "fall" ];
 	animation_current->reset();
 	setStatus( Status_Fell );
@@ -1008,7 +1084,7 @@ void Character::takeDamage(World & world, ObjectAttack * obj, int damage, double
         fall(-forceX, forceY );
         world.addMessage(fallMessage(-forceX, forceY));
     } else	{
-        animation_current = getMovement( "pain" );
+        animation_current = getMovement(Movement_Pain);
         if ( getStatus() != Status_Grabbed ){
             setStatus( Status_Hurt );
         }
@@ -1116,7 +1192,7 @@ void Character::landed( World * world ){
             world->Quake( (int)fabs(getYVelocity()) );
 
             setStatus( Status_Ground );
-            animation_current = getMovement( "idle" );
+            animation_current = getMovement(Movement_Idle);
             animation_current->reset();
             world->addMessage( movedMessage() );
             world->addMessage( animationMessage() );
@@ -1144,7 +1220,7 @@ void Character::landed( World * world ){
                 // setStatus( Status_Hurt );
                 setStatus( Status_Rise );
                 // animation_current = movements[ "rise" ];
-                animation_current = getMovement( "rise" );
+                animation_current = getMovement(Movement_Rise);
                 animation_current->reset();
             }
 
@@ -1160,7 +1236,7 @@ void Character::landed( World * world ){
 
             setStatus( Status_Ground );
             // animation_current = movements["idle"];
-            animation_current = getMovement( "idle" );
+            animation_current = getMovement(Movement_Idle);
             animation_current->reset();
 
             world->addMessage( movedMessage() );
@@ -1298,12 +1374,12 @@ void Character::act( vector< Object * > * others, World * world, vector< Object
             } else {
                 setStatus( Status_Grabbed );
                 // animation_current = movements["pain"];
-                animation_current = getMovement( "pain" );
+                animation_current = getMovement(Movement_Pain);
             }
         }
     } else if ( getStatus() == Status_Rise || getStatus() == Status_Get ){
         if ( animation_current->Act() ){
-            animation_current = getMovement( "idle" );
+            animation_current = getMovement(Movement_Idle);
             setStatus( Status_Ground );
         }
     } else if ( getStatus() == Status_Grabbed ){
@@ -1393,7 +1469,7 @@ void Character::grabbed( Object * obj ){
 	grab_time = 0;
 	setY( 0 );
 	// animation_current = movements[ "pain" ];
-	animation_current = getMovement( "pain" );
+	animation_current = getMovement(Movement_Pain);
 	animation_current->reset();
 }
 
@@ -1411,6 +1487,25 @@ void Character::filterEnemies( vector< Object * > & mine, vector< Object * > * a
 		*/
 	}
 }
+
+void Character::filterNearbyEnemies( vector< Object * > & mine, vector< Object * > * all, World * world ){
+    /* the world only knows where its own objects are */
+    if (world != NULL && all == &world->getObjects()){
+        /* only the x distance matters to pick the closest enemy, anyone
+         * found within the radius is closer than everyone outside of it.
+         */
+        const double radius = 320;
+        const double anyZ = 100000;
+        vector<Object*> nearby;
+        world->findNearby(getX(), getZ(), radius, anyZ, nearby);
+        filterEnemies(mine, &nearby);
+        if (! mine.empty()){
+            return;
+        }
+    }
+
+    filterEnemies(mine, all);
+}
 	
 void Character::deathReset(){
 }
@@ -1792,7 +1887,7 @@ void Character::interpretMessage(World * world, Network::Message & message ){
             int x, z;
             message >> x >> z;
             doJump(x / 100.0, z / 100.0);
-            animation_current = getMovement("jump");
+            animation_current = getMovement(Movement_Jump);
             break;
         }
         case CM::Health : {
@@ -1833,7 +1928,7 @@ void Character::interpretMessage(World * world, Network::Message & message ){
             animation_current = getMovement( message.path );
             if ( animation_current == NULL ){
                 Global::debug( 1 ) << "Could not find animation for '" << message.path << "'" << endl;
-                animation_current = getMovement( "idle" );
+                animation_current = getMovement(Movement_Idle);
             }
             if ( message.path != "walk" && message.path != "idle" ){
                 animation_current->reset();
@@ -50,6 +50,19 @@ const int Status_Dead = 7; /* dying */
 const int Status_Get = 8; /* getting an object */
 const int Status_Falling = 9; /* falling due to lack of ground beneath them */
 
+/* Handles for the movements that are looked up every tick. Any other
+ * movement name gets a handle from Character::movementHandle.
+ */
+const int Movement_Idle = 0;
+const int Movement_Walk = 1;
+const int Movement_Jump = 2;
+const int Movement_Grab = 3;
+const int Movement_Pain = 4;
+const int Movement_Throw = 5;
+const int Movement_Rise = 6;
+const int Movement_Fall = 7;
+const int Movement_Get = 8;
+
 class Character;
 
 /* Handles palette swaps */
@@ -79,6 +92,20 @@ protected:
     Util::ReferenceCount<Graphics::Shader> create();
     Graphics::Bitmap remapTexture;
 
+    /* filter() is called for every pixel that is drawn without a shader, so
+     * instead of searching `colors' it puts the colors in 4096 buckets by the
+     * top 4 bits of their red, green and blue. Most pixels land in an empty
+     * bucket and the rest only compare against a few colors.
+     */
+    struct Lookup{
+        Lookup(const std::map<Graphics::Color, Graphics::Color> & colors);
+
+        static int bucket(const Graphics::Color & color);
+
+        /* colors in bucket n are entries[start[n]] to entries[start[n + 1]] */
+        std::vector<unsigned int> start;
+        std::vector<std::pair<Graphics::Color, Graphics::Color> > entries;
+    };
 
     /*
     virtual void setAnimation(const std::string & name, Animation * animation);
@@ -97,6 +124,8 @@ protected:
     Filesystem::RelativePath remapFrom;
     Filesystem::RelativePath remapTo;
     std::map<Graphics::Color, Graphics::Color> colors;
+    /* shared by copies, it never changes */
+    Util::ReferenceCount<Lookup> lookup;
 
     Util::ReferenceCount<Graphics::Shader> shader;
 };
@@ -324,7 +353,14 @@ public:
     virtual Util::ReferenceCount<Animation> getCurrentMovement() const;
     virtual void setMovement( Animation * animation, const std::string & name );
     virtual Util::ReferenceCount<Animation> getMovement( const std::string & str );
+    /* same as getMovement(name) for the name that `handle' belongs to */
+    virtual const Util::ReferenceCount<Animation> & getMovement( const int handle );
     // virtual Animation * getMovement( const unsigned int x );
+
+    /* The handle for a movement name, the same name always gets the same
+     * handle in every character.
+     */
+    static int movementHandle( const std::string & name );
     virtual const std::map<std::string, Util::ReferenceCount<Animation> > & getMovements();
 
     virtual inline int getShadow() const {
@@ -453,6 +489,11 @@ protected:
     int getShadowY();
 
     virtual void filterEnemies( std::vector< Object * > & mine, std::vector< Object * > * all );
+    /* Like filterEnemies but only looks close by if there is anyone to fight
+     * there, otherwise it looks at everything in `all'. The closest enemy is
+     * in `mine' either way.
+     */
+    virtual void filterNearbyEnemies( std::vector< Object * > & mine, std::vector< Object * > * all, World * world );
     // virtual void reMap( const std::string & from, const std::string & to, int id );
     virtual void addRemap(Remap * remap);
     /* true if a mapping between `from' and `to' doesn't already exist */
@@ -499,6 +540,8 @@ protected:
 private:
     /* map from name of animation to animation */
     std::map<std::string, Util::ReferenceCount<Animation> > movements;
+    /* the same animations indexed by their movement handle */
+    std::vector<Util::ReferenceCount<Animation> > movementsByHandle;
 
 protected:
 
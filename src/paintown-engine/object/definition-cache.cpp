@@ -0,0 +1,71 @@
+#include "definition-cache.h"
+#include <r-tech1/token.h>
+#include <r-tech1/tokenreader.h>
+#include <r-tech1/thread.h>
+#include <r-tech1/debug.h>
+#include <r-tech1/exceptions/exception.h>
+#include <map>
+#include <string>
+
+using std::map;
+using std::string;
+using std::endl;
+
+namespace Paintown{
+
+struct Definition{
+    Definition():
+    head(NULL){
+    }
+
+    Util::ReferenceCount<TokenReader> reader;
+    Token * head;
+};
+
+/* keyed by the path of the file */
+static map<string, Definition> definitions;
+static Util::Thread::LockObject definitionLock;
+
+void DefinitionCache::prepare(const Filesystem::AbsolutePath & path){
+    {
+        Util::Thread::ScopedLock locked(definitionLock);
+        if (definitions.find(path.path()) != definitions.end()){
+            return;
+        }
+    }
+
+    /* the slow part is done without the lock */
+    Definition definition;
+    definition.reader = Util::ReferenceCount<TokenReader>(new TokenReader());
+    try{
+        definition.head = definition.reader->readTokenFromFile(path.path());
+    } catch (const Exception::Base & fail){
+        Global::debug(1) << "Could not read ahead " << path.path() << ": " << fail.getTrace() << endl;
+        return;
+    }
+
+    Util::Thread::ScopedLock locked(definitionLock);
+    if (definitions.find(path.path()) == definitions.end()){
+        definitions[path.path()] = definition;
+    }
+}
+
+Token * DefinitionCache::take(const Filesystem::AbsolutePath & path, Util::ReferenceCount<TokenReader> & reader){
+    Util::Thread::ScopedLock locked(definitionLock);
+    map<string, Definition>::iterator found = definitions.find(path.path());
+    if (found == definitions.end()){
+        return NULL;
+    }
+
+    Token * head = found->second.head;
+    reader = found->second.reader;
+    definitions.erase(found);
+    return head;
+}
+
+void DefinitionCache::clear(){
+    Util::Thread::ScopedLock locked(definitionLock);
+    definitions.clear();
+}
+
+}
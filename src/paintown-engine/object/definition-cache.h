@@ -0,0 +1,40 @@
+#ifndef _paintown_definition_cache_h
+#define _paintown_definition_cache_h
+
+#include <r-tech1/pointer.h>
+#include <r-tech1/file-system.h>
+
+class Token;
+class TokenReader;
+
+namespace Paintown{
+
+/* Object definition files that were read and parsed ahead of time.
+ *
+ * Most of loading an object has to happen on the main thread: its bitmaps
+ * are made for the display and its animations share data with the objects
+ * the game is using. Reading and tokenizing the definition file doesn't
+ * touch any of that, so Level::ThreadedCacher does it here on its own thread
+ * and the object picks up the parsed file when it loads.
+ */
+class DefinitionCache{
+public:
+    /* Reads and parses the file unless that was done already. Can be called
+     * from any thread. A file that can't be read is left alone so the object
+     * reports the problem when it loads.
+     */
+    static void prepare(const Filesystem::AbsolutePath & path);
+
+    /* The parsed file, or NULL if it wasn't prepared. Each file is only
+     * given out once. The tokens belong to `reader' and are good for as long
+     * as it is kept.
+     */
+    static Token * take(const Filesystem::AbsolutePath & path, Util::ReferenceCount<TokenReader> & reader);
+
+    /* throws away the files that were never taken */
+    static void clear();
+};
+
+}
+
+#endif
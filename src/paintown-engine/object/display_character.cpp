@@ -96,11 +96,11 @@ void DisplayCharacter::load(){
         throw LoadException(__FILE__, __LINE__, ex, "Could not load character " + path.path());
     }
 
-    if ( getMovement( "idle" ) == NULL ){
+    if ( getMovement(Movement_Idle) == NULL ){
         throw LoadException(__FILE__, __LINE__, "No 'idle' animation given for " + path.path());
     }
 
-    animation_current = getMovement("idle");
+    animation_current = getMovement(Movement_Idle);
     animation_current->Act();
 
     effects.push_back(new DrawNormalEffect(this));
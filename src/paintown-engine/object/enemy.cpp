@@ -24,6 +24,9 @@ namespace Paintown{
 
 const int NORMAL_AGRESSION = 97;
 
+/* number of walking steps between moved messages */
+static const int WalkUpdateInterval = 3;
+
 Enemy::Enemy( ):
 Character( ALLIANCE_ENEMY ),
 aggression( NORMAL_AGRESSION ){
@@ -57,6 +60,7 @@ aggression( NORMAL_AGRESSION ){
 
 void Enemy::constructSelf(){
     want_path = false;
+    unsentMoves = 0;
     show_name_time = 0;
     show_life = getHealth();
     id = -1;
@@ -185,13 +189,13 @@ void Enemy::act( vector< Object * > * others, World * world, vector< Object * >
 	if ( getStatus() != Status_Ground && getStatus() != Status_Jumping )
 		return;
 
-	filterEnemies( enemies, others );
+	filterNearbyEnemies( enemies, others, world );
 		
 	if (animation_current != NULL && animation_current->Act()){
 		animation_current->reset();
 		// nextTicket();
 		// animation_current = movements[ "idle" ];
-		animation_current = getMovement( "idle" );
+		animation_current = getMovement(Movement_Idle);
 		animation_current->reset();
 	}
 	
@@ -200,7 +204,7 @@ void Enemy::act( vector< Object * > * others, World * world, vector< Object * >
 		const Object * main_enemy = findClosest( enemies );
 
 		// if ( animation_current == movements["idle"] || animation_current == movements["walk"] ){
-		if ( animation_current == getMovement( "idle" ) || animation_current == getMovement( "walk" ) ){
+		if ( animation_current == getMovement(Movement_Idle) || animation_current == getMovement(Movement_Walk) ){
 			faceObject( main_enemy );
 
 			/*
@@ -285,7 +289,7 @@ void Enemy::act( vector< Object * > * others, World * world, vector< Object * >
 			bool moved = false;
 
 			// animation_current = movements[ "walk" ];
-			animation_current = getMovement( "walk" );
+			animation_current = getMovement(Movement_Walk);
 			world->addMessage( animationMessage() );
 			if ( !closeFloat(want_x, getX()) ){
 				int dir = 1;
@@ -311,10 +315,20 @@ void Enemy::act( vector< Object * > * others, World * world, vector< Object * >
 				moved = true;
 			}
 
+			/* clients smooth out the motion between updates so only
+			 * every few steps are sent, plus the step where it stops
+			 */
 			if ( moved ){
+				unsentMoves += 1;
+			}
+			if ( unsentMoves > 0 && (unsentMoves >= WalkUpdateInterval || !moved || !want_path) ){
 				world->addMessage( movedMessage() );
+				unsentMoves = 0;
 			}
 
+		} else if ( unsentMoves > 0 ){
+			world->addMessage( movedMessage() );
+			unsentMoves = 0;
 		}
 		
 	// }
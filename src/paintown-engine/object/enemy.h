@@ -69,6 +69,8 @@ protected:
 	// Heart * heart;
 	int want_x, want_z;
 	bool want_path;
+	/* steps taken since the last moved message */
+	int unsentMoves;
 
 	int show_name_time;
 	int id;
@@ -8,6 +8,7 @@
 #include "item.h"
 #include "object_attack.h"
 #include "stimulation.h"
+#include "definition-cache.h"
 #include "../game/world.h"
 #include <iostream>
 #include <string>
@@ -29,13 +30,17 @@ ObjectNonAttack(0, 0),
 // collide(0),
 stimulation(stimulation){
     TokenReader tr;
+    /* owns the tokens if the file was read ahead of time */
+    Util::ReferenceCount<TokenReader> prepared;
 
     setMaxHealth(1);
     setHealth(1);
 
     try{
-        Token * head;
-        head = tr.readTokenFromFile(filename.path());
+        Token * head = DefinitionCache::take(filename, prepared);
+        if (head == NULL){
+            head = tr.readTokenFromFile(filename.path());
+        }
 
         if (*head != check){
             throw LoadException(__FILE__, __LINE__, "Item does not begin with 'item'" );
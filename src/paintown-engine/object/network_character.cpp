@@ -146,7 +146,7 @@ void NetworkCharacter::act( vector< Object * > * others, World * world, vector<
         // Global::debug( 0 ) << "Reset animation" << endl;
         if (animation_current->getName() != "idle" &&
             animation_current->getName() != "walk"){
-            animation_current = getMovement("idle");
+            animation_current = getMovement(Movement_Idle);
         }
         animation_current->reset();
     }
@@ -178,7 +178,7 @@ void NetworkCharacter::deathReset(){
     setHealth(getMaxHealth());
     setInvincibility(400);
     setDeath(0);
-    animation_current = getMovement("idle");
+    animation_current = getMovement(Movement_Idle);
 }
 
 }
@@ -717,7 +717,7 @@ bool Player::canGrab( Object * enemy ){
 		return false;
 	}
 
-	if ( getMovement( "grab" ) == NULL ){
+	if ( getMovement(Movement_Grab) == NULL ){
 		return false;
 	}
 
@@ -768,7 +768,7 @@ void Player::deathReset(){
         }
         setTrails(0, 0);
         setDeath(0);
-        animation_current = getMovement("idle");
+        animation_current = getMovement(Movement_Idle);
     }
 }
         
@@ -915,7 +915,7 @@ void Player::handleGrab(World * world, vector<Object*> * others){
             grabEnemy(guy);
             world->addMessage(grabMessage(getId(), guy->getId()));
             setZ(guy->getZ()+1);
-            animation_current = getMovement("grab");
+            animation_current = getMovement(Movement_Grab);
             animation_current->reset();
             world->addMessage(animationMessage());
             setStatus(Status_Grab);
@@ -924,7 +924,7 @@ void Player::handleGrab(World * world, vector<Object*> * others){
         }
     }
 
-    animation_current = getMovement("walk");
+    animation_current = getMovement(Movement_Walk);
     world->addMessage(animationMessage());
 }
 
@@ -1012,9 +1012,9 @@ void Player::act(vector<Object *> * others, World * world, vector<Object *> * ad
     bool reset = animation_current->Act();
 
     /* cant interrupt an animation unless its walking or idling */
-    if (animation_current != getMovement("walk") &&
-        animation_current != getMovement("idle") &&
-        animation_current != getMovement("jump")){
+    if (animation_current != getMovement(Movement_Walk) &&
+        animation_current != getMovement(Movement_Idle) &&
+        animation_current != getMovement(Movement_Jump)){
         if (!reset) return;
     } else {
     }
@@ -1063,7 +1063,7 @@ void Player::act(vector<Object *> * others, World * world, vector<Object *> * ad
 
         if (! possible_animations.empty()){
             final = chooseLikelyAnimation(others, possible_animations, current_name);
-            if (final == getMovement("get")){
+            if (final == getMovement(Movement_Get)){
                 setStatus(Status_Get);
                 world->addMessage(movedMessage());
             }
@@ -1072,11 +1072,11 @@ void Player::act(vector<Object *> * others, World * world, vector<Object *> * ad
         /* special cases when no animation has been chosen */
         if (final == NULL && getStatus() != Status_Grab){
             bool moving = key_forward || key_up || key_down;
-            if (getMovement("jump") == NULL ||
-                animation_current != getMovement("jump")){
+            if (getMovement(Movement_Jump) == NULL ||
+                animation_current != getMovement(Movement_Jump)){
                 if (!moving){
-                    if (animation_current != getMovement("idle")){
-                        animation_current = getMovement("idle");
+                    if (animation_current != getMovement(Movement_Idle)){
+                        animation_current = getMovement(Movement_Idle);
                         world->addMessage( animationMessage() );
                     }
                 } else{
@@ -1086,7 +1086,7 @@ void Player::act(vector<Object *> * others, World * world, vector<Object *> * ad
         } else if (final != NULL && animation_current != final){
             if (final->getName() == "special"){
                 if (getHealth() <= 10){
-                    animation_current = getMovement("idle");
+                    animation_current = getMovement(Movement_Idle);
                     world->addMessage(animationMessage());
                     return;
                 } else {
@@ -1111,7 +1111,7 @@ void Player::act(vector<Object *> * others, World * world, vector<Object *> * ad
                }
                */
 
-            if (animation_current == getMovement("jump")){
+            if (animation_current == getMovement(Movement_Jump)){
                 double x = 0;
                 double z = 0;
                 if (key_forward){
@@ -1133,13 +1133,13 @@ void Player::act(vector<Object *> * others, World * world, vector<Object *> * ad
     if (getStatus() == Status_Grab &&
         animation_current == NULL){
 
-        animation_current = getMovement("grab");
+        animation_current = getMovement(Movement_Grab);
         world->addMessage(animationMessage());
     }
 
     if ((getStatus() == Status_Ground) &&
-        (animation_current == getMovement("walk") ||
-         animation_current == getMovement("idle"))){
+        (animation_current == getMovement(Movement_Walk) ||
+         animation_current == getMovement(Movement_Idle))){
 
         bool moved = false;
         if (key_forward){
@@ -1163,8 +1163,8 @@ void Player::act(vector<Object *> * others, World * world, vector<Object *> * ad
             world->addMessage(movedMessage());
         }
     } else {
-        if (getMovement("throw") != NULL &&
-            animation_current == getMovement("throw")){
+        if (getMovement(Movement_Throw) != NULL &&
+            animation_current == getMovement(Movement_Throw)){
 
             handleThrow(world);
         }
@@ -48,9 +48,9 @@ void VersusEnemy::act( vector< Object * > * others, World * world, vector< Objec
 		animation_current->reset();
 		// nextTicket();
 		// animation_current = movements[ "idle" ];
-		animation_current = getMovement( "idle" );
+		animation_current = getMovement(Movement_Idle);
 		animation_current->reset();
-	} else if ( animation_current != getMovement( "walk" ) && animation_current != getMovement( "idle" ) ){
+	} else if ( animation_current != getMovement(Movement_Walk) && animation_current != getMovement(Movement_Idle) ){
 		return;
 	}
 
@@ -60,12 +60,12 @@ void VersusEnemy::act( vector< Object * > * others, World * world, vector< Objec
 			break;
 		}
 		case DO_WALK_BACKWARD : {
-			animation_current = getMovement( "walk" );
+			animation_current = getMovement(Movement_Walk);
 			moveX( -getSpeed() );
 			break;
 		}
 		case DO_WALK_FORWARD : {
-			animation_current = getMovement( "walk" );
+			animation_current = getMovement(Movement_Walk);
 			moveX( getSpeed() );
 			break;
 		}
@@ -96,7 +96,7 @@ void VersusEnemy::act( vector< Object * > * others, World * world, vector< Objec
 		/* guaranteed to get something back ... */
 		const Object * main_enemy = findClosest( enemies );
 
-		if ( animation_current == getMovement( "idle" ) || animation_current == getMovement( "walk" ) ){
+		if ( animation_current == getMovement(Movement_Idle) || animation_current == getMovement(Movement_Walk) ){
 			/* See if we can attack:
 			 * If we are in range of the Z coordinate, relativeDistance(), then find an attack 
 			 * with a suitable X range.  
@@ -62,7 +62,7 @@ void VersusPlayer::act( vector< Object * > * others, World * world, vector< Obje
 	bool reset = animation_current->Act();
 
 	/* cant interrupt an animation unless its walking or idling */
-	if ( animation_current != getMovement( "walk" ) && animation_current != getMovement( "idle" ) && animation_current != getMovement( "jump" ) ){
+	if ( animation_current != getMovement(Movement_Walk) && animation_current != getMovement(Movement_Idle) && animation_current != getMovement(Movement_Jump) ){
 		if ( !reset ) return;
 	}
 	string current_name = animation_current->getName();
@@ -123,9 +123,9 @@ void VersusPlayer::act( vector< Object * > * others, World * world, vector< Obje
 		if ( final == NULL  && getStatus() != Status_Grab ){
 			// bool moving = keyboard[ getKey( PAIN_KEY_FORWARD ) ] || keyboard[ getKey( PAIN_KEY_UP ) ] || keyboard[ getKey( PAIN_KEY_DOWN ) ] || keyboard[ getKey( PAIN_KEY_BACK ) ];
 			bool moving = keyboard[ getKey( Forward ) ] || keyboard[ getKey( Back ) ];
-			if ( getMovement( "jump" ) == NULL || animation_current != getMovement( "jump" ) ){
+			if ( getMovement(Movement_Jump) == NULL || animation_current != getMovement(Movement_Jump) ){
 				if ( !moving ){
-					animation_current = getMovement( "idle" );
+					animation_current = getMovement(Movement_Idle);
 				} else	{
 					vector< Object * > my_enemies;
 					filterEnemies( my_enemies, others );
@@ -138,7 +138,7 @@ void VersusPlayer::act( vector< Object * > * others, World * world, vector< Obje
 							grabEnemy( guy );
 							setZ( guy->getZ()+1 );
 							// animation_current = movements[ "grab" ];
-							animation_current = getMovement( "grab" );
+							animation_current = getMovement(Movement_Grab);
 							setStatus( Status_Grab );
 							// cout<<"Grabbed"<<endl;
 						}
@@ -146,14 +146,14 @@ void VersusPlayer::act( vector< Object * > * others, World * world, vector< Obje
 							break;
 					}
 					if ( !cy ){
-						animation_current = getMovement( "walk" );
+						animation_current = getMovement(Movement_Walk);
 					}
 				}
 			}
 		} else if ( final != NULL && animation_current != final ){
 			if ( final->getName() == "special" ){
 				if ( getHealth() <= 10 ){
-					animation_current = getMovement( "idle" );
+					animation_current = getMovement(Movement_Idle);
 					return;
 				} else {
 					hurt( 10 );
@@ -166,7 +166,7 @@ void VersusPlayer::act( vector< Object * > * others, World * world, vector< Obje
 			/* remove the used keys from the key cache */
 			key_cache.clear();
 			
-			if ( animation_current == getMovement("jump") ) {
+			if ( animation_current == getMovement(Movement_Jump) ) {
 				double x = 0;
 				double y = 0;
 				if ( keyboard[ getKey( Forward ) ] ){
@@ -188,10 +188,10 @@ void VersusPlayer::act( vector< Object * > * others, World * world, vector< Obje
 	}
 
 	if ( getStatus() == Status_Grab && animation_current == NULL ){
-		animation_current = getMovement( "grab" );
+		animation_current = getMovement(Movement_Grab);
 	}
 
-	if ( (getStatus() == Status_Ground) && (animation_current == getMovement( "walk" ) || animation_current == getMovement( "idle" )) ){
+	if ( (getStatus() == Status_Ground) && (animation_current == getMovement(Movement_Walk) || animation_current == getMovement(Movement_Idle)) ){
 
 		// if ( keyboard[ KEY_RIGHT ] || keyboard[ KEY_LEFT ] ){
 		if ( keyboard[ getKey( Forward ) ] ){
@@ -207,7 +207,7 @@ void VersusPlayer::act( vector< Object * > * others, World * world, vector< Obje
 		}
 	} else {
 	
-		if ( getMovement( "throw" ) != NULL && animation_current == getMovement( "throw" ) ){
+		if ( getMovement(Movement_Throw) != NULL && animation_current == getMovement(Movement_Throw) ){
 			if ( getLink() == NULL ){
 				cout<<"Link is null. This cant happen."<<endl;
 				exit( 1 );
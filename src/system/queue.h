@@ -0,0 +1,281 @@
+#ifndef _paintown_system_queue_h
+#define _paintown_system_queue_h
+
+#include <r-tech1/system.h>
+#include <vector>
+#include <ostream>
+#include <string>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/* Bounded queues that pass things between threads without a lock.
+ *
+ *   SingleQueue - one thread pushes and one other thread pops
+ *   ManyQueue - any number of threads push and one thread pops
+ *
+ * push() returns false instead of blocking when the queue is full, so the
+ * caller decides whether to wait, drop the item or put it somewhere else.
+ *
+ * Both keep counts of what went through them, the deepest the queue got and
+ * how long things waited in it, as measured by System::currentMilliseconds.
+ * The numbers are written without synchronization so they are only good for
+ * reporting.
+ */
+
+namespace System{
+
+namespace Atomic{
+
+/* full memory barrier */
+inline void barrier(){
+#ifdef _MSC_VER
+    _ReadWriteBarrier();
+    _mm_mfence();
+#else
+    __sync_synchronize();
+#endif
+}
+
+inline bool compareAndSwap(volatile unsigned int * where, unsigned int expected, unsigned int value){
+#ifdef _MSC_VER
+    return (unsigned int) _InterlockedCompareExchange((volatile long *) where, (long) value, (long) expected) == expected;
+#else
+    return __sync_bool_compare_and_swap(where, expected, value);
+#endif
+}
+
+inline void add(volatile unsigned int * where, unsigned int amount){
+#ifdef _MSC_VER
+    _InterlockedExchangeAdd((volatile long *) where, (long) amount);
+#else
+    __sync_fetch_and_add(where, amount);
+#endif
+}
+
+}
+
+struct QueueStatistics{
+    QueueStatistics():
+    pushed(0),
+    popped(0),
+    full(0),
+    deepest(0),
+    totalLatency(0),
+    worstLatency(0){
+    }
+
+    volatile unsigned int pushed;
+    unsigned int popped;
+    /* number of times push() failed */
+    volatile unsigned int full;
+    unsigned int deepest;
+    uint64_t totalLatency;
+    uint64_t worstLatency;
+
+    void countPop(uint64_t pushedAt){
+        uint64_t now = System::currentMilliseconds();
+        uint64_t latency = now > pushedAt ? now - pushedAt : 0;
+        popped += 1;
+        totalLatency += latency;
+        if (latency > worstLatency){
+            worstLatency = latency;
+        }
+    }
+
+    void report(std::ostream & out, const std::string & name) const {
+        out << name << ": pushed " << pushed << " popped " << popped << " full " << full << " deepest " << deepest;
+        if (popped > 0){
+            out << " average latency " << (totalLatency / popped) << " worst latency " << worstLatency;
+        }
+        out << std::endl;
+    }
+};
+
+template <class T>
+class SingleQueue{
+public:
+    /* holds at most `size' things */
+    SingleQueue(unsigned int size):
+    capacity(size + 1),
+    cells(size + 1),
+    head(0),
+    tail(0){
+    }
+
+    /* only called by the producer */
+    bool push(const T & item){
+        unsigned int next = (tail + 1) % capacity;
+        Atomic::barrier();
+        unsigned int current = head;
+        if (next == current){
+            statistics.full += 1;
+            return false;
+        }
+
+        cells[tail].item = item;
+        cells[tail].pushed = System::currentMilliseconds();
+        Atomic::barrier();
+        tail = next;
+
+        statistics.pushed += 1;
+        unsigned int depth = (next + capacity - current) % capacity;
+        if (depth > statistics.deepest){
+            statistics.deepest = depth;
+        }
+        return true;
+    }
+
+    /* only called by the consumer */
+    bool pop(T & out){
+        Atomic::barrier();
+        if (head == tail){
+            return false;
+        }
+
+        Cell & cell = cells[head];
+        out = cell.item;
+        statistics.countPop(cell.pushed);
+        /* don't hold on to whatever the item refers to */
+        cell.item = T();
+        Atomic::barrier();
+        head = (head + 1) % capacity;
+        return true;
+    }
+
+    const QueueStatistics & getStatistics() const {
+        return statistics;
+    }
+
+protected:
+    struct Cell{
+        Cell():
+        pushed(0){
+        }
+
+        T item;
+        uint64_t pushed;
+    };
+
+    const unsigned int capacity;
+    std::vector<Cell> cells;
+    /* next cell to pop, only written by the consumer */
+    volatile unsigned int head;
+    /* next cell to push, only written by the producer */
+    volatile unsigned int tail;
+    QueueStatistics statistics;
+
+private:
+    SingleQueue(const SingleQueue &);
+    SingleQueue & operator=(const SingleQueue &);
+};
+
+/* Every cell has a sequence number that says whose turn it is. A producer
+ * claims a cell by moving `enqueue' forward with a compare and swap and then
+ * publishes the item by bumping the sequence, the consumer waits for that
+ * bump before reading the cell.
+ */
+template <class T>
+class ManyQueue{
+public:
+    /* the size is rounded up to a power of two */
+    ManyQueue(unsigned int size):
+    mask(roundUp(size) - 1),
+    cells(roundUp(size)),
+    enqueue(0),
+    dequeue(0){
+        for (unsigned int i = 0; i < cells.size(); i++){
+            cells[i].sequence = i;
+        }
+    }
+
+    /* can be called by any thread */
+    bool push(const T & item){
+        unsigned int position = enqueue;
+        Cell * cell = NULL;
+        while (true){
+            cell = &cells[position & mask];
+            Atomic::barrier();
+            int difference = (int) (cell->sequence - position);
+            if (difference == 0){
+                if (Atomic::compareAndSwap(&enqueue, position, position + 1)){
+                    break;
+                }
+            } else if (difference < 0){
+                Atomic::add(&statistics.full, 1);
+                return false;
+            }
+            position = enqueue;
+        }
+
+        cell->item = item;
+        cell->pushed = System::currentMilliseconds();
+        Atomic::barrier();
+        cell->sequence = position + 1;
+
+        Atomic::add(&statistics.pushed, 1);
+        unsigned int depth = position + 1 - dequeue;
+        if (depth > statistics.deepest && depth <= mask + 1){
+            statistics.deepest = depth;
+        }
+        return true;
+    }
+
+    /* only called by the consumer */
+    bool pop(T & out){
+        Cell & cell = cells[dequeue & mask];
+        Atomic::barrier();
+        if ((int) (cell.sequence - (dequeue + 1)) < 0){
+            return false;
+        }
+
+        out = cell.item;
+        statistics.countPop(cell.pushed);
+        cell.item = T();
+        Atomic::barrier();
+        cell.sequence = dequeue + mask + 1;
+        dequeue += 1;
+        return true;
+    }
+
+    const QueueStatistics & getStatistics() const {
+        return statistics;
+    }
+
+protected:
+    static unsigned int roundUp(unsigned int size){
+        unsigned int out = 2;
+        while (out < size){
+            out *= 2;
+        }
+        return out;
+    }
+
+    struct Cell{
+        Cell():
+        sequence(0),
+        pushed(0){
+        }
+
+        volatile unsigned int sequence;
+        T item;
+        uint64_t pushed;
+    };
+
+    const unsigned int mask;
+    std::vector<Cell> cells;
+    volatile unsigned int enqueue;
+    /* only touched by the consumer */
+    volatile unsigned int dequeue;
+    QueueStatistics statistics;
+
+private:
+    ManyQueue(const ManyQueue &);
+    ManyQueue & operator=(const ManyQueue &);
+};
+
+}
+
+#endif
@@ -0,0 +1,196 @@
+#include "mugen/ai-policy.h"
+#include "mugen/behavior.h"
+#include "mugen/exception.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/* Checks learning, saving and merging AI policies without playing any matches */
+
+static int testLearning(){
+    Mugen::AIPolicy policy;
+    int punch = policy.intern("punch");
+    int kick = policy.intern("kick");
+    if (policy.intern("punch") != punch || punch == kick){
+        std::cout << "Interning gave the wrong ids" << std::endl;
+        return 1;
+    }
+
+    if (Mugen::AIPolicy::bucket(0) != 0 || Mugen::AIPolicy::bucket(-Mugen::AIPolicy::BucketWidth) != 1 || Mugen::AIPolicy::bucket(1000000) != Mugen::AIPolicy::Buckets - 1){
+        std::cout << "Bad distance buckets" << std::endl;
+        return 1;
+    }
+
+    /* kick always hits up close and never from far away, sweep sometimes
+     * hits from far away and punch was never tried there
+     */
+    int sweep = policy.intern("sweep");
+    int close = Mugen::AIPolicy::bucket(10);
+    int far = Mugen::AIPolicy::bucket(200);
+    for (int i = 0; i < 10; i++){
+        policy.attempted(punch, close);
+        policy.attempted(kick, close);
+        policy.hit(kick, close);
+        policy.attempted(kick, far);
+        policy.attempted(sweep, far);
+        if (i % 3 == 0){
+            policy.hit(sweep, far);
+        }
+    }
+
+    /* random 0 is always the best command */
+    if (policy.choose(close, 0) != kick){
+        std::cout << "Expected kick up close but got " << policy.getName(policy.choose(close, 0)) << std::endl;
+        return 1;
+    }
+
+    /* while learning a command that was never tried looks good enough to try */
+    if (policy.choose(far, 0) != punch){
+        std::cout << "Expected to try punch from far away but got " << policy.getName(policy.choose(far, 0)) << std::endl;
+        return 1;
+    }
+
+    /* otherwise only what was seen to hit counts, and untried commands go last.
+     * random 7 is the worst command that was kept.
+     */
+    policy.setLearning(false);
+    if (policy.choose(far, 0) != sweep){
+        std::cout << "Expected sweep from far away but got " << policy.getName(policy.choose(far, 0)) << std::endl;
+        return 1;
+    }
+
+    if (policy.choose(far, 7) != punch){
+        std::cout << "Expected punch last from far away but got " << policy.getName(policy.choose(far, 7)) << std::endl;
+        return 1;
+    }
+
+    /* nothing changes unless the policy is learning */
+    policy.attempted(kick, close);
+    if (policy.getAttempts(kick, close) != 10){
+        std::cout << "Policy learned while it wasn't learning" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int testSaving(){
+    Mugen::AIPolicy policy;
+    int move = policy.intern("Kung Fu Palm");
+    policy.attempted(move, 3);
+    policy.attempted(move, 3);
+    policy.hit(move, 3);
+
+    std::ostringstream out;
+    policy.write(out);
+    std::istringstream in(out.str());
+    Mugen::AIPolicy loaded;
+    loaded.read(in);
+
+    /* read commands can't be chosen until the character interns them */
+    if (loaded.choose(3, 0) != -1){
+        std::cout << "Chose a command that wasn't interned" << std::endl;
+        return 1;
+    }
+
+    int id = loaded.intern("Kung Fu Palm");
+    if (!loaded.isTrained() || loaded.getAttempts(id, 3) != 2 || loaded.getHits(id, 3) != 1){
+        std::cout << "Policy didn't load what was saved" << std::endl;
+        return 1;
+    }
+
+    std::istringstream bad("not a policy\n");
+    try{
+        Mugen::AIPolicy nothing;
+        nothing.read(bad);
+        std::cout << "Read a policy from garbage" << std::endl;
+        return 1;
+    } catch (const MugenException & fail){
+    }
+
+    return 0;
+}
+
+static int testMerging(){
+    Mugen::AIPolicy base;
+    int move = base.intern("punch");
+    base.attempted(move, 0);
+
+    /* two workers start from the same policy and learn different things */
+    Mugen::AIPolicy worker1(base);
+    Mugen::AIPolicy worker2(base);
+    worker1.attempted(move, 0);
+    worker1.hit(move, 0);
+    worker2.attempted(move, 1);
+
+    Mugen::AIPolicy merged(base);
+    merged.merge(worker1, &base);
+    merged.merge(worker2, &base);
+    if (merged.getAttempts(move, 0) != 2 || merged.getHits(move, 0) != 1 || merged.getAttempts(move, 1) != 1){
+        std::cout << "Merged policy has the wrong counts" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/* attempts a command the way selectBestCommand() does once it picked one */
+class TestBehavior: public Mugen::LearningAIBehavior {
+public:
+    TestBehavior(const PaintownUtil::ReferenceCount<Mugen::AIPolicy> & policy):
+    LearningAIBehavior(5, policy){
+    }
+
+    void attempt(int command, int bucket){
+        policy->attempted(command, bucket);
+        lastCommand = command;
+        lastBucket = bucket;
+    }
+};
+
+/* a move that hits several times is still one hit for one attempt */
+static int testHitOnce(){
+    PaintownUtil::ReferenceCount<Mugen::AIPolicy> policy(new Mugen::AIPolicy());
+    int punch = policy->intern("punch");
+    int bucket = Mugen::AIPolicy::bucket(50);
+    TestBehavior behavior(policy);
+
+    behavior.attempt(punch, bucket);
+    behavior.hit(NULL);
+    behavior.hit(NULL);
+    behavior.hit(NULL);
+    if (policy->getAttempts(punch, bucket) != 1 || policy->getHits(punch, bucket) != 1){
+        std::cout << "Three hits of one attempt counted " << policy->getHits(punch, bucket) << " hits" << std::endl;
+        return 1;
+    }
+
+    behavior.attempt(punch, bucket);
+    behavior.hit(NULL);
+    if (policy->getAttempts(punch, bucket) != 2 || policy->getHits(punch, bucket) != 2){
+        std::cout << "The hit of the second attempt wasn't counted" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(){
+    if (testLearning() != 0){
+        return 1;
+    }
+
+    if (testSaving() != 0){
+        return 1;
+    }
+
+    if (testMerging() != 0){
+        return 1;
+    }
+
+    if (testHitOnce() != 0){
+        return 1;
+    }
+
+    std::cout << "AI policy tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "mugen/broad-phase.h"
+#include "mugen/animation.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using std::vector;
+
+/* Checks the broad phase the way Stage::physics uses it, without loading a
+ * stage. Things are indexed by the extent of their boxes and the index has
+ * to follow them when a hit moves them in the middle of a tick.
+ */
+
+struct Thing{
+    Thing(int id, int x, int left, int right):
+    id(id),
+    x(x){
+        Mugen::Area box;
+        box.x1 = left;
+        box.x2 = right;
+        box.y1 = -10;
+        box.y2 = 0;
+        boxes.push_back(box);
+    }
+
+    int id;
+    int x;
+    vector<Mugen::Area> boxes;
+};
+
+/* same as Stage::indexCharacter */
+static void index(Mugen::BroadPhase & phase, const Thing & thing){
+    int left = 0;
+    int right = 0;
+    if (Mugen::BroadPhase::extent(thing.boxes, thing.x, left, right)){
+        phase.update(thing.id, left, right);
+    } else {
+        phase.remove(thing.id);
+    }
+}
+
+/* same as Stage::nearbyCharacters */
+static bool touches(const Mugen::BroadPhase & phase, const Thing & attacker, const Thing & target){
+    int left = 0;
+    int right = 0;
+    if (!phase.find(attacker.id, left, right)){
+        return false;
+    }
+    vector<int> found;
+    phase.query(left, right, found);
+    return std::find(found.begin(), found.end(), target.id) != found.end();
+}
+
+/* Two attackers hit the same target in one tick. The first hit knocks the
+ * target out of its reach and into the reach of the second attacker, who
+ * only finds it if the target was indexed again after the first hit.
+ */
+static int testTwoAttackers(){
+    Thing target(0, 100, -10, 10);
+    Thing first(1, 70, -10, 25);
+    Thing second(2, 150, -10, 10);
+
+    Mugen::BroadPhase phase;
+    index(phase, target);
+    index(phase, first);
+    index(phase, second);
+
+    if (!touches(phase, first, target)){
+        std::cout << "First attacker can't reach the target" << std::endl;
+        return 1;
+    }
+
+    if (touches(phase, second, target)){
+        std::cout << "Second attacker reaches the target before it was knocked back" << std::endl;
+        return 1;
+    }
+
+    /* the first hit knocks the target back */
+    target.x = 145;
+    Mugen::BroadPhase stale = phase;
+    index(phase, target);
+
+    if (touches(stale, second, target)){
+        std::cout << "The stale index should not find the moved target" << std::endl;
+        return 1;
+    }
+
+    if (!touches(phase, second, target)){
+        std::cout << "Second attacker didn't find the target after it moved" << std::endl;
+        return 1;
+    }
+
+    if (touches(phase, first, target)){
+        std::cout << "First attacker still reaches the target after it moved" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/* A target that changes to a state without boxes drops out of the index */
+static int testNoBoxes(){
+    Thing target(0, 100, -10, 10);
+    Thing attacker(1, 90, -10, 10);
+
+    Mugen::BroadPhase phase;
+    index(phase, target);
+    index(phase, attacker);
+
+    target.boxes.clear();
+    index(phase, target);
+    if (touches(phase, attacker, target)){
+        std::cout << "Found a target that has no boxes" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(){
+    if (testTwoAttackers() != 0){
+        return 1;
+    }
+
+    if (testNoBoxes() != 0){
+        return 1;
+    }
+
+    std::cout << "Broad phase tests passed" << std::endl;
+    return 0;
+}
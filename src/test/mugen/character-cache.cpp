@@ -0,0 +1,74 @@
+#include "character-cache.h"
+#include "mugen/character.h"
+#include "mugen/constraint.h"
+#include "util/debug.h"
+#include "util/file-system.h"
+#include "util/token.h"
+
+using namespace std;
+
+CharacterCache::CharacterCache(const vector<string> & roster):
+roster(roster){
+}
+
+CharacterCache::~CharacterCache(){
+    for (map<pair<int, int>, Mugen::Character*>::iterator it = characters.begin(); it != characters.end(); it++){
+        delete it->second;
+    }
+}
+
+/* the same things a World saves, including the commands */
+Mugen::AllCharacterData CharacterCache::snapshot(const Mugen::Character & character){
+    Mugen::AllCharacterData data(character.snapshotStateData(), character.getCurrentAnimationState(), character.getStatePersistent());
+    const vector<Mugen::Command2*> & commands = character.getCommands();
+    for (vector<Mugen::Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
+        Token * serialized = (*it)->serialize();
+        data.character.commandState[(*it)->getName()] = serialized->toStringCompact();
+        delete serialized;
+    }
+    return data;
+}
+
+Mugen::Character & CharacterCache::get(int player, int side){
+    pair<int, int> key(player, side);
+    map<pair<int, int>, Mugen::Character*>::iterator found = characters.find(key);
+    if (found != characters.end()){
+        Mugen::Character & character = *found->second;
+        const Mugen::AllCharacterData & data = loaded[key];
+        character.setStateData(data.character);
+        character.setCurrentAnimationState(data.animation);
+        character.setStatePersistent(data.statePersistent);
+        return character;
+    }
+
+    const string & path = roster[player];
+    Global::debug(1) << "Loading " << path << endl;
+    Mugen::Character * character = new Mugen::Character(Storage::instance().find(Filesystem::RelativePath(path)), side);
+    try{
+        character->load();
+    } catch (...){
+        delete character;
+        throw;
+    }
+    characters[key] = character;
+    loaded[key] = snapshot(*character);
+    return *character;
+}
+
+bool CharacterCache::isLoadedState(int player, int side) const {
+    pair<int, int> key(player, side);
+    map<pair<int, int>, Mugen::Character*>::const_iterator character = characters.find(key);
+    map<pair<int, int>, Mugen::AllCharacterData>::const_iterator data = loaded.find(key);
+    if (character == characters.end() || data == loaded.end()){
+        return false;
+    }
+
+    Mugen::AllCharacterData now = snapshot(*character->second);
+    Token * nowToken = Mugen::serialize(now.character);
+    Token * loadedToken = Mugen::serialize(data->second.character);
+    bool same = nowToken->toString() == loadedToken->toString() &&
+                now.statePersistent == data->second.statePersistent;
+    delete nowToken;
+    delete loadedToken;
+    return same;
+}
@@ -0,0 +1,43 @@
+#ifndef _paintown_test_mugen_character_cache_h
+#define _paintown_test_mugen_character_cache_h
+
+#include <string>
+#include <vector>
+#include <map>
+#include "mugen/world.h"
+
+namespace Mugen{
+    class Character;
+}
+
+/* Characters run-match has loaded so far, one for each side since a
+ * character can face itself.
+ *
+ * Whatever a match leaves behind in a character, like its variables, the
+ * commands it was in the middle of or how it was hit, would change the next
+ * match it plays. So the state of every character is saved as soon as it is
+ * loaded and put back every time the character is handed out. The saved
+ * state is kept by roster index and side, because the stage gives the
+ * character a new id every match.
+ */
+class CharacterCache{
+public:
+    /* players are indexes into `roster' */
+    CharacterCache(const std::vector<std::string> & roster);
+    virtual ~CharacterCache();
+
+    Mugen::Character & get(int player, int side);
+
+    /* true if the character is the way it was right after it was loaded */
+    bool isLoadedState(int player, int side) const;
+
+protected:
+    static Mugen::AllCharacterData snapshot(const Mugen::Character & character);
+
+    const std::vector<std::string> & roster;
+    std::map<std::pair<int, int>, Mugen::Character*> characters;
+    /* every character right after it was loaded */
+    std::map<std::pair<int, int>, Mugen::AllCharacterData> loaded;
+};
+
+#endif
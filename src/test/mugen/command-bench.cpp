@@ -0,0 +1,113 @@
+#include "command-moves.h"
+#include "mugen/command.h"
+#include "mugen/constraint.h"
+#include "util/debug.h"
+#include "util/timedifference.h"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+
+using namespace std;
+
+/* Times how long it takes to match a whole move list against a long stream
+ * of random input, once with every command handled on its own and once with
+ * a CommandSet.
+ *
+ *   command-bench [ticks] [characters]
+ */
+
+static double runEach(const vector<Mugen::Input> & inputs, int characters){
+    vector<vector<Mugen::Command2*> > lists;
+    for (int i = 0; i < characters; i++){
+        lists.push_back(CommandMoves::makeCommands());
+    }
+
+    int fired = 0;
+    TimeDifference diff;
+    diff.startTime();
+    for (unsigned int tick = 0; tick < inputs.size(); tick++){
+        for (vector<vector<Mugen::Command2*> >::iterator list = lists.begin(); list != lists.end(); list++){
+            for (vector<Mugen::Command2*>::iterator it = list->begin(); it != list->end(); it++){
+                if ((*it)->handle(inputs[tick], tick + 1)){
+                    fired += 1;
+                }
+            }
+        }
+    }
+    diff.endTime();
+
+    ostringstream out;
+    out << "Each command: " << inputs.size() << " ticks, " << fired << " commands fired, took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+
+    for (vector<vector<Mugen::Command2*> >::iterator list = lists.begin(); list != lists.end(); list++){
+        CommandMoves::deleteCommands(*list);
+    }
+
+    return diff.getTime() / 1000.0;
+}
+
+static double runSet(const vector<Mugen::Input> & inputs, int characters){
+    vector<vector<Mugen::Command2*> > lists;
+    vector<Mugen::CommandSet> sets(characters);
+    for (int i = 0; i < characters; i++){
+        lists.push_back(CommandMoves::makeCommands());
+    }
+
+    int fired = 0;
+    TimeDifference diff;
+    diff.startTime();
+    for (unsigned int tick = 0; tick < inputs.size(); tick++){
+        for (int i = 0; i < characters; i++){
+            const vector<bool> & out = sets[i].handle(lists[i], inputs[tick], tick + 1);
+            for (vector<bool>::const_iterator it = out.begin(); it != out.end(); it++){
+                if (*it){
+                    fired += 1;
+                }
+            }
+        }
+    }
+    diff.endTime();
+
+    ostringstream out;
+    out << "Command set: " << inputs.size() << " ticks, " << fired << " commands fired, took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+
+    uint64_t handled = 0;
+    uint64_t skipped = 0;
+    for (int i = 0; i < characters; i++){
+        handled += sets[i].getHandled();
+        skipped += sets[i].getSkipped();
+        CommandMoves::deleteCommands(lists[i]);
+    }
+    Global::debug(0, "test") << "Command set handled " << handled << " commands and skipped " << skipped << endl;
+
+    return diff.getTime() / 1000.0;
+}
+
+int main(int argc, char ** argv){
+    int ticks = 100000;
+    int characters = 4;
+    if (argc > 1){
+        ticks = atoi(argv[1]);
+    }
+    if (argc > 2){
+        characters = atoi(argv[2]);
+    }
+
+    CommandMoves::RandomInput random(1);
+    vector<Mugen::Input> inputs;
+    for (int i = 0; i < ticks; i++){
+        inputs.push_back(random.next());
+    }
+
+    double each = runEach(inputs, characters);
+    double set = runSet(inputs, characters);
+
+    if (each > 0 && set > 0){
+        Global::debug(0, "test") << "Command set was " << (each / set) << " times as fast, " << (ticks * characters / set * 1000) << " character ticks per second" << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+#ifndef _paintown_test_mugen_command_moves_h
+#define _paintown_test_mugen_command_moves_h
+
+/* Shared by the command-set test and the command benchmark. Builds a list of
+ * commands like the ones in a typical .cmd file and makes up input for them.
+ */
+
+#include "mugen/command.h"
+#include "mugen/constraint.h"
+#include "mugen/ast/key.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace CommandMoves{
+
+/* Parses the right hand side of `command = ...' in a .cmd file, which is
+ * enough of the syntax for these tests: ~30a, /F, $D, >~a and a+b.
+ */
+static Ast::Key * parseKey(const std::string & raw){
+    size_t plus = raw.find('+');
+    if (plus != std::string::npos){
+        return new Ast::KeyCombined(0, 0, parseKey(raw.substr(0, plus)), parseKey(raw.substr(plus + 1)));
+    }
+
+    switch (raw[0]){
+        case '/': return new Ast::KeyModifier(0, 0, Ast::KeyModifier::MustBeHeldDown, parseKey(raw.substr(1)));
+        case '$': return new Ast::KeyModifier(0, 0, Ast::KeyModifier::Direction, parseKey(raw.substr(1)));
+        case '>': return new Ast::KeyModifier(0, 0, Ast::KeyModifier::Only, parseKey(raw.substr(1)));
+        case '~': {
+            size_t end = 1;
+            int hold = 0;
+            while (end < raw.size() && raw[end] >= '0' && raw[end] <= '9'){
+                hold = hold * 10 + raw[end] - '0';
+                end += 1;
+            }
+            return new Ast::KeyModifier(0, 0, Ast::KeyModifier::Release, parseKey(raw.substr(end)), hold);
+        }
+    }
+
+    return new Ast::KeySingle(0, 0, raw.c_str());
+}
+
+static Ast::KeyList * parseCommand(const std::string & command){
+    std::vector<Ast::Key*> keys;
+    size_t start = 0;
+    while (start < command.size()){
+        size_t comma = command.find(',', start);
+        if (comma == std::string::npos){
+            comma = command.size();
+        }
+        std::string key;
+        for (size_t i = start; i < comma; i++){
+            if (command[i] != ' '){
+                key += command[i];
+            }
+        }
+        keys.push_back(parseKey(key));
+        start = comma + 1;
+    }
+    return new Ast::KeyList(0, 0, keys);
+}
+
+struct Move{
+    const char * name;
+    const char * command;
+    int time;
+    int bufferTime;
+};
+
+/* Roughly what kfm.cmd and most other characters define */
+static const Move moves[] = {
+    {"TripleKFPalm", "~D, DF, F, D, DF, F, x", 20, 1},
+    {"TripleKFPalm2", "~D, DF, F, D, DF, F, y", 20, 1},
+    {"SmashKFUpper", "~D, DB, B, D, DB, B, x", 20, 1},
+    {"FastKFPalm", "~D, DF, F, x+y", 15, 1},
+    {"QCF_x", "~D, DF, F, x", 15, 1},
+    {"QCF_y", "~D, DF, F, y", 15, 1},
+    {"QCF_xy", "~D, DF, F, x+y", 15, 1},
+    {"QCB_a", "~D, DB, B, a", 15, 1},
+    {"QCB_b", "~D, DB, B, b", 15, 1},
+    {"QCB_ab", "~D, DB, B, a+b", 15, 1},
+    {"DP_x", "~F, D, DF, x", 15, 1},
+    {"DP_y", "~F, D, DF, y", 15, 1},
+    {"HCB_x", "~F, DF, D, DB, B, x", 20, 1},
+    {"HCF_a", "~B, DB, D, DF, F, a", 20, 1},
+    {"charge_B_F_x", "~40$B, F, x", 10, 1},
+    {"charge_D_U_a", "~40$D, U, a", 10, 1},
+    {"FF", "F, F", 10, 1},
+    {"BB", "B, B", 10, 1},
+    {"recovery", "x+y", 1, 1},
+    {"ab", "a+b", 1, 1},
+    {"down_a", "/$D, a", 1, 1},
+    {"down_b", "/$D, b", 1, 1},
+    {"fwd_x", "/F, x", 1, 1},
+    {"back_x", "/B, x", 1, 1},
+    {"release_a", "a, >~a", 5, 1},
+    {"a", "a", 1, 1},
+    {"b", "b", 1, 1},
+    {"c", "c", 1, 1},
+    {"x", "x", 1, 1},
+    {"y", "y", 1, 1},
+    {"z", "z", 1, 1},
+    {"s", "s", 1, 1},
+    {"holdfwd", "/$F", 1, 1},
+    {"holdback", "/$B", 1, 1},
+    {"holdup", "/$U", 1, 1},
+    {"holddown", "/$D", 1, 1},
+};
+
+static std::vector<Mugen::Command2*> makeCommands(){
+    std::vector<Mugen::Command2*> out;
+    for (unsigned int i = 0; i < sizeof(moves) / sizeof(Move); i++){
+        const Move & move = moves[i];
+        out.push_back(new Mugen::Command2(move.name, parseCommand(move.command), move.time, move.bufferTime));
+    }
+    return out;
+}
+
+static void deleteCommands(std::vector<Mugen::Command2*> & commands){
+    for (std::vector<Mugen::Command2*>::iterator it = commands.begin(); it != commands.end(); it++){
+        delete *it;
+    }
+    commands.clear();
+}
+
+/* Holds and lets go of keys at random the way HumanBehavior::updateInput
+ * reports them: `pressed' is true while a key is held and `released' is true
+ * for the one tick after it is let go. Every so often all the keys are let go
+ * for a while so commands time out.
+ */
+class RandomInput{
+public:
+    RandomInput(uint32_t seed):
+    seed(seed),
+    rest(0){
+    }
+
+    Mugen::Input next(){
+        input.released = Mugen::Input::Key();
+
+        if (rest > 0){
+            rest -= 1;
+            letGo();
+            return input;
+        }
+
+        if (random() % 200 == 0){
+            rest = 10 + random() % 30;
+        }
+
+        toggle(input.pressed.forward, input.released.forward, 6);
+        toggle(input.pressed.back, input.released.back, 8);
+        toggle(input.pressed.up, input.released.up, 12);
+        toggle(input.pressed.down, input.released.down, 6);
+        toggle(input.pressed.a, input.released.a, 10);
+        toggle(input.pressed.b, input.released.b, 10);
+        toggle(input.pressed.c, input.released.c, 14);
+        toggle(input.pressed.x, input.released.x, 8);
+        toggle(input.pressed.y, input.released.y, 8);
+        toggle(input.pressed.z, input.released.z, 14);
+        toggle(input.pressed.start, input.released.start, 200);
+
+        return input;
+    }
+
+protected:
+    uint32_t random(){
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7fff;
+    }
+
+    /* flips the key once every `chance' ticks on average */
+    void toggle(bool & pressed, bool & released, uint32_t chance){
+        if (random() % chance == 0){
+            released = pressed;
+            pressed = !pressed;
+        }
+    }
+
+    void letGo(){
+        Mugen::Input::Key & pressed = input.pressed;
+        Mugen::Input::Key & released = input.released;
+        released.a = pressed.a; released.b = pressed.b; released.c = pressed.c;
+        released.x = pressed.x; released.y = pressed.y; released.z = pressed.z;
+        released.forward = pressed.forward; released.back = pressed.back;
+        released.up = pressed.up; released.down = pressed.down;
+        released.start = pressed.start;
+        input.pressed = Mugen::Input::Key();
+    }
+
+    uint32_t seed;
+    int rest;
+    Mugen::Input input;
+};
+
+}
+
+#endif
@@ -0,0 +1,255 @@
+#include "command-moves.h"
+#include "mugen/command.h"
+#include "mugen/constraint.h"
+#include "util/debug.h"
+#include <r-tech1/token.h>
+#include <vector>
+#include <string>
+#include <sstream>
+
+using std::vector;
+using std::string;
+
+/* Checks that CommandSet fires exactly the same commands as handling each
+ * Command2 on its own, and leaves the commands in the same state.
+ */
+
+static string serialize(const vector<Mugen::Command2*> & commands){
+    std::ostringstream out;
+    for (vector<Mugen::Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
+        Token * token = (*it)->serialize();
+        out << token->toStringCompact() << std::endl;
+        delete token;
+    }
+    return out.str();
+}
+
+static vector<Token*> snapshot(const vector<Mugen::Command2*> & commands){
+    vector<Token*> out;
+    for (vector<Mugen::Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
+        out.push_back((*it)->serialize());
+    }
+    return out;
+}
+
+static void restore(const vector<Mugen::Command2*> & commands, vector<Token*> & tokens){
+    for (unsigned int i = 0; i < commands.size(); i++){
+        commands[i]->deserialize(tokens[i]);
+        delete tokens[i];
+    }
+    tokens.clear();
+}
+
+static vector<bool> handleEach(const vector<Mugen::Command2*> & commands, const Mugen::Input & input, int tick){
+    vector<bool> out;
+    for (vector<Mugen::Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
+        out.push_back((*it)->handle(input, tick));
+    }
+    return out;
+}
+
+/* Runs the same input through both and fails on the first tick they differ */
+static int testRandom(uint32_t seed, int ticks){
+    vector<Mugen::Command2*> each = CommandMoves::makeCommands();
+    vector<Mugen::Command2*> all = CommandMoves::makeCommands();
+    Mugen::CommandSet set;
+    CommandMoves::RandomInput random(seed);
+    int fired = 0;
+    int result = 0;
+
+    for (int tick = 1; tick <= ticks; tick++){
+        Mugen::Input input = random.next();
+        vector<bool> expected = handleEach(each, input, tick);
+        const vector<bool> & got = set.handle(all, input, tick);
+        if (expected != got){
+            Global::debug(0) << "Seed " << seed << " tick " << tick << ": different commands fired" << std::endl;
+            result = 1;
+            break;
+        }
+
+        if (serialize(each) != serialize(all)){
+            Global::debug(0) << "Seed " << seed << " tick " << tick << ": different command state" << std::endl;
+            result = 1;
+            break;
+        }
+
+        for (vector<bool>::const_iterator it = got.begin(); it != got.end(); it++){
+            if (*it){
+                fired += 1;
+            }
+        }
+    }
+
+    /* make sure the input actually does something */
+    if (result == 0 && fired == 0){
+        Global::debug(0) << "Seed " << seed << ": no commands fired" << std::endl;
+        result = 1;
+    }
+
+    CommandMoves::deleteCommands(each);
+    CommandMoves::deleteCommands(all);
+    return result;
+}
+
+/* Rolls the commands back to a snapshot and plays the same input again,
+ * which has to give the same commands as the first time.
+ */
+static int testRollback(uint32_t seed, int ticks){
+    vector<Mugen::Command2*> commands = CommandMoves::makeCommands();
+    Mugen::CommandSet set;
+    CommandMoves::RandomInput random(seed);
+    int result = 0;
+
+    for (int tick = 1; tick <= ticks && result == 0; tick += 20){
+        vector<Token*> saved = snapshot(commands);
+        vector<Mugen::Input> inputs;
+        vector<vector<bool> > first;
+        for (int i = 0; i < 20; i++){
+            inputs.push_back(random.next());
+            first.push_back(set.handle(commands, inputs.back(), tick + i));
+        }
+        string state = serialize(commands);
+
+        restore(commands, saved);
+        for (int i = 0; i < 20; i++){
+            if (set.handle(commands, inputs[i], tick + i) != first[i]){
+                Global::debug(0) << "Seed " << seed << " tick " << (tick + i) << ": replay fired different commands" << std::endl;
+                result = 1;
+                break;
+            }
+        }
+
+        if (result == 0 && serialize(commands) != state){
+            Global::debug(0) << "Seed " << seed << " tick " << tick << ": replay ended in a different state" << std::endl;
+            result = 1;
+        }
+    }
+
+    CommandMoves::deleteCommands(commands);
+    return result;
+}
+
+/* The scripted sequences from command.cpp, a single command at a time */
+static int testScript(const string & command, const vector<Mugen::Input> & inputs){
+    vector<Mugen::Command2*> each;
+    vector<Mugen::Command2*> all;
+    each.push_back(new Mugen::Command2("", CommandMoves::parseCommand(command), 1000, 0));
+    all.push_back(new Mugen::Command2("", CommandMoves::parseCommand(command), 1000, 0));
+    Mugen::CommandSet set;
+    int result = 0;
+
+    for (unsigned int tick = 0; tick < inputs.size(); tick++){
+        if (handleEach(each, inputs[tick], tick + 1) != set.handle(all, inputs[tick], tick + 1)){
+            Global::debug(0) << "Command '" << command << "' tick " << (tick + 1) << ": different commands fired" << std::endl;
+            result = 1;
+            break;
+        }
+    }
+
+    CommandMoves::deleteCommands(each);
+    CommandMoves::deleteCommands(all);
+    return result;
+}
+
+static void parseKey(Mugen::Input & input, const string & key){
+    bool release = key.size() > 1 && key[0] == '~';
+    Mugen::Input::Key & keys = release ? input.released : input.pressed;
+    string name = release ? key.substr(1) : key;
+    if (name == "a"){
+        keys.a = true;
+    } else if (name == "b"){
+        keys.b = true;
+    } else if (name == "c"){
+        keys.c = true;
+    } else if (name == "x"){
+        keys.x = true;
+    } else if (name == "y"){
+        keys.y = true;
+    } else if (name == "z"){
+        keys.z = true;
+    } else if (name == "U"){
+        keys.up = true;
+    } else if (name == "D"){
+        keys.down = true;
+    } else if (name == "F"){
+        keys.forward = true;
+    } else if (name == "B"){
+        keys.back = true;
+    }
+}
+
+/* "a;a,b;~b" is three ticks, the first has a held, the second a and b and in
+ * the last b was just let go
+ */
+static vector<Mugen::Input> loadScript(const string & script){
+    vector<Mugen::Input> out;
+    std::istringstream lines(script);
+    string line;
+    while (std::getline(lines, line, ';')){
+        Mugen::Input input;
+        std::istringstream keys(line);
+        string key;
+        while (std::getline(keys, key, ',')){
+            if (key != ""){
+                parseKey(input, key);
+            }
+        }
+        out.push_back(input);
+    }
+    return out;
+}
+
+static int testScripts(){
+    return testScript("a", loadScript("a;")) ||
+           testScript("a", loadScript("b;")) ||
+           testScript("a, b", loadScript("a;a,b")) ||
+           testScript("a, b", loadScript("a;a;a;a;a;a;a;a;a;a;b;")) ||
+           testScript("~a", loadScript("a;~a;")) ||
+           testScript("~30a", loadScript("a;a;a;~a;")) ||
+           testScript("a+b", loadScript("a;a,b;")) ||
+           testScript("/a, b, b, c", loadScript("a;a,b;~b;b;c;")) ||
+           testScript("/a, b, b, c", loadScript("a;a,b;a,~b;a,b;a,c;")) ||
+           testScript("a, a, b", loadScript("a;~a;a;~a;b")) ||
+           testScript("~D, DF, F, x", loadScript("D;~D;D,F;~D,F;F,x;")) ||
+           testScript("F, F", loadScript("F;~F;;F;;;;;F;~F;F"));
+}
+
+int runTest(int (*test)(), const std::string & name){
+    if (test()){
+        Global::debug(0) << name << " failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static int testRandom1(){
+    return testRandom(1, 5000);
+}
+
+static int testRandom2(){
+    return testRandom(0xdeadbeef, 5000);
+}
+
+static int testRandom3(){
+    return testRandom(42, 5000);
+}
+
+static int testRollback1(){
+    return testRollback(7, 10000);
+}
+
+int main(int argc, char ** argv){
+    if (
+        runTest(testScripts, "Scripts") ||
+        runTest(testRandom1, "Random1") ||
+        runTest(testRandom2, "Random2") ||
+        runTest(testRandom3, "Random3") ||
+        runTest(testRollback1, "Rollback1") ||
+        /* having false here lets us copy/paste a runTest line easily */
+        false
+        ){
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,373 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+#include <new>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/timedifference.h"
+#include "mugen/character.h"
+#include "mugen/config.h"
+#include "mugen/behavior.h"
+#include "mugen/stage.h"
+#include "mugen/context.h"
+#include "mugen/profile.h"
+#include "mugen/random.h"
+#include "mugen/parse-cache.h"
+#include "util/file-system.h"
+#include "play-behavior.h"
+#include "stress-objects.h"
+
+using namespace std;
+
+/* A repeatable benchmark of Stage::logic. Every scenario starts from the same
+ * random seed and the same input, so two runs on the same build do the same
+ * work and their numbers can be compared.
+ *
+ *   logic-bench [--ticks N] [--repeat N] [--seed N] [--scenario NAME]
+ *               [--save FILE] [--compare FILE] [--threshold PERCENT]
+ *
+ * Results are written one per line as
+ *
+ *   scenario metric value
+ *
+ * which is also the format of a saved baseline. With --compare every metric
+ * is shown next to the baseline, and the exit code is 1 if ticks per second
+ * dropped or allocations per tick went up by more than the threshold.
+ */
+
+static const char * REPLAY_FILE = "src/test/mugen/replay.txt";
+
+/* Every allocation made by anything, counted so the benchmark can report
+ * allocations per tick. Only the logic runs while counting so other threads
+ * aren't a concern.
+ */
+static unsigned long allocations = 0;
+static unsigned long allocatedBytes = 0;
+
+#if __cplusplus >= 201103L
+#define NEW_THROW
+#define DELETE_THROW noexcept
+#else
+#define NEW_THROW throw(std::bad_alloc)
+#define DELETE_THROW throw()
+#endif
+
+void * operator new(std::size_t size) NEW_THROW {
+    allocations += 1;
+    allocatedBytes += size;
+    void * out = malloc(size == 0 ? 1 : size);
+    if (out == NULL){
+        throw std::bad_alloc();
+    }
+    return out;
+}
+
+void * operator new[](std::size_t size) NEW_THROW {
+    return operator new(size);
+}
+
+void operator delete(void * what) DELETE_THROW {
+    free(what);
+}
+
+void operator delete[](void * what) DELETE_THROW {
+    free(what);
+}
+
+struct Scenario{
+    const char * name;
+    /* characters on each side */
+    int perSide;
+    /* helpers and projectiles for each character */
+    int helpers;
+    int projectiles;
+    /* player 1 plays the recorded replay instead of the AI */
+    bool replay;
+};
+
+static const Scenario scenarios[] = {
+    {"1v1", 1, 0, 0, true},
+    /* the stage doesn't know about simul matches, so this is just two
+     * characters added to each side
+     */
+    {"2v2", 2, 0, 0, false},
+    {"helpers", 1, 150, 150, false},
+};
+
+struct Settings{
+    Settings():
+    ticks(2000),
+    repeat(3),
+    seed(1),
+    threshold(10){
+    }
+
+    int ticks;
+    int repeat;
+    uint32_t seed;
+    double threshold;
+    vector<string> only;
+};
+
+/* scenario and metric */
+typedef map<pair<string, string>, double> Results;
+
+/* Everything for one run of a scenario. Characters are loaded again for every
+ * run so each one starts from scratch, the parse cache makes that cheap.
+ */
+class Match{
+public:
+    Match(const Scenario & scenario, uint32_t seed){
+        string path = "mugen/chars/kfm/kfm.def";
+        string stagePath = "mugen/stages/kfm.def";
+        stage = PaintownUtil::ReferenceCount<Mugen::Stage>(new Mugen::Stage(Storage::instance().find(Filesystem::RelativePath(stagePath))));
+
+        for (int i = 0; i < scenario.perSide; i++){
+            PaintownUtil::ReferenceCount<Mugen::Character> player1 = load(path, Mugen::Stage::Player1Side);
+            PaintownUtil::ReferenceCount<Mugen::Character> player2 = load(path, Mugen::Stage::Player2Side);
+            if (i == 0 && scenario.replay){
+                setBehavior(*player1, PaintownUtil::ReferenceCount<Mugen::Behavior>(new PlayBehavior(REPLAY_FILE, true)));
+            } else {
+                setBehavior(*player1, PaintownUtil::ReferenceCount<Mugen::Behavior>(new Mugen::LearningAIBehavior(Mugen::Data::getInstance().getDifficulty())));
+            }
+            setBehavior(*player2, PaintownUtil::ReferenceCount<Mugen::Behavior>(new Mugen::LearningAIBehavior(Mugen::Data::getInstance().getDifficulty())));
+            /* alternate sides so the first two players, which the HUD looks
+             * at, are on different teams
+             */
+            stage->addPlayer1(player1.raw());
+            stage->addPlayer2(player2.raw());
+        }
+
+        stage->load();
+        stage->getContext().setRandom(Mugen::Random(seed));
+        stage->reset();
+
+        if (scenario.helpers > 0 || scenario.projectiles > 0){
+            int count = characters.size();
+            stage->setEntityLimits(scenario.helpers * count + 56, 512, scenario.projectiles * count + 256);
+            for (vector<PaintownUtil::ReferenceCount<Mugen::Character> >::iterator it = characters.begin(); it != characters.end(); it++){
+                StressObjects::addHelpers(*stage, **it, scenario.helpers);
+                StressObjects::addProjectiles(*stage, **it, scenario.projectiles);
+            }
+        }
+    }
+
+    PaintownUtil::ReferenceCount<Mugen::Character> load(const string & path, int side){
+        PaintownUtil::ReferenceCount<Mugen::Character> character(new Mugen::Character(Storage::instance().find(Filesystem::RelativePath(path)), side));
+        character->load();
+        characters.push_back(character);
+        return character;
+    }
+
+    void setBehavior(Mugen::Character & character, const PaintownUtil::ReferenceCount<Mugen::Behavior> & behavior){
+        behaviors.push_back(behavior);
+        character.setBehavior(behavior.raw());
+    }
+
+    vector<PaintownUtil::ReferenceCount<Mugen::Character> > characters;
+    vector<PaintownUtil::ReferenceCount<Mugen::Behavior> > behaviors;
+    /* declared last so it is destroyed first, it refers to the characters */
+    PaintownUtil::ReferenceCount<Mugen::Stage> stage;
+};
+
+/* Returns the number of seconds it took to run the logic */
+static double timeLogic(Mugen::Stage & stage, int ticks){
+    TimeDifference diff;
+    diff.startTime();
+    for (int i = 0; i < ticks; i++){
+        stage.logic();
+    }
+    diff.endTime();
+    return diff.getTime() / 1000000.0;
+}
+
+static void runScenario(const Scenario & scenario, const Settings & settings, Results & results){
+    string name = scenario.name;
+
+    /* the best of a few runs, the others were slowed down by something else */
+    double best = 0;
+    for (int i = 0; i < settings.repeat; i++){
+        Match match(scenario, settings.seed);
+        double seconds = timeLogic(*match.stage, settings.ticks);
+        if (i == 0 || seconds < best){
+            best = seconds;
+        }
+    }
+
+    results[make_pair(name, string("ticks"))] = settings.ticks;
+    results[make_pair(name, string("seconds"))] = best;
+    results[make_pair(name, string("ticks_per_second"))] = best > 0 ? settings.ticks / best : 0;
+
+    /* one more run with the profiler on and allocations counted, kept apart
+     * from the timed runs so the profiler doesn't slow those down
+     */
+    Match match(scenario, settings.seed);
+    Mugen::Profiler & profiler = match.stage->getContext().getProfiler();
+    profiler.reset();
+    profiler.setEnabled(true);
+    unsigned long startAllocations = allocations;
+    unsigned long startBytes = allocatedBytes;
+    timeLogic(*match.stage, settings.ticks);
+    unsigned long tickAllocations = allocations - startAllocations;
+    unsigned long tickBytes = allocatedBytes - startBytes;
+    profiler.setEnabled(false);
+
+    results[make_pair(name, string("allocations_per_tick"))] = (double) tickAllocations / settings.ticks;
+    results[make_pair(name, string("bytes_per_tick"))] = (double) tickBytes / settings.ticks;
+    for (int phase = 0; phase < Mugen::Profiler::PhaseCount; phase++){
+        Mugen::Profiler::Phase what = (Mugen::Profiler::Phase) phase;
+        string phaseName = Mugen::Profiler::phaseName(what);
+        results[make_pair(name, phaseName + "_us_per_tick")] = profiler.getTime(what) / 1000.0 / settings.ticks;
+        results[make_pair(name, phaseName + "_calls_per_tick")] = (double) profiler.getCount(what) / settings.ticks;
+    }
+
+    ostringstream out;
+    out << name << ": " << settings.ticks << " ticks, " << (unsigned long) results[make_pair(name, string("ticks_per_second"))] << " ticks/sec, " << results[make_pair(name, string("allocations_per_tick"))] << " allocations/tick";
+    Global::debug(0, "test") << out.str() << endl;
+}
+
+static void writeResults(ostream & out, const Results & results){
+    out << "# scenario metric value" << endl;
+    for (Results::const_iterator it = results.begin(); it != results.end(); it++){
+        out << it->first.first << " " << it->first.second << " " << it->second << endl;
+    }
+}
+
+static Results readResults(const string & path){
+    Results out;
+    ifstream input(path.c_str());
+    if (!input){
+        Global::debug(0) << "Could not read " << path << endl;
+        return out;
+    }
+    string line;
+    while (getline(input, line)){
+        if (line.size() == 0 || line[0] == '#'){
+            continue;
+        }
+        istringstream parse(line);
+        string scenario;
+        string metric;
+        double value = 0;
+        parse >> scenario >> metric >> value;
+        if (!parse.fail()){
+            out[make_pair(scenario, metric)] = value;
+        }
+    }
+    return out;
+}
+
+/* how much worse `now' is than `then', in percent. for most metrics bigger is
+ * worse but ticks per second is the other way around
+ */
+static double regression(const string & metric, double then, double now){
+    if (then == 0){
+        return 0;
+    }
+    if (metric == "ticks_per_second"){
+        return (then - now) * 100 / then;
+    }
+    return (now - then) * 100 / then;
+}
+
+/* Returns the number of metrics that got worse by more than the threshold.
+ * Only ticks per second and allocations are checked, the phase times are too
+ * noisy to fail on.
+ */
+static int compare(const Results & baseline, const Results & results, double threshold){
+    int worse = 0;
+    for (Results::const_iterator it = results.begin(); it != results.end(); it++){
+        const string & scenario = it->first.first;
+        const string & metric = it->first.second;
+        Results::const_iterator old = baseline.find(it->first);
+        if (old == baseline.end()){
+            cout << scenario << " " << metric << " " << it->second << " (not in the baseline)" << endl;
+            continue;
+        }
+
+        double change = regression(metric, old->second, it->second);
+        bool checked = metric == "ticks_per_second" || metric == "allocations_per_tick";
+        bool failed = checked && change > threshold;
+        cout << scenario << " " << metric << " " << old->second << " -> " << it->second;
+        if (old->second != 0){
+            cout << " (" << (change > 0 ? "+" : "") << change << "% worse)";
+        }
+        if (failed){
+            cout << " REGRESSION";
+            worse += 1;
+        }
+        cout << endl;
+    }
+    return worse;
+}
+
+int main(int argc, char ** argv){
+    Settings settings;
+    string save;
+    string baseline;
+
+    for (int i = 1; i < argc; i++){
+        string arg = argv[i];
+        bool more = i + 1 < argc;
+        if (arg == "--ticks" && more){
+            settings.ticks = atoi(argv[++i]);
+        } else if (arg == "--repeat" && more){
+            settings.repeat = atoi(argv[++i]);
+        } else if (arg == "--seed" && more){
+            settings.seed = strtoul(argv[++i], NULL, 0);
+        } else if (arg == "--scenario" && more){
+            settings.only.push_back(argv[++i]);
+        } else if (arg == "--save" && more){
+            save = argv[++i];
+        } else if (arg == "--compare" && more){
+            baseline = argv[++i];
+        } else if (arg == "--threshold" && more){
+            settings.threshold = atof(argv[++i]);
+        } else {
+            Global::debug(0) << "Usage: " << argv[0] << " [--ticks N] [--repeat N] [--seed N] [--scenario 1v1|2v2|helpers] [--save FILE] [--compare FILE] [--threshold PERCENT]" << endl;
+            return 1;
+        }
+    }
+
+    if (settings.ticks < 1 || settings.repeat < 1){
+        Global::debug(0) << "Need at least one tick and one repeat" << endl;
+        return 1;
+    }
+
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    Mugen::ParseCache cache;
+    Results results;
+    for (unsigned int i = 0; i < sizeof(scenarios) / sizeof(Scenario); i++){
+        const Scenario & scenario = scenarios[i];
+        bool wanted = settings.only.empty();
+        for (vector<string>::iterator it = settings.only.begin(); it != settings.only.end(); it++){
+            if (*it == scenario.name){
+                wanted = true;
+            }
+        }
+        if (wanted){
+            runScenario(scenario, settings, results);
+        }
+    }
+
+    if (save != ""){
+        ofstream file(save.c_str());
+        writeResults(file, results);
+    }
+
+    if (baseline != ""){
+        return compare(readResults(baseline), results, settings.threshold) > 0 ? 1 : 0;
+    }
+
+    writeResults(cout, results);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <string>
+#include <vector>
+#include "util/init.h"
+#include "util/debug.h"
+#include "mugen/character.h"
+#include "mugen/config.h"
+#include "mugen/behavior.h"
+#include "mugen/stage.h"
+#include "mugen/compiler.h"
+#include "mugen/parse-cache.h"
+#include "mugen/exception.h"
+#include "util/file-system.h"
+#include "character-cache.h"
+
+using namespace std;
+
+/* Checks that a character run-match keeps around starts its next match the
+ * way it was right after it was loaded, no matter what the match before did
+ * to it.
+ */
+
+static const int Ticks = 300;
+
+/* plays part of a match and leaves something behind in player 1 */
+static void play(Mugen::Character & player1, Mugen::Character & player2){
+    Mugen::LearningAIBehavior behavior1(Mugen::Data::getInstance().getDifficulty());
+    Mugen::LearningAIBehavior behavior2(Mugen::Data::getInstance().getDifficulty());
+    player1.setBehavior(&behavior1);
+    player2.setBehavior(&behavior2);
+
+    {
+        Mugen::Stage stage(Storage::instance().find(Filesystem::RelativePath("mugen/stages/kfm.def")));
+        stage.addPlayer1(&player1);
+        stage.addPlayer2(&player2);
+        stage.load();
+        stage.reset();
+        for (int i = 0; i < Ticks && !stage.isMatchOver(); i++){
+            stage.logic();
+        }
+        player1.setVariable(0, Mugen::RuntimeValue(1234));
+    }
+
+    player1.setBehavior(NULL);
+    player2.setBehavior(NULL);
+}
+
+static int run(){
+    Mugen::ParseCache parseCache;
+    vector<string> roster;
+    roster.push_back("mugen/chars/kfm/kfm.def");
+    CharacterCache cache(roster);
+
+    Mugen::Character & player1 = cache.get(0, Mugen::Stage::Player1Side);
+    Mugen::Character & player2 = cache.get(0, Mugen::Stage::Player2Side);
+    if (&player1 == &player2){
+        Global::debug(0) << "Both sides got the same character" << endl;
+        return 1;
+    }
+
+    play(player1, player2);
+    if (cache.isLoadedState(0, Mugen::Stage::Player1Side)){
+        Global::debug(0) << "The match didn't change player 1" << endl;
+        return 1;
+    }
+
+    /* the second match gets the same characters, put back the way they were */
+    if (&cache.get(0, Mugen::Stage::Player1Side) != &player1 ||
+        &cache.get(0, Mugen::Stage::Player2Side) != &player2){
+        Global::debug(0) << "The characters were loaded again" << endl;
+        return 1;
+    }
+
+    if (!cache.isLoadedState(0, Mugen::Stage::Player1Side) ||
+        !cache.isLoadedState(0, Mugen::Stage::Player2Side) ||
+        player1.getVariable(0).toNumber() == 1234){
+        Global::debug(0) << "The second match doesn't start from the loaded state" << endl;
+        return 1;
+    }
+
+    /* and again after another match */
+    play(player1, player2);
+    cache.get(0, Mugen::Stage::Player1Side);
+    if (!cache.isLoadedState(0, Mugen::Stage::Player1Side)){
+        Global::debug(0) << "The third match doesn't start from the loaded state" << endl;
+        return 1;
+    }
+
+    Global::debug(0, "test") << "Matches start from the loaded state" << endl;
+    return 0;
+}
+
+int main(){
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+    InputManager manager;
+    Mugen::Sound::disableSounds();
+    try{
+        return run();
+    } catch (const MugenException & fail){
+        Global::debug(0) << fail.getFullReason() << endl;
+    } catch (const Filesystem::NotFound & fail){
+        Global::debug(0) << fail.getTrace() << endl;
+    }
+    return 1;
+}
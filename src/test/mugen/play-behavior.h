@@ -0,0 +1,251 @@
+#ifndef _paintown_test_mugen_play_behavior_h
+#define _paintown_test_mugen_play_behavior_h
+
+/* Plays back input recorded by the replay test. Shared by the replay test
+ * and the logic benchmark.
+ */
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <exception>
+#include "util/debug.h"
+#include "util/funcs.h"
+#include "mugen/behavior.h"
+#include "mugen/command.h"
+#include "mugen/stage.h"
+
+static std::string describeInput(const Mugen::Input & input){
+    std::ostringstream out;
+
+    std::vector<std::string> keys;
+    if (input.pressed.forward){
+        keys.push_back("F");
+    }
+    if (input.pressed.back){
+        keys.push_back("B");
+    }
+    if (input.pressed.up){
+        keys.push_back("U");
+    }
+    if (input.pressed.down){
+        keys.push_back("D");
+    }
+    if (input.pressed.a){
+        keys.push_back("a");
+    }
+    if (input.pressed.b){
+        keys.push_back("b");
+    }
+    if (input.pressed.c){
+        keys.push_back("c");
+    }
+    if (input.pressed.x){
+        keys.push_back("x");
+    }
+    if (input.pressed.y){
+        keys.push_back("y");
+    }
+    if (input.pressed.z){
+        keys.push_back("z");
+    }
+    if (input.pressed.start){
+        keys.push_back("s");
+    }
+    if (input.released.forward){
+        keys.push_back("~F");
+    }
+    if (input.released.back){
+        keys.push_back("~B");
+    }
+    if (input.released.up){
+        keys.push_back("~U");
+    }
+    if (input.released.down){
+        keys.push_back("~D");
+    }
+    if (input.released.a){
+        keys.push_back("~a");
+    }
+    if (input.released.b){
+        keys.push_back("~b");
+    }
+    if (input.released.c){
+        keys.push_back("~c");
+    }
+    if (input.released.x){
+        keys.push_back("~x");
+    }
+    if (input.released.y){
+        keys.push_back("~y");
+    }
+    if (input.released.z){
+        keys.push_back("~z");
+    }
+    if (input.released.start){
+        keys.push_back("~s");
+    }
+
+    bool first = true;
+    for (std::vector<std::string>::iterator it = keys.begin(); it != keys.end(); it++){
+        if (!first){
+            out << ", ";
+        }
+        first = false;
+        out << *it;
+    }
+
+    return out.str();
+}
+
+class PlayBehavior: public Mugen::Behavior {
+public:
+    /* with `repeat' the recording starts over once it runs out instead of
+     * being an error, and ticks that weren't recorded get no input
+     */
+    PlayBehavior(const std::string & path, bool repeat = false):
+    repeat(repeat){
+        load(path);
+    }
+
+    void load(const std::string & path){
+        std::ifstream file(path.c_str());
+        while (file.good()){
+            char line[256];
+            file.getline(line, sizeof(line) - 1);
+            line[255] = 0;
+            parse(inputs, line);
+        }
+        file.close();
+    }
+    
+    /* a,b,c */
+    void parse(std::map<unsigned int, Mugen::Input> & inputs, const std::string & line){
+        Mugen::Input out;
+
+        int colon = line.find(':');
+        std::string tick_string = line.substr(0, colon);
+        std::string rest = line.substr(colon + 1);
+
+        std::istringstream get(tick_string);
+        unsigned int tick = 0;
+        get >> tick;
+
+        std::vector<std::string> keys = Util::splitString(rest, ',');
+        for (std::vector<std::string>::iterator it = keys.begin(); it != keys.end(); it++){
+            std::string key = *it;
+            if (key == "F"){
+                out.pressed.forward = true;
+            }
+            if (key == "B"){
+                out.pressed.back = true;
+            }
+            if (key == "U"){
+                out.pressed.up = true;
+            }
+            if (key == "D"){
+                out.pressed.down = true;
+            }
+            if (key == "a"){
+                out.pressed.a = true;
+            }
+            if (key == "b"){
+                out.pressed.b = true;
+            }
+            if (key == "c"){
+                out.pressed.c = true;
+            }
+            if (key == "x"){
+                out.pressed.x = true;
+            }
+            if (key == "y"){
+                out.pressed.y = true;
+            }
+            if (key == "z"){
+                out.pressed.z = true;
+            }
+            if (key == "s"){
+                out.pressed.start = true;
+            }
+            if (key == "~F"){
+                out.released.forward = true;
+            }
+            if (key == "~B"){
+                out.released.back = true;
+            }
+            if (key == "~U"){
+                out.released.up = true;
+            }
+            if (key == "~D"){
+                out.released.down = true;
+            }
+            if (key == "~a"){
+                out.released.a = true;
+            }
+            if (key == "~b"){
+                out.released.b = true;
+            }
+            if (key == "~c"){
+                out.released.c = true;
+            }
+            if (key == "~x"){
+                out.released.x = true;
+            }
+            if (key == "~y"){
+                out.released.y = true;
+            }
+            if (key == "~z"){
+                out.released.z = true;
+            }
+            if (key == "~s"){
+                out.released.start = true;
+            }
+        }
+
+        inputs[tick] = out;
+    }
+
+    void flip(){
+    }
+
+    bool repeat;
+    std::map<unsigned int, Mugen::Input> inputs;
+
+    Mugen::Input getInput(unsigned int tick){
+        if (repeat){
+            if (!inputs.empty()){
+                tick = tick % (inputs.rbegin()->first + 1);
+            }
+            if (inputs.find(tick) == inputs.end()){
+                return Mugen::Input();
+            }
+        } else if (inputs.find(tick) == inputs.end()){
+            Global::debug(0) << "Error: no commands for stage tick " << tick << std::endl;
+            throw std::exception();
+        }
+
+        return inputs[tick];
+    }
+
+    std::vector<std::string> currentCommands(const Mugen::Stage & stage, Mugen::Character * owner, const std::vector<Mugen::Command2*> & commands, bool reversed){
+        std::vector<std::string> out;
+
+        Mugen::Input input = getInput(stage.getTicks());
+
+        Global::debug(1) << "Tick " << stage.getTicks() << " input: " << describeInput(input) << std::endl;
+
+        for (std::vector<Mugen::Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
+            Mugen::Command2 * command = *it;
+            if (command->handle(input, stage.getTicks())){
+                Global::debug(1) << "command: " << command->getName() << std::endl;
+                out.push_back(command->getName());
+            }
+        }
+
+        return out;
+    }
+};
+
+#endif
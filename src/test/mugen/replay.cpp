@@ -15,6 +15,7 @@
 #include "mugen/util.h"
 #include "mugen/game.h"
 #include "util/file-system.h"
+#include "play-behavior.h"
 
 using namespace std;
 
@@ -63,8 +64,10 @@ public:
 
 int run(string path1 = "mugen/chars/kfm/kfm.def", string path2 = "mugen/chars/kfm/kfm.def"){
     Game game(path1, path2, "mugen/stages/kfm.def");
-    Mugen::Random randomState(*Mugen::Random::getState());
+    /* every run of the match starts from the same random numbers */
+    Mugen::Random randomState(1);
     game.load();
+    game.stage->getContext().setRandom(randomState);
 
     vector<PaintownUtil::ReferenceCount<Mugen::World> > worlds;
 
@@ -83,8 +86,8 @@ int run(string path1 = "mugen/chars/kfm/kfm.def", string path2 = "mugen/chars/kf
     Global::debug(0, "test") << diff.printTime("Took") << endl;
 
     /* Reset the state */
-    Mugen::Random::setState(randomState);
     game.load();
+    game.stage->getContext().setRandom(randomState);
 
     Global::debug(0) << "Rerun match and check states" << std::endl;
     /* Now check that all previous states match what comes out of the new game */
@@ -119,8 +122,8 @@ int run(string path1 = "mugen/chars/kfm/kfm.def", string path2 = "mugen/chars/kf
         Global::debug(0, "test") << diff.printTime("Took") << endl;
     }
     
-    Mugen::Random::setState(randomState);
     game.load();
+    game.stage->getContext().setRandom(randomState);
 
     Global::debug(0) << "Set every 50th state." << std::endl;
     /* Now check that all previous states match what comes out of the new game */
@@ -161,221 +164,6 @@ int run(string path1 = "mugen/chars/kfm/kfm.def", string path2 = "mugen/chars/kf
     return 0;
 }
 
-static string describeInput(const Mugen::Input & input){
-    ostringstream out;
-
-    vector<string> keys;
-    if (input.pressed.forward){
-        keys.push_back("F");
-    }
-    if (input.pressed.back){
-        keys.push_back("B");
-    }
-    if (input.pressed.up){
-        keys.push_back("U");
-    }
-    if (input.pressed.down){
-        keys.push_back("D");
-    }
-    if (input.pressed.a){
-        keys.push_back("a");
-    }
-    if (input.pressed.b){
-        keys.push_back("b");
-    }
-    if (input.pressed.c){
-        keys.push_back("c");
-    }
-    if (input.pressed.x){
-        keys.push_back("x");
-    }
-    if (input.pressed.y){
-        keys.push_back("y");
-    }
-    if (input.pressed.z){
-        keys.push_back("z");
-    }
-    if (input.pressed.start){
-        keys.push_back("s");
-    }
-    if (input.released.forward){
-        keys.push_back("~F");
-    }
-    if (input.released.back){
-        keys.push_back("~B");
-    }
-    if (input.released.up){
-        keys.push_back("~U");
-    }
-    if (input.released.down){
-        keys.push_back("~D");
-    }
-    if (input.released.a){
-        keys.push_back("~a");
-    }
-    if (input.released.b){
-        keys.push_back("~b");
-    }
-    if (input.released.c){
-        keys.push_back("~c");
-    }
-    if (input.released.x){
-        keys.push_back("~x");
-    }
-    if (input.released.y){
-        keys.push_back("~y");
-    }
-    if (input.released.z){
-        keys.push_back("~z");
-    }
-    if (input.released.start){
-        keys.push_back("~s");
-    }
-
-    bool first = true;
-    for (vector<string>::iterator it = keys.begin(); it != keys.end(); it++){
-        if (!first){
-            out << ", ";
-        }
-        first = false;
-        out << *it;
-    }
-
-    return out.str();
-}
-
-class PlayBehavior: public Mugen::Behavior {
-public:
-    PlayBehavior(const std::string & path){
-        load(path);
-    }
-
-    void load(const std::string & path){
-        ifstream file(path.c_str());
-        while (file.good()){
-            char line[256];
-            file.getline(line, sizeof(line) - 1);
-            line[255] = 0;
-            parse(inputs, line);
-        }
-        file.close();
-    }
-    
-    /* a,b,c */
-    void parse(map<unsigned int, Mugen::Input> & inputs, const std::string & line){
-        Mugen::Input out;
-
-        int colon = line.find(':');
-        string tick_string = line.substr(0, colon);
-        string rest = line.substr(colon + 1);
-
-        istringstream get(tick_string);
-        unsigned int tick = 0;
-        get >> tick;
-
-        vector<string> keys = Util::splitString(rest, ',');
-        for (vector<string>::iterator it = keys.begin(); it != keys.end(); it++){
-            string key = *it;
-            if (key == "F"){
-                out.pressed.forward = true;
-            }
-            if (key == "B"){
-                out.pressed.back = true;
-            }
-            if (key == "U"){
-                out.pressed.up = true;
-            }
-            if (key == "D"){
-                out.pressed.down = true;
-            }
-            if (key == "a"){
-                out.pressed.a = true;
-            }
-            if (key == "b"){
-                out.pressed.b = true;
-            }
-            if (key == "c"){
-                out.pressed.c = true;
-            }
-            if (key == "x"){
-                out.pressed.x = true;
-            }
-            if (key == "y"){
-                out.pressed.y = true;
-            }
-            if (key == "z"){
-                out.pressed.z = true;
-            }
-            if (key == "s"){
-                out.pressed.start = true;
-            }
-            if (key == "~F"){
-                out.released.forward = true;
-            }
-            if (key == "~B"){
-                out.released.back = true;
-            }
-            if (key == "~U"){
-                out.released.up = true;
-            }
-            if (key == "~D"){
-                out.released.down = true;
-            }
-            if (key == "~a"){
-                out.released.a = true;
-            }
-            if (key == "~b"){
-                out.released.b = true;
-            }
-            if (key == "~c"){
-                out.released.c = true;
-            }
-            if (key == "~x"){
-                out.released.x = true;
-            }
-            if (key == "~y"){
-                out.released.y = true;
-            }
-            if (key == "~z"){
-                out.released.z = true;
-            }
-            if (key == "~s"){
-                out.released.start = true;
-            }
-        }
-
-        inputs[tick] = out;
-    }
-
-    void flip(){
-    }
-
-    map<unsigned int, Mugen::Input> inputs;
-
-    vector<string> currentCommands(const Mugen::Stage & stage, Mugen::Character * owner, const vector<Mugen::Command2*> & commands, bool reversed){
-        vector<string> out;
-
-        if (inputs.find(stage.getTicks()) == inputs.end()){
-            Global::debug(0) << "Error: no commands for stage tick " << stage.getTicks() << std::endl;
-            throw std::exception();
-        }
-
-        Mugen::Input input = inputs[stage.getTicks()];
-
-        Global::debug(1) << "Tick " << stage.getTicks() << " input: " << describeInput(input) << std::endl;
-
-        for (vector<Mugen::Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-            Mugen::Command2 * command = *it;
-            if (command->handle(input, stage.getTicks())){
-                Global::debug(1) << "command: " << command->getName() << endl;
-                out.push_back(command->getName());
-            }
-        }
-
-        return out;
-    }
-};
-
 class RecordHumanBehavior: public Mugen::HumanBehavior {
 public:
     RecordHumanBehavior(const InputMap<Mugen::Keys> & right, const InputMap<Mugen::Keys> & left):
@@ -484,7 +272,6 @@ void record(){
 
     string kfm = "mugen/chars/kfm/kfm.def";
     Game game(kfm, kfm, "mugen/stages/kfm.def");
-    Mugen::Random randomState(*Mugen::Random::getState());
     game.load();
 
     RecordHumanBehavior human(Mugen::getPlayer1Keys(), Mugen::getPlayer1InputLeft());
@@ -542,8 +329,10 @@ int play(){
     string kfm = "mugen/chars/kfm/kfm.def";
     Game game(kfm, kfm, "mugen/stages/kfm.def");
     srand(0);
-    Mugen::Random randomState(*Mugen::Random::getState());
+    /* every run of the match starts from the same random numbers */
+    Mugen::Random randomState(1);
     game.load();
+    game.stage->getContext().setRandom(randomState);
 
     vector<PaintownUtil::ReferenceCount<Mugen::World> > worlds;
 
@@ -562,10 +351,10 @@ int play(){
 
     Global::debug(0) << worlds.size() << " world states" << std::endl;
     
-    Mugen::Random::setState(randomState);
     {
         int count = 200;
         game.load();
+        game.stage->getContext().setRandom(randomState);
         PlayBehavior human(REPLAY_FILE);
         game.player1->setBehavior(&human);
         PaintownUtil::ReferenceCount<Mugen::Stage> stage = game.stage;
@@ -1,60 +1,774 @@
 #include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <string.h>
+#include <stdio.h>
 #include "util/init.h"
 #include "util/debug.h"
 #include "util/timedifference.h"
 #include "mugen/character.h"
 #include "mugen/config.h"
 #include "mugen/behavior.h"
+#include "mugen/ai-policy.h"
 #include "mugen/stage.h"
+#include "mugen/context.h"
+#include "mugen/random.h"
+#include "mugen/exception.h"
 #include "mugen/parse-cache.h"
 #include "util/file-system.h"
+#include "tournament.h"
+#include "character-cache.h"
+
+#ifndef WINDOWS
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/select.h>
+#endif
 
 using namespace std;
 
-void run(string path1 = "mugen/chars/kfm/kfm.def", string path2 = "mugen/chars/kfm/kfm.def"){
+/* Plays AI against AI matches as fast as the logic can run, for balance
+ * testing and to catch regressions.
+ *
+ *   run-match [player1.def [player2.def]]
+ *   run-match --roster FILE [--stages FILE] [--format round-robin|swiss]
+ *             [--rounds N] [--workers N] [--seed N] [--max-ticks N]
+ *             [--csv FILE] [--matrix FILE] [--json FILE] [--train]
+ *
+ * The roster and stage files list one .def per line, relative to the data
+ * directory. Blank lines and lines starting with # are skipped.
+ *
+ * Matches are handed out to a pool of worker processes. Each worker loads a
+ * character the first time it needs it and keeps it for the rest of the
+ * tournament, but puts it back the way it was right after loading before
+ * every match. Only the stage is loaded again for every match.
+ *
+ * With --train the AI of every character keeps learning from one match to
+ * the next and what it learned is saved as the character's AI policy, which
+ * the game then uses. Each worker trains on its own and the parent adds it
+ * all up at the end.
+ */
+
+struct Setup{
+    Setup():
+    maxTicks(0),
+    train(false){
+    }
+
+    vector<string> roster;
+    vector<string> stages;
+    /* a match that goes on longer than this is stopped and counts as failed */
+    unsigned long maxTicks;
+    bool train;
+};
+
+static void initialize(){
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+}
+
+/* While training every match adds to the saved policy of the character.
+ * Otherwise each match starts from a copy of it so the result doesn't depend
+ * on what the worker played before.
+ */
+static PaintownUtil::ReferenceCount<Mugen::AIPolicy> policyFor(const Setup & setup, const Mugen::Character & character){
+    PaintownUtil::ReferenceCount<Mugen::AIPolicy> saved = Mugen::AIPolicy::forCharacter(character.getLocation());
+    if (setup.train){
+        saved->setLearning(true);
+        return saved;
+    }
+    return PaintownUtil::ReferenceCount<Mugen::AIPolicy>(new Mugen::AIPolicy(*saved));
+}
+
+static Tournament::Result play(CharacterCache & cache, const Setup & setup, const Tournament::Match & match){
+    Tournament::Result result;
+    result.match = match;
+
+    Mugen::Character * player1 = NULL;
+    Mugen::Character * player2 = NULL;
+    try{
+        player1 = &cache.get(match.player1, Mugen::Stage::Player1Side);
+        player2 = &cache.get(match.player2, Mugen::Stage::Player2Side);
+        player1->resetPlayer();
+        player2->resetPlayer();
+        int wins1 = player1->getMatchWins();
+        int wins2 = player2->getMatchWins();
+
+        Mugen::LearningAIBehavior player1AIBehavior(Mugen::Data::getInstance().getDifficulty(), policyFor(setup, *player1));
+        Mugen::LearningAIBehavior player2AIBehavior(Mugen::Data::getInstance().getDifficulty(), policyFor(setup, *player2));
+        player1->setBehavior(&player1AIBehavior);
+        player2->setBehavior(&player2AIBehavior);
+
+        Mugen::Stage stage(Storage::instance().find(Filesystem::RelativePath(setup.stages[match.stage])));
+        stage.addPlayer1(player1);
+        stage.addPlayer2(player2);
+        stage.load();
+        stage.getContext().setRandom(Mugen::Random(match.seed));
+        stage.reset();
+
+        /* Don't need the real timer here because we just invoke the logic portion of stage
+         * as fast as possible.
+         */
+        TimeDifference diff;
+        diff.startTime();
+        while (!stage.isMatchOver() && (setup.maxTicks == 0 || result.ticks < setup.maxTicks)){
+            stage.logic();
+            result.ticks += 1;
+        }
+        diff.endTime();
+        result.seconds = diff.getTime() / 1000000.0;
+
+        result.life1 = player1->getHealth();
+        result.life2 = player2->getHealth();
+        if (!stage.isMatchOver()){
+            result.error = "match did not finish";
+        } else if (player1->getMatchWins() > wins1){
+            result.winner = 1;
+        } else if (player2->getMatchWins() > wins2){
+            result.winner = 2;
+        } else {
+            result.winner = Tournament::Result::Draw;
+        }
+    } catch (const Filesystem::NotFound & fail){
+        result.error = fail.getTrace();
+    } catch (const MugenException & fail){
+        result.error = fail.getFullReason();
+    } catch (const Exception::Base & fail){
+        result.error = fail.getTrace();
+    }
+
+    /* the behaviors are gone now */
+    if (player1 != NULL){
+        player1->setBehavior(NULL);
+    }
+    if (player2 != NULL){
+        player2->setBehavior(NULL);
+    }
+
+    return result;
+}
+
+static void report(const Tournament::Result & result, const Setup & setup){
+    const Tournament::Match & match = result.match;
+    ostringstream out;
+    out << "Match " << match.id << ": " << setup.roster[match.player1] << " vs " << setup.roster[match.player2] << " on " << setup.stages[match.stage] << ": ";
+    switch (result.winner){
+        case Tournament::Result::Failed: out << "failed, " << result.error; break;
+        case Tournament::Result::Draw: out << "draw"; break;
+        case 1: out << setup.roster[match.player1] << " won"; break;
+        case 2: out << setup.roster[match.player2] << " won"; break;
+    }
+    out << " after " << result.ticks << " ticks, " << (unsigned long) result.ticksPerSecond() << " ticks/sec";
+    Global::debug(0, "test") << out.str() << endl;
+}
+
+/* Plays matches one after the other in this process */
+class SerialRunner{
+public:
+    SerialRunner(const Setup & setup):
+    setup(setup),
+    characters(setup.roster){
+    }
+
+    vector<Tournament::Result> run(const vector<Tournament::Match> & matches){
+        vector<Tournament::Result> out;
+        for (vector<Tournament::Match>::const_iterator it = matches.begin(); it != matches.end(); it++){
+            out.push_back(play(characters, setup, *it));
+            report(out.back(), setup);
+        }
+        return out;
+    }
+
+protected:
+    const Setup & setup;
     Mugen::ParseCache cache;
-    string stagePath = "mugen/stages/kfm.def";
-    Mugen::Character kfm1(Storage::instance().find(Filesystem::RelativePath(path1)), Mugen::Stage::Player1Side);
-    Mugen::Character kfm2(Storage::instance().find(Filesystem::RelativePath(path2)), Mugen::Stage::Player2Side);
-    Global::debug(0) << "Loading player 1 " << path1 << endl;
-    kfm1.load();
-    Global::debug(0) << "Loading player 2 " << path2 << endl;
-    kfm2.load();
-    Mugen::LearningAIBehavior player1AIBehavior(Mugen::Data::getInstance().getDifficulty());
-    Mugen::LearningAIBehavior player2AIBehavior(Mugen::Data::getInstance().getDifficulty());
-    kfm1.setBehavior(&player1AIBehavior);
-    kfm2.setBehavior(&player2AIBehavior);
-    Mugen::Stage stage(Storage::instance().find(Filesystem::RelativePath(stagePath)));
-    stage.addPlayer1(&kfm1);
-    stage.addPlayer2(&kfm2);
-    Global::debug(0) << "Loading stage" << std::endl;
-    stage.load();
-    stage.reset();
-
-    Global::debug(0) << "Run match" << std::endl;
-    /* Don't need the real timer here because we just invoke the logic portion of stage
-     * as fast as possible.
-     */
+    CharacterCache characters;
+};
+
+#ifndef WINDOWS
+/* added to the policy files a worker saves */
+static string trainingSuffix(pid_t pid){
+    ostringstream out;
+    out << "." << pid;
+    return out.str();
+}
+
+/* A match goes to a worker as one line
+ *
+ *   id round player1 player2 stage seed
+ *
+ * and comes back as
+ *
+ *   id winner ticks seconds life1 life2 error...
+ */
+static string writeMatch(const Tournament::Match & match){
+    ostringstream out;
+    out << match.id << " " << match.round << " " << match.player1 << " " << match.player2 << " " << match.stage << " " << match.seed << "\n";
+    return out.str();
+}
+
+static bool readMatch(const string & line, Tournament::Match & match){
+    istringstream in(line);
+    in >> match.id >> match.round >> match.player1 >> match.player2 >> match.stage >> match.seed;
+    return !in.fail();
+}
+
+static string writeResult(const Tournament::Result & result){
+    ostringstream out;
+    out.precision(17);
+    out << result.match.id << " " << result.winner << " " << result.ticks << " " << result.seconds << " " << result.life1 << " " << result.life2 << " ";
+    for (unsigned int i = 0; i < result.error.size(); i++){
+        char c = result.error[i];
+        out << (c == '\n' || c == '\r' ? ' ' : c);
+    }
+    out << "\n";
+    return out.str();
+}
+
+static bool readResult(const string & line, Tournament::Result & result){
+    istringstream in(line);
+    in >> result.match.id >> result.winner >> result.ticks >> result.seconds >> result.life1 >> result.life2;
+    if (in.fail()){
+        return false;
+    }
+    in.get();
+    getline(in, result.error);
+    return true;
+}
+
+static bool writeAll(int fd, const string & data){
+    unsigned int written = 0;
+    while (written < data.size()){
+        ssize_t count = write(fd, data.c_str() + written, data.size() - written);
+        if (count < 0 && errno == EINTR){
+            continue;
+        }
+        if (count <= 0){
+            return false;
+        }
+        written += count;
+    }
+    return true;
+}
+
+/* The body of a worker process, plays matches until the pipe is closed */
+static void workerLoop(int input, int output, const Setup & setup){
+    InputManager manager;
+    initialize();
+    Mugen::ParseCache cache;
+    CharacterCache characters(setup.roster);
+
+    string buffer;
+    char data[1024];
+    while (true){
+        size_t end = buffer.find('\n');
+        if (end == string::npos){
+            ssize_t count = read(input, data, sizeof(data));
+            if (count < 0 && errno == EINTR){
+                continue;
+            }
+            if (count <= 0){
+                break;
+            }
+            buffer.append(data, count);
+            continue;
+        }
+
+        string line = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+        Tournament::Match match;
+        if (!readMatch(line, match)){
+            continue;
+        }
+        if (!writeAll(output, writeResult(play(characters, setup, match)))){
+            break;
+        }
+    }
+
+    if (setup.train){
+        Mugen::AIPolicy::saveAll(trainingSuffix(getpid()));
+    }
+}
+
+/* Worker processes that each play one match at a time. Workers are forked
+ * before anything is loaded, so each one starts from nothing and builds up
+ * its own characters. A worker that dies takes only its current match with
+ * it and is replaced.
+ */
+class WorkerPool{
+public:
+    WorkerPool(int count, const Setup & setup):
+    setup(setup){
+        /* a dead worker shouldn't kill us when we write to it */
+        signal(SIGPIPE, SIG_IGN);
+        for (int i = 0; i < count; i++){
+            workers.push_back(Worker());
+            start(workers.back());
+        }
+    }
+
+    vector<Tournament::Result> run(const vector<Tournament::Match> & matches){
+        deque<Tournament::Match> waiting(matches.begin(), matches.end());
+        map<int, Tournament::Result> done;
+
+        while (done.size() < matches.size()){
+            for (vector<Worker>::iterator it = workers.begin(); it != workers.end() && !waiting.empty(); it++){
+                Worker & worker = *it;
+                if (!worker.busy){
+                    worker.match = waiting.front();
+                    waiting.pop_front();
+                    worker.busy = true;
+                    /* if the write fails the worker is gone and the read below notices */
+                    writeAll(worker.input, writeMatch(worker.match));
+                }
+            }
+
+            fd_set readable;
+            FD_ZERO(&readable);
+            int highest = -1;
+            for (vector<Worker>::iterator it = workers.begin(); it != workers.end(); it++){
+                if (it->busy){
+                    FD_SET(it->output, &readable);
+                    if (it->output > highest){
+                        highest = it->output;
+                    }
+                }
+            }
+
+            if (select(highest + 1, &readable, NULL, NULL, NULL) < 0){
+                if (errno == EINTR){
+                    continue;
+                }
+                throw MugenException(string("Could not wait for workers: ") + strerror(errno), __FILE__, __LINE__);
+            }
+
+            for (vector<Worker>::iterator it = workers.begin(); it != workers.end(); it++){
+                Worker & worker = *it;
+                if (worker.busy && FD_ISSET(worker.output, &readable)){
+                    service(worker, done);
+                }
+            }
+        }
+
+        vector<Tournament::Result> out;
+        for (map<int, Tournament::Result>::iterator it = done.begin(); it != done.end(); it++){
+            out.push_back(it->second);
+        }
+        return out;
+    }
+
+    /* stops every worker, gives back the process id of every worker there was */
+    vector<pid_t> finish(){
+        for (vector<Worker>::iterator it = workers.begin(); it != workers.end(); it++){
+            stop(*it);
+        }
+        return started;
+    }
+
+    ~WorkerPool(){
+        finish();
+    }
+
+protected:
+    struct Worker{
+        Worker():
+        pid(-1),
+        input(-1),
+        output(-1),
+        busy(false){
+        }
+
+        pid_t pid;
+        /* we write matches to this */
+        int input;
+        /* and read results from this */
+        int output;
+        string buffer;
+        bool busy;
+        Tournament::Match match;
+    };
+
+    void start(Worker & worker){
+        int toWorker[2];
+        int fromWorker[2];
+        if (pipe(toWorker) != 0 || pipe(fromWorker) != 0){
+            throw MugenException(string("Could not make a pipe: ") + strerror(errno), __FILE__, __LINE__);
+        }
+
+        pid_t pid = fork();
+        if (pid < 0){
+            throw MugenException(string("Could not start a worker: ") + strerror(errno), __FILE__, __LINE__);
+        }
+
+        if (pid == 0){
+            close(toWorker[1]);
+            close(fromWorker[0]);
+            /* don't keep the other workers' pipes open */
+            for (vector<Worker>::iterator it = workers.begin(); it != workers.end(); it++){
+                if (it->pid > 0){
+                    close(it->input);
+                    close(it->output);
+                }
+            }
+            workerLoop(toWorker[0], fromWorker[1], setup);
+            /* skip the destructors, they belong to the parent */
+            _exit(0);
+        }
+
+        close(toWorker[0]);
+        close(fromWorker[1]);
+        started.push_back(pid);
+        worker.pid = pid;
+        worker.input = toWorker[1];
+        worker.output = fromWorker[0];
+        worker.buffer = "";
+        worker.busy = false;
+    }
+
+    void stop(Worker & worker){
+        if (worker.pid <= 0){
+            return;
+        }
+        close(worker.input);
+        close(worker.output);
+        int status = 0;
+        waitpid(worker.pid, &status, 0);
+        worker.pid = -1;
+    }
+
+    void service(Worker & worker, map<int, Tournament::Result> & done){
+        char data[1024];
+        ssize_t count = read(worker.output, data, sizeof(data));
+        if (count < 0 && errno == EINTR){
+            return;
+        }
+
+        if (count <= 0){
+            Tournament::Result result;
+            result.match = worker.match;
+            result.error = "worker died";
+            done[result.match.id] = result;
+            report(result, setup);
+            stop(worker);
+            start(worker);
+            return;
+        }
+
+        worker.buffer.append(data, count);
+        size_t end = worker.buffer.find('\n');
+        if (end != string::npos){
+            Tournament::Result result;
+            result.match = worker.match;
+            if (!readResult(worker.buffer.substr(0, end), result) || result.match.id != worker.match.id){
+                result = Tournament::Result();
+                result.match = worker.match;
+                result.error = "bad result from worker";
+            }
+            result.match = worker.match;
+            worker.buffer.erase(0, end + 1);
+            worker.busy = false;
+            done[result.match.id] = result;
+            report(result, setup);
+        }
+    }
+
+    const Setup & setup;
+    vector<Worker> workers;
+    vector<pid_t> started;
+};
+
+/* Adds what the workers learned about a character to its saved policy.
+ * Every worker started from the same saved policy, so only what it learned
+ * after that is added.
+ */
+static void mergeTraining(const Filesystem::AbsolutePath & character, const vector<pid_t> & workers){
+    Filesystem::AbsolutePath location = Mugen::AIPolicy::location(character);
+    PaintownUtil::ReferenceCount<Mugen::AIPolicy> policy = Mugen::AIPolicy::forCharacter(character);
+    Mugen::AIPolicy base(*policy);
+    for (vector<pid_t>::const_iterator it = workers.begin(); it != workers.end(); it++){
+        Filesystem::AbsolutePath path(location.path() + trainingSuffix(*it));
+        Mugen::AIPolicy learned;
+        try{
+            learned.load(path);
+        } catch (const MugenException & fail){
+            /* the worker never played this character or died */
+            continue;
+        }
+        policy->merge(learned, &base);
+        remove(path.path().c_str());
+    }
+}
+
+static void mergeTraining(const Setup & setup, const vector<pid_t> & workers){
+    map<string, bool> merged;
+    for (vector<string>::const_iterator name = setup.roster.begin(); name != setup.roster.end(); name++){
+        if (merged[*name]){
+            continue;
+        }
+        merged[*name] = true;
+
+        try{
+            mergeTraining(Storage::instance().find(Filesystem::RelativePath(*name)), workers);
+        } catch (const Filesystem::NotFound & fail){
+            Global::debug(0, "test") << "Could not find " << *name << endl;
+        }
+    }
+
+    Mugen::AIPolicy::saveAll();
+}
+#endif
+
+struct Options{
+    Options():
+    format("round-robin"),
+    rounds(0),
+    workers(1),
+    seed(1){
+    }
+
+    string format;
+    int rounds;
+    int workers;
+    uint32_t seed;
+    string csv;
+    string matrix;
+    string json;
+};
+
+static vector<string> readList(const string & path){
+    vector<string> out;
+    ifstream input(path.c_str());
+    if (!input){
+        throw MugenException("Could not read " + path, __FILE__, __LINE__);
+    }
+    string line;
+    while (getline(input, line)){
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == string::npos || line[start] == '#'){
+            continue;
+        }
+        size_t end = line.find_last_not_of(" \t\r");
+        out.push_back(line.substr(start, end - start + 1));
+    }
+    return out;
+}
+
+static void usage(const char * name){
+    Global::debug(0) << "Usage: " << name << " [player1.def [player2.def]]" << endl;
+    Global::debug(0) << "       " << name << " --roster FILE [--stages FILE] [--format round-robin|swiss] [--rounds N] [--workers N] [--seed N] [--max-ticks N] [--csv FILE] [--matrix FILE] [--json FILE] [--train]" << endl;
+}
+
+/* Plays a batch of matches that don't depend on each other, on the worker
+ * pool if there is one.
+ */
+class Runner{
+public:
+    Runner(const Setup & setup, int workers):
+    setup(setup){
+#ifndef WINDOWS
+        if (workers > 1){
+            pool = PaintownUtil::ReferenceCount<WorkerPool>(new WorkerPool(workers, setup));
+            return;
+        }
+#else
+        if (workers > 1){
+            Global::debug(0) << "Worker processes are not supported here, playing one match at a time" << endl;
+        }
+#endif
+        InputManager * manager = new InputManager();
+        input = PaintownUtil::ReferenceCount<InputManager>(manager);
+        initialize();
+        serial = PaintownUtil::ReferenceCount<SerialRunner>(new SerialRunner(setup));
+    }
+
+    vector<Tournament::Result> run(const vector<Tournament::Match> & matches){
+#ifndef WINDOWS
+        if (pool != NULL){
+            return pool->run(matches);
+        }
+#endif
+        return serial->run(matches);
+    }
+
+    /* saves what the AI learned in all the matches */
+    void saveTraining(){
+#ifndef WINDOWS
+        if (pool != NULL){
+            vector<pid_t> workers = pool->finish();
+            /* the workers did all the loading so far */
+            input = PaintownUtil::ReferenceCount<InputManager>(new InputManager());
+            initialize();
+            mergeTraining(setup, workers);
+            return;
+        }
+#endif
+        Mugen::AIPolicy::saveAll();
+    }
+
+protected:
+    const Setup & setup;
+#ifndef WINDOWS
+    PaintownUtil::ReferenceCount<WorkerPool> pool;
+#endif
+    PaintownUtil::ReferenceCount<InputManager> input;
+    PaintownUtil::ReferenceCount<SerialRunner> serial;
+};
+
+static int run(const Setup & setup, const Options & options){
+    Runner runner(setup, options.workers);
+    Tournament::Standings standings(setup.roster.size());
+    vector<Tournament::Result> results;
+
     TimeDifference diff;
     diff.startTime();
-    while (!stage.isMatchOver()){
-        stage.logic();
+    if (options.format == "swiss"){
+        int rounds = options.rounds > 0 ? options.rounds : Tournament::swissRounds(setup.roster.size());
+        for (int round = 0; round < rounds; round++){
+            int bye = -1;
+            vector<Tournament::Match> matches = Tournament::swissRound(standings, round, setup.stages.size(), options.seed, results.size(), bye);
+            if (bye != -1){
+                Global::debug(0, "test") << "Round " << round << ": " << setup.roster[bye] << " sits out" << endl;
+                standings.addBye(bye);
+            }
+            vector<Tournament::Result> played = runner.run(matches);
+            for (vector<Tournament::Result>::iterator it = played.begin(); it != played.end(); it++){
+                standings.add(*it);
+                results.push_back(*it);
+            }
+        }
+    } else {
+        int rounds = options.rounds > 0 ? options.rounds : 1;
+        results = runner.run(Tournament::roundRobin(setup.roster.size(), setup.stages.size(), rounds, options.seed));
+        for (vector<Tournament::Result>::iterator it = results.begin(); it != results.end(); it++){
+            standings.add(*it);
+        }
     }
     diff.endTime();
-    Global::debug(0, "test") << diff.printTime("Success! Took") << endl;
+    double seconds = diff.getTime() / 1000000.0;
+
+    if (setup.train){
+        runner.saveTraining();
+        Global::debug(0, "test") << "Saved the AI policies" << endl;
+    }
+
+    unsigned long ticks = 0;
+    int failed = 0;
+    for (vector<Tournament::Result>::iterator it = results.begin(); it != results.end(); it++){
+        ticks += it->ticks;
+        if (it->winner == Tournament::Result::Failed){
+            failed += 1;
+        }
+    }
+
+    vector<int> ranking = standings.ranking();
+    for (unsigned int i = 0; i < ranking.size(); i++){
+        int player = ranking[i];
+        Global::debug(0, "test") << (i + 1) << ". " << setup.roster[player] << " " << standings.getScore(player) << " points, " << standings.getWins(player) << " won " << standings.getLosses(player) << " lost " << standings.getDraws(player) << " drawn" << endl;
+    }
+    ostringstream out;
+    out << results.size() << " matches, " << failed << " failed, " << ticks << " ticks, " << (seconds > 0 ? (unsigned long) (ticks / seconds) : 0) << " ticks/sec. Took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+
+    if (options.csv != ""){
+        ofstream file(options.csv.c_str());
+        Tournament::writeCsv(file, results, setup.roster, setup.stages);
+    }
+    if (options.matrix != ""){
+        ofstream file(options.matrix.c_str());
+        Tournament::writeMatrixCsv(file, standings, setup.roster);
+    }
+    if (options.json != ""){
+        ofstream file(options.json.c_str());
+        Tournament::writeJson(file, results, standings, setup.roster, setup.stages, seconds);
+    }
+
+    return failed > 0 ? 1 : 0;
 }
 
 int main(int argc, char ** argv){
-    InputManager manager;
-    Global::InitConditions conditions;
-    conditions.graphics = Global::InitConditions::Disabled;
-    Global::init(conditions);
-    Global::setDebug(0);
-    if (argc == 1){
-        run();
-    } else if (argc == 2){
-        run(argv[1]);
-    } else if (argc > 2){
-        run(argv[1], argv[2]);
+    Setup setup;
+    Options options;
+    string roster;
+    string stages;
+    vector<string> players;
+
+    for (int i = 1; i < argc; i++){
+        string arg = argv[i];
+        bool more = i + 1 < argc;
+        if (arg == "--roster" && more){
+            roster = argv[++i];
+        } else if (arg == "--stages" && more){
+            stages = argv[++i];
+        } else if (arg == "--format" && more){
+            options.format = argv[++i];
+        } else if (arg == "--rounds" && more){
+            options.rounds = atoi(argv[++i]);
+        } else if (arg == "--workers" && more){
+            options.workers = atoi(argv[++i]);
+        } else if (arg == "--seed" && more){
+            options.seed = strtoul(argv[++i], NULL, 0);
+        } else if (arg == "--max-ticks" && more){
+            setup.maxTicks = strtoul(argv[++i], NULL, 0);
+        } else if (arg == "--csv" && more){
+            options.csv = argv[++i];
+        } else if (arg == "--matrix" && more){
+            options.matrix = argv[++i];
+        } else if (arg == "--json" && more){
+            options.json = argv[++i];
+        } else if (arg == "--train"){
+            setup.train = true;
+        } else if (arg.size() > 0 && arg[0] == '-'){
+            usage(argv[0]);
+            return 1;
+        } else {
+            players.push_back(arg);
+        }
+    }
+
+    if (options.format != "round-robin" && options.format != "swiss"){
+        usage(argv[0]);
+        return 1;
+    }
+
+    try{
+        if (roster != ""){
+            setup.roster = readList(roster);
+        } else {
+            setup.roster = players;
+            while (setup.roster.size() < 2){
+                setup.roster.push_back("mugen/chars/kfm/kfm.def");
+            }
+        }
+
+        if (stages != ""){
+            setup.stages = readList(stages);
+        } else {
+            setup.stages.push_back("mugen/stages/kfm.def");
+        }
+
+        if (setup.roster.size() < 2 || setup.stages.size() < 1){
+            Global::debug(0) << "Need at least two characters and one stage" << endl;
+            return 1;
+        }
+
+        return run(setup, options);
+    } catch (const Filesystem::NotFound & fail){
+        Global::debug(0) << fail.getTrace() << endl;
+        return 1;
+    } catch (const MugenException & fail){
+        Global::debug(0) << fail.getFullReason() << endl;
+        return 1;
+    } catch (const Exception::Base & fail){
+        Global::debug(0) << fail.getTrace() << endl;
+        return 1;
     }
 }
@@ -0,0 +1,54 @@
+#ifndef _paintown_test_mugen_stress_objects_h
+#define _paintown_test_mugen_stress_objects_h
+
+/* Fills a stage with helpers and projectiles. Shared by the stress test and
+ * the logic benchmark.
+ */
+
+#include "util/debug.h"
+#include "mugen/character.h"
+#include "mugen/helper.h"
+#include "mugen/projectile.h"
+#include "mugen/stage.h"
+
+namespace StressObjects{
+
+/* Spread things over a stretch of the stage that is much wider than the screen */
+static double spread(int index, int total){
+    if (total < 2){
+        return 0;
+    }
+    return -400 + 800.0 * index / (total - 1);
+}
+
+static void addHelpers(Mugen::Stage & stage, Mugen::Character & owner, int count){
+    for (int i = 0; i < count; i++){
+        Mugen::Helper * helper = stage.createHelper(&owner, &owner, 1000 + i, "stress");
+        if (helper == NULL){
+            Global::debug(0) << "Could only create " << i << " helpers" << std::endl;
+            return;
+        }
+        helper->setX(spread(i, count));
+        helper->setY(0);
+        stage.addObject(helper);
+        helper->changeState(stage, Mugen::Standing);
+    }
+}
+
+static void addProjectiles(Mugen::Stage & stage, Mugen::Character & owner, int count){
+    for (int i = 0; i < count; i++){
+        /* Uses the standing animation for its boxes and never runs out of hits */
+        stage.addProjectile(new Mugen::Projectile(spread(i, count), -40, 2000 + i, &owner, 0, 0, 0,
+                                                  0, 1, 1, false, -1,
+                                                  0, 0, 0, 0,
+                                                  0, 0, 1,
+                                                  1, 1000000, 0, 1, 0,
+                                                  40, 40, -240, 1, -1,
+                                                  -1, -1, 0, 0,
+                                                  0, 0, owner.getFacing(), Mugen::HitDefinition()));
+    }
+}
+
+}
+
+#endif
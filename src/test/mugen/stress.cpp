@@ -0,0 +1,92 @@
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/timedifference.h"
+#include "mugen/character.h"
+#include "mugen/helper.h"
+#include "mugen/projectile.h"
+#include "mugen/config.h"
+#include "mugen/behavior.h"
+#include "mugen/stage.h"
+#include "mugen/parse-cache.h"
+#include "util/file-system.h"
+#include "stress-objects.h"
+
+using namespace std;
+
+/* Fills the stage with lots of helpers and projectiles and times how long
+ * the stage logic takes. Hit detection used to look at every pair of things
+ * on the stage so this is mostly a test of how well it scales.
+ */
+
+static const int ticks = 600;
+
+/* Returns the number of milliseconds it took to run the stage */
+static double run(int helpers, int projectiles){
+    Mugen::ParseCache cache;
+    string path = "mugen/chars/kfm/kfm.def";
+    string stagePath = "mugen/stages/kfm.def";
+    Mugen::Character kfm1(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player1Side);
+    Mugen::Character kfm2(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player2Side);
+    kfm1.load();
+    kfm2.load();
+    Mugen::LearningAIBehavior player1AIBehavior(Mugen::Data::getInstance().getDifficulty());
+    Mugen::LearningAIBehavior player2AIBehavior(Mugen::Data::getInstance().getDifficulty());
+    kfm1.setBehavior(&player1AIBehavior);
+    kfm2.setBehavior(&player2AIBehavior);
+    Mugen::Stage stage(Storage::instance().find(Filesystem::RelativePath(stagePath)));
+    stage.addPlayer1(&kfm1);
+    stage.addPlayer2(&kfm2);
+    stage.load();
+    stage.reset();
+    stage.setEntityLimits(helpers * 2 + 56, 512, projectiles + 256);
+
+    StressObjects::addHelpers(stage, kfm1, helpers);
+    StressObjects::addHelpers(stage, kfm2, helpers);
+    StressObjects::addProjectiles(stage, kfm1, projectiles);
+    StressObjects::addProjectiles(stage, kfm2, projectiles);
+
+    TimeDifference diff;
+    diff.startTime();
+    for (int i = 0; i < ticks; i++){
+        stage.logic();
+    }
+    diff.endTime();
+
+    ostringstream out;
+    out << helpers * 2 << " helpers " << projectiles * 2 << " projectiles, " << ticks << " ticks took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+    return diff.getTime() / 1000.0;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int helpers = 150;
+    int projectiles = 150;
+    if (argc > 1){
+        helpers = atoi(argv[1]);
+    }
+    if (argc > 2){
+        projectiles = atoi(argv[2]);
+    }
+
+    double empty = run(0, 0);
+    double half = run(helpers / 2, projectiles / 2);
+    double full = run(helpers, projectiles);
+
+    /* With the broad phase twice the things should take about twice as long,
+     * checking every pair would take four times as long.
+     */
+    if (half > 0 && empty < half){
+        Global::debug(0, "test") << "Doubling the number of things took " << ((full - empty) / (half - empty)) << " times as long" << endl;
+    }
+
+    return 0;
+}
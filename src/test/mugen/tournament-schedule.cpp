@@ -0,0 +1,175 @@
+#include "tournament.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+using std::vector;
+using std::string;
+
+/* Checks the schedules run-match makes without playing any matches */
+
+static int testRoundRobin(){
+    int players = 4;
+    vector<Tournament::Match> matches = Tournament::roundRobin(players, 2, 2, 1);
+    if (matches.size() != 24){
+        std::cout << "Expected 24 matches but got " << matches.size() << std::endl;
+        return 1;
+    }
+
+    /* every pair meets twice per stage, once from each side */
+    vector<int> sides(players * players);
+    for (vector<Tournament::Match>::iterator it = matches.begin(); it != matches.end(); it++){
+        if (it->id != it - matches.begin()){
+            std::cout << "Match ids are out of order" << std::endl;
+            return 1;
+        }
+        sides[it->player1 * players + it->player2] += 1;
+    }
+
+    for (int player1 = 0; player1 < players; player1++){
+        for (int player2 = 0; player2 < players; player2++){
+            int expected = player1 == player2 ? 0 : 2;
+            if (sides[player1 * players + player2] != expected){
+                std::cout << player1 << " was player 1 against " << player2 << " " << sides[player1 * players + player2] << " times" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    /* the seeds don't depend on anything but the tournament seed and the id */
+    vector<Tournament::Match> again = Tournament::roundRobin(players, 2, 2, 1);
+    vector<Tournament::Match> other = Tournament::roundRobin(players, 2, 2, 2);
+    if (again[5].seed != matches[5].seed || other[5].seed == matches[5].seed || matches[5].seed == matches[6].seed){
+        std::cout << "Bad match seeds" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int testSwiss(int players){
+    Tournament::Standings standings(players);
+    int id = 0;
+    int rounds = Tournament::swissRounds(players);
+    for (int round = 0; round < rounds; round++){
+        int bye = -1;
+        vector<Tournament::Match> matches = Tournament::swissRound(standings, round, 3, 7, id, bye);
+        vector<int> seen(players);
+        if (bye != -1){
+            if (standings.hadBye(bye)){
+                std::cout << "Player " << bye << " got two byes" << std::endl;
+                return 1;
+            }
+            seen[bye] += 1;
+            standings.addBye(bye);
+        }
+
+        for (vector<Tournament::Match>::iterator it = matches.begin(); it != matches.end(); it++){
+            const Tournament::Match & match = *it;
+            if (match.id != id || match.stage != round % 3){
+                std::cout << "Bad id or stage in round " << round << std::endl;
+                return 1;
+            }
+            if (standings.hasPlayed(match.player1, match.player2)){
+                std::cout << "Rematch between " << match.player1 << " and " << match.player2 << " in round " << round << std::endl;
+                return 1;
+            }
+            seen[match.player1] += 1;
+            seen[match.player2] += 1;
+            id += 1;
+
+            /* the lower numbered player always wins */
+            Tournament::Result result;
+            result.match = match;
+            result.winner = match.player1 < match.player2 ? 1 : 2;
+            standings.add(result);
+        }
+
+        for (int i = 0; i < players; i++){
+            if (seen[i] != 1){
+                std::cout << "Player " << i << " was scheduled " << seen[i] << " times in round " << round << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if (standings.ranking()[0] != 0 || standings.getWins(0) != rounds){
+        std::cout << "Player 0 should have won every match" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int testSwiss5(){
+    return testSwiss(5);
+}
+
+static int testSwiss8(){
+    return testSwiss(8);
+}
+
+static int testOutput(){
+    vector<string> roster;
+    roster.push_back("kfm/kfm.def");
+    roster.push_back("odd, \"name\".def");
+    vector<string> stages;
+    stages.push_back("stages/kfm.def");
+
+    Tournament::Standings standings(2);
+    vector<Tournament::Result> results;
+    Tournament::Result result;
+    result.match = Tournament::Match(0, 0, 0, 1, 0, 3);
+    result.winner = 2;
+    result.ticks = 1000;
+    result.seconds = 0.5;
+    results.push_back(result);
+    standings.add(result);
+
+    std::ostringstream csv;
+    Tournament::writeCsv(csv, results, roster, stages);
+    if (csv.str().find("\"odd, \"\"name\"\".def\",stages/kfm.def,3,\"odd, \"\"name\"\".def\",1000,0.5,2000,") == string::npos){
+        std::cout << "Bad csv: " << csv.str() << std::endl;
+        return 1;
+    }
+
+    std::ostringstream matrix;
+    Tournament::writeMatrixCsv(matrix, standings, roster);
+    if (matrix.str().find("\"odd, \"\"name\"\".def\",1,0") == string::npos){
+        std::cout << "Bad matrix: " << matrix.str() << std::endl;
+        return 1;
+    }
+
+    std::ostringstream json;
+    Tournament::writeJson(json, results, standings, roster, stages, 1);
+    if (json.str().find("\"odd, \\\"name\\\".def\"") == string::npos ||
+        json.str().find("\"matrix\": [") == string::npos){
+        std::cout << "Bad json: " << json.str() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int runTest(int (*test)(), const std::string & name){
+    if (test()){
+        std::cout << name << " failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char ** argv){
+    if (
+        runTest(testRoundRobin, "RoundRobin") ||
+        runTest(testSwiss5, "Swiss5") ||
+        runTest(testSwiss8, "Swiss8") ||
+        runTest(testOutput, "Output") ||
+        false
+        ){
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,423 @@
+#include "tournament.h"
+#include <algorithm>
+#include <sstream>
+
+using std::vector;
+using std::string;
+using std::ostream;
+using std::endl;
+
+namespace Tournament{
+
+Match::Match():
+id(0),
+round(0),
+player1(0),
+player2(0),
+stage(0),
+seed(0){
+}
+
+Match::Match(int id, int round, int player1, int player2, int stage, uint32_t seed):
+id(id),
+round(round),
+player1(player1),
+player2(player2),
+stage(stage),
+seed(seed){
+}
+
+Result::Result():
+winner(Failed),
+ticks(0),
+seconds(0),
+life1(0),
+life2(0){
+}
+
+double Result::ticksPerSecond() const {
+    if (seconds <= 0){
+        return 0;
+    }
+    return ticks / seconds;
+}
+
+/* splitmix64, same as Mugen::Random uses to seed itself */
+uint32_t matchSeed(uint32_t seed, int id){
+    uint64_t z = (((uint64_t) seed) << 32 | (uint32_t) id) + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (uint32_t) (z ^ (z >> 31));
+}
+
+vector<Match> roundRobin(int players, int stages, int rounds, uint32_t seed){
+    vector<Match> out;
+    int id = 0;
+    for (int round = 0; round < rounds; round++){
+        for (int stage = 0; stage < stages; stage++){
+            for (int player1 = 0; player1 < players; player1++){
+                for (int player2 = player1 + 1; player2 < players; player2++){
+                    if (round % 2 == 0){
+                        out.push_back(Match(id, round, player1, player2, stage, matchSeed(seed, id)));
+                    } else {
+                        out.push_back(Match(id, round, player2, player1, stage, matchSeed(seed, id)));
+                    }
+                    id += 1;
+                }
+            }
+        }
+    }
+    return out;
+}
+
+Standings::Standings(int players):
+players(players),
+wins(players),
+losses(players),
+draws(players),
+failures(players),
+byes(players),
+beat(players * players),
+played(players * players){
+}
+
+void Standings::add(const Result & result){
+    int player1 = result.match.player1;
+    int player2 = result.match.player2;
+    switch (result.winner){
+        case Result::Failed: {
+            failures[player1] += 1;
+            failures[player2] += 1;
+            return;
+        }
+        case Result::Draw: {
+            draws[player1] += 1;
+            draws[player2] += 1;
+            break;
+        }
+        case 1: {
+            wins[player1] += 1;
+            losses[player2] += 1;
+            beat[player1 * players + player2] += 1;
+            break;
+        }
+        case 2: {
+            wins[player2] += 1;
+            losses[player1] += 1;
+            beat[player2 * players + player1] += 1;
+            break;
+        }
+    }
+    played[player1 * players + player2] += 1;
+    played[player2 * players + player1] += 1;
+}
+
+void Standings::addBye(int player){
+    byes[player] += 1;
+}
+
+double Standings::getScore(int player) const {
+    return wins[player] + byes[player] + draws[player] * 0.5;
+}
+
+int Standings::getWins(int player) const {
+    return wins[player];
+}
+
+int Standings::getLosses(int player) const {
+    return losses[player];
+}
+
+int Standings::getDraws(int player) const {
+    return draws[player];
+}
+
+int Standings::getFailures(int player) const {
+    return failures[player];
+}
+
+int Standings::getWins(int player, int against) const {
+    return beat[player * players + against];
+}
+
+bool Standings::hasPlayed(int player1, int player2) const {
+    return played[player1 * players + player2] > 0;
+}
+
+bool Standings::hadBye(int player) const {
+    return byes[player] > 0;
+}
+
+namespace{
+
+class ByScore{
+public:
+    ByScore(const Standings & standings):
+    standings(standings){
+    }
+
+    bool operator()(int player1, int player2) const {
+        double score1 = standings.getScore(player1);
+        double score2 = standings.getScore(player2);
+        if (score1 != score2){
+            return score1 > score2;
+        }
+        return player1 < player2;
+    }
+
+    const Standings & standings;
+};
+
+}
+
+vector<int> Standings::ranking() const {
+    vector<int> out;
+    for (int i = 0; i < players; i++){
+        out.push_back(i);
+    }
+    std::sort(out.begin(), out.end(), ByScore(*this));
+    return out;
+}
+
+/* Pairs the first player with the closest one they haven't met and the rest
+ * the same way, going back to try the next closest if the rest can't be
+ * paired without a rematch.
+ */
+static bool pairUp(const Standings & standings, vector<int> & waiting, vector<int> & pairs){
+    if (waiting.size() < 2){
+        return true;
+    }
+
+    int player1 = waiting[0];
+    for (unsigned int i = 1; i < waiting.size(); i++){
+        int player2 = waiting[i];
+        if (standings.hasPlayed(player1, player2)){
+            continue;
+        }
+
+        vector<int> rest;
+        for (unsigned int j = 1; j < waiting.size(); j++){
+            if (j != i){
+                rest.push_back(waiting[j]);
+            }
+        }
+
+        pairs.push_back(player1);
+        pairs.push_back(player2);
+        if (pairUp(standings, rest, pairs)){
+            return true;
+        }
+        pairs.pop_back();
+        pairs.pop_back();
+    }
+
+    return false;
+}
+
+vector<Match> swissRound(const Standings & standings, int round, int stages, uint32_t seed, int firstId, int & bye){
+    vector<int> waiting = standings.ranking();
+    bye = -1;
+    if (waiting.size() % 2 == 1){
+        int pick = waiting.size() - 1;
+        for (int i = waiting.size() - 1; i >= 0; i--){
+            if (!standings.hadBye(waiting[i])){
+                pick = i;
+                break;
+            }
+        }
+        bye = waiting[pick];
+        waiting.erase(waiting.begin() + pick);
+    }
+
+    vector<int> pairs;
+    if (!pairUp(standings, waiting, pairs)){
+        /* everyone has met already, so just pair them in ranking order */
+        pairs = waiting;
+    }
+
+    vector<Match> out;
+    int id = firstId;
+    int stage = stages > 0 ? round % stages : 0;
+    for (unsigned int i = 0; i + 1 < pairs.size(); i += 2){
+        int player1 = pairs[i];
+        int player2 = pairs[i + 1];
+        if (round % 2 == 1){
+            std::swap(player1, player2);
+        }
+        out.push_back(Match(id, round, player1, player2, stage, matchSeed(seed, id)));
+        id += 1;
+    }
+
+    return out;
+}
+
+int swissRounds(int players){
+    int rounds = 0;
+    while ((1 << rounds) < players){
+        rounds += 1;
+    }
+    return rounds;
+}
+
+static string csvField(const string & what){
+    if (what.find_first_of(",\"\n") == string::npos){
+        return what;
+    }
+    string out = "\"";
+    for (unsigned int i = 0; i < what.size(); i++){
+        if (what[i] == '"'){
+            out += '"';
+        }
+        out += what[i];
+    }
+    return out + "\"";
+}
+
+static string jsonString(const string & what){
+    std::ostringstream out;
+    out << '"';
+    for (unsigned int i = 0; i < what.size(); i++){
+        char c = what[i];
+        switch (c){
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default: {
+                if ((unsigned char) c < 0x20){
+                    out << "\\u00" << "0123456789abcdef"[(c >> 4) & 0xf] << "0123456789abcdef"[c & 0xf];
+                } else {
+                    out << c;
+                }
+            }
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+static string winnerName(const Result & result, const vector<string> & roster){
+    switch (result.winner){
+        case Result::Failed: return "failed";
+        case Result::Draw: return "draw";
+        case 1: return roster[result.match.player1];
+        case 2: return roster[result.match.player2];
+    }
+    return "";
+}
+
+void writeCsv(ostream & out, const vector<Result> & results, const vector<string> & roster, const vector<string> & stages){
+    out << "id,round,player1,player2,stage,seed,winner,ticks,seconds,ticks_per_second,life1,life2,error" << endl;
+    for (vector<Result>::const_iterator it = results.begin(); it != results.end(); it++){
+        const Result & result = *it;
+        const Match & match = result.match;
+        out << match.id << ","
+            << match.round << ","
+            << csvField(roster[match.player1]) << ","
+            << csvField(roster[match.player2]) << ","
+            << csvField(stages[match.stage]) << ","
+            << match.seed << ","
+            << csvField(winnerName(result, roster)) << ","
+            << result.ticks << ","
+            << result.seconds << ","
+            << result.ticksPerSecond() << ","
+            << result.life1 << ","
+            << result.life2 << ","
+            << csvField(result.error) << endl;
+    }
+}
+
+void writeMatrixCsv(ostream & out, const Standings & standings, const vector<string> & roster){
+    out << "winner";
+    for (unsigned int i = 0; i < roster.size(); i++){
+        out << "," << csvField(roster[i]);
+    }
+    out << endl;
+    for (unsigned int player = 0; player < roster.size(); player++){
+        out << csvField(roster[player]);
+        for (unsigned int against = 0; against < roster.size(); against++){
+            out << "," << standings.getWins(player, against);
+        }
+        out << endl;
+    }
+}
+
+void writeJson(ostream & out, const vector<Result> & results, const Standings & standings, const vector<string> & roster, const vector<string> & stages, double seconds){
+    unsigned long ticks = 0;
+    double matchSeconds = 0;
+    for (vector<Result>::const_iterator it = results.begin(); it != results.end(); it++){
+        ticks += it->ticks;
+        matchSeconds += it->seconds;
+    }
+
+    out << "{" << endl;
+    out << "  \"roster\": [";
+    for (unsigned int i = 0; i < roster.size(); i++){
+        out << (i > 0 ? ", " : "") << jsonString(roster[i]);
+    }
+    out << "]," << endl;
+
+    out << "  \"stages\": [";
+    for (unsigned int i = 0; i < stages.size(); i++){
+        out << (i > 0 ? ", " : "") << jsonString(stages[i]);
+    }
+    out << "]," << endl;
+
+    out << "  \"seconds\": " << seconds << "," << endl;
+    out << "  \"ticks\": " << ticks << "," << endl;
+    /* how fast a single worker plays, and how fast all of them together did */
+    out << "  \"ticks_per_second\": " << (matchSeconds > 0 ? ticks / matchSeconds : 0) << "," << endl;
+    out << "  \"total_ticks_per_second\": " << (seconds > 0 ? ticks / seconds : 0) << "," << endl;
+
+    out << "  \"matches\": [" << endl;
+    for (vector<Result>::const_iterator it = results.begin(); it != results.end(); it++){
+        const Result & result = *it;
+        const Match & match = result.match;
+        out << "    {\"id\": " << match.id
+            << ", \"round\": " << match.round
+            << ", \"player1\": " << match.player1
+            << ", \"player2\": " << match.player2
+            << ", \"stage\": " << match.stage
+            << ", \"seed\": " << match.seed
+            << ", \"winner\": " << result.winner
+            << ", \"ticks\": " << result.ticks
+            << ", \"seconds\": " << result.seconds
+            << ", \"ticks_per_second\": " << result.ticksPerSecond()
+            << ", \"life1\": " << result.life1
+            << ", \"life2\": " << result.life2;
+        if (result.error != ""){
+            out << ", \"error\": " << jsonString(result.error);
+        }
+        out << "}" << (it + 1 != results.end() ? "," : "") << endl;
+    }
+    out << "  ]," << endl;
+
+    out << "  \"standings\": [" << endl;
+    vector<int> ranking = standings.ranking();
+    for (unsigned int i = 0; i < ranking.size(); i++){
+        int player = ranking[i];
+        out << "    {\"player\": " << player
+            << ", \"score\": " << standings.getScore(player)
+            << ", \"wins\": " << standings.getWins(player)
+            << ", \"losses\": " << standings.getLosses(player)
+            << ", \"draws\": " << standings.getDraws(player)
+            << ", \"failures\": " << standings.getFailures(player)
+            << "}" << (i + 1 < ranking.size() ? "," : "") << endl;
+    }
+    out << "  ]," << endl;
+
+    /* matrix[a][b] is how many times a beat b */
+    out << "  \"matrix\": [" << endl;
+    for (int player = 0; player < standings.getPlayers(); player++){
+        out << "    [";
+        for (int against = 0; against < standings.getPlayers(); against++){
+            out << (against > 0 ? ", " : "") << standings.getWins(player, against);
+        }
+        out << "]" << (player + 1 < standings.getPlayers() ? "," : "") << endl;
+    }
+    out << "  ]" << endl;
+    out << "}" << endl;
+}
+
+}
@@ -0,0 +1,120 @@
+#ifndef _paintown_test_mugen_tournament_h
+#define _paintown_test_mugen_tournament_h
+
+/* Scheduling and bookkeeping for run-match. Nothing in here knows how a
+ * match is played, it only decides who plays who and writes down what
+ * happened.
+ */
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+
+namespace Tournament{
+
+/* players and stages are indexes into the roster and the stage list */
+struct Match{
+    Match();
+    Match(int id, int round, int player1, int player2, int stage, uint32_t seed);
+
+    int id;
+    int round;
+    int player1;
+    int player2;
+    int stage;
+    /* the match context is seeded with this so the match can be played again */
+    uint32_t seed;
+};
+
+struct Result{
+    Result();
+
+    /* the match could not be played, `error' says why */
+    static const int Failed = -1;
+    static const int Draw = 0;
+
+    Match match;
+    /* 1 or 2 if someone won */
+    int winner;
+    unsigned long ticks;
+    double seconds;
+    double life1;
+    double life2;
+    std::string error;
+
+    double ticksPerSecond() const;
+};
+
+/* the seed for one match, mixed from the tournament seed so it doesn't depend
+ * on which worker plays it or in what order
+ */
+uint32_t matchSeed(uint32_t seed, int id);
+
+/* Every pair of players meets once on every stage each round. Sides swap
+ * from one round to the next so nobody always gets player 1.
+ */
+std::vector<Match> roundRobin(int players, int stages, int rounds, uint32_t seed);
+
+/* Wins, draws and who played who */
+class Standings{
+public:
+    Standings(int players);
+
+    void add(const Result & result);
+    void addBye(int player);
+
+    /* a win is worth 1 and a draw 1/2, a bye counts as a win */
+    double getScore(int player) const;
+    int getWins(int player) const;
+    int getLosses(int player) const;
+    int getDraws(int player) const;
+    int getFailures(int player) const;
+
+    /* number of times `player' beat `against' */
+    int getWins(int player, int against) const;
+    bool hasPlayed(int player1, int player2) const;
+    bool hadBye(int player) const;
+
+    /* best score first, ties go to the lower index */
+    std::vector<int> ranking() const;
+
+    inline int getPlayers() const {
+        return players;
+    }
+
+protected:
+    int players;
+    std::vector<int> wins;
+    std::vector<int> losses;
+    std::vector<int> draws;
+    std::vector<int> failures;
+    std::vector<int> byes;
+    /* players * players */
+    std::vector<int> beat;
+    std::vector<int> played;
+};
+
+/* The next round of a swiss tournament. Players are paired off in ranking
+ * order with the closest player they haven't met yet, and if there is an odd
+ * number the lowest ranked player without a bye so far sits out; `bye' is set
+ * to them or -1. Everyone plays on the same stage, the stages take turns from
+ * round to round. Match ids start at `firstId'.
+ */
+std::vector<Match> swissRound(const Standings & standings, int round, int stages, uint32_t seed, int firstId, int & bye);
+
+/* how many rounds a swiss tournament needs to find a winner */
+int swissRounds(int players);
+
+/* One line per match */
+void writeCsv(std::ostream & out, const std::vector<Result> & results, const std::vector<std::string> & roster, const std::vector<std::string> & stages);
+
+/* rows are the winners and columns the losers */
+void writeMatrixCsv(std::ostream & out, const Standings & standings, const std::vector<std::string> & roster);
+
+/* The matches, the standings and the win matrix in one object */
+void writeJson(std::ostream & out, const std::vector<Result> & results, const Standings & standings, const std::vector<std::string> & roster, const std::vector<std::string> & stages, double seconds);
+
+}
+
+#endif
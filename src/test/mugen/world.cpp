@@ -55,8 +55,10 @@ public:
 
 int run(string path1 = "mugen/chars/kfm/kfm.def", string path2 = "mugen/chars/kfm/kfm.def"){
     Game game(path1, path2, "mugen/stages/kfm.def");
-    Mugen::Random randomState(*Mugen::Random::getState());
+    /* every run of the match starts from the same random numbers */
+    Mugen::Random randomState(1);
     game.load();
+    game.stage->getContext().setRandom(randomState);
 
     vector<PaintownUtil::ReferenceCount<Mugen::World> > worlds;
 
@@ -75,8 +77,8 @@ int run(string path1 = "mugen/chars/kfm/kfm.def", string path2 = "mugen/chars/kf
     Global::debug(0, "test") << diff.printTime("Took") << endl;
 
     /* Reset the state */
-    Mugen::Random::setState(randomState);
     game.load();
+    game.stage->getContext().setRandom(randomState);
 
     Global::debug(0) << "Rerun match and check states" << std::endl;
     /* Now check that all previous states match what comes out of the new game */
@@ -111,8 +113,8 @@ int run(string path1 = "mugen/chars/kfm/kfm.def", string path2 = "mugen/chars/kf
         Global::debug(0, "test") << diff.printTime("Took") << endl;
     }
     
-    Mugen::Random::setState(randomState);
     game.load();
+    game.stage->getContext().setRandom(randomState);
 
     Global::debug(0) << "Set every 50th state." << std::endl;
     /* Now check that all previous states match what comes out of the new game */
@@ -0,0 +1,257 @@
+/* checks that messages come out of Message::parse and Message(socket) the
+ * same as they went into Message::dump
+ */
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <string.h>
+#include "util/network/network.h"
+#include "util/thread.h"
+#include "util/funcs.h"
+#include "paintown-engine/network/network.h"
+
+using std::string;
+using std::vector;
+
+namespace Global{
+    int getVersion(){
+        return 0;
+    }
+}
+
+static const int port = 8924;
+
+static Network::Message makeMessage(uint32_t id, int used, const string & path){
+    Network::Message message;
+    message.id = id;
+    for (int i = 0; i < used; i++){
+        message.data[i] = i + 1;
+    }
+    message.path = path;
+    return message;
+}
+
+static bool same(const Network::Message & a, const Network::Message & b){
+    return a.id == b.id &&
+           memcmp(a.data, b.data, sizeof(a.data)) == 0 &&
+           a.path == b.path;
+}
+
+static vector<Network::Message> allMessages(){
+    vector<Network::Message> messages;
+    /* ids that take one byte and ones that take five */
+    messages.push_back(makeMessage(0, 2, ""));
+    messages.push_back(makeMessage(127, 2, ""));
+    messages.push_back(makeMessage(1 << 28, 2, ""));
+    messages.push_back(makeMessage(0xffffffff, 2, ""));
+    /* no data, all of it, and some with zeros at the end */
+    messages.push_back(makeMessage(5, 0, ""));
+    messages.push_back(makeMessage(5, Network::DATA_SIZE, ""));
+    messages.push_back(makeMessage(5, Network::DATA_SIZE / 2, ""));
+    /* zeros in the middle of the data have to stay */
+    Network::Message holes = makeMessage(6, Network::DATA_SIZE, "");
+    holes.data[1] = 0;
+    holes.data[Network::DATA_SIZE - 2] = 0;
+    messages.push_back(holes);
+    /* paths */
+    messages.push_back(makeMessage(7, 4, "a"));
+    messages.push_back(makeMessage(7, 4, "players/akuma/akuma.txt"));
+    messages.push_back(makeMessage(7, 4, string(300, 'x')));
+    return messages;
+}
+
+/* a message with `used' bytes of data only sends those */
+static int testTrimmed(){
+    for (int used = 0; used <= Network::DATA_SIZE; used++){
+        Network::Message message = makeMessage(1, used, "");
+        vector<uint8_t> buffer;
+        message.dump(buffer);
+        /* one byte each for the id, the data length and the path length */
+        if ((int) buffer.size() != used + 3 || message.size() != used + 3){
+            std::cout << "Message with " << used << " bytes of data took " << buffer.size() << " bytes" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int testRoundTrip(){
+    vector<Network::Message> messages = allMessages();
+    for (vector<Network::Message>::iterator it = messages.begin(); it != messages.end(); it++){
+        const Network::Message & message = *it;
+        vector<uint8_t> buffer;
+        message.dump(buffer);
+        if ((int) buffer.size() != message.size()){
+            std::cout << "Message " << message.id << " says it takes " << message.size() << " bytes but took " << buffer.size() << std::endl;
+            return 1;
+        }
+
+        Network::Message out;
+        unsigned int missing = 0;
+        if (Network::Message::parse(&buffer[0], buffer.size(), out, missing) != buffer.size() || !same(message, out)){
+            std::cout << "Message " << message.id << " with path '" << message.path << "' did not come back the same" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Feeds a stream of messages in as Message(socket) reads them, only as many
+ * bytes as parse() says are missing. That should never go past the end of a
+ * message.
+ */
+static int testMissing(){
+    vector<Network::Message> messages = allMessages();
+    vector<uint8_t> stream;
+    vector<unsigned int> ends;
+    for (vector<Network::Message>::iterator it = messages.begin(); it != messages.end(); it++){
+        it->dump(stream);
+        ends.push_back(stream.size());
+    }
+
+    unsigned int start = 0;
+    for (unsigned int index = 0; index < messages.size(); index++){
+        Network::Message out;
+        unsigned int have = 0;
+        unsigned int missing = 0;
+        unsigned int used = 0;
+        while ((used = Network::Message::parse(&stream[start], have, out, missing)) == 0){
+            if (missing == 0 || start + have + missing > ends[index]){
+                std::cout << "Message " << index << " asked for " << missing << " bytes with " << have << " read" << std::endl;
+                return 1;
+            }
+            have += missing;
+        }
+
+        if (start + used != ends[index] || !same(messages[index], out)){
+            std::cout << "Message " << index << " did not come back the same from a stream" << std::endl;
+            return 1;
+        }
+        start += used;
+    }
+
+    return 0;
+}
+
+static bool rejects(const vector<uint8_t> & buffer){
+    try{
+        Network::Message out;
+        unsigned int missing = 0;
+        Network::Message::parse(&buffer[0], buffer.size(), out, missing);
+        return false;
+    } catch (const Network::NetworkException & fail){
+        return true;
+    }
+}
+
+static int testMalformed(){
+    /* a number can't be longer than five bytes */
+    vector<uint8_t> number(6, 0x80);
+    number[5] = 0;
+    if (!rejects(number)){
+        std::cout << "A six byte number was accepted" << std::endl;
+        return 1;
+    }
+
+    /* the data length is past DATA_SIZE */
+    vector<uint8_t> data;
+    data.push_back(1);
+    data.push_back(Network::DATA_SIZE + 1);
+    if (!rejects(data)){
+        std::cout << "Too much data was accepted" << std::endl;
+        return 1;
+    }
+
+    /* path longer than 64k */
+    vector<uint8_t> path;
+    Network::Message message = makeMessage(1, 0, "");
+    message.dump(path);
+    path.pop_back();
+    path.push_back(0x81);
+    path.push_back(0x80);
+    path.push_back(0x04);
+    if (!rejects(path)){
+        std::cout << "A path longer than 64k was accepted" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+static volatile int socketResult = 0;
+
+static void * readMessages(void * arg){
+    try{
+        Network::Socket server = Network::openReliable(port);
+        Network::listen(server);
+        Network::Socket client = Network::accept(server);
+        vector<Network::Message> messages = allMessages();
+        for (vector<Network::Message>::iterator it = messages.begin(); it != messages.end(); it++){
+            Network::Message message(client);
+            if (!same(*it, message) || message.readFrom != client){
+                std::cout << "Message " << it->id << " did not come back the same from a socket" << std::endl;
+                socketResult = 1;
+            }
+        }
+        Network::close(client);
+        Network::close(server);
+    } catch (const Network::NetworkException & fail){
+        std::cout << "Network exception: " << fail.getMessage() << std::endl;
+        socketResult = 1;
+    }
+    return NULL;
+}
+
+/* all the messages go out in one write, like the network world sends them */
+static int testSocket(){
+    socketResult = 0;
+    Util::Thread::Id reader;
+    if (!Util::Thread::createThread(&reader, NULL, (Util::Thread::ThreadFunction) readMessages, NULL)){
+        std::cout << "Could not start the reader" << std::endl;
+        return 1;
+    }
+
+    int tries = 0;
+    while (true){
+        try{
+            Network::Socket socket = Network::connectReliable("127.0.0.1", port);
+            Network::sendAllMessages(allMessages(), socket);
+            Network::close(socket);
+            break;
+        } catch (const Network::NetworkException & fail){
+            /* the reader might not be listening yet */
+            tries += 1;
+            if (tries == 50){
+                std::cout << "Could not connect: " << fail.getMessage() << std::endl;
+                socketResult = 1;
+                break;
+            }
+            Util::rest(100);
+        }
+    }
+
+    Util::Thread::joinThread(reader);
+    return socketResult;
+}
+
+int main(){
+    Network::init();
+
+    int ok = 0;
+
+    /* run the tests even if some fail */
+    ok = testTrimmed() || ok;
+    ok = testRoundTrip() || ok;
+    ok = testMissing() || ok;
+    ok = testMalformed() || ok;
+    ok = testSocket() || ok;
+
+    Network::closeAll();
+
+    if (ok == 0){
+        std::cout << "Message tests passed" << std::endl;
+    }
+
+    return ok;
+}
@@ -0,0 +1,107 @@
+/* checks that DrawList keeps objects back to front as they come and go */
+
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include "paintown-engine/game/draw_list.h"
+#include "test-object.h"
+
+using namespace std;
+
+/* ordered by z, objects with the same z in the order they are in the world */
+static bool ordered(const DrawList & list, const vector<Paintown::Object*> & objects){
+    const vector<Paintown::Object*> & drawn = list.getObjects();
+    if (drawn.size() != objects.size()){
+        cout << "Drawing " << drawn.size() << " objects out of " << objects.size() << endl;
+        return false;
+    }
+
+    vector<unsigned int> positions;
+    for (vector<Paintown::Object*>::const_iterator it = drawn.begin(); it != drawn.end(); it++){
+        unsigned int position = 0;
+        while (position < objects.size() && objects[position] != *it){
+            position += 1;
+        }
+        if (position == objects.size()){
+            cout << "Drawing an object that is gone" << endl;
+            return false;
+        }
+        positions.push_back(position);
+    }
+
+    for (unsigned int index = 1; index < drawn.size(); index++){
+        const Paintown::Object * before = drawn[index - 1];
+        const Paintown::Object * after = drawn[index];
+        if (before->getRZ() > after->getRZ() ||
+            (before->getRZ() == after->getRZ() && positions[index - 1] >= positions[index])){
+            cout << "Object at z " << after->getRZ() << " is drawn after one at z " << before->getRZ() << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int run(){
+    srand(9);
+    vector<Paintown::Object*> all;
+    vector<Paintown::Object*> objects;
+    DrawList list;
+
+    list.update(objects);
+    if (!list.getObjects().empty()){
+        cout << "Empty world has something to draw" << endl;
+        return 1;
+    }
+
+    for (int i = 0; i < 50; i++){
+        Paintown::Object * object = new TestObject(rand() % 500, rand() % 20);
+        all.push_back(object);
+        objects.push_back(object);
+    }
+
+    int result = 0;
+    for (int frame = 0; frame < 200 && result == 0; frame++){
+        /* move some, a lot of them end up at the same z */
+        for (vector<Paintown::Object*>::iterator it = objects.begin(); it != objects.end(); it++){
+            if (rand() % 4 == 0){
+                (*it)->setZ((*it)->getZ() + rand() % 5 - 2);
+            }
+        }
+
+        /* objects die and new ones show up at the end */
+        if (frame % 7 == 0 && objects.size() > 10){
+            objects.erase(objects.begin() + rand() % objects.size());
+        }
+        if (frame % 5 == 0){
+            Paintown::Object * object = new TestObject(rand() % 500, rand() % 20);
+            all.push_back(object);
+            objects.push_back(object);
+        }
+
+        /* every now and then the world moves objects around in its list */
+        if (frame % 50 == 25){
+            swap(objects[0], objects[objects.size() - 1]);
+        }
+
+        list.update(objects);
+        if (!ordered(list, objects)){
+            cout << "Wrong order in frame " << frame << endl;
+            result = 1;
+        }
+    }
+
+    for (vector<Paintown::Object*>::iterator it = all.begin(); it != all.end(); it++){
+        delete *it;
+    }
+
+    return result;
+}
+
+int main(){
+    int result = run();
+    if (result == 0){
+        cout << "Draw list tests passed" << endl;
+    }
+    return result;
+}
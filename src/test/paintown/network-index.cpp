@@ -0,0 +1,113 @@
+/* checks that NetworkIndex finds the same object a search of the world would */
+
+#include <iostream>
+#include <vector>
+#include "paintown-engine/network/network_index.h"
+#include "test-object.h"
+
+using namespace std;
+
+/* the first object with the id, like the worlds used to search for it */
+static Paintown::Object * search(const vector<Paintown::Object*> & objects, Paintown::Object::networkid_t id){
+    for (vector<Paintown::Object*>::const_iterator it = objects.begin(); it != objects.end(); it++){
+        if ((*it)->getId() == id){
+            return *it;
+        }
+    }
+    return NULL;
+}
+
+static bool check(const NetworkIndex & index, const vector<Paintown::Object*> & objects, Paintown::Object::networkid_t highest){
+    for (Paintown::Object::networkid_t id = 0; id <= highest; id++){
+        if (index.find(id) != search(objects, id)){
+            cout << "Found the wrong object for id " << id << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static Paintown::Object * make(Paintown::Object::networkid_t id){
+    Paintown::Object * object = new TestObject(0, 0);
+    object->setId(id);
+    return object;
+}
+
+static int run(){
+    vector<Paintown::Object*> all;
+    vector<Paintown::Object*> objects;
+    NetworkIndex index;
+    int result = 0;
+
+    /* enough to grow the index a few times */
+    for (Paintown::Object::networkid_t id = 0; id < 200; id++){
+        Paintown::Object * object = make(id);
+        all.push_back(object);
+        objects.push_back(object);
+        index.add(object);
+    }
+
+    /* objects that aren't on the network */
+    Paintown::Object * local = make((Paintown::Object::networkid_t) -1);
+    all.push_back(local);
+    objects.push_back(local);
+    index.add(local);
+    if (index.find((Paintown::Object::networkid_t) -1) != NULL){
+        cout << "Found an object without an id" << endl;
+        result = 1;
+    }
+
+    if (result == 0 && !check(index, objects, 210)){
+        result = 1;
+    }
+
+    /* an object with an id another object has, the first one stays */
+    Paintown::Object * twin = make(42);
+    all.push_back(twin);
+    objects.push_back(twin);
+    index.add(twin);
+    if (result == 0 && !check(index, objects, 210)){
+        result = 1;
+    }
+
+    /* once the first one is gone the second one is found */
+    index.remove(objects[42], objects);
+    objects.erase(objects.begin() + 42);
+    if (result == 0 && (index.find(42) != twin || !check(index, objects, 210))){
+        cout << "Removing an object with a twin lost the twin" << endl;
+        result = 1;
+    }
+
+    index.remove(twin, objects);
+    objects.erase(objects.end() - 1);
+    if (result == 0 && !check(index, objects, 210)){
+        result = 1;
+    }
+
+    /* rebuilding gives the same answers */
+    index.rebuild(objects);
+    if (result == 0 && !check(index, objects, 210)){
+        result = 1;
+    }
+
+    objects.clear();
+    index.rebuild(objects);
+    if (result == 0 && index.find(0) != NULL){
+        cout << "Empty index found something" << endl;
+        result = 1;
+    }
+
+    for (vector<Paintown::Object*>::iterator it = all.begin(); it != all.end(); it++){
+        delete *it;
+    }
+
+    return result;
+}
+
+int main(){
+    int result = run();
+    if (result == 0){
+        cout << "Network index tests passed" << endl;
+    }
+    return result;
+}
@@ -0,0 +1,116 @@
+/* checks that SpatialGrid finds the same objects as looking at all of them */
+
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+#include "paintown-engine/game/spatial_grid.h"
+#include "test-object.h"
+
+using namespace std;
+
+static const int Width = 40;
+static const int Depth = 20;
+
+/* the grid can return objects outside of the area but never miss one inside */
+static bool check(const SpatialGrid & grid, const vector<Paintown::Object*> & objects, double x, double z, double xRadius, double zRadius){
+    vector<unsigned int> found;
+    grid.query(x, z, xRadius, zRadius, found);
+
+    for (unsigned int index = 1; index < found.size(); index++){
+        if (found[index - 1] >= found[index]){
+            cout << "Query around " << x << ", " << z << " is not in increasing order" << endl;
+            return false;
+        }
+    }
+
+    for (unsigned int index = 0; index < objects.size(); index++){
+        const Paintown::Object * object = objects[index];
+        if (fabs(object->getX() - x) <= xRadius && fabs(object->getZ() - z) <= zRadius){
+            bool there = false;
+            for (unsigned int i = 0; i < found.size(); i++){
+                if (found[i] == index){
+                    there = true;
+                }
+            }
+            if (!there){
+                cout << "Query around " << x << ", " << z << " missed object " << index << " at " << object->getX() << ", " << object->getZ() << endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool checkAll(const SpatialGrid & grid, const vector<Paintown::Object*> & objects){
+    for (int i = 0; i < 200; i++){
+        double x = rand() % 1400 - 200;
+        double z = rand() % 500 - 100;
+        double xRadius = rand() % 150;
+        double zRadius = rand() % 60;
+        if (!check(grid, objects, x, z, xRadius, zRadius)){
+            return false;
+        }
+    }
+    return true;
+}
+
+static int run(){
+    srand(4);
+    vector<Paintown::Object*> objects;
+    for (int i = 0; i < 100; i++){
+        objects.push_back(new TestObject(rand() % 1000, rand() % 300, 10 + i));
+    }
+
+    int result = 0;
+    SpatialGrid grid(Width, Depth);
+    if (grid.isReady()){
+        cout << "Grid is ready before it was built" << endl;
+        result = 1;
+    }
+
+    grid.rebuild(objects);
+    if (!grid.isReady() || grid.getWidest() != 10 + 99){
+        cout << "Grid didn't see all of the objects" << endl;
+        result = 1;
+    }
+
+    if (result == 0 && !checkAll(grid, objects)){
+        result = 1;
+    }
+
+    /* move everything, some of it out past where the grid was built */
+    for (unsigned int index = 0; result == 0 && index < objects.size(); index++){
+        Paintown::Object * object = objects[index];
+        object->setX(rand() % 1400 - 200);
+        object->setZ(rand() % 500 - 100);
+        grid.update(index);
+    }
+
+    if (result == 0 && !checkAll(grid, objects)){
+        result = 1;
+    }
+
+    grid.clear();
+    vector<unsigned int> found;
+    grid.query(0, 0, 1000, 1000, found);
+    if (grid.isReady() || !found.empty()){
+        cout << "Cleared grid still has objects" << endl;
+        result = 1;
+    }
+
+    for (vector<Paintown::Object*>::iterator it = objects.begin(); it != objects.end(); it++){
+        delete *it;
+    }
+
+    return result;
+}
+
+int main(){
+    int result = run();
+    if (result == 0){
+        cout << "Spatial grid tests passed" << endl;
+    }
+    return result;
+}
@@ -0,0 +1,90 @@
+#ifndef _paintown_test_object_h
+#define _paintown_test_object_h
+
+#include <string>
+#include <vector>
+#include "paintown-engine/object/object.h"
+
+/* An object that doesn't do anything, for testing the parts of a world that
+ * only look at where objects are and what their ids are.
+ */
+class TestObject: public Paintown::Object{
+public:
+    TestObject(int x, int z, int width = 10):
+    Object(x, z, 0),
+    width(width){
+    }
+
+    virtual void act(std::vector<Paintown::Object *> * others, World * world, std::vector<Paintown::Object *> * add){
+    }
+
+    virtual void draw(Graphics::Bitmap * work, int rel_x, int rel_y){
+    }
+
+    virtual void grabbed(Paintown::Object * obj){
+    }
+
+    virtual void unGrab(){
+    }
+
+    virtual bool isGrabbed(){
+        return false;
+    }
+
+    virtual Paintown::Object * copy(){
+        return new TestObject(*this);
+    }
+
+    virtual const std::string getAttackName(){
+        return "";
+    }
+
+    virtual bool collision(Paintown::ObjectAttack * obj){
+        return false;
+    }
+
+    virtual int getDamage() const {
+        return 0;
+    }
+
+    virtual double getForceX() const {
+        return 0;
+    }
+
+    virtual double getForceY() const {
+        return 0;
+    }
+
+    virtual bool isCollidable(Paintown::Object * obj){
+        return false;
+    }
+
+    virtual bool isGettable(){
+        return false;
+    }
+
+    virtual bool isGrabbable(Paintown::Object * obj){
+        return false;
+    }
+
+    virtual bool isAttacking(){
+        return false;
+    }
+
+    virtual int getWidth() const {
+        return width;
+    }
+
+    virtual int getHeight() const {
+        return 10;
+    }
+
+    virtual Network::Message getCreateMessage(){
+        return Network::Message();
+    }
+
+protected:
+    int width;
+};
+
+#endif
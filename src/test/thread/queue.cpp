@@ -0,0 +1,255 @@
+#include <iostream>
+#include <vector>
+#include "util/thread.h"
+#include "system/queue.h"
+
+#ifdef WINDOWS
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+using namespace std;
+
+/* Checks the lock free queues in system/queue.h. Items are numbered by the
+ * thread that pushed them so the consumer can tell that each one arrived
+ * exactly once and that the ones from the same producer stayed in order.
+ */
+
+static const unsigned int Items = 200000;
+static const unsigned int Producers = 4;
+
+static void relax(){
+#ifdef WINDOWS
+    Sleep(0);
+#else
+    sched_yield();
+#endif
+}
+
+static unsigned int item(unsigned int producer, unsigned int number){
+    return (producer << 24) | number;
+}
+
+/* remembers what a consumer got so far */
+class Checker{
+public:
+    Checker(unsigned int producers):
+    next(producers, 0),
+    failed(false){
+    }
+
+    void got(unsigned int value){
+        unsigned int producer = value >> 24;
+        unsigned int number = value & 0xffffff;
+        if (producer >= next.size()){
+            if (!failed){
+                cout << "Got an item from unknown producer " << producer << endl;
+            }
+            failed = true;
+            return;
+        }
+
+        if (number != next[producer]){
+            if (!failed){
+                cout << "Producer " << producer << ": expected item " << next[producer] << " but got " << number << endl;
+            }
+            failed = true;
+        }
+        next[producer] = number + 1;
+    }
+
+    bool done(unsigned int each) const {
+        for (unsigned int i = 0; i < next.size(); i++){
+            if (next[i] != each){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    vector<unsigned int> next;
+    bool failed;
+};
+
+struct Producer{
+    Producer(void * queue, unsigned int id):
+    queue(queue),
+    id(id){
+    }
+
+    void * queue;
+    unsigned int id;
+};
+
+static void * produceSingle(void * arg){
+    Producer * producer = (Producer*) arg;
+    System::SingleQueue<unsigned int> * queue = (System::SingleQueue<unsigned int>*) producer->queue;
+    for (unsigned int i = 0; i < Items; i++){
+        while (!queue->push(item(producer->id, i))){
+            relax();
+        }
+    }
+    return NULL;
+}
+
+static void * produceMany(void * arg){
+    Producer * producer = (Producer*) arg;
+    System::ManyQueue<unsigned int> * queue = (System::ManyQueue<unsigned int>*) producer->queue;
+    for (unsigned int i = 0; i < Items; i++){
+        while (!queue->push(item(producer->id, i))){
+            relax();
+        }
+    }
+    return NULL;
+}
+
+template <class Queue>
+static bool consume(Queue & queue, Checker & checker, unsigned int total){
+    unsigned int count = 0;
+    while (count < total){
+        unsigned int value = 0;
+        if (queue.pop(value)){
+            checker.got(value);
+            count += 1;
+        } else {
+            relax();
+        }
+    }
+
+    unsigned int extra = 0;
+    if (queue.pop(extra)){
+        cout << "Got more items than were pushed" << endl;
+        return false;
+    }
+
+    return !checker.failed && checker.done(Items);
+}
+
+static int testSingleThreaded(){
+    System::SingleQueue<unsigned int> queue(16);
+    Producer producer(&queue, 0);
+    Util::Thread::Id thread;
+    if (!Util::Thread::createThread(&thread, NULL, (Util::Thread::ThreadFunction) produceSingle, &producer)){
+        cout << "Could not start the producer" << endl;
+        return 1;
+    }
+
+    Checker checker(1);
+    bool ok = consume(queue, checker, Items);
+    Util::Thread::joinThread(thread);
+    if (!ok){
+        cout << "SingleQueue lost or reordered items" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+static int testManyProducers(){
+    System::ManyQueue<unsigned int> queue(16);
+    vector<Producer> producers;
+    for (unsigned int i = 0; i < Producers; i++){
+        producers.push_back(Producer(&queue, i));
+    }
+
+    vector<Util::Thread::Id> threads;
+    for (unsigned int i = 0; i < Producers; i++){
+        Util::Thread::Id thread;
+        if (!Util::Thread::createThread(&thread, NULL, (Util::Thread::ThreadFunction) produceMany, &producers[i])){
+            cout << "Could not start producer " << i << endl;
+            return 1;
+        }
+        threads.push_back(thread);
+    }
+
+    Checker checker(Producers);
+    bool ok = consume(queue, checker, Items * Producers);
+    for (vector<Util::Thread::Id>::iterator it = threads.begin(); it != threads.end(); it++){
+        Util::Thread::joinThread(*it);
+    }
+
+    if (!ok){
+        cout << "ManyQueue lost or reordered items" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/* A full queue turns pushes away without losing what it holds, and takes
+ * more once something is popped. Goes around the cells several times.
+ */
+template <class Queue>
+static int testFull(const string & name){
+    const unsigned int size = 4;
+    Queue queue(size);
+    unsigned int pushed = 0;
+    unsigned int popped = 0;
+    for (unsigned int round = 0; round < size * 5; round++){
+        while (pushed - popped < size){
+            if (!queue.push(pushed)){
+                cout << name << ": push failed with " << (pushed - popped) << " items in a queue of " << size << endl;
+                return 1;
+            }
+            pushed += 1;
+        }
+
+        if (queue.push(pushed)){
+            cout << name << ": pushed into a full queue" << endl;
+            return 1;
+        }
+
+        /* take out a different number every time so the ends move around */
+        unsigned int take = round % size + 1;
+        for (unsigned int i = 0; i < take; i++){
+            unsigned int value = 0;
+            if (!queue.pop(value) || value != popped){
+                cout << name << ": expected " << popped << " from the queue" << endl;
+                return 1;
+            }
+            popped += 1;
+        }
+    }
+
+    while (popped < pushed){
+        unsigned int value = 0;
+        if (!queue.pop(value) || value != popped){
+            cout << name << ": expected " << popped << " from the queue" << endl;
+            return 1;
+        }
+        popped += 1;
+    }
+
+    unsigned int value = 0;
+    if (queue.pop(value)){
+        cout << name << ": popped from an empty queue" << endl;
+        return 1;
+    }
+
+    if (queue.getStatistics().full != size * 5 || queue.getStatistics().pushed != pushed || queue.getStatistics().popped != popped){
+        cout << name << ": wrong statistics" << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(){
+    if (testFull<System::SingleQueue<unsigned int> >("SingleQueue") != 0){
+        return 1;
+    }
+
+    if (testFull<System::ManyQueue<unsigned int> >("ManyQueue") != 0){
+        return 1;
+    }
+
+    if (testSingleThreaded() != 0){
+        return 1;
+    }
+
+    if (testManyProducers() != 0){
+        return 1;
+    }
+
+    cout << "Queue tests passed" << endl;
+    return 0;
+}